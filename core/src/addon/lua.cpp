@@ -31,6 +31,7 @@
 #include <lua.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -339,7 +340,7 @@ void windower::lua::save(state s, writer& w)
 
 void windower::lua::save(state s, std::ostream& stream)
 {
-    class stream_writer sealed : public writer
+    class stream_writer final : public writer
     {
     public:
         stream_writer(std::ostream& stream) noexcept : m_stream{stream} {}
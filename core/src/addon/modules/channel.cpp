@@ -27,41 +27,127 @@
 #include "addon/addon.hpp"
 #include "addon/lua.hpp"
 #include "addon/modules/channel.lua.hpp"
+#include "addon/script_base.hpp"
 #include "addon/unsafe.hpp"
 #include "core.hpp"
 
 #include <lua.hpp>
 
 #include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
 #include <new>
+#include <span>
+#include <string>
+#include <vector>
 
 namespace
 {
 
 std::byte remote_pcall_key;
 
+// A published snapshot of a channel's data. Slots are never removed, so
+// their addresses can be handed out to Lua and cached there.
+class snapshot_slot
+{
+public:
+    double version = 0;
+    std::weak_ptr<windower::lua::state> owner;
+    std::vector<std::byte> data;
+};
+
+std::map<std::u8string, snapshot_slot, std::less<>> snapshot_slots;
+std::uint64_t snapshot_version_counter = 0;
+
+double next_snapshot_version() noexcept
+{
+    return static_cast<double>(++snapshot_version_counter);
+}
+
+}
+
+int windower::get_remote_handle(lua::state s)
+{
+    auto const name = lua::get<std::u8string_view>(s, 1);
+
+    lua::stack_guard guard{s};
+    if (auto addon_manager = core::instance().addon_manager.get())
+    {
+        if (auto addon = addon_manager->get(name))
+        {
+            lua::create<std::weak_ptr<lua::state>>(guard, addon->root_handle());
+            return guard.release();
+        }
+    }
+    lua::push(guard, lua::nil);
+    return guard.release();
 }
 
 extern "C"
 {
-    static int get_remote_handle(windower::lua::state s)
+    static int get_snapshot_slot(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto const key = lua::get<std::u8string_view>(s, 1);
+        auto it        = snapshot_slots.find(key);
+        if (it == snapshot_slots.end())
+        {
+            it = snapshot_slots.emplace(key, snapshot_slot{}).first;
+        }
+
+        lua::stack_guard guard{s};
+        lua::push(guard, static_cast<void*>(&it->second));
+        return guard.release();
+    }
+
+    static int read_snapshot(windower::lua::state s)
     {
         using namespace windower;
 
-        auto const name = lua::get<std::u8string_view>(s, 1);
+        auto const slot = static_cast<snapshot_slot*>(lua::get<void*>(s, 1));
 
         lua::stack_guard guard{s};
-        if (auto addon_manager = core::instance().addon_manager.get())
+        if (slot && !slot->data.empty())
         {
-            if (auto addon = addon_manager->get(name))
-            {
-                lua::create<std::weak_ptr<lua::state>>(
-                    guard, addon->root_handle());
-                return guard.release();
-            }
+            lua::push(guard, std::span<std::byte const>{slot->data});
         }
-        lua::push(guard, lua::nil);
+        else
+        {
+            lua::push(guard, lua::nil);
+        }
+        return guard.release();
+    }
+
+    static double snapshot_version_native(void* slot_ptr)
+    {
+        auto& slot = *static_cast<snapshot_slot*>(slot_ptr);
+        if (!slot.data.empty() && slot.owner.expired())
+        {
+            slot.data    = {};
+            slot.version = next_snapshot_version();
+        }
+        return slot.version;
+    }
+
+    static int publish_snapshot(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto const slot = static_cast<snapshot_slot*>(lua::get<void*>(s, 1));
+        auto const data = std::bit_cast<std::byte const*>(
+            lua::get<std::uintptr_t>(s, 2));
+        auto const size = lua::get<std::size_t>(s, 3);
+
+        slot->owner = script_base::get_script_base(s)->root_handle();
+        slot->data.assign(data, data + size);
+        slot->version = next_snapshot_version();
+
+        lua::stack_guard guard{s};
+        lua::push(guard, slot->version);
         return guard.release();
     }
 
@@ -111,8 +197,12 @@ int windower::load_channel_module(lua::state s)
     lua::push(guard, &remote_pcall_key);
     lua::push(guard, get_remote_handle);
     lua::push(guard, remote_pcall_native);
+    lua::push(guard, get_snapshot_slot);
+    lua::push(guard, read_snapshot);
+    lua::push(guard, snapshot_version_native);
+    lua::push(guard, publish_snapshot);
 
-    lua::call(guard, 4);
+    lua::call(guard, 8);
 
     return guard.release();
 }
@@ -30,6 +30,8 @@
 namespace windower
 {
 
+int get_remote_handle(lua::state);
+
 int load_channel_module(lua::state);
 
 }
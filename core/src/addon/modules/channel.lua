@@ -27,7 +27,11 @@ local -- params
     registry,
     remote_pcall_key,
     get_remote_handle,
-    remote_pcall_native_ptr = ...
+    remote_pcall_native_ptr,
+    get_snapshot_slot,
+    read_snapshot,
+    snapshot_version_native_ptr,
+    publish_snapshot = ...
 -- LuaFormatter on
 
 local ffi = require('ffi')
@@ -47,6 +51,7 @@ local ffi_typeof = ffi.typeof
 
 local serialize_buffer = serializer.serialize_buffer
 local deserialize_buffer = serializer.deserialize_buffer
+local deserialize = serializer.deserialize
 
 local package_name = windower.package_name or '<script>'
 
@@ -57,46 +62,47 @@ local handle_key = {}
 local script_handle = {}
 
 local servers = setmetatable({}, {__mode = 'v'})
+local server_names = setmetatable({}, {__mode = 'k'})
 
-local pcall_impl
-do
-    local void_ptr_ref = ffi_typeof('void*[1]')
-    local size_t_ref = ffi_typeof('int32_t[1]')
-    local remote_pcall_native = ffi_cast('int32_t(*)(void*, void*&, int32_t&)',
-                                         remote_pcall_native_ptr)
+local pack = function(...) return {n = select('#', ...), ...} end
 
+local local_pcall
+do
     local restore = function(func, env, ...)
         setfenv(func, env)
         return ...
     end
 
-    pcall_impl = function(channel, func, ...)
-        local name = rawget(channel, name_key)
-        local handle = rawget(channel, handle_key)
-        if not handle then
-            local server = servers[name]
-            if server == nil then
-                return false, 'channel \'' .. name ..
-                           '\' not found or has been closed'
-            end
-            local env = server.env
-            if type(env) ~= 'table' then env = {} end
-            return restore(func, getfenv(func),
-                           pcall(setfenv(func, env), server.data, ...))
+    local_pcall = function(name, func, ...)
+        local server = servers[name]
+        if server == nil then
+            return false, 'channel \'' .. name ..
+                       '\' not found or has been closed'
         end
-        local data, size = serialize_buffer({
-            name = name,
-            func = func,
-            arg_count = select('#', ...),
-            arg_table = {...}
-        })
+        local env = server.env
+        if type(env) ~= 'table' then env = {} end
+        return restore(func, getfenv(func),
+                       pcall(setfenv(func, env), server.data, ...))
+    end
+end
+
+-- Sends a serialized request to another interpreter and returns the decoded
+-- response, or false and an error message.
+local remote_request
+do
+    local void_ptr_ref = ffi_typeof('void*[1]')
+    local size_t_ref = ffi_typeof('int32_t[1]')
+    local remote_pcall_native = ffi_cast('int32_t(*)(void*, void*&, int32_t&)',
+                                         remote_pcall_native_ptr)
+
+    remote_request = function(handle, request)
+        local data, size = serialize_buffer(request)
         if handle == script_handle then handle = nil end
         local data_ref = void_ptr_ref(data)
         local size_ref = size_t_ref(size)
         local result_code = remote_pcall_native(handle, data_ref, size_ref)
         if result_code == 0 then
-            local result = deserialize_buffer(data_ref[0], size_ref[0])
-            return unpack(result.result_table, 1, result.result_count)
+            return true, deserialize_buffer(data_ref[0], size_ref[0])
         elseif result_code == 1 then
             return false, 'remote interpreter unloaded'
         elseif result_code == 2 then
@@ -107,6 +113,20 @@ do
     end
 end
 
+local pcall_impl = function(channel, func, ...)
+    local name = rawget(channel, name_key)
+    local handle = rawget(channel, handle_key)
+    if not handle then return local_pcall(name, func, ...) end
+    local ok, result = remote_request(handle, {
+        name = name,
+        func = func,
+        arg_count = select('#', ...),
+        arg_table = {...}
+    })
+    if not ok then return false, result end
+    return unpack(result.result_table, 1, result.result_count)
+end
+
 local call_impl
 do
     local results = function(ok, ...)
@@ -149,16 +169,217 @@ do
     end
 end
 
+local read_many_impl
+do
+    local read_path = function(data, path)
+        if type(path) ~= 'table' then return data[path] end
+        local res = data
+        for i = 1, #path do res = res[path[i]] end
+        return res
+    end
+
+    read_many_impl = function(data, count, paths)
+        local results = {}
+        for i = 1, count do results[i] = read_path(data, paths[i]) end
+        return results
+    end
+end
+
+-- Reads several key paths in a single call. Each argument is either a key
+-- or an array of keys, and one value is returned per argument.
+local read_many = function(channel, ...)
+    local count = select('#', ...)
+    return unpack(call_impl(channel, read_many_impl, count, {...}), 1, count)
+end
+
+local new_batch
+do
+    local queue_key = {}
+
+    -- Runs every queued call of one target interpreter. Remote calls are
+    -- sent as a single request and their results come back in a single
+    -- response.
+    local run_group = function(handle, group, results)
+        local count = group.count
+        if not handle then
+            for i = 1, count do
+                local call = group[i]
+                results[call.index] = pack(
+                    local_pcall(call.name, call.func,
+                                unpack(call.arg_table, 1, call.arg_count)))
+            end
+            return
+        end
+
+        local ok, response = remote_request(handle, {
+            batch_count = count,
+            batch = group
+        })
+        if ok and (type(response) ~= 'table' or
+            type(response.batch) ~= 'table') then
+            ok, response = false, 'invalid channel protocol'
+        end
+        for i = 1, count do
+            local index = group[i].index
+            if ok then
+                results[index] = response.batch[i]
+            else
+                results[index] = {n = 2, false, response}
+            end
+        end
+    end
+
+    local queue = function(batch, channel, func, ...)
+        local entries = rawget(batch, queue_key)
+        local index = #entries + 1
+        entries[index] = {
+            index = index,
+            name = rawget(channel, name_key),
+            handle = rawget(channel, handle_key) or false,
+            func = func,
+            arg_count = select('#', ...),
+            arg_table = {...}
+        }
+        return index
+    end
+
+    local read_batch = function(batch, channel, ...)
+        local count = select('#', ...)
+        if count == 0 then
+            return queue(batch, channel, read_0_impl)
+        elseif count == 1 then
+            return queue(batch, channel, read_1_impl, (...))
+        else
+            return queue(batch, channel, read_n_impl, count, ...)
+        end
+    end
+
+    local read_many_batch = function(batch, channel, ...)
+        return queue(batch, channel, read_many_impl, select('#', ...), {...})
+    end
+
+    -- Executes all queued calls and returns their results in queue order.
+    -- Each result is a table of the values the corresponding pcall would
+    -- have returned, with the count stored in n.
+    local execute = function(batch)
+        local entries = rawget(batch, queue_key)
+        rawset(batch, queue_key, {})
+
+        local groups = {}
+        local order = {}
+        for i = 1, #entries do
+            local entry = entries[i]
+            local handle = entry.handle
+            local group = groups[handle]
+            if group == nil then
+                group = {count = 0}
+                groups[handle] = group
+                order[#order + 1] = handle
+            end
+            local count = group.count + 1
+            group.count = count
+            group[count] = entry
+            entry.handle = nil
+        end
+
+        local results = {}
+        for i = 1, #order do
+            local handle = order[i]
+            run_group(handle, groups[handle], results)
+        end
+        return results
+    end
+
+    local metatable = {
+        __index = {
+            pcall = queue,
+            read = read_batch,
+            read_many = read_many_batch,
+            execute = execute
+        },
+        __metatable = false
+    }
+
+    new_batch = function()
+        return setmetatable({[queue_key] = {}}, metatable)
+    end
+end
+
+-- Snapshots are immutable serialized copies of a server's data, published
+-- under a version number that changes with every publish and when the
+-- publishing interpreter unloads. Clients decode a snapshot once per version
+-- and share the decoded copy, which must be treated as read-only.
+local publish
+local snapshot_version
+local snapshot
+do
+    local snapshot_version_native = ffi_cast('double(*)(void*)',
+                                             snapshot_version_native_ptr)
+    local intptr_t = ffi_typeof('intptr_t')
+
+    local slot_key = {}
+
+    local cache = {}
+
+    local get_slot = function(channel)
+        local slot = rawget(channel, slot_key)
+        if slot == nil then
+            slot = get_snapshot_slot(rawget(channel, package_name_key) .. ':' ..
+                                         rawget(channel, name_key))
+            rawset(channel, slot_key, slot)
+        end
+        return slot
+    end
+
+    publish = function(server, data)
+        local name = server_names[server]
+        if name == nil then error('channel server expected') end
+        if data == nil then data = server.data end
+        local slot = get_snapshot_slot(package_name .. ':' .. name)
+        local ptr, size = serialize_buffer(data)
+        return publish_snapshot(slot, tonumber(ffi_cast(intptr_t, ptr)), size)
+    end
+
+    snapshot_version = function(channel)
+        return snapshot_version_native(get_slot(channel))
+    end
+
+    snapshot = function(channel, ...)
+        local slot = get_slot(channel)
+        local version = snapshot_version_native(slot)
+        local entry = cache[slot]
+        if entry == nil or entry.version ~= version then
+            local data = read_snapshot(slot)
+            entry = {version = version, value = data and deserialize(data)}
+            cache[slot] = entry
+        end
+        local res = entry.value
+        for i = 1, select('#', ...) do
+            if res == nil then return nil end
+            res = res[select(i, ...)]
+        end
+        return res
+    end
+end
+
 local new_server = function(name)
     local server = {}
     servers[name] = server
+    server_names[server] = name
     return server
 end
 
 local get_client
 do
     local metatable = {
-        __index = {pcall = pcall_impl, call = call_impl, read = read_impl},
+        __index = {
+            pcall = pcall_impl,
+            call = call_impl,
+            read = read_impl,
+            read_many = read_many,
+            version = snapshot_version,
+            snapshot = snapshot
+        },
         __tostring = function(c)
             return 'core.channel:' .. rawget(c, package_name_key) .. ':' ..
                        rawget(c, name_key)
@@ -190,40 +411,70 @@ local remote_pcall
 do
     local intptr_t = ffi_typeof('intptr_t')
 
+    local serialize_result = function(result)
+        local ptr, size = serialize_buffer(result)
+        return tonumber(ffi_cast(intptr_t, ptr)), size
+    end
+
     local make_result = function(...)
-        local ptr, size = serialize_buffer({
+        return serialize_result({
             result_count = select('#', ...),
             result_table = {...}
         })
-        return tonumber(ffi_cast(intptr_t, ptr)), size
+    end
+
+    local is_valid_call = function(call)
+        return type(call) == 'table' and type(call.name) == 'string' and
+                   type(call.func) == 'function' and
+                   type(call.arg_count) == 'number' and
+                   type(call.arg_table) == 'table'
+    end
+
+    local run_call = function(call)
+        return local_pcall(call.name, call.func,
+                           unpack(call.arg_table, 1, call.arg_count))
+    end
+
+    local run_batch = function(data)
+        local count = data.batch_count
+        local calls = data.batch
+        local results = {}
+        for i = 1, count do
+            local call = calls[i]
+            if is_valid_call(call) then
+                results[i] = pack(run_call(call))
+            else
+                results[i] = {n = 2, false, 'invalid channel protocol'}
+            end
+        end
+        return serialize_result({batch = results})
     end
 
     remote_pcall = function(data_ptr, data_size)
         local ok, data = pcall(deserialize_buffer, data_ptr, data_size)
         if not ok then return make_result(false, data) end
-        if type(data) ~= 'table' or type(data.name) ~= 'string' or
-            type(data.func) ~= 'function' or type(data.arg_count) ~= 'number' or
-            type(data.arg_table) ~= 'table' then
-            return make_result(false, 'invalid channel protocol')
+        if type(data) == 'table' and type(data.batch_count) == 'number' and
+            type(data.batch) == 'table' then
+            return run_batch(data)
         end
-        local server = servers[data.name]
-        if server == nil then
-            return make_result(false, 'channel \'' .. data.name ..
-                                   '\' not found or has been closed')
+        if not is_valid_call(data) then
+            return make_result(false, 'invalid channel protocol')
         end
-        local env = server.env
-        if type(env) ~= 'table' then env = {} end
-        return make_result(pcall(setfenv(data.func, env), server.data,
-                                 unpack(data.arg_table, 1, data.arg_count)))
+        return make_result(run_call(data))
     end
 end
 
 local channel = {
     new = new_server,
     get = get_client,
+    batch = new_batch,
     pcall = pcall_impl,
     call = call_impl,
-    read = read_impl
+    read = read_impl,
+    read_many = read_many,
+    publish = publish,
+    version = snapshot_version,
+    snapshot = snapshot
 }
 
 rawset(registry, remote_pcall_key, remote_pcall)
@@ -237,5 +488,11 @@ serializer.register('__channel.read', channel.read, false)
 serializer.register('__channel.read_0', read_0_impl, false)
 serializer.register('__channel.read_1', read_1_impl, false)
 serializer.register('__channel.read_n', read_n_impl, false)
+serializer.register('__channel.read_many', channel.read_many, false)
+serializer.register('__channel.read_many_impl', read_many_impl, false)
+serializer.register('__channel.batch', channel.batch, false)
+serializer.register('__channel.publish', channel.publish, false)
+serializer.register('__channel.version', channel.version, false)
+serializer.register('__channel.snapshot', channel.snapshot, false)
 
 return channel
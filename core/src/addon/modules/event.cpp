@@ -25,11 +25,22 @@
 #include "addon/modules/event.hpp"
 
 #include "addon/lua.hpp"
+#include "addon/modules/channel.hpp"
 #include "addon/modules/event.lua.hpp"
 #include "addon/unsafe.hpp"
 #include "unicode.hpp"
 
+#include <cstdint>
 #include <exception>
+#include <memory>
+#include <span>
+
+namespace
+{
+
+std::byte receive_key;
+
+}
 
 extern "C"
 {
@@ -65,6 +76,71 @@ extern "C"
         }
         return guard.release();
     }
+
+    // Fans a single encoded argument payload out to every subscribed
+    // interpreter. Arguments are the remote event name, the payload and one
+    // handle per subscriber (false for the script environment). Returns one
+    // result per subscriber: true to keep it subscribed, false to drop it or
+    // an error message if one of its handlers failed.
+    static int trigger_remote(lua::state s)
+    {
+        auto const name    = lua::get<std::u8string_view>(s, 1);
+        auto const payload = lua::get<std::span<std::byte const>>(s, 2);
+        auto const count   = gsl::narrow_cast<int>(lua::top(s));
+
+        auto const data_ptr  = const_cast<std::byte*>(payload.data());
+        auto const data_size = gsl::narrow<std::int32_t>(payload.size());
+
+        lua::stack_guard guard{s};
+        lua::reserve(guard, count);
+        for (auto i = 3; i <= count; ++i)
+        {
+            auto const state_ptr =
+                lua::typeof(guard, i) == lua::type::userdata
+                    ? lua::get<std::weak_ptr<lua::state>>(guard, i).lock()
+                    : core::instance().script_environment.root_handle().lock();
+            if (!state_ptr)
+            {
+                lua::push(guard, false);
+                continue;
+            }
+
+            lua::stack_guard remote{*state_ptr};
+            lua::push(remote, &receive_key);
+            lua::raw_get(remote, lua::registry);
+            if (lua::typeof(remote, -1) != lua::type::function)
+            {
+                lua::push(guard, false);
+                continue;
+            }
+            lua::push(remote, name);
+            lua::push(remote, data_ptr);
+            lua::push(remote, data_size);
+            try
+            {
+                lua::call(remote, 3, 2);
+            }
+            catch (lua::error const&)
+            {
+                lua::push(guard, false);
+                continue;
+            }
+
+            if (lua::get<bool>(remote, -2))
+            {
+                lua::push(guard, true);
+            }
+            else if (lua::typeof(remote, -1) == lua::type::string)
+            {
+                lua::push(guard, lua::get<std::u8string_view>(remote, -1));
+            }
+            else
+            {
+                lua::push(guard, false);
+            }
+        }
+        return guard.release();
+    }
 }
 
 int windower::load_event_module(lua::state s)
@@ -73,10 +149,14 @@ int windower::load_event_module(lua::state s)
 
     lua::load(guard, lua_event_source, u8"core.event");
 
+    lua::copy(guard, lua::registry);
+    lua::push(guard, &receive_key);
     lua::push(guard, save_stack);
     lua::push(guard, error_addon);
+    lua::push(guard, get_remote_handle);
+    lua::push(guard, trigger_remote);
 
-    lua::call(guard, 2);
+    lua::call(guard, 6);
 
     return guard.release();
 }
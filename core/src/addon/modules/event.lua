@@ -24,8 +24,12 @@ SOFTWARE.
 
 -- LuaFormatter off
 local -- params
+    registry,
+    receive_key,
     save_stack,
-    error_addon = ...
+    error_addon,
+    get_remote_handle,
+    trigger_remote = ...
 -- LuaFormatter on
 
 ---@type __windower_coroutinelib
@@ -45,8 +49,11 @@ local package_name = windower.package_name or '<script>'
 
 local error = error
 local next = next
+local pcall = pcall
 local rawget = rawget
+local select = select
 local setmetatable = setmetatable
+local unpack = unpack
 
 local os_time = os.time
 local os_clock = os.clock
@@ -57,11 +64,14 @@ local table_remove = table.remove
 
 local channel_get = channel.get
 
+local serializer_serialize = serializer.serialize
+local serializer_deserialize_buffer = serializer.deserialize_buffer
+
 local package_name_key = {}
 local name_key = {}
 local local_handlers_key = {}
 local remote_handlers_key = {}
-local remote_handlers_lookup_key = {}
+local remote_name_key = {}
 local server_key = {}
 local serializable_key = {}
 
@@ -76,7 +86,6 @@ local register
 local unregister
 local client
 
-local remote_trigger
 local remote_register
 local remote_unregister
 
@@ -87,23 +96,39 @@ local trigger_local_handlers = function(e, ...)
 end
 
 local trigger_remote_handlers = function(e, ...)
-    local handlers = rawget(e, remote_handlers_key)
-    if handlers == nil then return true end
+    local subscribers = rawget(e, remote_handlers_key)
+    if subscribers == nil then return true end
+    local last = subscribers.count
+    if last == 0 then return false end
+    local names = subscribers.names
+    local ok, payload = pcall(serializer_serialize,
+                              {n = select('#', ...), ...})
+    if not ok then
+        error('cannot send event arguments to remote handlers: ' .. payload)
+    end
+    local results = {
+        trigger_remote(rawget(e, remote_name_key), payload,
+                       unpack(subscribers, 1, last))
+    }
     local slot = 1
-    local last = handlers.count
     for i = 1, last do
-        local handler = handlers[i]
-        local ok, result = pcall(handler, ...)
-        if ok and result ~= false then
-            if i ~= slot then handlers[slot] = handler end
+        local result = results[i]
+        if result == true then
+            if i ~= slot then
+                subscribers[slot] = subscribers[i]
+                names[slot] = names[i]
+            end
             slot = slot + 1
+        elseif result then
+            error_addon(names[i], result)
         end
     end
-    while last >= slot do
-        table_remove(handlers, last)
-        last = last - 1
+    for i = last, slot, -1 do
+        subscribers[i] = nil
+        names[i] = nil
     end
-    handlers.count = last
+    last = slot - 1
+    subscribers.count = last
     return last > 0
 end
 
@@ -229,10 +254,10 @@ do
             [package_name_key] = package_name,
             [name_key] = name,
             [local_handlers_key] = {count = 0},
-            [remote_handlers_key] = {count = 0},
+            [remote_handlers_key] = {count = 0, names = {}},
+            [remote_name_key] = package_name .. ':' .. name,
             [server_key] = true,
-            [serializable_key] = serializable,
-            [remote_handlers_lookup_key] = setmetatable({}, {__mode = 'v'})
+            [serializable_key] = serializable
         }, metatable)
         servers[name] = e
         return e
@@ -297,23 +322,41 @@ local trigger_by_name = function(event_name, ...)
     return xpcall(trigger_handlers, save_stack, e, ...)
 end
 
+-- Called by the native event bus in every subscribed interpreter. The payload
+-- is shared between all subscribers and only decoded if there is a handler
+-- left to receive it.
+local receive = function(event_name, data, size)
+    local e = remote_clients[event_name]
+    if e == nil then return false end
+    if rawget(e, local_handlers_key).count == 0 then return true end
+    local ok, args = pcall(serializer_deserialize_buffer, data, size)
+    if not ok then return false, args end
+    local message
+    ok, message = xpcall(trigger_handlers, save_stack, e,
+                         unpack(args, 1, args.n))
+    if not ok then return false, message end
+    return true
+end
+
 local register_by_name = function(event_name, remote_package_name)
     local server = servers[event_name]
     if server == nil then return false end
-    local name = package_name .. ':' .. event_name
     coroutine.schedule(function()
-        local remote_server = channel_get(remote_package_name, '__event')
-        local remote_handler = function(...)
-            local ok, result, message = remote_server:pcall(remote_trigger,
-                                                            name, ...)
-            if ok and not result then
-                error_addon(remote_package_name, message)
-            end
-            return ok and result
+        local subscribers = rawget(server, remote_handlers_key)
+        local names = subscribers.names
+        local count = subscribers.count
+        for i = 1, count do
+            if names[i] == remote_package_name then return end
+        end
+        local handle = false
+        if remote_package_name ~= '<script>' then
+            handle = get_remote_handle(remote_package_name)
+            if handle == nil then return end
         end
-        register_handler(server, remote_handler, remote_handlers_key)
-        rawget(server, remote_handlers_lookup_key)[remote_package_name] =
-            remote_handler
+        count = count + 1
+        subscribers[count] = handle
+        names[count] = remote_package_name
+        subscribers.count = count
     end)
     return true
 end
@@ -321,21 +364,24 @@ end
 local unregister_by_name = function(event_name, remote_package_name)
     local server = servers[event_name]
     if server == nil then return false end
-    local fn = rawget(server, remote_handlers_lookup_key)[remote_package_name]
-    local handlers = rawget(server, remote_handlers_key)
-    for i = 1, #handlers do
-        if handlers[i] == fn then
-            table_remove(handlers, i)
+    local subscribers = rawget(server, remote_handlers_key)
+    local names = subscribers.names
+    local count = subscribers.count
+    for i = 1, count do
+        if names[i] == remote_package_name then
+            for j = i, count - 1 do
+                subscribers[j] = subscribers[j + 1]
+                names[j] = names[j + 1]
+            end
+            subscribers[count] = nil
+            names[count] = nil
+            subscribers.count = count - 1
             return true
         end
     end
     return false
 end
 
-remote_trigger = function(_, event_name, ...)
-    return trigger_by_name(event_name, ...)
-end
-
 remote_register = function(_, event_name, remote_package_name)
     return register_by_name(event_name, remote_package_name)
 end
@@ -358,7 +404,6 @@ serializer.register('__event.register', event.register, false)
 serializer.register('__event.unregister', event.unregister, false)
 serializer.register('__event.remote_register', remote_register, false)
 serializer.register('__event.remote_unregister', remote_unregister, false)
-serializer.register('__event.remote_trigger', remote_trigger, false)
 
 local serialize = function(event)
     local serializable = rawget(event, serializable_key)
@@ -376,4 +421,6 @@ end
 
 serializer.register_class('__event', serialize, deserialize)
 
+rawset(registry, receive_key, receive)
+
 return event
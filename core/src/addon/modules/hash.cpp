@@ -24,17 +24,130 @@
 
 #include "addon/modules/hash.hpp"
 
+#include "addon/error.hpp"
 #include "addon/lua.hpp"
 #include "addon/modules/hash.lua.hpp"
+#include "murmur3.hpp"
 
 #include <lua.hpp>
 
+#include <gsl/gsl>
+#include <xxhash.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+static_assert(std::is_standard_layout_v<windower::murmur3>);
+static_assert(sizeof(windower::murmur3) == 16);
+
+extern "C"
+{
+    static std::uint32_t
+    murmur3_native(void const* data, std::size_t size, std::int32_t seed)
+    {
+        return windower::murmur3::hash(
+            {static_cast<std::byte const*>(data), size},
+            static_cast<std::uint32_t>(seed));
+    }
+
+    static void murmur3_reset(void* state, std::int32_t seed)
+    {
+        static_cast<windower::murmur3*>(state)->reset(
+            static_cast<std::uint32_t>(seed));
+    }
+
+    static void murmur3_update(void* state, void const* data, std::size_t size)
+    {
+        static_cast<windower::murmur3*>(state)->update(
+            {static_cast<std::byte const*>(data), size});
+    }
+
+    static std::uint32_t murmur3_digest(void const* state)
+    {
+        return static_cast<windower::murmur3 const*>(state)->digest();
+    }
+
+    static std::uint64_t
+    hash64_native(void const* data, std::size_t size, std::uint64_t seed)
+    {
+        return XXH3_64bits_withSeed(data, size, seed);
+    }
+
+    static void* hash64_create(std::uint64_t seed)
+    {
+        auto const state = XXH3_createState();
+        if (state)
+        {
+            XXH3_64bits_reset_withSeed(state, seed);
+        }
+        return state;
+    }
+
+    static void hash64_destroy(void* state)
+    {
+        XXH3_freeState(static_cast<XXH3_state_t*>(state));
+    }
+
+    static void hash64_update(void* state, void const* data, std::size_t size)
+    {
+        XXH3_64bits_update(static_cast<XXH3_state_t*>(state), data, size);
+    }
+
+    static std::uint64_t hash64_digest(void const* state)
+    {
+        return XXH3_64bits_digest(static_cast<XXH3_state_t const*>(state));
+    }
+
+    // Hashes every string of an array with the 32-bit hash and returns the
+    // results in a new array.
+    static int hash_many(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto const count = lua::size(s, 1);
+        auto const seed  = static_cast<std::uint32_t>(lua::get<int>(s, 2));
+
+        lua::stack_guard guard{s};
+        lua::create_table(guard, count);
+        for (std::size_t i = 1; i <= count; ++i)
+        {
+            auto const index = gsl::narrow<int>(i);
+            lua::raw_get(guard, 1, index);
+            if (lua::typeof(guard, -1) != lua::type::string)
+            {
+                throw lua::error{"bad argument #1 to 'many' (array of "
+                                 "strings expected)"};
+            }
+            auto const value = lua::get<std::span<std::byte const>>(guard, -1);
+            lua::pop(guard);
+            auto const hash = murmur3::hash(value, seed);
+            lua::push(guard, static_cast<double>(hash));
+            lua::raw_set(guard, -2, index);
+        }
+        return guard.release();
+    }
+}
+
 int windower::load_hash_module(lua::state s)
 {
     lua::stack_guard guard{s};
 
     lua::load(guard, lua_hash_source, u8"core.hash");
-    lua::call(guard, 0);
+
+    lua::push(guard, &murmur3_native);
+    lua::push(guard, &murmur3_reset);
+    lua::push(guard, &murmur3_update);
+    lua::push(guard, &murmur3_digest);
+    lua::push(guard, &hash64_native);
+    lua::push(guard, &hash64_create);
+    lua::push(guard, &hash64_destroy);
+    lua::push(guard, &hash64_update);
+    lua::push(guard, &hash64_digest);
+    lua::push(guard, hash_many);
+
+    lua::call(guard, 10);
 
     return guard.release();
 }
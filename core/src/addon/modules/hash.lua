@@ -22,63 +22,158 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 ]]
 
+-- LuaFormatter off
+local -- params
+    murmur3_native_ptr,
+    murmur3_reset_ptr,
+    murmur3_update_ptr,
+    murmur3_digest_ptr,
+    hash64_native_ptr,
+    hash64_create_ptr,
+    hash64_destroy_ptr,
+    hash64_update_ptr,
+    hash64_digest_ptr,
+    hash_many = ...
+-- LuaFormatter on
+
 local bit = require('bit')
-local string = require('string')
+local ffi = require('ffi')
 
 local serializer = require('core.serializer')
 
-local band = bit.band
-local bor = bit.bor
-local bxor = bit.bxor
-local lshift = bit.lshift
-local rol = bit.rol
-local rshift = bit.rshift
+local error = error
+local setmetatable = setmetatable
+local tostring = tostring
+local type = type
+
 local tobit = bit.tobit
 
-local byte = string.byte
+local ffi_cast = ffi.cast
+local ffi_gc = ffi.gc
+local ffi_metatype = ffi.metatype
+local ffi_typeof = ffi.typeof
+
+-- LuaFormatter off
+local murmur3_native = ffi_cast('uint32_t(*)(void const*, size_t, int32_t)', murmur3_native_ptr)
+local murmur3_reset = ffi_cast('void(*)(void*, int32_t)', murmur3_reset_ptr)
+local murmur3_update = ffi_cast('void(*)(void*, void const*, size_t)', murmur3_update_ptr)
+local murmur3_digest = ffi_cast('uint32_t(*)(void const*)', murmur3_digest_ptr)
+
+local hash64_native = ffi_cast('uint64_t(*)(void const*, size_t, uint64_t)', hash64_native_ptr)
+local hash64_create = ffi_cast('void*(*)(uint64_t)', hash64_create_ptr)
+local hash64_destroy = ffi_cast('void(*)(void*)', hash64_destroy_ptr)
+local hash64_update = ffi_cast('void(*)(void*, void const*, size_t)', hash64_update_ptr)
+local hash64_digest = ffi_cast('uint64_t(*)(void const*)', hash64_digest_ptr)
+-- LuaFormatter on
+
+local check_seed = function(seed, name, index)
+    if seed == nil then return 0 end
+    if type(seed) ~= 'number' then
+        error('bad argument #' .. index .. ' to \'' .. name ..
+                  '\' (number expected, got ' .. type(seed) .. ')', 3)
+    end
+    return seed
+end
+
+local check_seed64 = function(seed, name, index)
+    if type(seed) == 'cdata' then return seed end
+    return check_seed(seed, name, index)
+end
 
-local hash
+local check_data = function(data, size, name)
+    if type(data) == 'string' then
+        if size == nil then size = #data end
+    elseif type(data) ~= 'cdata' then
+        error('bad argument #1 to \'' .. name ..
+                  '\' (string or cdata expected, got ' .. type(data) .. ')', 3)
+    elseif type(size) ~= 'number' then
+        error('bad argument #2 to \'' .. name .. '\' (number expected, got ' ..
+                  type(size) .. ')', 3)
+    end
+    return data, size
+end
+
+local hash32 = function(value, seed)
+    if type(value) ~= 'string' then value = tostring(value) end
+    return murmur3_native(value, #value, tobit(check_seed(seed, 'hash', 2)))
+end
+
+local hash64 = function(data, size, seed)
+    data, size = check_data(data, size, 'hash64')
+    return hash64_native(data, size, check_seed64(seed, 'hash64', 3))
+end
+
+local many = function(values, seed)
+    if type(values) ~= 'table' then
+        error('bad argument #1 to \'many\' (table expected, got ' ..
+                  type(values) .. ')', 2)
+    end
+    return hash_many(values, tobit(check_seed(seed, 'many', 2)))
+end
+
+-- Streaming hashers produce the same results as hashing the concatenation
+-- of everything passed to update in one call.
+local stream
 do
-    local mul = function(a, b)
-        return band(a, 0xFFFF) * b + lshift(rshift(a, 16) * b, 16)
+    local stream_t = ffi_metatype(ffi_typeof([[struct {
+        uint32_t hash;
+        uint32_t tail;
+        uint32_t tail_size;
+        uint32_t length;
+    }]]), {
+        __index = {
+            update = function(s, data, size)
+                data, size = check_data(data, size, 'update')
+                murmur3_update(s, data, size)
+                return s
+            end,
+            digest = function(s) return murmur3_digest(s) end
+        }
+    })
+
+    stream = function(seed)
+        local s = stream_t()
+        murmur3_reset(s, tobit(check_seed(seed, 'stream', 1)))
+        return s
     end
+end
 
-    hash = function(value, seed)
-        if type(value) ~= 'string' then value = tostring(value) end
-
-        if seed == nil then
-            seed = 0
-        elseif type(seed) ~= 'number' then
-            error('bad argument #2 to \'hash\' (number expected, got ' ..
-                      type(seed) .. ')')
-        end
-
-        local h = tobit(seed)
-
-        local length = #value
-        for i = 1, length - 3, 4 do
-            local a, b, c, d = byte(value, i, i + 3)
-            local block = bor(a, lshift(b, 8), lshift(c, 16), lshift(d, 24))
-            h = bxor(h, mul(rol(mul(block, 0xCC9E2D51), 15), 0x1B873593))
-            h = mul(rol(h, 13), 5) + 0xE6546B64
-        end
-
-        local tail = length % 4
-        if tail > 0 then
-            local a, b, c = byte(value, length - tail + 1, length)
-            local block = bor(a, lshift(b or 0, 8), lshift(c or 0, 16))
-            h = bxor(h, mul(rol(mul(block, 0xCC9E2D51), 15), 0x1B873593))
-        end
-
-        h = bxor(h, length)
-        h = mul(bxor(h, rshift(h, 16)), 0x85EBCA6B)
-        h = mul(bxor(h, rshift(h, 13)), 0xC2B2AE35)
-        h = bxor(h, rshift(h, 16))
-        if h < 0 then h = h + 0x100000000 end
-        return h
+local stream64
+do
+    local metatable = {
+        __index = {
+            update = function(s, data, size)
+                data, size = check_data(data, size, 'update')
+                hash64_update(s.state, data, size)
+                return s
+            end,
+            digest = function(s) return hash64_digest(s.state) end
+        }
+    }
+
+    stream64 = function(seed)
+        local state = hash64_create(check_seed64(seed, 'stream64', 1))
+        if state == nil then error('failed to create hash state') end
+        return setmetatable({state = ffi_gc(state, hash64_destroy)}, metatable)
     end
 end
 
+-- The module itself can be called to compute the 32-bit hash.
+local hash = setmetatable({
+    hash32 = hash32,
+    hash64 = hash64,
+    many = many,
+    stream = stream,
+    stream64 = stream64
+}, {
+    __call = function(_, value, seed) return hash32(value, seed) end
+})
+
 serializer.register('__hash', hash)
+serializer.register('__hash.hash32', hash32)
+serializer.register('__hash.hash64', hash64)
+serializer.register('__hash.many', many)
+serializer.register('__hash.stream', stream)
+serializer.register('__hash.stream64', stream64)
 
 return hash
@@ -28,6 +28,10 @@
 #include "addon/lua.hpp"
 #include "addon/modules/scanner.lua.hpp"
 
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
 extern "C"
 {
     static void* scan_native(
@@ -38,6 +42,33 @@ extern "C"
             {module_string, module_length},
             windower::signature{{signature_string, signature_length}});
     }
+
+    static void scan_all_native(
+        char8_t const* module_string, std::size_t module_length,
+        char8_t const* const* signature_strings,
+        std::size_t const* signature_lengths, std::size_t count,
+        void** results)
+    {
+        std::vector<windower::signature> signatures;
+        signatures.reserve(count);
+        std::vector<windower::signature const*> pointers;
+        pointers.reserve(count);
+        for (auto i = std::size_t{}; i < count; ++i)
+        {
+            signatures.emplace_back(std::u8string_view{
+                signature_strings[i], signature_lengths[i]});
+            pointers.push_back(&signatures.back());
+        }
+
+        std::vector<windower::address> addresses(count);
+        windower::library const library{
+            std::u8string_view{module_string, module_length}};
+        windower::scan_all(library, pointers, addresses);
+        for (auto i = std::size_t{}; i < count; ++i)
+        {
+            results[i] = addresses[i];
+        }
+    }
 }
 
 int windower::load_scanner_module(lua::state s)
@@ -47,7 +78,8 @@ int windower::load_scanner_module(lua::state s)
     lua::load(guard, lua_scanner_source, u8"core.scanner");
 
     lua::push(guard, &scan_native);
-    lua::call(guard, 1);
+    lua::push(guard, &scan_all_native);
+    lua::call(guard, 2);
 
     return guard.release();
 }
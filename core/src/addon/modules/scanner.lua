@@ -27,6 +27,8 @@ local ffi = require('ffi')
 local serializer = require('core.serializer')
 
 local error = error
+local pairs = pairs
+local tostring = tostring
 local type = type
 
 local args = {...}
@@ -35,6 +37,9 @@ local args = {...}
 local scan_native = ffi.new(
     'void*(*)(char const*,size_t,char const*,size_t)',
     args[1])
+local scan_all_native = ffi.new(
+    'void(*)(char const*,size_t,char const**,size_t*,size_t,void**)',
+    args[2])
 -- LuaFormatter on
 
 local scan = function(signature, module)
@@ -56,9 +61,54 @@ local scan = function(signature, module)
     return result
 end
 
-local scanner = {scan = scan}
+local scan_all = function(signatures, module)
+    if type(signatures) ~= 'table' then
+        error('bad argument #1 to \'scan_all\' (table expected, got ' ..
+                  type(signatures) .. ')', 2)
+    end
+    if module == nil then
+        module = 'ffximain.dll'
+    elseif type(module) ~= 'string' then
+        error('bad argument #2 to \'scan_all\' (string expected, got ' ..
+                  type(module) .. ')', 2)
+    end
+
+    local keys = {}
+    for key, signature in pairs(signatures) do
+        if type(signature) ~= 'string' then
+            error('bad argument #1 to \'scan_all\' (string expected for ' ..
+                      'signature \'' .. tostring(key) .. '\', got ' ..
+                      type(signature) .. ')', 2)
+        end
+        keys[#keys + 1] = key
+    end
+
+    local count = #keys
+    local strings = ffi.new('char const*[?]', count)
+    local lengths = ffi.new('size_t[?]', count)
+    for i = 1, count do
+        local signature = signatures[keys[i]]
+        strings[i - 1] = signature
+        lengths[i - 1] = #signature
+    end
+
+    local addresses = ffi.new('void*[?]', count)
+    scan_all_native(module, #module, strings, lengths, count, addresses)
+
+    local results = {}
+    for i = 1, count do
+        local result = addresses[i - 1]
+        if result ~= nil then -- coalesce nullptr to nil
+            results[keys[i]] = result
+        end
+    end
+    return results
+end
+
+local scanner = {scan = scan, scan_all = scan_all}
 
 serializer.register('__scanner', scanner, false)
 serializer.register('__scanner.scan', scanner.scan)
+serializer.register('__scanner.scan_all', scanner.scan_all)
 
 return scanner
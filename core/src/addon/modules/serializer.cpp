@@ -24,17 +24,1160 @@
 
 #include "addon/modules/serializer.hpp"
 
+#include "addon/error.hpp"
 #include "addon/lua.hpp"
 #include "addon/modules/serializer.lua.hpp"
+#include "addon/unsafe.hpp"
+#include "utility.hpp"
 
 #include <lua.hpp>
 
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+// Wire format tags. Everything below table_tag encodes its payload in the
+// tag itself: small integers (-27 to 100), small references (1 to 63), small
+// strings (up to 31 bytes) and small resource names (up to 15 bytes).
+constexpr std::uint8_t small_reference_tag = 128;
+constexpr std::uint8_t small_string_tag    = 192;
+constexpr std::uint8_t small_resource_tag  = 224;
+constexpr std::uint8_t table_tag           = 240;
+constexpr std::uint8_t large_resource_tag  = 241;
+constexpr std::uint8_t instance_tag        = 242;
+constexpr std::uint8_t large_reference_tag = 243;
+constexpr std::uint8_t large_string_tag    = 244;
+constexpr std::uint8_t int32_tag           = 245;
+constexpr std::uint8_t double_tag          = 246;
+constexpr std::uint8_t nil_tag             = 247;
+constexpr std::uint8_t false_tag           = 248;
+constexpr std::uint8_t true_tag            = 249;
+constexpr std::uint8_t int16_tag           = 250;
+constexpr std::uint8_t function_tag        = 251;
+constexpr std::uint8_t closure_tag         = 252;
+
+constexpr std::int32_t small_int_offset        = 27;
+constexpr std::uint32_t small_reference_offset = 127;
+constexpr double large_reference_offset        = 91;
+constexpr double large_string_offset           = 58;
+
+constexpr std::int32_t min_small_int        = -27;
+constexpr std::int32_t max_small_int        = 100;
+constexpr std::uint32_t max_small_reference = 63;
+constexpr std::size_t max_small_string      = 31;
+constexpr std::size_t max_small_resource    = 15;
+
+constexpr std::size_t max_depth           = 512;
+constexpr std::size_t initial_buffer_size = 4096;
+
+constexpr std::size_t registry_count = 6;
+
+int const state_upvalue              = windower::lua::upvalue(1);
+int const class_upvalue              = windower::lua::upvalue(2);
+int const resource_upvalue           = windower::lua::upvalue(3);
+int const resource_name_upvalue      = windower::lua::upvalue(4);
+int const resource_safe_upvalue      = windower::lua::upvalue(5);
+int const class_serializer_upvalue   = windower::lua::upvalue(6);
+int const class_deserializer_upvalue = windower::lua::upvalue(7);
+
+bool is_integer(double value) noexcept
+{
+    return (value + 0x1p52) - 0x1p52 == value;
+}
+
+class output_buffer
+{
+public:
+    std::byte* data() noexcept { return m_data.data(); }
+    std::size_t size() const noexcept { return m_size; }
+
+    std::span<std::byte const> view() const noexcept
+    {
+        return {m_data.data(), m_size};
+    }
+
+    void clear() noexcept { m_size = 0; }
+
+    void reserve(std::size_t size)
+    {
+        if (m_data.size() < size)
+        {
+            m_data.resize(size);
+        }
+    }
+
+    void release() noexcept
+    {
+        m_data = {};
+        m_size = 0;
+    }
+
+    void write(std::uint8_t value) { *grow(1) = std::byte{value}; }
+
+    void write(std::span<std::byte const> value)
+    {
+        if (!value.empty())
+        {
+            std::memcpy(grow(value.size()), value.data(), value.size());
+        }
+    }
+
+    template<typename T>
+    void write_value(T value)
+    {
+        std::memcpy(grow(sizeof value), &value, sizeof value);
+    }
+
+private:
+    std::vector<std::byte> m_data;
+    std::size_t m_size = 0;
+
+    std::byte* grow(std::size_t size)
+    {
+        auto const required = m_size + size;
+        if (required > m_data.size())
+        {
+            m_data.resize(
+                std::max({required, m_data.size() * 2, initial_buffer_size}));
+        }
+        auto const result = m_data.data() + m_size;
+        m_size            = required;
+        return result;
+    }
+};
+
+// Maps already written values to their reference numbers. LuaJIT interns
+// strings, so object identity is enough for every reference type. Entries
+// are invalidated by bumping the generation, which keeps clearing cheap and
+// lets the table be reused without reallocating.
+class seen_map
+{
+public:
+    std::uint32_t find(void const* key, windower::lua::type type) const noexcept
+    {
+        if (m_entries.empty())
+        {
+            return 0;
+        }
+        auto const mask = m_entries.size() - 1;
+        for (auto i = hash(key) & mask;; i = (i + 1) & mask)
+        {
+            auto const& entry = m_entries[i];
+            if (entry.generation != m_generation)
+            {
+                return 0;
+            }
+            if (entry.key == key && entry.type == type)
+            {
+                return entry.ref;
+            }
+        }
+    }
+
+    void insert(void const* key, windower::lua::type type, std::uint32_t ref)
+    {
+        if ((m_size + 1) * 2 > m_entries.size())
+        {
+            grow();
+        }
+        auto const mask = m_entries.size() - 1;
+        auto i          = hash(key) & mask;
+        while (m_entries[i].generation == m_generation)
+        {
+            i = (i + 1) & mask;
+        }
+        m_entries[i] = {key, ref, type, m_generation};
+        ++m_size;
+    }
+
+    void clear() noexcept
+    {
+        m_size = 0;
+        if (++m_generation == 0)
+        {
+            std::fill(m_entries.begin(), m_entries.end(), entry{});
+            m_generation = 1;
+        }
+    }
+
+private:
+    struct entry
+    {
+        void const* key          = nullptr;
+        std::uint32_t ref        = 0;
+        windower::lua::type type = windower::lua::type::none;
+        std::uint32_t generation = 0;
+    };
+
+    std::vector<entry> m_entries;
+    std::size_t m_size         = 0;
+    std::uint32_t m_generation = 1;
+
+    static std::size_t hash(void const* key) noexcept
+    {
+        auto const value = std::bit_cast<std::uintptr_t>(key);
+        return static_cast<std::size_t>((value >> 3) * 0x9E3779B1u);
+    }
+
+    void grow()
+    {
+        auto old = std::move(m_entries);
+        m_entries.assign(std::max<std::size_t>(old.size() * 2, 256), entry{});
+        auto const generation = m_generation;
+        m_generation          = 1;
+        m_size                = 0;
+        for (auto const& e : old)
+        {
+            if (e.generation == generation)
+            {
+                insert(e.key, e.type, e.ref);
+            }
+        }
+    }
+};
+
+// Class serializers and __pairs metamethods can call back into the
+// serializer, so every nesting level gets its own context. Contexts are
+// kept and reused by later calls, which makes steady state serialization
+// allocation free.
+class serialization_context
+{
+public:
+    output_buffer buffer;
+    seen_map seen;
+    std::vector<std::byte> dump;
+    std::size_t anchor_hint = 0;
+};
+
+class serializer_state
+{
+public:
+    std::deque<serialization_context> contexts;
+    std::size_t depth = 0;
+
+    // Number of hash entries of the last table decoded at each nesting
+    // depth. Messages tend to repeat the same shapes, so this is used to
+    // presize the next table decoded at the same depth.
+    std::vector<std::uint32_t> shape_hints;
+};
+
+class dump_writer final : public windower::lua::writer
+{
+public:
+    explicit dump_writer(std::vector<std::byte>& buffer) noexcept :
+        m_buffer{buffer}
+    {}
+
+    void write(std::span<std::byte const> data) noexcept override
+    {
+        m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+    }
+
+private:
+    std::vector<std::byte>& m_buffer;
+};
+
+void check_upvalue(
+    windower::lua::stack_guard const& s, int index, char const* action)
+{
+    using namespace windower;
+
+    auto const value = lua::absolute(s, index);
+    lua::copy(s, resource_safe_upvalue);
+    lua::copy(s, value);
+    lua::raw_get(s, -2);
+    auto const unsafe = lua::typeof(s, -1) == lua::type::boolean &&
+                        !lua::get<bool>(s, -1);
+    lua::pop(s, 2);
+    if (unsafe)
+    {
+        throw lua::error{
+            std::string{"attempt to "} + action + " an unsafe upvalue"};
+    }
+}
+
+class value_writer
+{
+public:
+    value_writer(
+        windower::lua::state s, serialization_context& context,
+        bool preserve_upvalues) :
+        m_guard{s},
+        m_context{context},
+        m_preserve_upvalues{preserve_upvalues}
+    {}
+
+    void write(int index)
+    {
+        using namespace windower;
+
+        m_context.buffer.clear();
+        m_context.seen.clear();
+
+        lua::reserve(m_guard, 8);
+        write_value(lua::absolute(m_guard, index), 0);
+        if (m_anchor != 0)
+        {
+            m_context.anchor_hint = m_seen;
+        }
+    }
+
+private:
+    windower::lua::stack_guard m_guard;
+    serialization_context& m_context;
+    bool m_preserve_upvalues;
+    int m_anchor         = 0;
+    std::uint32_t m_seen = 0;
+
+    // Writes the value at the given absolute stack index. The stack is left
+    // unchanged.
+    void write_value(int index, std::size_t depth)
+    {
+        using namespace windower;
+
+        // register refuses numbers, booleans and nil, so these never name a
+        // resource and skip the registry lookup.
+        auto const type = lua::typeof(m_guard, index);
+        switch (type)
+        {
+        case lua::type::number:
+            write_number(lua::get<double>(m_guard, index));
+            return;
+        case lua::type::boolean:
+            m_context.buffer.write(
+                lua::get<bool>(m_guard, index) ? true_tag : false_tag);
+            return;
+        case lua::type::nil: m_context.buffer.write(nil_tag); return;
+        default: break;
+        }
+
+        auto const key = lua::get<void const*>(m_guard, index);
+        if (auto const ref = m_context.seen.find(key, type))
+        {
+            write_reference(ref);
+            return;
+        }
+        add_seen(index, key, type);
+
+        lua::copy(m_guard, resource_name_upvalue);
+        lua::copy(m_guard, index);
+        lua::raw_get(m_guard, -2);
+        if (lua::typeof(m_guard, -1) == lua::type::string)
+        {
+            write_resource(lua::get<std::u8string_view>(m_guard, -1));
+            lua::pop(m_guard, 2);
+            return;
+        }
+        lua::pop(m_guard, 2);
+
+        switch (type)
+        {
+        case lua::type::string:
+            write_string(lua::get<std::span<std::byte const>>(m_guard, index));
+            break;
+        case lua::type::table: write_table(index, depth); break;
+        case lua::type::function: write_function(index, depth); break;
+        default:
+            throw lua::error{
+                "cannot serialize type " +
+                windower::to_string(lua::to_u8string_view(type))};
+        }
+    }
+
+    void add_seen(int index, void const* key, windower::lua::type type)
+    {
+        using namespace windower;
+
+        m_context.seen.insert(key, type, ++m_seen);
+
+        // Values produced by class serializers and iterators may be
+        // temporaries. Anchoring them keeps the addresses used as keys
+        // valid until the whole value has been written. The first value
+        // seen is always the root, so the anchor table is created before
+        // anything else is pushed.
+        if (m_anchor == 0)
+        {
+            lua::create_table(m_guard, m_context.anchor_hint);
+            m_anchor = lua::absolute(m_guard, -1);
+        }
+        lua::copy(m_guard, index);
+        lua::raw_set(m_guard, m_anchor, gsl::narrow_cast<int>(m_seen));
+    }
+
+    void write_reference(std::uint32_t ref)
+    {
+        if (ref <= max_small_reference)
+        {
+            m_context.buffer.write(
+                gsl::narrow_cast<std::uint8_t>(ref + small_reference_offset));
+        }
+        else
+        {
+            m_context.buffer.write(large_reference_tag);
+            write_number(ref - large_reference_offset);
+        }
+    }
+
+    void write_number(double value)
+    {
+        auto& buffer = m_context.buffer;
+        if (is_integer(value) && value >= -2147483648.0 &&
+            value <= 2147483647.0)
+        {
+            auto const integer = static_cast<std::int32_t>(value);
+            if (integer >= min_small_int && integer <= max_small_int)
+            {
+                buffer.write(
+                    gsl::narrow_cast<std::uint8_t>(integer + small_int_offset));
+            }
+            else if (integer >= -32768 && integer <= 32767)
+            {
+                buffer.write(int16_tag);
+                buffer.write_value(gsl::narrow_cast<std::int16_t>(integer));
+            }
+            else
+            {
+                buffer.write(int32_tag);
+                buffer.write_value(integer);
+            }
+        }
+        else
+        {
+            buffer.write(double_tag);
+            buffer.write_value(value);
+        }
+    }
+
+    void write_string(std::span<std::byte const> value)
+    {
+        auto& buffer = m_context.buffer;
+        if (value.size() <= max_small_string)
+        {
+            buffer.write(gsl::narrow_cast<std::uint8_t>(
+                value.size() + small_string_tag));
+        }
+        else
+        {
+            buffer.write(large_string_tag);
+            write_number(
+                static_cast<double>(value.size()) - large_string_offset);
+        }
+        buffer.write(value);
+    }
+
+    void write_resource(std::u8string_view name)
+    {
+        auto const bytes = std::as_bytes(std::span{name});
+        if (name.size() <= max_small_resource)
+        {
+            m_context.buffer.write(gsl::narrow_cast<std::uint8_t>(
+                name.size() + small_resource_tag));
+            m_context.buffer.write(bytes);
+        }
+        else
+        {
+            m_context.buffer.write(large_resource_tag);
+            write_string(bytes);
+        }
+    }
+
+    void write_table(int index, std::size_t depth)
+    {
+        using namespace windower;
+
+        if (depth >= max_depth)
+        {
+            throw lua::error{"serialized value nested too deeply"};
+        }
+
+        lua::stack_guard guard{m_guard};
+        lua::reserve(guard, 8);
+
+        if (!lua::get_metatable(guard, index))
+        {
+            m_context.buffer.write(table_tag);
+            write_fields(guard, index, false, depth);
+            return;
+        }
+        lua::pop(guard);
+
+        lua::copy(guard, class_upvalue);
+        lua::copy(guard, index);
+        lua::call(guard, 1, 1);
+        if (lua::typeof(guard, -1) == lua::type::nil)
+        {
+            m_context.buffer.write(table_tag);
+            write_fields(guard, index, true, depth);
+            return;
+        }
+
+        auto const class_name = lua::absolute(guard, -1);
+        m_context.buffer.write(instance_tag);
+        write_value(class_name, depth + 1);
+
+        lua::copy(guard, class_serializer_upvalue);
+        lua::copy(guard, class_name);
+        lua::raw_get(guard, -2);
+        if (lua::typeof(guard, -1) != lua::type::function)
+        {
+            throw lua::error{
+                "no serializer registered for class '" +
+                windower::to_string(
+                    lua::get<std::u8string_view>(guard, class_name)) +
+                "'"};
+        }
+        lua::copy(guard, index);
+        lua::call(guard, 1, 1);
+
+        auto const table         = lua::absolute(guard, -1);
+        auto const has_metatable = lua::get_metatable(guard, table);
+        if (has_metatable)
+        {
+            lua::pop(guard);
+        }
+        write_fields(guard, table, has_metatable, depth);
+    }
+
+    void write_fields(
+        windower::lua::stack_guard const& s, int table, bool has_metatable,
+        std::size_t depth)
+    {
+        using namespace windower;
+
+        auto const length = lua::size(s, table);
+        write_number(static_cast<double>(length));
+
+        auto const slot = gsl::narrow_cast<int>(lua::top(s)) + 1;
+        for (std::size_t i = 1; i <= length; ++i)
+        {
+            if (has_metatable)
+            {
+                lua::push(s, gsl::narrow_cast<std::int32_t>(i));
+                lua::get(s, table);
+            }
+            else
+            {
+                lua::raw_get(s, table, gsl::narrow_cast<int>(i));
+            }
+            write_value(slot, depth + 1);
+            lua::pop(s);
+        }
+
+        auto const write_pair = [&](int key, int value) {
+            if (lua::typeof(s, key) == lua::type::number)
+            {
+                auto const number = lua::get<double>(s, key);
+                if (is_integer(number) && number >= 1 &&
+                    number <= static_cast<double>(length))
+                {
+                    return;
+                }
+            }
+            write_value(key, depth + 1);
+            write_value(value, depth + 1);
+        };
+
+        if (has_metatable && push_pairs(s, table))
+        {
+            lua::copy(s, table);
+            lua::call(s, 1, 3);
+            auto const control = lua::absolute(s, -1);
+            while (true)
+            {
+                lua::copy(s, control - 2);
+                lua::copy(s, control - 1);
+                lua::copy(s, control);
+                lua::call(s, 2, 2);
+                if (lua::typeof(s, -2) == lua::type::nil)
+                {
+                    lua::pop(s, 2);
+                    break;
+                }
+                write_pair(control + 1, control + 2);
+                lua::pop(s);
+                lua::replace(s, control);
+            }
+            lua::pop(s, 3);
+        }
+        else
+        {
+            lua::push(s, lua::nil);
+            while (lua::next(s, table))
+            {
+                write_pair(slot, slot + 1);
+                lua::pop(s);
+            }
+        }
+
+        m_context.buffer.write(nil_tag);
+    }
+
+    static bool push_pairs(windower::lua::stack_guard const& s, int table)
+    {
+        using namespace windower;
+
+        if (!lua::get_metatable(s, table))
+        {
+            return false;
+        }
+        lua::push(s, u8"__pairs");
+        lua::raw_get(s, -2);
+        lua::remove(s, -2);
+        if (lua::typeof(s, -1) == lua::type::nil)
+        {
+            lua::pop(s);
+            return false;
+        }
+        return true;
+    }
+
+    void write_function(int index, std::size_t depth)
+    {
+        using namespace windower;
+
+        lua::stack_guard guard{m_guard};
+        auto const l = lua::unsafe::unwrap(guard);
+
+        if (::lua_iscfunction(l, index))
+        {
+            throw lua::error{"unable to dump given function"};
+        }
+
+        if (m_preserve_upvalues)
+        {
+            if (depth >= max_depth)
+            {
+                throw lua::error{"serialized value nested too deeply"};
+            }
+            lua::reserve(guard, 8);
+
+            ::lua_Debug info;
+            lua::copy(guard, index);
+            ::lua_getinfo(l, ">u", &info);
+            if (info.nups != 0)
+            {
+                m_context.buffer.write(closure_tag);
+                write_dump(guard, index);
+                write_number(info.nups);
+                for (auto i = 1; i <= info.nups; ++i)
+                {
+                    ::lua_getupvalue(l, index, i);
+                    check_upvalue(guard, -1, "serialize");
+                    write_value(lua::absolute(guard, -1), depth + 1);
+                    lua::pop(guard);
+                }
+                return;
+            }
+        }
+
+        m_context.buffer.write(function_tag);
+        write_dump(guard, index);
+    }
+
+    void write_dump(windower::lua::stack_guard const& s, int index)
+    {
+        using namespace windower;
+
+        auto& dump = m_context.dump;
+        dump.clear();
+        dump_writer writer{dump};
+        lua::copy(s, index);
+        lua::save(s, writer);
+        lua::pop(s);
+        write_string(dump);
+    }
+};
+
+class value_reader
+{
+public:
+    value_reader(
+        windower::lua::state s, std::span<std::byte const> data,
+        std::vector<std::uint32_t>& shape_hints) :
+        m_guard{s},
+        m_data{data},
+        m_shape_hints{shape_hints}
+    {}
+
+    // Leaves the decoded value on top of the stack.
+    std::size_t read()
+    {
+        using namespace windower;
+
+        lua::reserve(m_guard, 8);
+        lua::create_table(m_guard);
+        m_seen = lua::absolute(m_guard, -1);
+        read_value(0);
+        lua::remove(m_guard, m_seen);
+        return m_guard.release();
+    }
+
+private:
+    windower::lua::stack_guard m_guard;
+    std::span<std::byte const> m_data;
+    std::vector<std::uint32_t>& m_shape_hints;
+    std::size_t m_position = 0;
+    int m_seen             = 0;
+    int m_seen_count       = 0;
+
+    [[noreturn]] static void malformed()
+    {
+        throw windower::lua::error{"malformed serialized data"};
+    }
+
+    std::span<std::byte const> read_bytes(std::size_t size)
+    {
+        if (size > m_data.size() - m_position)
+        {
+            malformed();
+        }
+        auto const result = m_data.subspan(m_position, size);
+        m_position += size;
+        return result;
+    }
+
+    std::uint8_t read_byte()
+    {
+        return std::to_integer<std::uint8_t>(read_bytes(1).front());
+    }
+
+    template<typename T>
+    T read_value_of()
+    {
+        T result;
+        std::memcpy(&result, read_bytes(sizeof result).data(), sizeof result);
+        return result;
+    }
+
+    // Lengths, references and upvalue counts are always written as plain
+    // numbers, which never take a seen slot, so they are decoded without
+    // going through the Lua stack.
+    double read_number()
+    {
+        auto const tag = read_byte();
+        if (tag < small_reference_tag)
+        {
+            return tag - small_int_offset;
+        }
+        switch (tag)
+        {
+        case int16_tag: return read_value_of<std::int16_t>();
+        case int32_tag: return read_value_of<std::int32_t>();
+        case double_tag: return read_value_of<double>();
+        }
+        malformed();
+    }
+
+    std::size_t read_size(double value)
+    {
+        // Every element takes at least one byte, so anything larger than
+        // the remaining input cannot be valid.
+        if (!is_integer(value) || value < 0 ||
+            value > static_cast<double>(m_data.size() - m_position))
+        {
+            malformed();
+        }
+        return static_cast<std::size_t>(value);
+    }
+
+    // Resource names and function dumps are written as strings that do not
+    // take a seen slot.
+    std::span<std::byte const> read_unseen_string()
+    {
+        auto const tag = read_byte();
+        if (tag >= small_string_tag && tag < small_resource_tag)
+        {
+            return read_bytes(tag - small_string_tag);
+        }
+        if (tag == large_string_tag)
+        {
+            return read_bytes(read_size(read_number() + large_string_offset));
+        }
+        malformed();
+    }
+
+    int reserve_seen() noexcept { return ++m_seen_count; }
+
+    void set_seen(int slot)
+    {
+        using namespace windower;
+
+        lua::copy(m_guard, -1);
+        lua::raw_set(m_guard, m_seen, slot);
+    }
+
+    void push_reference(double ref)
+    {
+        using namespace windower;
+
+        if (!is_integer(ref) || ref < 1 || ref > m_seen_count)
+        {
+            malformed();
+        }
+        lua::raw_get(m_guard, m_seen, static_cast<int>(ref));
+    }
+
+    void push_resource(std::span<std::byte const> name)
+    {
+        using namespace windower;
+
+        lua::copy(m_guard, resource_upvalue);
+        lua::push(m_guard, name);
+        lua::raw_get(m_guard, -2);
+        lua::remove(m_guard, -2);
+    }
+
+    std::uint32_t shape_hint(std::size_t depth) const noexcept
+    {
+        return depth < m_shape_hints.size() ? m_shape_hints[depth] : 0;
+    }
+
+    void enter(std::size_t depth)
+    {
+        using namespace windower;
+
+        if (depth >= max_depth)
+        {
+            throw lua::error{"serialized value nested too deeply"};
+        }
+        lua::reserve(m_guard, 8);
+    }
+
+    void push_table(int slot, std::size_t depth)
+    {
+        using namespace windower;
+
+        enter(depth);
+
+        auto const length = read_size(read_number());
+        lua::create_table(m_guard, length, shape_hint(depth));
+        set_seen(slot);
+
+        auto const table = lua::absolute(m_guard, -1);
+        for (std::size_t i = 1; i <= length; ++i)
+        {
+            read_value(depth + 1);
+            lua::raw_set(m_guard, table, gsl::narrow_cast<int>(i));
+        }
+
+        std::uint32_t count = 0;
+        while (true)
+        {
+            read_value(depth + 1);
+            auto const key_type = lua::typeof(m_guard, -1);
+            if (key_type == lua::type::nil)
+            {
+                lua::pop(m_guard);
+                break;
+            }
+            if (key_type == lua::type::number &&
+                std::isnan(lua::get<double>(m_guard, -1)))
+            {
+                malformed();
+            }
+            read_value(depth + 1);
+            lua::raw_set(m_guard, table);
+            ++count;
+        }
+
+        if (m_shape_hints.size() <= depth)
+        {
+            m_shape_hints.resize(depth + 1);
+        }
+        m_shape_hints[depth] = count;
+    }
+
+    void push_instance(std::size_t depth)
+    {
+        using namespace windower;
+
+        enter(depth);
+
+        auto const slot = reserve_seen();
+        read_value(depth + 1);
+        auto const class_name = lua::absolute(m_guard, -1);
+
+        lua::copy(m_guard, class_deserializer_upvalue);
+        lua::copy(m_guard, class_name);
+        lua::raw_get(m_guard, -2);
+        lua::remove(m_guard, -2);
+        if (lua::typeof(m_guard, -1) != lua::type::function)
+        {
+            throw lua::error{
+                "no deserializer registered for class '" +
+                windower::to_string(
+                    lua::get<std::u8string_view>(m_guard, class_name)) +
+                "'"};
+        }
+
+        push_table(slot, depth);
+        lua::copy(m_guard, class_upvalue);
+        lua::call(m_guard, 2, 1);
+
+        // References that follow the instance resolve to the deserialized
+        // object rather than to the intermediate field table.
+        set_seen(slot);
+        lua::replace(m_guard, class_name);
+    }
+
+    void push_function(int slot, bool upvalues, std::size_t depth)
+    {
+        using namespace windower;
+
+        lua::load(m_guard, read_unseen_string(), u8"=(deserialized)");
+        if (upvalues)
+        {
+            enter(depth);
+
+            auto const function = lua::absolute(m_guard, -1);
+            auto const l        = lua::unsafe::unwrap(m_guard);
+            auto const count    = read_number();
+            for (auto i = 1; i <= count; ++i)
+            {
+                read_value(depth + 1);
+                check_upvalue(m_guard, -1, "deserialize");
+                if (!::lua_setupvalue(l, function, i))
+                {
+                    lua::pop(m_guard);
+                }
+            }
+        }
+        set_seen(slot);
+    }
+
+    // Pushes exactly one value onto the stack.
+    void read_value(std::size_t depth)
+    {
+        using namespace windower;
+
+        auto const tag = read_byte();
+        if (tag < small_reference_tag)
+        {
+            lua::push(m_guard, static_cast<double>(tag - small_int_offset));
+        }
+        else if (tag < small_string_tag)
+        {
+            push_reference(tag - small_reference_offset);
+        }
+        else if (tag < small_resource_tag)
+        {
+            lua::push(m_guard, read_bytes(tag - small_string_tag));
+            set_seen(reserve_seen());
+        }
+        else if (tag < table_tag)
+        {
+            push_resource(read_bytes(tag - small_resource_tag));
+            set_seen(reserve_seen());
+        }
+        else
+        {
+            switch (tag)
+            {
+            case table_tag: push_table(reserve_seen(), depth); break;
+            case large_resource_tag:
+            {
+                auto const slot = reserve_seen();
+                push_resource(read_unseen_string());
+                set_seen(slot);
+                break;
+            }
+            case instance_tag: push_instance(depth); break;
+            case large_reference_tag:
+                push_reference(read_number() + large_reference_offset);
+                break;
+            case large_string_tag:
+                lua::push(
+                    m_guard,
+                    read_bytes(
+                        read_size(read_number() + large_string_offset)));
+                set_seen(reserve_seen());
+                break;
+            case int32_tag:
+                lua::push(m_guard, read_value_of<std::int32_t>());
+                break;
+            case double_tag:
+                lua::push(m_guard, read_value_of<double>());
+                break;
+            case nil_tag: lua::push(m_guard, lua::nil); break;
+            case false_tag: lua::push(m_guard, false); break;
+            case true_tag: lua::push(m_guard, true); break;
+            case int16_tag:
+                lua::push(
+                    m_guard,
+                    static_cast<std::int32_t>(read_value_of<std::int16_t>()));
+                break;
+            case function_tag:
+                push_function(reserve_seen(), false, depth);
+                break;
+            case closure_tag: push_function(reserve_seen(), true, depth); break;
+            default:
+                throw lua::error{
+                    "unsupported serialized type " + std::to_string(tag)};
+            }
+        }
+    }
+};
+
+serializer_state& get_state(windower::lua::state s)
+{
+    using namespace windower;
+
+    auto const state = lua::get<serializer_state>(s, state_upvalue);
+    if (!state)
+    {
+        throw lua::error{"[INTERNAL ERROR] invalid serializer state"};
+    }
+    return *state;
+}
+
+}
+
+extern "C"
+{
+    // serialize(value, preserve_upvalues, as_string)
+    // Returns the encoded value either as a string or as a pointer into the
+    // interpreter's serialization buffer followed by its size. The buffer
+    // is overwritten by the next call.
+    static int serialize_native(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto& state                  = get_state(s);
+        auto const preserve_upvalues = lua::get<bool>(s, 2);
+        auto const as_string         = lua::get<bool>(s, 3);
+
+        if (state.contexts.size() <= state.depth)
+        {
+            state.contexts.emplace_back();
+        }
+        auto& context = state.contexts[state.depth];
+
+        ++state.depth;
+        auto const restore = gsl::finally([&state] { --state.depth; });
+
+        value_writer{s, context, preserve_upvalues}.write(1);
+
+        lua::stack_guard guard{s};
+        if (as_string)
+        {
+            lua::push(guard, context.buffer.view());
+        }
+        else
+        {
+            lua::push(guard, static_cast<void*>(context.buffer.data()));
+            lua::push(guard, static_cast<double>(context.buffer.size()));
+        }
+        return guard.release();
+    }
+
+    // deserialize(string) or deserialize(address, size)
+    static int deserialize_native(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto& state = get_state(s);
+
+        std::span<std::byte const> data;
+        switch (lua::typeof(s, 1))
+        {
+        case lua::type::string:
+            data = lua::get<std::span<std::byte const>>(s, 1);
+            break;
+        case lua::type::lightuserdata:
+            data = {
+                static_cast<std::byte const*>(lua::get<void*>(s, 1)),
+                lua::get<std::size_t>(s, 2)};
+            break;
+        case lua::type::number:
+            data = {
+                std::bit_cast<std::byte const*>(
+                    lua::get<std::uintptr_t>(s, 1)),
+                lua::get<std::size_t>(s, 2)};
+            break;
+        default: throw lua::error{"malformed serialized data"};
+        }
+        if (!data.data() && !data.empty())
+        {
+            throw lua::error{"malformed serialized data"};
+        }
+
+        return value_reader{s, data, state.shape_hints}.read();
+    }
+
+    static int reserve_buffer_native(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto& state = get_state(s);
+        if (state.contexts.empty())
+        {
+            state.contexts.emplace_back();
+        }
+        state.contexts.front().buffer.reserve(lua::get<std::size_t>(s, 1));
+        return 0;
+    }
+
+    static int clear_buffer_native(windower::lua::state s)
+    {
+        auto& state = get_state(s);
+        for (auto& context : state.contexts)
+        {
+            context.buffer.release();
+        }
+        return 0;
+    }
+
+    // create(class, resource_registry, resource_name_registry,
+    //        resource_safe_registry, class_serializer_registry,
+    //        class_deserializer_registry)
+    static int create_native(windower::lua::state s)
+    {
+        using namespace windower;
+
+        lua::stack_guard guard{s};
+
+        lua::create<serializer_state>(guard);
+        auto const state = lua::absolute(guard, -1);
+
+        auto const push_function = [&](auto function) {
+            lua::copy(guard, state);
+            for (std::size_t i = 1; i <= registry_count; ++i)
+            {
+                lua::copy(guard, gsl::narrow_cast<int>(i));
+            }
+            lua::push(guard, function, registry_count + 1);
+        };
+
+        push_function(serialize_native);
+        push_function(deserialize_native);
+        push_function(reserve_buffer_native);
+        push_function(clear_buffer_native);
+        lua::remove(guard, state);
+
+        return guard.release();
+    }
+}
+
 int windower::load_serializer_module(lua::state s)
 {
     lua::stack_guard guard{s};
 
     lua::load(guard, lua_serializer_source, u8"core.serializer");
-    lua::call(guard, 0);
+    lua::push(guard, create_native);
+    lua::call(guard, 1);
 
     return guard.release();
 }
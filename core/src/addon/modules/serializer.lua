@@ -18,6 +18,11 @@ ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
 OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 ]]
 
+-- LuaFormatter off
+local -- params
+    create_native = ...
+-- LuaFormatter on
+
 local bit = require('bit')
 local debug = require('debug')
 local ffi = require('ffi')
@@ -44,127 +49,13 @@ local jit = require('jit')
 ---@field move fun(...)
 local table = require('table')
 
-local getmetatable = getmetatable
-local pairs = pairs
-local setmetatable = setmetatable
+local tonumber = tonumber
 local type = type
 
-local debug_getinfo = debug.getinfo
-local debug_getupvalue = debug.getupvalue
 local ffi_cast = ffi.cast
-local ffi_copy = ffi.copy
-local ffi_new = ffi.new
-local ffi_string = ffi.string
-local string_dump = string.dump
-local table_insert = table.insert
-
-local seen_length_key = {}
-
-local buf_pos = 0
-local buf_size = -1
-local buf = nil
-local writable_buf = nil
-local writable_buf_size = nil
-local serialize_upvalues = false
-
-local uint8_t_array = ffi.typeof('uint8_t[?]')
-local uint8_t_ptr = ffi.typeof('uint8_t*')
-local int16_t_ref = ffi.typeof('int16_t[1]')
-local int32_t_ref = ffi.typeof('int32_t[1]')
-local double_ref = ffi.typeof('double[1]')
-
-local function buffer_prereserve(min_size)
-    if buf_size < min_size then
-        buf_size = min_size
-        buf = uint8_t_array(buf_size)
-    end
-end
-
-local function buffer_clear()
-    buf_size = -1
-    buf = nil
-    writable_buf = nil
-    writable_buf_size = nil
-end
-
-local function buffer_make_buffer(size)
-    if writable_buf then
-        buf = writable_buf
-        buf_size = writable_buf_size
-        writable_buf = nil
-        writable_buf_size = nil
-    end
-    buf_pos = 0
-    buffer_prereserve(size)
-end
-
-local function buffer_new_reader(str)
-    local size = #str
-    buffer_make_buffer(size)
-    ffi_copy(buf, str, size)
-end
-
-local function buffer_new_data_reader(data, size)
-    writable_buf = buf
-    writable_buf_size = buf_size
-    buf_pos = 0
-    buf_size = size
-    buf = ffi_cast(uint8_t_ptr, data)
-end
-
-local function buffer_reserve(additional_size)
-    while buf_pos + additional_size > buf_size do
-        buf_size = buf_size * 2
-        local oldbuf = buf
-        buf = uint8_t_array(buf_size)
-        ffi_copy(buf, oldbuf, buf_pos)
-    end
-end
 
-local function buffer_write_byte(value)
-    buffer_reserve(1)
-    buf[buf_pos] = value
-    buf_pos = buf_pos + 1
-end
-
-local function buffer_write_string(value)
-    local size = #value
-    buffer_reserve(size)
-    ffi_copy(buf + buf_pos, value, size)
-    buf_pos = buf_pos + size
-end
-
-local function buffer_write_data(ct, size, ...)
-    buffer_reserve(size)
-    ffi_copy(buf + buf_pos, ffi_new(ct, ...), size)
-    buf_pos = buf_pos + size
-end
-
-local function buffer_ensure(size)
-    if buf_pos + size > buf_size then error('malformed serialized data') end
-end
-
-local function buffer_read_byte()
-    buffer_ensure(1)
-    local x = buf[buf_pos]
-    buf_pos = buf_pos + 1
-    return x
-end
-
-local function buffer_read_string(size)
-    buffer_ensure(size)
-    local x = ffi_string(buf + buf_pos, size)
-    buf_pos = buf_pos + size
-    return x
-end
-
-local function buffer_read_data(ct, size)
-    buffer_ensure(size)
-    local x = ffi_new(ct)
-    ffi_copy(x, buf + buf_pos, size)
-    buf_pos = buf_pos + size
-    return x
-end
+local uint8_t_ptr = ffi.typeof('uint8_t*')
+local intptr_t = ffi.typeof('intptr_t')
 
 local resource_registry = {}
 local resource_name_registry = {}
@@ -173,263 +64,30 @@ local resource_safe_registry = {}
 local class_serializer_registry = {}
 local class_deserializer_registry = {}
 
-local serialize_value
-
-local function write_number(value, seen)
-    if (value + 2 ^ 52) - 2 ^ 52 == value and value >= -2147483648 and value <=
-        2147483647 then
-        if value >= -27 and value <= 100 then
-            -- small int
-            buffer_write_byte(value + 27)
-        elseif value >= -32768 and value <= 32767 then
-            -- int16_t
-            buffer_write_byte(250)
-            buffer_write_data(int16_t_ref, 2, value)
-        else
-            -- int13_t
-            buffer_write_byte(245)
-            buffer_write_data(int32_t_ref, 4, value)
-        end
-    else
-        -- double
-        buffer_write_byte(246)
-        buffer_write_data(double_ref, 8, value)
-    end
-end
-
-local function write_string(value, seen)
-    local size = #value
-    if size <= 31 then
-        -- small string
-        buffer_write_byte(size + 192)
-    else
-        -- large string
-        buffer_write_byte(244)
-        write_number(size - 58)
-    end
-    buffer_write_string(value)
-end
-
-local function write_nil(value, seen) buffer_write_byte(247) end
-
-local function write_boolean(value, seen) buffer_write_byte(value and 249 or 248) end
-
-local function write_table(value, seen)
-    local class_name = class(value)
-    if class_name then
-        buffer_write_byte(242)
-        serialize_value(class_name, seen)
-        local serializer = class_serializer_registry[class_name]
-        value = serializer(value)
-    else
-        buffer_write_byte(240)
-    end
-    local len = #value
-    write_number(len, seen)
-    for i = 1, len do serialize_value(value[i], seen) end
-    for k, v in pairs(value) do
-        if type(k) ~= 'number' or (k + 2 ^ 52) - 2 ^ 52 ~= k or k > len or k < 1 then
-            serialize_value(k, seen)
-            serialize_value(v, seen)
-        end
-    end
-    write_nil(nil, seen)
-end
-
-local function write_function(value, seen)
-    if serialize_upvalues then
-        local info = debug_getinfo(value, 'u')
-        if info.nups ~= 0 then
-            buffer_write_byte(252)
-            write_string(string_dump(value))
-            write_number(info.nups)
-            for i = 1, info.nups do
-                local _, upvalue = debug_getupvalue(value, i)
-                if resource_safe_registry[upvalue] == false then
-                    error('attempt to serialize an unsafe upvalue')
-                end
-                serialize_value(upvalue, seen)
-            end
-            return
-        end
-    end
-    buffer_write_byte(251)
-    write_string(string_dump(value))
-end
-
-local types = {
-    ['number'] = write_number,
-    ['string'] = write_string,
-    ['table'] = write_table,
-    ['boolean'] = write_boolean,
-    ['nil'] = write_nil,
-    ['function'] = write_function
-}
-
-serialize_value = function(value, seen)
-    if seen[value] then
-        local ref = seen[value]
-        if ref <= 63 then
-            -- small reference
-            buffer_write_byte(ref + 127)
-        else
-            -- large reference
-            buffer_write_byte(243)
-            write_number(ref - 91, seen)
-        end
-        return
-    end
-    local t = type(value)
-    if t ~= 'number' and t ~= 'boolean' and t ~= 'nil' then
-        local next = seen[seen_length_key] + 1
-        seen[value] = next
-        seen[seen_length_key] = next
-    end
-    if resource_name_registry[value] then
-        local name = resource_name_registry[value]
-        local size = #name
-        if size < 16 then
-            -- small resource
-            buffer_write_byte(size + 224)
-            buffer_write_string(name)
-        else
-            -- large resource
-            buffer_write_byte(241)
-            write_string(name, seen)
-        end
-        return
-    end
-    (types[t] or error('cannot serialize type ' .. t))(value, seen)
-end
-
-local function serialize_impl(value)
-    buffer_make_buffer(4096)
-    local seen = {[seen_length_key] = 0}
-    serialize_value(value, seen)
-end
-
-local function add_to_seen(value, seen)
-    table_insert(seen, value)
-    return value
-end
-
-local function reserve_seen(seen)
-    table_insert(seen, 0)
-    return #seen
-end
-
-local function deserialize_value(seen)
-    local t = buffer_read_byte()
-    if t < 128 then
-        -- small int
-        return t - 27
-    elseif t < 192 then
-        -- small reference
-        return seen[t - 127]
-    elseif t < 224 then
-        -- small string
-        return add_to_seen(buffer_read_string(t - 192), seen)
-    elseif t < 240 then
-        -- small resource
-        return add_to_seen(resource_registry[buffer_read_string(t - 224)], seen)
-    elseif t == 240 then
-        -- table
-        local v = add_to_seen({}, seen)
-        local len = deserialize_value(seen)
-        for i = 1, len do v[i] = deserialize_value(seen) end
-        local key = deserialize_value(seen)
-        while key ~= nil do
-            v[key] = deserialize_value(seen)
-            key = deserialize_value(seen)
-        end
-        return v
-    elseif t == 241 then
-        -- large resource
-        local idx = reserve_seen(seen)
-        local value = resource_registry[deserialize_value(seen)]
-        seen[idx] = value
-        return value
-    elseif t == 242 then
-        -- instance
-        local instance = add_to_seen({}, seen)
-        local class_name = deserialize_value(seen)
-        local deserializer = class_deserializer_registry[class_name]
-        local len = deserialize_value(seen)
-        for i = 1, len do instance[i] = deserialize_value(seen) end
-        local key = deserialize_value(seen)
-        while key ~= nil do
-            instance[key] = deserialize_value(seen)
-            key = deserialize_value(seen)
-        end
-        return deserializer(instance, class)
-    elseif t == 243 then
-        -- large reference
-        return seen[deserialize_value(seen) + 91]
-    elseif t == 244 then
-        -- large string
-        local size = deserialize_value(seen) + 58
-        local value = buffer_read_string(size)
-        return add_to_seen(value, seen)
-    elseif t == 245 then
-        -- int32_t
-        return buffer_read_data(int32_t_ref, 4)[0]
-    elseif t == 246 then
-        -- double
-        return buffer_read_data(double_ref, 8)[0]
-    elseif t == 247 then
-        -- nil
-        return nil
-    elseif t == 248 then
-        -- false
-        return false
-    elseif t == 249 then
-        -- true
-        return true
-    elseif t == 250 then
-        -- int16_t
-        return buffer_read_data(int16_t_ref, 2)[0]
-    elseif t == 251 then
-        -- function
-        return add_to_seen(loadstring(deserialize_value({})), seen)
-    elseif t == 252 then
-        -- function + upvalues
-        local idx = reserve_seen(seen)
-        local value = loadstring(deserialize_value({}))
-        local upvalue_count = deserialize_value({})
-        for i = 1, upvalue_count do
-            local upvalue = deserialize_value(seen)
-            if resource_safe_registry[upvalue] == false then
-                error('attempt to deserialize an unsafe upvalue')
-            end
-            debug.setupvalue(value, i, upvalue)
-        end
-        seen[idx] = value
-        return value
-    else
-        error('unsupported serialized type ' .. t)
-    end
-end
+-- The wire format is implemented natively. The registries are shared with
+-- the native side, so registrations take effect immediately.
+local serialize_native, deserialize_native, reserve_buffer, clear_buffer =
+    create_native(class, resource_registry, resource_name_registry,
+                  resource_safe_registry, class_serializer_registry,
+                  class_deserializer_registry)
 
 local serialize_buffer = function(value, preserve_upvalues)
-    serialize_upvalues = preserve_upvalues or false
-    serialize_impl(value)
-    return buf, buf_pos
+    local data, size = serialize_native(value, preserve_upvalues, false)
+    return ffi_cast(uint8_t_ptr, data), size
 end
 
 local deserialize_buffer = function(data, size, preserve_upvalues)
-    serialize_upvalues = preserve_upvalues or false
-    buffer_new_data_reader(data, size)
-    return deserialize_value({})
+    if type(data) == 'cdata' then data = tonumber(ffi_cast(intptr_t, data)) end
+    return deserialize_native(data, tonumber(size))
 end
 
 local serialize = function(value, preserve_upvalues)
-    return ffi_string(serialize_buffer(value, preserve_upvalues))
+    return serialize_native(value, preserve_upvalues, true)
 end
 
 local deserialize = function(str, preserve_upvalues)
-    serialize_upvalues = preserve_upvalues or false
-    buffer_new_reader(str)
-    return deserialize_value({})
+    if type(str) ~= 'string' then error('malformed serialized data') end
+    return deserialize_native(str)
 end
 
 local register = function(name, resource, safe)
@@ -441,6 +99,14 @@ local register = function(name, resource, safe)
         error()
     end
 
+    -- Numbers, booleans and nil are always written by value.
+    local resource_type = type(resource)
+    if resource_type == 'nil' or resource_type == 'number' or
+        resource_type == 'boolean' then
+        error('cannot register ' .. resource_type .. ' \'' .. name ..
+                  '\' as a resource')
+    end
+
     if resource_registry[name] ~= nil then
         error('\'' .. name .. '\' already registered with value ' ..
                   tostring(resource_registry[name]))
@@ -482,9 +148,6 @@ local unregister_class = function(name)
     class_deserializer_registry[name] = nil
 end
 
-local reserve_buffer = buffer_prereserve
-local clear_buffer = buffer_clear
-
 local serializer = {
     serialize_buffer = serialize_buffer,
     deserialize_buffer = deserialize_buffer,
@@ -494,8 +157,8 @@ local serializer = {
     unregister = unregister,
     register_class = register_class,
     unregister_class = unregister_class,
-    reserve_buffer = buffer_prereserve,
-    clear_buffer = buffer_clear
+    reserve_buffer = reserve_buffer,
+    clear_buffer = clear_buffer
 }
 
 -- built-ins
@@ -0,0 +1,485 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "addon/modules/store.hpp"
+
+#include "addon/error.hpp"
+#include "addon/lua.hpp"
+#include "addon/modules/store.lua.hpp"
+#include "addon/script_base.hpp"
+#include "addon/unsafe.hpp"
+
+#include <lua.hpp>
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+std::byte notify_key;
+
+enum class value_type : std::int32_t
+{
+    none    = 0,
+    boolean = 1,
+    number  = 2,
+    string  = 3,
+    blob    = 4,
+    record  = 5,
+};
+
+// The layouts of store_value, store_field and the leading members of
+// store_slot are mirrored by the FFI declarations in store.lua.
+class store_value
+{
+public:
+    value_type type   = value_type::none;
+    std::int32_t size = 0;
+    double number     = 0;
+    void const* data  = nullptr;
+};
+
+class store_field
+{
+public:
+    char8_t const* name    = nullptr;
+    std::int32_t name_size = 0;
+    store_value value;
+};
+
+static_assert(std::is_standard_layout_v<store_value>);
+static_assert(std::is_standard_layout_v<store_field>);
+
+// Stored values are never modified. Writers build a new value and swap it
+// into the slot, so readers that pinned the previous one keep a consistent
+// copy for as long as they hold on to it.
+class stored_value
+{
+public:
+    store_value value;
+    std::u8string bytes;
+    std::vector<store_field> fields;
+};
+
+// Slots are never removed, so their addresses can be cached by every
+// interpreter. Deleting a key only clears its value.
+class store_slot
+{
+public:
+    double version           = 0;
+    store_value const* value = nullptr;
+    std::shared_ptr<stored_value const> current;
+};
+
+class pinned_value
+{
+public:
+    store_value const* value = nullptr;
+    std::shared_ptr<stored_value const> owner;
+};
+
+class subscription
+{
+public:
+    std::u8string prefix;
+    std::weak_ptr<windower::lua::state> owner;
+};
+
+std::map<std::u8string, store_slot, std::less<>> slots;
+std::vector<subscription> subscriptions;
+
+store_slot& get_slot(std::u8string_view key)
+{
+    auto it = slots.find(key);
+    if (it == slots.end())
+    {
+        it = slots.emplace(key, store_slot{}).first;
+    }
+    return it->second;
+}
+
+std::u8string_view get_key(windower::lua::state s, int index)
+{
+    auto const key = windower::lua::get<std::u8string_view>(s, index);
+    if (key.empty())
+    {
+        throw windower::lua::error{"store key cannot be empty"};
+    }
+    return key;
+}
+
+bool matches(std::u8string_view prefix, std::u8string_view key) noexcept
+{
+    return prefix.empty() || key == prefix ||
+           (key.starts_with(prefix) && key[prefix.size()] == u8'.');
+}
+
+bool same_owner(
+    std::weak_ptr<windower::lua::state> const& lhs,
+    std::weak_ptr<windower::lua::state> const& rhs) noexcept
+{
+    return !lhs.owner_before(rhs) && !rhs.owner_before(lhs);
+}
+
+void set_bytes(stored_value& result, value_type type, std::u8string_view bytes)
+{
+    result.bytes      = bytes;
+    result.value.type = type;
+    result.value.size = gsl::narrow<std::int32_t>(result.bytes.size());
+    result.value.data = result.bytes.data();
+}
+
+void read_scalar(
+    windower::lua::state s, int index, store_value& value,
+    std::u8string_view& bytes)
+{
+    using namespace windower;
+
+    switch (lua::typeof(s, index))
+    {
+    case lua::type::boolean:
+        value.type   = value_type::boolean;
+        value.number = lua::get<bool>(s, index) ? 1 : 0;
+        break;
+    case lua::type::number:
+        value.type   = value_type::number;
+        value.number = lua::get<double>(s, index);
+        break;
+    case lua::type::string:
+        value.type = value_type::string;
+        bytes      = lua::get<std::u8string_view>(s, index);
+        break;
+    default: throw lua::error{"unsupported store record field type"};
+    }
+}
+
+// Records are flat tables with string keys and boolean, number or string
+// values. Field names and string values are packed into a single buffer
+// owned by the stored value.
+void read_record(windower::lua::state s, int index, stored_value& result)
+{
+    using namespace windower;
+
+    class pending_field
+    {
+    public:
+        std::u8string_view name;
+        std::u8string_view bytes;
+        store_value value;
+    };
+
+    std::vector<pending_field> pending;
+    auto total = std::size_t{};
+
+    lua::stack_guard guard{s};
+    lua::push(guard, lua::nil);
+    while (lua::next(guard, index))
+    {
+        if (lua::typeof(guard, -2) != lua::type::string)
+        {
+            throw lua::error{"store record field names must be strings"};
+        }
+        auto& field = pending.emplace_back();
+        field.name  = lua::get<std::u8string_view>(guard, -2);
+        read_scalar(s, lua::absolute(guard, -1), field.value, field.bytes);
+        total += field.name.size() + field.bytes.size();
+        lua::pop(guard);
+    }
+
+    result.bytes.reserve(total);
+    result.fields.resize(pending.size());
+    for (std::size_t i = 0; i < pending.size(); ++i)
+    {
+        result.bytes.append(pending[i].name);
+        result.bytes.append(pending[i].bytes);
+    }
+
+    auto position = result.bytes.data();
+    for (std::size_t i = 0; i < pending.size(); ++i)
+    {
+        auto const& source = pending[i];
+        auto& field        = result.fields[i];
+        field.name         = position;
+        field.name_size    = gsl::narrow<std::int32_t>(source.name.size());
+        position += source.name.size();
+        field.value = source.value;
+        if (field.value.type == value_type::string)
+        {
+            field.value.size = gsl::narrow<std::int32_t>(source.bytes.size());
+            field.value.data = position;
+            position += source.bytes.size();
+        }
+    }
+
+    result.value.type = value_type::record;
+    result.value.size = gsl::narrow<std::int32_t>(result.fields.size());
+    result.value.data = result.fields.data();
+}
+
+std::shared_ptr<stored_value const>
+make_value(windower::lua::state s, int index)
+{
+    using namespace windower;
+
+    auto result = std::make_shared<stored_value>();
+    switch (lua::typeof(s, index))
+    {
+    case lua::type::none:
+    case lua::type::nil: return nullptr;
+    case lua::type::table: read_record(s, index, *result); break;
+    case lua::type::boolean:
+    case lua::type::number:
+    case lua::type::string:
+    {
+        auto bytes = std::u8string_view{};
+        read_scalar(s, index, result->value, bytes);
+        if (result->value.type == value_type::string)
+        {
+            set_bytes(*result, value_type::string, bytes);
+        }
+        break;
+    }
+    default: throw lua::error{"unsupported store value type"};
+    }
+    return result;
+}
+
+// Swaps the new value into the key's slot and notifies every subscribed
+// interpreter. Returns the new version followed by the matching prefixes
+// the calling interpreter subscribed to itself, which the caller dispatches
+// without re-entering its own interpreter.
+int update(
+    windower::lua::state s, std::u8string_view key,
+    std::shared_ptr<stored_value const> value)
+{
+    using namespace windower;
+
+    auto& slot   = get_slot(key);
+    slot.current = std::move(value);
+    slot.value   = slot.current ? &slot.current->value : nullptr;
+    slot.version += 1;
+
+    auto const version = slot.version;
+    auto const self    = script_base::get_script_base(s)->root_handle();
+
+    std::erase_if(subscriptions, [](auto const& entry) {
+        return entry.owner.expired();
+    });
+
+    lua::stack_guard guard{s};
+    lua::push(guard, version);
+    auto const count = subscriptions.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto const& entry = subscriptions[i];
+        if (!matches(entry.prefix, key))
+        {
+            continue;
+        }
+        if (same_owner(entry.owner, self))
+        {
+            lua::reserve(guard, 1);
+            lua::push(guard, entry.prefix);
+            continue;
+        }
+
+        auto const state_ptr = entry.owner.lock();
+        if (!state_ptr)
+        {
+            continue;
+        }
+
+        lua::stack_guard remote{*state_ptr};
+        lua::push(remote, &notify_key);
+        lua::raw_get(remote, lua::registry);
+        if (lua::typeof(remote, -1) != lua::type::function)
+        {
+            continue;
+        }
+        lua::push(remote, entry.prefix);
+        lua::push(remote, key);
+        lua::push(remote, version);
+        try
+        {
+            lua::call(remote, 3, 0);
+        }
+        catch (lua::error const&)
+        {
+        }
+    }
+    return guard.release();
+}
+
+}
+
+extern "C"
+{
+    static int get_slot_native(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto& slot = get_slot(get_key(s, 1));
+
+        lua::stack_guard guard{s};
+        lua::push(guard, static_cast<void*>(&slot));
+        return guard.release();
+    }
+
+    static int set_native(windower::lua::state s)
+    {
+        auto const key = get_key(s, 1);
+        return update(s, key, make_value(s, 2));
+    }
+
+    static int set_blob_native(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto const key = get_key(s, 1);
+
+        auto bytes = std::u8string_view{};
+        if (lua::typeof(s, 2) == lua::type::string)
+        {
+            bytes = lua::get<std::u8string_view>(s, 2);
+        }
+        else
+        {
+            auto const data =
+                std::bit_cast<char8_t const*>(lua::get<std::uintptr_t>(s, 2));
+            bytes = {data, lua::get<std::size_t>(s, 3)};
+        }
+
+        auto result = std::make_shared<stored_value>();
+        set_bytes(*result, value_type::blob, bytes);
+        return update(s, key, std::move(result));
+    }
+
+    static int keys_native(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto const prefix = lua::get<std::u8string_view>(s, 1);
+
+        std::vector<std::u8string_view> names;
+        for (auto it = slots.lower_bound(prefix); it != slots.end(); ++it)
+        {
+            auto key = std::u8string_view{it->first};
+            if (!prefix.empty())
+            {
+                if (!key.starts_with(prefix))
+                {
+                    break;
+                }
+                if (key.size() <= prefix.size() ||
+                    key[prefix.size()] != u8'.')
+                {
+                    continue;
+                }
+                key.remove_prefix(prefix.size() + 1);
+            }
+            if (it->second.current)
+            {
+                names.push_back(key.substr(0, key.find(u8'.')));
+            }
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+
+        lua::stack_guard guard{s};
+        lua::create_table(guard, names.size());
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            lua::push(guard, names[i]);
+            lua::raw_set(guard, -2, gsl::narrow<int>(i + 1));
+        }
+        return guard.release();
+    }
+
+    static int subscribe_native(windower::lua::state s)
+    {
+        using namespace windower;
+
+        auto const prefix = lua::get<std::u8string_view>(s, 1);
+        auto const self   = script_base::get_script_base(s)->root_handle();
+
+        auto const it = std::find_if(
+            subscriptions.begin(), subscriptions.end(), [&](auto const& entry) {
+                return entry.prefix == prefix && same_owner(entry.owner, self);
+            });
+        if (it == subscriptions.end())
+        {
+            subscriptions.push_back({std::u8string{prefix}, self});
+        }
+        return 0;
+    }
+
+    static void const* acquire_native(void const* slot_ptr)
+    {
+        auto const& slot = *static_cast<store_slot const*>(slot_ptr);
+        if (!slot.current)
+        {
+            return nullptr;
+        }
+        return new pinned_value{slot.value, slot.current};
+    }
+
+    static void release_native(void const* ptr) noexcept
+    {
+        auto const deleter = std::unique_ptr<pinned_value const>{
+            static_cast<pinned_value const*>(ptr)};
+    }
+}
+
+int windower::load_store_module(lua::state s)
+{
+    lua::stack_guard guard{s};
+
+    lua::load(guard, lua_store_source, u8"core.store");
+
+    lua::copy(guard, lua::registry);
+    lua::push(guard, &notify_key);
+    lua::push(guard, get_slot_native);
+    lua::push(guard, set_native);
+    lua::push(guard, set_blob_native);
+    lua::push(guard, keys_native);
+    lua::push(guard, subscribe_native);
+    lua::push(guard, &acquire_native);
+    lua::push(guard, &release_native);
+
+    lua::call(guard, 9);
+
+    return guard.release();
+}
@@ -0,0 +1,253 @@
+--[[
+Copyright © Windower Dev Team
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"),to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+]]
+
+-- LuaFormatter off
+local -- params
+    registry,
+    notify_key,
+    get_slot_native,
+    set_native,
+    set_blob_native,
+    keys_native,
+    subscribe_native,
+    acquire_native_ptr,
+    release_native_ptr = ...
+-- LuaFormatter on
+
+local ffi = require('ffi')
+
+local event = require('core.event')
+local serializer = require('core.serializer')
+
+---@type __windower_coroutinelib
+local coroutine = coroutine
+
+local error = error
+local rawset = rawset
+local select = select
+local tonumber = tonumber
+local type = type
+
+local ffi_cast = ffi.cast
+local ffi_gc = ffi.gc
+local ffi_metatype = ffi.metatype
+local ffi_string = ffi.string
+local ffi_typeof = ffi.typeof
+
+local schedule = coroutine.schedule
+
+local none_type = 0
+local boolean_type = 1
+local number_type = 2
+local string_type = 3
+local blob_type = 4
+local record_type = 5
+
+local value_t = ffi_typeof([[struct {
+    int32_t type;
+    int32_t size;
+    double number;
+    void const* data;
+}]])
+
+local field_t = ffi_typeof([[struct {
+    char const* name;
+    int32_t name_size;
+    $ value;
+}]], value_t)
+
+local slot_t = ffi_typeof([[struct {
+    double version;
+    $ const* value;
+}]], value_t)
+
+local field_ptr = ffi_typeof('$ const*', field_t)
+local slot_ptr = ffi_typeof('$ const*', slot_t)
+local intptr_t = ffi_typeof('intptr_t')
+
+local acquire_native = ffi_cast('void const*(*)(void const*)',
+                                acquire_native_ptr)
+local release_native = ffi_cast('void(*)(void const*)', release_native_ptr)
+
+local slots = {}
+
+local get_slot = function(key)
+    local slot = slots[key]
+    if slot == nil then
+        if type(key) ~= 'string' then
+            error('bad argument #1 (string expected, got ' .. type(key) .. ')',
+                  3)
+        end
+        slot = ffi_cast(slot_ptr, get_slot_native(key))
+        slots[key] = slot
+    end
+    return slot
+end
+
+local decode_scalar = function(value)
+    local value_type = value.type
+    if value_type == number_type then
+        return value.number
+    elseif value_type == boolean_type then
+        return value.number ~= 0
+    elseif value_type == string_type or value_type == blob_type then
+        return ffi_string(value.data, value.size)
+    end
+    return nil
+end
+
+local decode = function(value)
+    if value == nil then return nil end
+    if value.type ~= record_type then return decode_scalar(value) end
+    local fields = ffi_cast(field_ptr, value.data)
+    local result = {}
+    for i = 0, value.size - 1 do
+        local field = fields[i]
+        result[ffi_string(field.name, field.name_size)] =
+            decode_scalar(field.value)
+    end
+    return result
+end
+
+local find_field = function(value, name)
+    if value == nil or value.type ~= record_type then return nil end
+    local fields = ffi_cast(field_ptr, value.data)
+    local length = #name
+    for i = 0, value.size - 1 do
+        local field = fields[i]
+        if field.name_size == length and
+            ffi_string(field.name, length) == name then
+            return decode_scalar(field.value)
+        end
+    end
+    return nil
+end
+
+-- A view pins the value a key held when it was taken. Its data can be read
+-- in place through view.value and stays valid until the view is collected,
+-- regardless of later writes to the key.
+local view_t = ffi_metatype(ffi_typeof('struct { $ const* value; }', value_t), {
+    __index = {
+        get = function(view) return decode(view.value) end,
+        field = function(view, name) return find_field(view.value, name) end
+    }
+})
+local view_ptr = ffi_typeof('$ const*', view_t)
+
+local dispatch
+local changed
+do
+    local events = {}
+
+    local trigger = function(e, key, version)
+        schedule(function() e:trigger(key, version) end)
+    end
+
+    dispatch = function(key, version, ...)
+        for i = 1, select('#', ...) do
+            local e = events[select(i, ...)]
+            if e ~= nil then trigger(e, key, version) end
+        end
+        return version
+    end
+
+    changed = function(prefix)
+        if prefix == nil then prefix = '' end
+        local e = events[prefix]
+        if e == nil then
+            subscribe_native(prefix)
+            e = event.new(false)
+            events[prefix] = e
+        end
+        return e:client()
+    end
+
+    rawset(registry, notify_key, function(prefix, key, version)
+        local e = events[prefix]
+        if e ~= nil then trigger(e, key, version) end
+    end)
+end
+
+local store = {}
+
+store.get = function(key) return decode(get_slot(key).value) end
+
+store.field = function(key, name)
+    return find_field(get_slot(key).value, name)
+end
+
+store.version = function(key) return get_slot(key).version end
+
+store.view = function(key)
+    local ptr = acquire_native(get_slot(key))
+    if ptr == nil then return nil end
+    return ffi_gc(ffi_cast(view_ptr, ptr), release_native)
+end
+
+store.set = function(key, value)
+    return dispatch(key, set_native(key, value))
+end
+
+store.set_blob = function(key, data, size)
+    if type(data) == 'string' then
+        return dispatch(key, set_blob_native(key, data))
+    end
+    if type(size) ~= 'number' then
+        error('bad argument #3 to \'set_blob\' (number expected, got ' ..
+                  type(size) .. ')', 2)
+    end
+    local address = tonumber(ffi_cast(intptr_t, data))
+    return dispatch(key, set_blob_native(key, address, size))
+end
+
+store.delete = function(key) return dispatch(key, set_native(key, nil)) end
+
+store.keys = function(prefix)
+    if prefix == nil then prefix = '' end
+    return keys_native(prefix)
+end
+
+store.changed = changed
+
+store.type = {
+    none = none_type,
+    boolean = boolean_type,
+    number = number_type,
+    string = string_type,
+    blob = blob_type,
+    record = record_type
+}
+
+serializer.register('__store', store, false)
+serializer.register('__store.get', store.get, false)
+serializer.register('__store.field', store.field, false)
+serializer.register('__store.version', store.version, false)
+serializer.register('__store.view', store.view, false)
+serializer.register('__store.set', store.set, false)
+serializer.register('__store.set_blob', store.set_blob, false)
+serializer.register('__store.delete', store.delete, false)
+serializer.register('__store.keys', store.keys, false)
+serializer.register('__store.changed', store.changed, false)
+
+return store
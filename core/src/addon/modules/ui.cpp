@@ -109,6 +109,32 @@ extern "C"
         ctx.bounds({x0, y0, x1, y1});
     }
 
+    void invalidate(context& ctx) { ctx.invalidate(); }
+
+    void highlight_rerecorded(context& ctx, bool enabled)
+    {
+        ctx.highlight_rerecorded(enabled);
+    }
+
+    void get_buffer_capacity(
+        context const& ctx, std::size_t* vertices, std::size_t* indices)
+    {
+        *vertices = ctx.vertex_capacity();
+        *indices  = ctx.index_capacity();
+    }
+
+    void set_buffer_capacity(
+        context& ctx, std::size_t vertices, std::size_t indices)
+    {
+        ctx.vertex_capacity(vertices);
+        ctx.index_capacity(indices);
+    }
+
+    frame_stats const* get_frame_stats(context const& ctx)
+    {
+        return &ctx.frame_stats();
+    }
+
     widget::button_state button(
         context& ctx, std::uint64_t id, char8_t const* text_data,
         std::size_t text_size, bool checked)
@@ -254,6 +280,11 @@ int load_ui_module(lua::state s)
     lua::push(guard, &ui::wrappers::end_scope);
     lua::push(guard, &ui::wrappers::set_enabled);
     lua::push(guard, &ui::wrappers::set_bounds);
+    lua::push(guard, &ui::wrappers::invalidate);
+    lua::push(guard, &ui::wrappers::highlight_rerecorded);
+    lua::push(guard, &ui::wrappers::get_buffer_capacity);
+    lua::push(guard, &ui::wrappers::set_buffer_capacity);
+    lua::push(guard, &ui::wrappers::get_frame_stats);
     lua::push(guard, &ui::wrappers::button);
     lua::push(guard, &ui::wrappers::check);
     lua::push(guard, &ui::wrappers::color_picker);
@@ -37,6 +37,11 @@ local -- params
     end_scope_ptr,
     set_enabled_ptr,
     set_bounds_ptr,
+    invalidate_ptr,
+    highlight_rerecorded_ptr,
+    get_buffer_capacity_ptr,
+    set_buffer_capacity_ptr,
+    get_frame_stats_ptr,
     button_ptr,
     check_ptr,
     color_picker_ptr,
@@ -98,6 +103,18 @@ local nine_patch_t = ffi.typeof([[struct {
     $ overdraw;
 }]], dimension_t, rectangle_t, thickness_t, thickness_t)
 
+local ring_statistics_t = ffi.typeof([[struct {
+    size_t used;
+    size_t wraps;
+    size_t stalls;
+    size_t rings;
+}]])
+
+local frame_stats_t = ffi.typeof([[struct {
+    $ vertices;
+    $ indices;
+}]], ring_statistics_t, ring_statistics_t)
+
 ---@class layer_t
 ---@field screen number
 ---@field world number
@@ -319,6 +336,21 @@ local set_enabled_t = ffi.typeof(
 local set_bounds_t = ffi.typeof(
     'void(*)($&,float,float,float,float)',
     context_t)
+local invalidate_t = ffi.typeof(
+    'void(*)($&)',
+    context_t)
+local highlight_rerecorded_t = ffi.typeof(
+    'void(*)($&,bool)',
+    context_t)
+local get_buffer_capacity_t = ffi.typeof(
+    'void(*)($ const&,size_t*,size_t*)',
+    context_t)
+local set_buffer_capacity_t = ffi.typeof(
+    'void(*)($&,size_t,size_t)',
+    context_t)
+local get_frame_stats_t = ffi.typeof(
+    '$ const*(*)($ const&)',
+    frame_stats_t, context_t)
 
 local button_t = ffi.typeof(
     '$(*)($&,uint64_t,char const*,size_t,bool)',
@@ -374,6 +406,11 @@ local begin_scope = begin_scope_t(begin_scope_ptr)
 local end_scope = end_scope_t(end_scope_ptr)
 local set_enabled = set_enabled_t(set_enabled_ptr)
 local set_bounds = set_bounds_t(set_bounds_ptr)
+local invalidate = invalidate_t(invalidate_ptr)
+local highlight_rerecorded = highlight_rerecorded_t(highlight_rerecorded_ptr)
+local get_buffer_capacity = get_buffer_capacity_t(get_buffer_capacity_ptr)
+local set_buffer_capacity = set_buffer_capacity_t(set_buffer_capacity_ptr)
+local get_frame_stats = get_frame_stats_t(get_frame_stats_ptr)
 
 local button = button_t(button_ptr)
 local check = check_t(check_ptr)
@@ -952,6 +989,50 @@ do
     end
 end
 
+-- ui.invalidate
+do
+    ui.invalidate = function()
+        invalidate(current_context or get_context())
+    end
+
+    ui.highlight_rerecorded = function(enabled)
+        highlight_rerecorded(get_context(), enabled)
+    end
+end
+
+-- ui.buffer_capacity
+do
+    local capacity = ffi.new('size_t[2]')
+
+    ui.buffer_capacity = function()
+        get_buffer_capacity(get_context(), capacity, capacity + 1)
+        return tonumber(capacity[0]), tonumber(capacity[1])
+    end
+
+    ui.set_buffer_capacity = function(vertices, indices)
+        get_buffer_capacity(get_context(), capacity, capacity + 1)
+        set_buffer_capacity(
+            get_context(), vertices or capacity[0], indices or capacity[1])
+    end
+
+    local ring_statistics = function(stats)
+        return {
+            used = tonumber(stats.used),
+            wraps = tonumber(stats.wraps),
+            stalls = tonumber(stats.stalls),
+            rings = tonumber(stats.rings),
+        }
+    end
+
+    ui.frame_stats = function()
+        local stats = get_frame_stats(get_context())
+        return {
+            vertices = ring_statistics(stats.vertices),
+            indices = ring_statistics(stats.indices),
+        }
+    end
+end
+
 ui.primitive = {}
 
 -- primitive: rectangle
@@ -31,9 +31,9 @@
 
 #include <lua.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <memory>
 #include <string>
 
 namespace
@@ -41,90 +41,53 @@ namespace
 
 extern "C"
 {
-    void delete_u8string(void const* ptr) noexcept
+    std::size_t to_wstring_native(
+        char8_t const* str, std::size_t size, wchar_t* buffer,
+        std::size_t capacity) noexcept
     {
-        auto const deleter = std::unique_ptr<std::u8string const>{
-            static_cast<std::u8string const*>(ptr)};
+        return windower::to_wstring({str, size}, {buffer, capacity});
     }
 
-    void const* u8string_data(void const* ptr) noexcept
+    std::size_t from_wstring_native(
+        wchar_t const* str, std::size_t size, char8_t* buffer,
+        std::size_t capacity) noexcept
     {
-        return static_cast<std::u8string const*>(ptr)->data();
+        return windower::to_u8string({str, size}, {buffer, capacity});
     }
 
-    std::size_t u8string_length(void const* ptr) noexcept
+    std::size_t to_sjis_string_native(
+        char8_t const* str, std::size_t size, windower::sjis_char* buffer,
+        std::size_t capacity) noexcept
     {
-        return static_cast<std::u8string const*>(ptr)->size();
+        return windower::to_sjis_string({str, size}, {buffer, capacity});
     }
 
-    void delete_wstring(void const* ptr) noexcept
+    std::size_t from_sjis_string_native(
+        windower::sjis_char const* str, std::size_t size, char8_t* buffer,
+        std::size_t capacity) noexcept
     {
-        auto const deleter = std::unique_ptr<std::wstring const>{
-            static_cast<std::wstring const*>(ptr)};
+        return windower::to_u8string(
+            windower::sjis_string_view{str, size}, {buffer, capacity});
     }
 
-    void const* wstring_data(void const* ptr) noexcept
+    std::size_t lookup_autotranslate(
+        char32_t code_point, windower::client_language language,
+        char8_t* buffer, std::size_t capacity) noexcept
     {
-        return static_cast<std::wstring const*>(ptr)->data();
+        auto const result =
+            windower::ffximain::lookup_autotranslate(code_point, language);
+        if (result.size() <= capacity)
+        {
+            std::copy(result.begin(), result.end(), buffer);
+        }
+        return result.size();
     }
 
-    std::size_t wstring_length(void const* ptr) noexcept
+    char32_t find_autotranslate(
+        char8_t const* text, std::size_t size,
+        windower::client_language language) noexcept
     {
-        return static_cast<std::wstring const*>(ptr)->size();
-    }
-
-    void delete_sjis_string(void const* ptr) noexcept
-    {
-        auto const deleter = std::unique_ptr<windower::sjis_string const>{
-            static_cast<windower::sjis_string const*>(ptr)};
-    }
-
-    void const* sjis_string_data(void const* ptr) noexcept
-    {
-        return static_cast<windower::sjis_string const*>(ptr)->data();
-    }
-
-    std::size_t sjis_string_length(void const* ptr) noexcept
-    {
-        return static_cast<windower::sjis_string const*>(ptr)->size();
-    }
-
-    void const* to_wstring_native(char8_t const* str, std::size_t size) noexcept
-    {
-        auto ptr = std::make_unique<std::wstring>();
-        *ptr     = windower::to_wstring({str, size});
-        return ptr.release();
-    }
-
-    void const*
-    from_wstring_native(wchar_t const* str, std::size_t size) noexcept
-    {
-        auto ptr = std::make_unique<std::u8string>();
-        *ptr     = windower::to_u8string({str, size});
-        return ptr.release();
-    }
-
-    void const*
-    to_sjis_string_native(char8_t const* str, std::size_t size) noexcept
-    {
-        auto ptr = std::make_unique<windower::sjis_string>();
-        *ptr     = windower::to_sjis_string({str, size});
-        return ptr.release();
-    }
-
-    void const* from_sjis_string_native(
-        windower::sjis_char const* str, size_t size) noexcept
-    {
-        auto ptr = std::make_unique<std::u8string>();
-        *ptr     = windower::to_u8string({str, size});
-        return ptr.release();
-    }
-
-    void const* lookup_autotranslate(char32_t code_point) noexcept
-    {
-        auto ptr = std::make_unique<std::u8string>();
-        *ptr     = windower::ffximain::lookup_autotranslate(code_point);
-        return ptr.release();
+        return windower::ffximain::find_autotranslate({text, size}, language);
     }
 }
 
@@ -135,21 +98,13 @@ int windower::load_unicode_module(lua::state s)
     lua::stack_guard guard{s};
 
     lua::load(guard, lua_unicode_source, u8"core.unicode");
-    lua::push(guard, &delete_u8string);
-    lua::push(guard, &u8string_data);
-    lua::push(guard, &u8string_length);
-    lua::push(guard, &delete_wstring);
-    lua::push(guard, &wstring_data);
-    lua::push(guard, &wstring_length);
-    lua::push(guard, &delete_sjis_string);
-    lua::push(guard, &sjis_string_data);
-    lua::push(guard, &sjis_string_length);
     lua::push(guard, &to_wstring_native);
     lua::push(guard, &from_wstring_native);
     lua::push(guard, &to_sjis_string_native);
     lua::push(guard, &from_sjis_string_native);
     lua::push(guard, &lookup_autotranslate);
-    lua::call(guard, 14);
+    lua::push(guard, &find_autotranslate);
+    lua::call(guard, 6);
 
     return guard.release();
 }
@@ -29,35 +29,46 @@ local string = require('string')
 local serializer = require('core.serializer')
 
 local ffi_copy = ffi.copy
-local ffi_gc = ffi.gc
 local ffi_istype = ffi.istype
 local ffi_sizeof = ffi.sizeof
 local ffi_string = ffi.string
 
 local unicode = {}
 
-local delete_u8string = ffi.new('void(*)(void const*)', (select(1, ...)))
-local u8string_data = ffi.new('void const*(*)(void const*)', (select(2, ...)))
-local u8string_length = ffi.new('size_t(*)(void const*)', (select(3, ...)))
+local to_wstring_native = ffi.new('size_t(*)(char const*, size_t, void*, size_t)', (select(1, ...)))
+local from_wstring_native = ffi.new('size_t(*)(wchar_t const*, size_t, void*, size_t)', (select(2, ...)))
 
-local delete_wstring = ffi.new('void(*)(void const*)', (select(4, ...)))
-local wstring_data = ffi.new('void const*(*)(void const*)', (select(5, ...)))
-local wstring_length = ffi.new('size_t(*)(void const*)', (select(6, ...)))
+local to_sjis_string_native = ffi.new('size_t(*)(char const*, size_t, void*, size_t)', (select(3, ...)))
+local from_sjis_string_native = ffi.new('size_t(*)(char const*, size_t, void*, size_t)', (select(4, ...)))
 
-local delete_sjis_string = ffi.new('void(*)(void const*)', (select(7, ...)))
-local sjis_string_data = ffi.new('void const*(*)(void const*)', (select(8, ...)))
-local sjis_string_length = ffi.new('size_t(*)(void const*)', (select(9, ...)))
+local lookup_autotranslate = ffi.new('size_t(*)(uint32_t, uint8_t, void*, size_t)', (select(5, ...)))
+local find_autotranslate = ffi.new('uint32_t(*)(char const*, size_t, uint8_t)', (select(6, ...)))
 
-local to_wstring_native = ffi.new('void const*(*)(char const*, size_t)', (select(10, ...)))
-local from_wstring_native = ffi.new('void const*(*)(wchar_t const*, size_t)', (select(11, ...)))
+local byte_array = ffi.typeof('uint8_t[?]')
+local wchar_array = ffi.typeof('wchar_t[?]')
+local wchar_ptr = ffi.typeof('wchar_t*')
 
-local to_sjis_string_native = ffi.new('void const*(*)(char const*, size_t)', (select(12, ...)))
-local from_sjis_string_native = ffi.new('void const*(*)(char const*, size_t)', (select(13, ...)))
+-- Conversions are written into this scratch buffer and copied out from
+-- there, so converting a string allocates nothing on the native side. Each
+-- interpreter loads its own copy of this module, and with it its own buffer.
+local scratch_size = 0x200
+local scratch = byte_array(scratch_size)
 
-local lookup_autotranslate = ffi.new('void const*(*)(uint32_t)', (select(14, ...)))
+local grow_scratch = function(size)
+    while scratch_size < size do
+        scratch_size = scratch_size * 2
+    end
+    scratch = byte_array(scratch_size)
+end
 
-local wchar_array = ffi.typeof('wchar_t[?]')
-local wchar_ptr = ffi.typeof('wchar_t*')
+local convert = function(native, unit_size, source, source_length)
+    local length = native(source, source_length, scratch, scratch_size / unit_size)
+    if length * unit_size > scratch_size then
+        grow_scratch(length * unit_size)
+        length = native(source, source_length, scratch, scratch_size / unit_size)
+    end
+    return length
+end
 
 unicode.symbol = {
     element = {
@@ -79,12 +90,9 @@ unicode.to_utf16 = function(utf8_string)
                   type(utf8_string) .. ')', 2)
     end
 
-    local utf16_ptr = ffi_gc(to_wstring_native(utf8_string, #utf8_string),
-                             delete_wstring)
-    local utf16_length = wstring_length(utf16_ptr)
+    local utf16_length = convert(to_wstring_native, 2, utf8_string, #utf8_string)
     local result = wchar_array(utf16_length + 1)
-    ffi_copy(result, wstring_data(utf16_ptr), utf16_length * 2)
-    delete_wstring(ffi_gc(utf16_ptr, nil))
+    ffi_copy(result, scratch, utf16_length * 2)
     return result, utf16_length
 end
 
@@ -111,12 +119,8 @@ unicode.from_utf16 = function(utf16_string, utf16_length)
                   type(utf16_length) .. ')', 2)
     end
 
-    local utf8_ptr = ffi_gc(from_wstring_native(utf16_string, utf16_length),
-                            delete_u8string)
-    local utf8_length = u8string_length(utf8_ptr)
-    local result = ffi_string(u8string_data(utf8_ptr), utf8_length)
-    delete_u8string(ffi_gc(utf8_ptr, nil))
-    return result, utf8_length
+    local utf8_length = convert(from_wstring_native, 1, utf16_string, utf16_length)
+    return ffi_string(scratch, utf8_length), utf8_length
 end
 
 unicode.to_shift_jis = function(utf8_string)
@@ -125,12 +129,8 @@ unicode.to_shift_jis = function(utf8_string)
                   type(utf8_string) .. ')', 2)
     end
 
-    local shift_jis_ptr = ffi_gc(to_sjis_string_native(utf8_string, #utf8_string),
-                                 delete_u8string)
-    local shift_jis_length = u8string_length(shift_jis_ptr)
-    local result = ffi_string(u8string_data(shift_jis_ptr), shift_jis_length)
-    delete_u8string(ffi_gc(shift_jis_ptr, nil))
-    return result, shift_jis_length
+    local shift_jis_length = convert(to_sjis_string_native, 1, utf8_string, #utf8_string)
+    return ffi_string(scratch, shift_jis_length), shift_jis_length
 end
 
 unicode.from_shift_jis = function(shift_jis_string)
@@ -139,13 +139,8 @@ unicode.from_shift_jis = function(shift_jis_string)
                   type(shift_jis_string) .. ')', 2)
     end
 
-    local utf8_ptr = ffi_gc(from_sjis_string_native(shift_jis_string,
-                                                  #shift_jis_string),
-                            delete_u8string)
-    local utf8_length = u8string_length(utf8_ptr)
-    local result = ffi_string(u8string_data(utf8_ptr), utf8_length)
-    delete_u8string(ffi_gc(utf8_ptr, nil))
-    return result, utf8_length
+    local utf8_length = convert(from_sjis_string_native, 1, shift_jis_string, #shift_jis_string)
+    return ffi_string(scratch, utf8_length), utf8_length
 end
 
 unicode.length = function(string)
@@ -164,6 +159,60 @@ unicode.length = function(string)
     end
 end
 
+do
+    local languages = {japanese = 1, english = 2}
+
+    local get_language = function(language, name, index)
+        if language == nil then
+            return languages.english
+        end
+
+        local result = languages[language]
+        if result == nil then
+            error('bad argument #' .. index .. ' to \'' .. name ..
+                      '\' (\'english\' or \'japanese\' expected, got ' ..
+                      tostring(language) .. ')', 3)
+        end
+        return result
+    end
+
+    unicode.lookup_autotranslate = function(code_point, language)
+        if type(code_point) ~= 'number' then
+            error(
+                'bad argument #1 to \'lookup_autotranslate\' (number expected, got ' ..
+                    type(code_point) .. ')', 2)
+        end
+
+        language = get_language(language, 'lookup_autotranslate', 2)
+        local length = lookup_autotranslate(code_point, language, scratch, scratch_size)
+        if length > scratch_size then
+            grow_scratch(length)
+            length = lookup_autotranslate(code_point, language, scratch, scratch_size)
+        end
+        if length == 0 then
+            return nil
+        end
+        return ffi_string(scratch, length)
+    end
+
+    -- Also returns nil until the client's entries have been indexed, which
+    -- takes a few seconds after the client loads its dictionary.
+    unicode.find_autotranslate = function(text, language)
+        if type(text) ~= 'string' then
+            error(
+                'bad argument #1 to \'find_autotranslate\' (string expected, got ' ..
+                    type(text) .. ')', 2)
+        end
+
+        language = get_language(language, 'find_autotranslate', 2)
+        local code_point = find_autotranslate(text, #text, language)
+        if code_point == 0 then
+            return nil
+        end
+        return code_point
+    end
+end
+
 do
     local bit_band = bit.band
     local bit_bor = bit.bor
@@ -208,12 +257,9 @@ do
                                            06),
                                        bit_band(string_byte(utf8, 4), 0x3F))
             if code_point >= 0xF0000 and code_point <= 0x10FFFF then
-                local ptr = ffi_gc(lookup_autotranslate(code_point),
-                                   delete_u8string)
-                local length = u8string_length(ptr)
-                if length > 0 then
-                    return prefix .. ffi_string(u8string_data(ptr), length) ..
-                               postfix
+                local text = unicode.lookup_autotranslate(code_point)
+                if text then
+                    return prefix .. text .. postfix
                 end
             end
             return utf8
@@ -227,6 +273,9 @@ serializer.register('__unicode.from_utf16', unicode.from_utf16)
 serializer.register('__unicode.to_shift_jis', unicode.to_shift_jis)
 serializer.register('__unicode.from_shift_jis', unicode.from_shift_jis)
 serializer.register('__unicode.length', unicode.length)
+serializer.register('__unicode.lookup_autotranslate',
+                    unicode.lookup_autotranslate)
+serializer.register('__unicode.find_autotranslate', unicode.find_autotranslate)
 serializer.register('__unicode.expand_autotranslate',
                     unicode.expand_autotranslate)
 serializer.register('__unicode.symbol', unicode.symbol, false)
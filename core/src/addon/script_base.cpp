@@ -38,6 +38,7 @@
 #include "addon/modules/pin.hpp"
 #include "addon/modules/scanner.hpp"
 #include "addon/modules/serializer.hpp"
+#include "addon/modules/store.hpp"
 #include "addon/modules/ui.hpp"
 #include "addon/modules/unicode.hpp"
 #include "addon/modules/windower.hpp"
@@ -456,6 +457,7 @@ void initialize(
     lua::preload(interpreter, u8"core.pin", load_pin_module);
     lua::preload(interpreter, u8"core.scanner", load_scanner_module);
     lua::preload(interpreter, u8"core.serializer", load_serializer_module);
+    lua::preload(interpreter, u8"core.store", load_store_module);
     lua::preload(interpreter, u8"core.ui", load_ui_module);
     lua::preload(interpreter, u8"core.unicode", load_unicode_module);
     lua::preload(interpreter, u8"core.windower", load_windower_module);
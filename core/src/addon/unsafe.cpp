@@ -27,9 +27,11 @@
 #include "addon/error.hpp"
 #include "addon/lua.hpp"
 
-#include <windows.h>
+#if defined(_WIN32)
+#    include <windows.h>
 
-#include <shlwapi.h>
+#    include <shlwapi.h>
+#endif
 
 #include <gsl/gsl>
 #include <lua.hpp>
@@ -79,7 +81,7 @@ extern "C"
 
     static void const* get_target(::lua_State* s, int index) noexcept(false)
     {
-        return ::lua_tocfunction(s, index);
+        return std::bit_cast<void const*>(::lua_tocfunction(s, index));
     }
 
     static void push_source_string(::lua_State* s, int index) noexcept(false)
@@ -87,12 +89,13 @@ extern "C"
         static constexpr auto ptr_nibbles =
             (sizeof(std::intptr_t) * CHAR_BIT + 3) / 4;
 
-        auto ptr         = ::get_target(s, index);
+        auto ptr   = ::get_target(s, index);
+        auto count = 0;
+#if defined(_WIN32)
         auto module      = ::HMODULE{};
         auto const flags = ::DWORD{
             GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
             GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT};
-        auto count = 0;
         auto utf8buffer =
             std::array<char, (MAX_PATH - 4) * 4 + 3 + ptr_nibbles>{};
         if (::GetModuleHandleExW(flags, std::bit_cast<::LPCWSTR>(ptr), &module))
@@ -116,6 +119,10 @@ extern "C"
                 }
             }
         }
+#else
+        // Only the address is shown outside Windows.
+        auto utf8buffer = std::array<char, 2 + ptr_nibbles>{};
+#endif
         gsl::at(utf8buffer, count)     = u8'0';
         gsl::at(utf8buffer, count + 1) = u8'x';
         for (auto i = 0; i != ptr_nibbles; ++i)
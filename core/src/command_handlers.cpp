@@ -30,7 +30,14 @@
 #include "unicode.hpp"
 #include "utility.hpp"
 
+#include <gsl/gsl>
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
 #include <limits>
+#include <string>
+#include <string_view>
 
 namespace
 {
@@ -72,6 +79,69 @@ void check_args(
     check_args(command_name, args, expected, expected);
 }
 
+// Windows opens a device instead of a file for these names, whatever the
+// case, and even with an extension or trailing spaces.
+bool is_reserved_device_name(std::u8string_view name) noexcept
+{
+    auto stem = name.substr(0, name.find(u8'.'));
+    while (!stem.empty() && stem.back() == u8' ')
+    {
+        stem.remove_suffix(1);
+    }
+
+    if (stem.size() < 3 || stem.size() > 4)
+    {
+        return false;
+    }
+
+    std::array<char8_t, 4> buffer{};
+    for (std::size_t i = 0; i < stem.size(); ++i)
+    {
+        auto const c = gsl::at(stem, i);
+        gsl::at(buffer, i) = c >= u8'A' && c <= u8'Z'
+                                 ? static_cast<char8_t>(c - u8'A' + u8'a')
+                                 : c;
+    }
+    auto const lower = std::u8string_view{buffer.data(), stem.size()};
+
+    if (lower == u8"con" || lower == u8"prn" || lower == u8"aux" ||
+        lower == u8"nul")
+    {
+        return true;
+    }
+    return lower.size() == 4 &&
+           (lower.starts_with(u8"com") || lower.starts_with(u8"lpt")) &&
+           lower[3] >= u8'1' && lower[3] <= u8'9';
+}
+
+// Captures are written to the user's captures directory, so the name has
+// to be a single plain file name that can't step out of it or name a
+// device.
+std::filesystem::path capture_path(std::u8string const& name)
+{
+    namespace fs = std::filesystem;
+
+    auto const name_path = fs::path{name};
+    if (name.empty() || name.find(u8"..") != std::u8string::npos ||
+        name.find_first_of(u8"/\\:") != std::u8string::npos ||
+        is_reserved_device_name(name) || name_path.has_root_name() ||
+        name_path.has_root_directory())
+    {
+        throw windower::command_error{
+            u8"Invalid capture name \"" + name + u8"\"", u8"/uicapture"};
+    }
+
+    auto const directory =
+        fs::weakly_canonical(windower::user_path() / u8"captures");
+    auto const path = fs::weakly_canonical(directory / (name + u8".uic"));
+    if (path.parent_path() != directory)
+    {
+        throw windower::command_error{
+            u8"Invalid capture name \"" + name + u8"\"", u8"/uicapture"};
+    }
+    return path;
+}
+
 std::future<void> install_impl(std::vector<std::u8string> const& args)
 {
     check_args(u8"/install", args, 1, unlimited);
@@ -384,3 +454,18 @@ void windower::command_handlers::prevwindow(
     check_args(u8"/prevwindow", args, 0);
     core::instance().ui.activate_previous_window();
 }
+
+void windower::command_handlers::uicapture(
+    std::vector<std::u8string> const& args, command_source source)
+{
+    check_args(u8"/uicapture", args, 0, 1);
+    auto const name = args.empty() ? std::u8string{u8"frame"} : args.front();
+    auto const path = capture_path(name);
+    if (!core::instance().ui.capture_frame(path))
+    {
+        throw command_error{
+            u8"User interface is not initialized", u8"/uicapture"};
+    }
+    core::output(
+        u8"core", u8"Capturing the next frame to " + path.u8string(), source);
+}
@@ -53,6 +53,7 @@ void reset(std::vector<std::u8string> const&, windower::command_source);
 void pkg(std::vector<std::u8string> const&, windower::command_source);
 void nextwindow(std::vector<std::u8string> const&, windower::command_source);
 void prevwindow(std::vector<std::u8string> const&, windower::command_source);
+void uicapture(std::vector<std::u8string> const&, windower::command_source);
 
 };
 
@@ -338,6 +338,10 @@ windower::core::core() noexcept
         cmd.register_command(
             command_manager::layer::core, u8"", u8"prevwindow",
             command_handlers::prevwindow);
+
+        cmd.register_command(
+            command_manager::layer::core, u8"", u8"uicapture",
+            command_handlers::uicapture);
     });
 }
 
@@ -28,6 +28,7 @@
 
 #include <gsl/gsl>
 
+#include <algorithm>
 #include <array>
 
 namespace
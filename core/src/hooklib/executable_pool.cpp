@@ -0,0 +1,184 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "hooklib/executable_pool.hpp"
+
+#include "utility.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+windower::hooklib::executable_pool::executable_pool(
+    page_provider& provider, std::size_t slot_size) :
+    m_provider{provider},
+    m_slot_size{(slot_size + 15) & ~std::size_t{15}},
+    m_slot_count{m_provider.region_size() / m_slot_size}
+{
+    if (m_slot_count == 0 ||
+        m_slot_count > std::numeric_limits<std::uint16_t>::max())
+    {
+        throw std::invalid_argument{"invalid executable pool slot size"};
+    }
+}
+
+windower::hooklib::executable_pool::~executable_pool()
+{
+    for (auto const& region : m_regions)
+    {
+        m_provider.deallocate(region.base);
+    }
+}
+
+void* windower::hooklib::executable_pool::allocate(void const* hint)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    if (m_batch_depth == 0)
+    {
+        throw std::logic_error{"executable pool written outside a batch"};
+    }
+
+    auto it = std::find_if(
+        m_regions.begin(), m_regions.end(), [&](region const& region) {
+            return !region.free.empty() && in_reach(region, hint);
+        });
+    if (it == m_regions.end())
+    {
+        region fresh{m_provider.allocate(hint), {}, false};
+        try
+        {
+            fresh.free.resize(m_slot_count);
+            // Slots are handed out from the back, so reverse the order to
+            // fill a region from its start.
+            std::iota(fresh.free.rbegin(), fresh.free.rend(), std::uint16_t{});
+            if (!in_reach(fresh, hint))
+            {
+                throw std::runtime_error{
+                    "no executable memory within reach of the target"};
+            }
+            m_regions.push_back(std::move(fresh));
+        }
+        catch (...)
+        {
+            m_provider.deallocate(fresh.base);
+            throw;
+        }
+        it = std::prev(m_regions.end());
+    }
+
+    if (!it->writable)
+    {
+        m_provider.make_writable(it->base);
+        it->writable = true;
+    }
+
+    auto const index = it->free.back();
+    it->free.pop_back();
+    return std::next(it->base, index * m_slot_size);
+}
+
+void windower::hooklib::executable_pool::deallocate(void* slot) noexcept
+{
+    if (!slot)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    auto const ptr = static_cast<std::byte*>(slot);
+    auto const it  = std::find_if(
+        m_regions.begin(), m_regions.end(), [&](region const& region) {
+            return ptr >= region.base &&
+                   ptr < std::next(region.base, m_provider.region_size());
+        });
+    if (it == m_regions.end())
+    {
+        fail_fast();
+    }
+
+    auto const index = std::distance(it->base, ptr) / m_slot_size;
+    it->free.push_back(gsl::narrow_cast<std::uint16_t>(index));
+    if (it->free.size() == m_slot_count)
+    {
+        m_provider.deallocate(it->base);
+        m_regions.erase(it);
+    }
+}
+
+void windower::hooklib::executable_pool::begin_batch() noexcept
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    ++m_batch_depth;
+}
+
+void windower::hooklib::executable_pool::end_batch() noexcept
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (--m_batch_depth != 0)
+    {
+        return;
+    }
+    for (auto& region : m_regions)
+    {
+        if (region.writable)
+        {
+            m_provider.make_executable(region.base);
+            region.writable = false;
+        }
+    }
+}
+
+bool windower::hooklib::executable_pool::in_reach(
+    region const& region, void const* hint) const noexcept
+{
+    // A rel32 displacement wraps around a 32-bit address space.
+    if constexpr (sizeof(void*) <= sizeof(std::int32_t))
+    {
+        return true;
+    }
+    else
+    {
+        if (!hint)
+        {
+            return true;
+        }
+        constexpr auto reach =
+            std::uintmax_t{std::numeric_limits<std::int32_t>::max()};
+        auto const first    = std::bit_cast<std::uintptr_t>(region.base);
+        auto const last     = first + m_provider.region_size();
+        auto const target   = std::bit_cast<std::uintptr_t>(hint);
+        auto const distance = target < first ? last - target : target - first;
+        return distance <= reach;
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_HOOKLIB_EXECUTABLE_POOL_HPP
+#define WINDOWER_HOOKLIB_EXECUTABLE_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace windower::hooklib
+{
+
+// Supplies regions of executable memory. Regions start out executable and
+// read-only, and only become writable while a write batch is open.
+class page_provider
+{
+public:
+    virtual ~page_provider() = default;
+
+    virtual std::size_t region_size() const noexcept = 0;
+    virtual std::byte* allocate(void const* hint) = 0;
+    virtual void deallocate(std::byte* region) noexcept = 0;
+    virtual void make_writable(std::byte* region) = 0;
+    virtual void make_executable(std::byte* region) noexcept = 0;
+};
+
+// Packs fixed-size slots of executable code into shared regions, keeping
+// every slot within rel32 reach of the address it was requested near.
+// Protection changes are deferred to the end of the outermost write batch,
+// so installing several hooks together flips each region only once.
+class executable_pool
+{
+public:
+    class write_batch
+    {
+    public:
+        explicit write_batch(executable_pool& pool) noexcept : m_pool{pool}
+        {
+            m_pool.begin_batch();
+        }
+
+        write_batch(write_batch const&) = delete;
+        write_batch(write_batch&&)      = delete;
+
+        ~write_batch() noexcept { m_pool.end_batch(); }
+
+        write_batch& operator=(write_batch const&) = delete;
+        write_batch& operator=(write_batch&&) = delete;
+
+    private:
+        executable_pool& m_pool;
+    };
+
+    executable_pool(page_provider& provider, std::size_t slot_size);
+
+    executable_pool(executable_pool const&) = delete;
+    executable_pool(executable_pool&&)      = delete;
+
+    ~executable_pool();
+
+    executable_pool& operator=(executable_pool const&) = delete;
+    executable_pool& operator=(executable_pool&&) = delete;
+
+    // Returns a writable slot; must be called while a write batch is open.
+    void* allocate(void const* hint = nullptr);
+    void deallocate(void* slot) noexcept;
+
+    void begin_batch() noexcept;
+    void end_batch() noexcept;
+
+private:
+    struct region
+    {
+        std::byte* base;
+        std::vector<std::uint16_t> free;
+        bool writable;
+    };
+
+    page_provider& m_provider;
+    std::size_t m_slot_size;
+    std::size_t m_slot_count;
+    std::vector<region> m_regions;
+    std::size_t m_batch_depth = 0;
+    std::mutex m_mutex;
+
+    bool in_reach(region const& region, void const* hint) const noexcept;
+};
+
+}
+
+#endif
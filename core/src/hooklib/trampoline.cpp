@@ -25,6 +25,7 @@
 #include "trampoline.hpp"
 
 #include "handle.hpp"
+#include "hooklib/executable_pool.hpp"
 #include "hooklib/x86.hpp"
 #include "utility.hpp"
 
@@ -46,84 +47,69 @@
 namespace
 {
 
-class heap
+class virtual_page_provider final : public windower::hooklib::page_provider
 {
 public:
-    static heap const& instance()
+    virtual_page_provider() noexcept
     {
-        static heap const instance{HEAP_CREATE_ENABLE_EXECUTE};
-        return instance;
+        ::SYSTEM_INFO info = {};
+        ::GetSystemInfo(&info);
+        m_region_size = info.dwAllocationGranularity;
     }
 
-    operator ::HANDLE() const noexcept { return m_handle; }
-
-private:
-    ::HANDLE m_handle;
+    std::size_t region_size() const noexcept override
+    {
+        return m_region_size;
+    }
 
-    heap(heap const&) = delete;
-    heap(heap&&)      = delete;
-    heap(::DWORD options) : m_handle{::HeapCreate(options, 0, 0)}
+    std::byte* allocate(void const*) override
     {
-        if (!m_handle)
+        // Regions are reserved at allocation granularity, so that no other
+        // allocation shares their pages and protection changes stay local.
+        auto const ptr = ::VirtualAlloc(
+            nullptr, m_region_size, MEM_RESERVE | MEM_COMMIT,
+            PAGE_EXECUTE_READ);
+        if (!ptr)
         {
             windower::throw_system_error();
         }
+        return static_cast<std::byte*>(ptr);
     }
 
-    ~heap() noexcept
+    void deallocate(std::byte* region) noexcept override
     {
-        if (m_handle && !::HeapDestroy(m_handle))
+        if (!::VirtualFree(region, 0, MEM_RELEASE))
         {
             windower::fail_fast();
         }
     }
 
-    heap& operator=(heap const&) = delete;
-    heap& operator=(heap&&) = delete;
-};
-
-template<typename T>
-class executable_allocator
-{
-public:
-    using value_type = T;
-
-    executable_allocator() = default;
-
-    template<typename U>
-    executable_allocator(executable_allocator<U> const&) noexcept
-    {}
-
-    T* allocate(std::size_t n)
+    void make_writable(std::byte* region) override
     {
-        auto ptr = ::HeapAlloc(heap::instance(), 0, n * sizeof(T));
-        if (!ptr)
+        // Hooks are patched in before their batch ends, and a region also
+        // holds trampolines that are already live, so it stays executable.
+        ::DWORD old = 0;
+        if (!::VirtualProtect(
+                region, m_region_size, PAGE_EXECUTE_READWRITE, &old))
         {
-            throw std::bad_alloc{};
+            windower::throw_system_error();
         }
-        return static_cast<T*>(ptr);
     }
 
-    void deallocate(T* ptr, std::size_t)
+    void make_executable(std::byte* region) noexcept override
     {
-        if (!::HeapFree(heap::instance(), 0, ptr))
+        ::DWORD old = 0;
+        if (!::VirtualProtect(region, m_region_size, PAGE_EXECUTE_READ, &old) ||
+            !::FlushInstructionCache(
+                ::GetCurrentProcess(), region, m_region_size))
         {
-            windower::throw_system_error();
+            windower::fail_fast();
         }
     }
-};
 
-template<typename T, typename U>
-bool operator==(executable_allocator<T> const&, executable_allocator<U> const&)
-{
-    return true;
-}
-
-template<typename T, typename U>
-bool operator!=(executable_allocator<T> const&, executable_allocator<U> const&)
-{
-    return false;
-}
+private:
+    std::size_t m_region_size = 0;
+};
 
 class patch_guard
 {
@@ -380,23 +366,17 @@ public:
 
         auto raw_target = std::bit_cast<std::uint8_t*>(target);
         m_hotpatched    = x86::is_hotpatchable(raw_target);
-        if (m_hotpatched)
-        {
-            m_size = 2;
-        }
-        else
+        if (!m_hotpatched)
         {
             raw_target = x86::follow_jumps(raw_target);
-            auto mark  = raw_target;
-            do
-            {
-                mark   = x86::next_instruction(mark);
-                m_size = std::distance(raw_target, mark);
-            } while (m_size < sizeof(x86::jump));
         }
 
-        std::copy(raw_target, std::next(raw_target, m_size), std::begin(m_raw));
-        new (m_raw.data() + m_size) x86::jump(std::next(raw_target, m_size));
+        auto const relocated = x86::relocate(
+            raw_target, m_hotpatched ? 2 : sizeof(x86::jump),
+            {m_raw.data(), x86::max_relocated_size});
+        m_size = relocated.source_size;
+        new (m_raw.data() + relocated.size)
+            x86::jump(std::next(raw_target, m_size));
 
         if (thunk)
         {
@@ -443,7 +423,7 @@ public:
     }
 
 private:
-    std::array<unsigned char, x86::max_instruction_size + sizeof(x86::jump)>
+    std::array<unsigned char, x86::max_relocated_size + sizeof(x86::jump)>
         m_raw;
     std::array<unsigned char, sizeof(x86::thiscall_thunk)> m_thunk;
     std::size_t m_size     = 0;
@@ -451,11 +431,40 @@ private:
     bool m_hotpatched      = false;
 };
 
+windower::hooklib::executable_pool& windower::hooklib::trampoline::pool()
+{
+    static virtual_page_provider provider;
+    static executable_pool pool{provider, sizeof(block)};
+    return pool;
+}
+
+windower::hooklib::trampoline::install_batch::install_batch()
+{
+    pool().begin_batch();
+}
+
+windower::hooklib::trampoline::install_batch::~install_batch() noexcept
+{
+    pool().end_batch();
+}
+
 windower::hooklib::trampoline::trampoline(
-    void (*target)(), void (*callback)(), void (*thunk)()) :
-    m_block{std::construct_at(
-        executable_allocator<block>{}.allocate(1), target, callback, thunk)}
-{}
+    void (*target)(), void (*callback)(), void (*thunk)())
+{
+    auto& blocks     = pool();
+    auto const batch = executable_pool::write_batch{blocks};
+    auto const slot  = blocks.allocate(std::bit_cast<void const*>(target));
+    try
+    {
+        m_block = std::construct_at(
+            static_cast<block*>(slot), target, callback, thunk);
+    }
+    catch (...)
+    {
+        blocks.deallocate(slot);
+        throw;
+    }
+}
 
 windower::hooklib::trampoline::operator bool() const noexcept
 {
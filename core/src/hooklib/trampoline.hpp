@@ -30,9 +30,26 @@
 namespace windower::hooklib
 {
 
+class executable_pool;
+
 class trampoline
 {
 public:
+    // Keeps trampoline memory writable until the outermost batch ends, so a
+    // group of hooks is installed with a single protection change.
+    class install_batch
+    {
+    public:
+        install_batch();
+        install_batch(install_batch const&) = delete;
+        install_batch(install_batch&&)      = delete;
+
+        ~install_batch() noexcept;
+
+        install_batch& operator=(install_batch const&) = delete;
+        install_batch& operator=(install_batch&&) = delete;
+    };
+
     trampoline() = default;
     trampoline(void (*)(), void (*)(), void (*)() = nullptr);
 
@@ -44,6 +61,8 @@ private:
     class block;
 
     block const* m_block;
+
+    static executable_pool& pool();
 };
 
 }
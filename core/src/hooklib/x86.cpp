@@ -26,318 +26,441 @@
 
 #include <gsl/gsl>
 
+#include <algorithm>
+#include <array>
 #include <bit>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <span>
 #include <stdexcept>
+#include <vector>
 
 namespace
 {
 
-auto octal_split(gsl::not_null<std::uint8_t*>& it) noexcept
+// Operand layout of each opcode, packed into one byte per opcode so that
+// the length of an instruction follows from a few table lookups.
+enum operands : std::uint8_t
 {
-    std::uint8_t a = *it >> 6 & 3;
-    std::uint8_t b = *it >> 3 & 7;
-    std::uint8_t c = *it >> 0 & 7;
+    none     = 0x00,
+    modrm    = 0x01, // a ModRM byte, with SIB and displacement as encoded
+    imm8     = 0x02, // an 8-bit immediate
+    imm16    = 0x04, // a 16-bit immediate
+    immz     = 0x08, // a 16- or 32-bit immediate, by operand size
+    moffs    = 0x10, // a 16- or 32-bit address, by address size
+    relative = 0x20, // the immediate is a branch displacement
+    group3   = 0x40, // the immediate is only present for ModRM.reg 0 and 1
+    invalid  = 0x80,
+};
+
+constexpr std::uint8_t operator|(operands lhs, operands rhs) noexcept
+{
+    return static_cast<std::uint8_t>(
+        static_cast<std::uint8_t>(lhs) | static_cast<std::uint8_t>(rhs));
+}
+
+constexpr std::uint8_t operator|(std::uint8_t lhs, operands rhs) noexcept
+{
+    return static_cast<std::uint8_t>(lhs | static_cast<std::uint8_t>(rhs));
+}
+
+using operand_table = std::array<std::uint8_t, 256>;
+
+constexpr operand_table make_one_byte_table() noexcept
+{
+    operand_table table{};
+    auto const set = [&](std::size_t first, std::size_t last, auto value) {
+        for (auto i = first; i <= last; ++i)
+        {
+            table.at(i) = static_cast<std::uint8_t>(value);
+        }
+    };
 
-    it = std::next(it.get());
+    // ALU rows: op r/m,r / op r,r/m / op al,ib / op eax,iz
+    for (auto row = std::size_t{}; row < 0x40; row += 8)
+    {
+        set(row + 0, row + 3, modrm);
+        set(row + 4, row + 4, imm8);
+        set(row + 5, row + 5, immz);
+    }
+    set(0x62, 0x63, modrm);
+    set(0x68, 0x68, immz);
+    set(0x69, 0x69, modrm | immz);
+    set(0x6A, 0x6A, imm8);
+    set(0x6B, 0x6B, modrm | imm8);
+    set(0x70, 0x7F, relative | imm8);
+    set(0x80, 0x80, modrm | imm8);
+    set(0x81, 0x81, modrm | immz);
+    set(0x82, 0x83, modrm | imm8);
+    set(0x84, 0x8F, modrm);
+    set(0x9A, 0x9A, immz | imm16);
+    set(0xA0, 0xA3, moffs);
+    set(0xA8, 0xA8, imm8);
+    set(0xA9, 0xA9, immz);
+    set(0xB0, 0xB7, imm8);
+    set(0xB8, 0xBF, immz);
+    set(0xC0, 0xC1, modrm | imm8);
+    set(0xC2, 0xC2, imm16);
+    set(0xC4, 0xC5, modrm);
+    set(0xC6, 0xC6, modrm | imm8);
+    set(0xC7, 0xC7, modrm | immz);
+    set(0xC8, 0xC8, imm16 | imm8);
+    set(0xCA, 0xCA, imm16);
+    set(0xCD, 0xCD, imm8);
+    set(0xD0, 0xD3, modrm);
+    set(0xD4, 0xD5, imm8);
+    set(0xD8, 0xDF, modrm);
+    set(0xE0, 0xE3, relative | imm8);
+    set(0xE4, 0xE7, imm8);
+    set(0xE8, 0xE9, relative | immz);
+    set(0xEA, 0xEA, immz | imm16);
+    set(0xEB, 0xEB, relative | imm8);
+    set(0xF6, 0xF6, modrm | group3 | imm8);
+    set(0xF7, 0xF7, modrm | group3 | immz);
+    set(0xFE, 0xFF, modrm);
+    return table;
+}
 
-    return std::make_tuple(a, b, c);
+constexpr operand_table make_two_byte_table() noexcept
+{
+    operand_table table{};
+    auto const set = [&](std::size_t first, std::size_t last, auto value) {
+        for (auto i = first; i <= last; ++i)
+        {
+            table.at(i) = static_cast<std::uint8_t>(value);
+        }
+    };
+
+    set(0x00, 0xFF, modrm);
+    set(0x04, 0x04, invalid);
+    set(0x05, 0x09, none);
+    set(0x0A, 0x0A, invalid);
+    set(0x0B, 0x0B, none);
+    set(0x0C, 0x0C, invalid);
+    set(0x0E, 0x0E, none);
+    set(0x0F, 0x0F, modrm | imm8);
+    set(0x24, 0x27, invalid);
+    set(0x30, 0x35, none);
+    set(0x36, 0x36, invalid);
+    set(0x37, 0x37, none);
+    set(0x38, 0x3F, invalid);
+    set(0x70, 0x73, modrm | imm8);
+    set(0x77, 0x77, none);
+    set(0x7A, 0x7B, invalid);
+    set(0x80, 0x8F, relative | immz);
+    set(0xA0, 0xA2, none);
+    set(0xA4, 0xA4, modrm | imm8);
+    set(0xA6, 0xA7, invalid);
+    set(0xA8, 0xAA, none);
+    set(0xAC, 0xAC, modrm | imm8);
+    set(0xBA, 0xBA, modrm | imm8);
+    set(0xC2, 0xC2, modrm | imm8);
+    set(0xC4, 0xC6, modrm | imm8);
+    set(0xC8, 0xCF, none);
+    return table;
 }
 
-std::uint8_t
-decode_mod_sib(gsl::not_null<std::uint8_t*>& it, bool address_override) noexcept
+constexpr operand_table one_byte_table = make_one_byte_table();
+constexpr operand_table two_byte_table = make_two_byte_table();
+
+constexpr bool is_prefix(std::uint8_t byte) noexcept
 {
-    std::uint8_t mod;
-    std::uint8_t reg;
-    std::uint8_t r_m;
+    switch (byte)
+    {
+    case 0x26:
+    case 0x2E:
+    case 0x36:
+    case 0x3E:
+    case 0x64:
+    case 0x65:
+    case 0x66:
+    case 0x67:
+    case 0xF0:
+    case 0xF2:
+    case 0xF3: return true;
+    default: return false;
+    }
+}
 
-    std::tie(mod, reg, r_m) = octal_split(it);
+// Returns the number of ModRM, SIB and displacement bytes.
+std::size_t
+modrm_size(std::uint8_t const* it, bool address_override) noexcept
+{
+    auto const mod = *it >> 6 & 3;
+    auto const r_m = *it >> 0 & 7;
+    if (mod == 3)
+    {
+        return 1;
+    }
     if (address_override)
     {
-        if ((mod == 0 && r_m == 6) || mod == 2)
+        if (mod == 0)
         {
-            it = std::next(it.get(), 2);
+            return r_m == 6 ? 3 : 1;
         }
-        else if (mod == 1)
+        return mod == 1 ? 2 : 3;
+    }
+
+    auto size = std::size_t{1};
+    if (r_m == 4)
+    {
+        ++size;
+        auto const base = *std::next(it) & 7;
+        if (mod == 0 && base == 5)
         {
-            it = std::next(it.get());
+            return size + 4;
         }
     }
-    else
+    if (mod == 0)
     {
-        if ((mod == 0 && r_m == 5) || mod == 2)
+        return r_m == 5 ? size + 4 : size;
+    }
+    return mod == 1 ? size + 1 : size + 4;
+}
+
+std::int32_t read_relative(std::uint8_t const* it, std::size_t size) noexcept
+{
+    switch (size)
+    {
+    case 1: return static_cast<std::int8_t>(*it);
+    case 2:
+        return static_cast<std::int16_t>(*it | *std::next(it) << 8);
+    default:
+        return static_cast<std::int32_t>(
+            std::uint32_t{*it} | std::uint32_t{*std::next(it)} << 8 |
+            std::uint32_t{*std::next(it, 2)} << 16 |
+            std::uint32_t{*std::next(it, 3)} << 24);
+    }
+}
+
+void write_rel32(std::uint8_t* it, std::int64_t value)
+{
+    if (value < std::numeric_limits<std::int32_t>::min() ||
+        value > std::numeric_limits<std::int32_t>::max())
+    {
+        throw std::runtime_error{"relocated branch is out of range"};
+    }
+    auto const raw    = static_cast<std::uint32_t>(value);
+    *it               = raw >> 0x00 & 0xFF;
+    *std::next(it)    = raw >> 0x08 & 0xFF;
+    *std::next(it, 2) = raw >> 0x10 & 0xFF;
+    *std::next(it, 3) = raw >> 0x18 & 0xFF;
+}
+
+}
+
+windower::hooklib::x86::instruction
+windower::hooklib::x86::decode(gsl::not_null<std::uint8_t const*> code_ptr)
+{
+    auto const begin      = code_ptr.get();
+    auto it               = begin;
+    auto operand_override = false;
+    auto address_override = false;
+
+    while (is_prefix(*it) &&
+           gsl::narrow_cast<std::size_t>(std::distance(begin, it)) <
+               max_instruction_size)
+    {
+        operand_override = operand_override || *it == 0x66;
+        address_override = address_override || *it == 0x67;
+        it               = std::next(it);
+    }
+
+    auto const opcode_offset = std::distance(begin, it);
+    auto flags               = std::uint8_t{};
+    auto register_only       = false;
+    if (*it == 0x0F)
+    {
+        it = std::next(it);
+        switch (*it)
         {
-            it = std::next(it.get(), 4);
+        case 0x38:
+            it    = std::next(it);
+            flags = modrm;
+            break;
+        case 0x3A:
+            it    = std::next(it);
+            flags = modrm | imm8;
+            break;
+        default:
+            flags = gsl::at(two_byte_table, *it);
+            // mov to and from control and debug registers ignores ModRM.mod
+            register_only = (*it & 0xFC) == 0x20;
+            break;
         }
-        else if (mod == 1)
+    }
+    else
+    {
+        if ((*it == 0x62 || *it == 0xC4 || *it == 0xC5) &&
+            (*std::next(it) & 0xC0) == 0xC0)
         {
-            it = std::next(it.get());
+            throw std::runtime_error{"VEX and EVEX encodings are unsupported"};
         }
-
-        if (mod != 3 && r_m == 4)
+        // pop r/m is only defined for ModRM.reg 0; anything else is XOP.
+        if (*it == 0x8F && (*std::next(it) & 0x38) != 0)
         {
-            it = std::next(it.get());
+            throw std::runtime_error{"XOP encodings are unsupported"};
         }
+        flags = gsl::at(one_byte_table, *it);
+    }
+    if (flags & invalid)
+    {
+        throw std::runtime_error{"invalid x86 opcode"};
     }
 
-    return reg;
-}
+    it = std::next(it);
 
-void decode_prefix(
-    gsl::not_null<std::uint8_t*>& it, bool& operand_override,
-    bool& address_override) noexcept
-{
-    while (true)
+    if (flags & modrm)
     {
-        switch (*it)
+        if ((flags & group3) && (*it >> 3 & 7) > 1)
         {
-        default: return;
-
-        case 0046:
-        case 0056:
-        case 0066:
-        case 0076:
-        case 0144:
-        case 0145:
-        case 0360:
-        case 0362:
-        case 0363: break;
-
-        case 0146: operand_override = true; break;
-        case 0147: address_override = true; break;
+            flags &= ~(imm8 | immz);
         }
+        it = std::next(
+            it, register_only ? 1 : modrm_size(it, address_override));
+    }
 
-        it = std::next(it.get());
+    auto const immediate = it;
+    if (flags & immz)
+    {
+        it = std::next(it, operand_override ? 2 : 4);
+    }
+    if (flags & imm16)
+    {
+        it = std::next(it, 2);
+    }
+    if (flags & imm8)
+    {
+        it = std::next(it);
+    }
+    if (flags & moffs)
+    {
+        it = std::next(it, address_override ? 2 : 4);
     }
-}
 
-void decode_opcode_1(
-    gsl::not_null<std::uint8_t*>& it, bool operand_override,
-    bool address_override) noexcept
-{
-    std::uint8_t a;
-    std::uint8_t b;
-    std::uint8_t c;
-    std::tie(a, b, c) = octal_split(it);
-    switch (a)
+    auto const size = gsl::narrow_cast<std::size_t>(std::distance(begin, it));
+    if (size > max_instruction_size)
     {
-    default: break;
-    case 0:
-        switch (c)
-        {
-        default: break;
-        case 0:
-        case 1:
-        case 2:
-        case 3: decode_mod_sib(it, address_override); break;
+        throw std::runtime_error{"invalid x86 opcode"};
+    }
 
-        case 4: it = std::next(it.get()); break;
+    instruction result{};
+    result.size          = gsl::narrow_cast<std::uint8_t>(size);
+    result.opcode_offset = gsl::narrow_cast<std::uint8_t>(opcode_offset);
+    if (flags & relative)
+    {
+        result.relative_offset =
+            gsl::narrow_cast<std::uint8_t>(std::distance(begin, immediate));
+        result.relative_size =
+            gsl::narrow_cast<std::uint8_t>(std::distance(immediate, it));
+    }
+    return result;
+}
 
-        case 5: it = std::next(it.get(), operand_override ? 2 : 4); break;
-        }
-        break;
+// Copies whole instructions covering at least minimum_size bytes of source
+// into destination, which must be the buffer's final location. Relative
+// branches are adjusted to keep their targets, and short branches are
+// widened to rel32 since their targets are rarely in reach of the copy.
+// Anything that cannot be moved faithfully throws rather than producing a
+// subtly wrong copy.
+windower::hooklib::x86::relocation windower::hooklib::x86::relocate(
+    gsl::not_null<std::uint8_t const*> source, std::size_t minimum_size,
+    std::span<std::uint8_t> destination)
+{
+    auto const begin = source.get();
+    auto from        = std::size_t{};
+    auto to          = std::size_t{};
+    std::vector<std::uintptr_t> targets;
 
-    case 1:
-        switch (b)
+    auto const reserve = [&](std::size_t size) {
+        if (destination.size() - to < size)
         {
-        default: break;
-        case 4:
-            switch (c)
-            {
-            default: break;
-            case 2:
-            case 3: decode_mod_sib(it, address_override); break;
-            }
-            break;
-
-        case 5:
-            switch (c)
-            {
-            default: break;
-            case 1: decode_mod_sib(it, address_override); [[fallthrough]];
-            case 0: it = std::next(it.get(), operand_override ? 2 : 4); break;
+            throw std::runtime_error{"relocated code does not fit"};
+        }
+        return std::next(destination.data(), to);
+    };
 
-            case 3: decode_mod_sib(it, address_override); [[fallthrough]];
-            case 2: it = std::next(it.get()); break;
-            }
-            break;
+    while (from < minimum_size)
+    {
+        auto const code        = std::next(begin, from);
+        auto const instruction = decode(code);
+        auto const size        = std::size_t{instruction.size};
 
-        case 6:
-        case 7: it = std::next(it.get()); break;
+        if (instruction.relative_size == 0)
+        {
+            std::copy_n(code, size, reserve(size));
+            from += size;
+            to += size;
+            continue;
         }
-        break;
 
-    case 2:
-        switch (b)
+        if (instruction.relative_size == 2)
         {
-        default: break;
-        case 0:
-            decode_mod_sib(it, address_override);
-            switch (c)
-            {
-            default: break;
-            case 0:
-            case 2:
-            case 3: it = std::next(it.get()); break;
+            throw std::runtime_error{"16-bit branches cannot be relocated"};
+        }
 
-            case 1: it = std::next(it.get(), operand_override ? 2 : 4); break;
-            }
-            break;
-        case 1: decode_mod_sib(it, address_override); break;
-        case 3:
-            switch (c)
-            {
-            default: break;
-            case 2: it = std::next(it.get(), address_override ? 4 : 6); break;
-            }
-            break;
-        case 4:
-            switch (c)
-            {
-            default: break;
-            case 0:
-            case 1:
-            case 2:
-            case 3: it = std::next(it.get(), 4); break;
-            }
-            break;
-        case 5:
-            switch (c)
+        auto const target =
+            std::bit_cast<std::uintptr_t>(std::next(code, size)) +
+            static_cast<std::uintptr_t>(static_cast<std::intptr_t>(
+                read_relative(
+                    std::next(code, instruction.relative_offset),
+                    instruction.relative_size)));
+        targets.push_back(target);
+
+        auto const opcode = *std::next(code, instruction.opcode_offset);
+        auto prefixes     = std::size_t{instruction.opcode_offset};
+        auto new_size     = size;
+        if (instruction.relative_size == 1)
+        {
+            if (opcode >= 0xE0 && opcode <= 0xE3)
             {
-            default: break;
-            case 0: it = std::next(it.get()); break;
-            case 1: it = std::next(it.get(), operand_override ? 2 : 4); break;
+                throw std::runtime_error{"loop and jcxz cannot be relocated"};
             }
-            break;
-        case 6: it = std::next(it.get()); break;
-        case 7: it = std::next(it.get(), operand_override ? 2 : 4); break;
+            new_size = prefixes + (opcode == 0xEB ? 5 : 6);
         }
-        break;
 
-    case 3:
-        switch (b << 3 | c)
+        auto const out = reserve(new_size);
+        std::copy_n(code, prefixes, out);
+        if (instruction.relative_size == 1)
         {
-        default: break;
-        case 000:
-        case 001:
-        case 006:
-            decode_mod_sib(it, address_override);
-            it = std::next(it.get());
-            break;
-
-        case 002:
-        case 012: it = std::next(it.get(), 2); break;
-
-        case 004:
-        case 005:
-        case 020:
-        case 021:
-        case 022:
-        case 023:
-        case 030:
-        case 031:
-        case 032:
-        case 033:
-        case 034:
-        case 035:
-        case 036:
-        case 037:
-        case 076:
-        case 077: decode_mod_sib(it, address_override); break;
-
-        case 007:
-            decode_mod_sib(it, address_override);
-            it = std::next(it.get(), operand_override ? 2 : 4);
-            break;
-
-        case 010: it = std::next(it.get(), 3); break;
-
-        case 015:
-        case 024:
-        case 025:
-        case 040:
-        case 041:
-        case 042:
-        case 043:
-        case 044:
-        case 045:
-        case 046:
-        case 047:
-        case 053: it = std::next(it.get()); break;
-
-        case 050:
-        case 051:
-        case 052: it = std::next(it.get(), operand_override ? 2 : 4); break;
-
-        case 066:
-            switch (decode_mod_sib(it, address_override))
+            auto const op = std::next(out, prefixes);
+            if (opcode == 0xEB)
             {
-            default: break;
-            case 0:
-            case 1: it = std::next(it.get());
+                *op = 0xE9;
             }
-            break;
-
-        case 067:
-            switch (decode_mod_sib(it, address_override))
+            else
             {
-            default: break;
-            case 0:
-            case 1: it = std::next(it.get(), operand_override ? 2 : 4);
+                *op            = 0x0F;
+                *std::next(op) = gsl::narrow_cast<std::uint8_t>(opcode + 0x10);
             }
-            break;
         }
-        break;
-    }
-}
-
-void decode_opcode_2(gsl::not_null<std::uint8_t*>&, bool, bool)
-{
-    throw std::runtime_error{"2 byte opcodes are not yet implemented"};
-}
-
-void decode_opcode_3(gsl::not_null<std::uint8_t*>&, bool, bool)
-{
-    throw std::runtime_error{"3 byte opcodes are not yet implemented"};
-}
-
-void decode_opcode_4(gsl::not_null<std::uint8_t*>&, bool, bool)
-{
-    throw std::runtime_error{"3 byte opcodes are not yet implemented"};
-}
+        else
+        {
+            std::copy_n(code, size, out);
+        }
 
-void decode(gsl::not_null<std::uint8_t*>& it)
-{
-    auto operand_override = false;
-    auto address_override = false;
+        auto const end = std::bit_cast<std::intptr_t>(std::next(out, new_size));
+        write_rel32(
+            std::next(out, new_size - 4),
+            static_cast<std::int64_t>(target) - static_cast<std::int64_t>(end));
 
-    decode_prefix(it, operand_override, address_override);
+        from += size;
+        to += new_size;
+    }
 
-    switch (*it)
+    auto const first = std::bit_cast<std::uintptr_t>(begin);
+    for (auto const target : targets)
     {
-    default: decode_opcode_1(it, operand_override, address_override); break;
-
-    case 0017:
-        it = std::next(it.get());
-        switch (*it)
+        if (target > first && target < first + from)
         {
-        default: decode_opcode_2(it, operand_override, address_override); break;
-
-        case 0070:
-            it = std::next(it.get());
-            decode_opcode_3(it, operand_override, address_override);
-            break;
-
-        case 0072:
-            it = std::next(it.get());
-            decode_opcode_4(it, operand_override, address_override);
-            break;
+            throw std::runtime_error{
+                "branches into relocated code cannot be relocated"};
         }
-        break;
     }
-}
 
+    return {from, to};
 }
 
 windower::hooklib::x86::jump::jump(void* target)
@@ -373,13 +496,7 @@ static_assert(
 gsl::not_null<std::uint8_t*>
 windower::hooklib::x86::next_instruction(gsl::not_null<std::uint8_t*> code_ptr)
 {
-    auto max = std::next(code_ptr.get(), max_instruction_size + 1);
-    decode(code_ptr);
-    if (code_ptr == max)
-    {
-        throw std::runtime_error{"invalid x86 opcode"};
-    }
-    return code_ptr;
+    return std::next(code_ptr.get(), decode(code_ptr).size);
 }
 
 bool windower::hooklib::x86::is_hotpatchable(
@@ -410,7 +527,8 @@ gsl::not_null<std::uint8_t*> windower::hooklib::x86::follow_jumps(
         }
 
         case 0xEB: {
-            auto const offset = *std::next(code_ptr.get(), 1);
+            auto const offset =
+                static_cast<std::int8_t>(*std::next(code_ptr.get(), 1));
             code_ptr          = std::next(code_ptr.get(), 2 + offset);
             break;
         }
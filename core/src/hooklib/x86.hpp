@@ -30,6 +30,7 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <span>
 
 namespace windower::hooklib
 {
@@ -56,11 +57,35 @@ public:
         jump m_jump;
     };
 
+    struct instruction
+    {
+        std::uint8_t size;
+        std::uint8_t opcode_offset;
+        std::uint8_t relative_offset;
+        std::uint8_t relative_size;
+    };
+
+    struct relocation
+    {
+        std::size_t source_size;
+        std::size_t size;
+    };
+
     static constexpr std::size_t max_instruction_size         = 15;
     static constexpr std::uint8_t nop_instruction             = 0x90;
     static constexpr std::uint8_t trap_instruction            = 0xCC;
     static unsigned short int const hotpatch_jump_instruction = 0xF9EB;
 
+    // Relocating a prologue long enough to hold a jump can widen short
+    // branches to their rel32 forms, at most tripling their size.
+    static constexpr std::size_t max_relocated_size =
+        3 * (max_instruction_size + sizeof(jump) - 1);
+
+    static instruction decode(gsl::not_null<std::uint8_t const*>);
+    static relocation relocate(
+        gsl::not_null<std::uint8_t const*>, std::size_t,
+        std::span<std::uint8_t>);
+
     static gsl::not_null<std::uint8_t*>
         follow_jumps(gsl::not_null<std::uint8_t*>) noexcept;
     static gsl::not_null<std::uint8_t*>
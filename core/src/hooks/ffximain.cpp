@@ -37,13 +37,17 @@
 
 #include <windows.h>
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <ostream>
 #include <queue>
 #include <sstream>
+#include <string>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 using namespace windower::signature_literals;
@@ -145,6 +149,7 @@ namespace hooks
 
 chat_log const* const* chat_log_ptr               = nullptr;
 chat_mode const* const* chat_mode_ptr             = nullptr;
+windower::address autotranslate_owner_ptr         = {};
 autotranslate_dictionary const* autotranslate_ptr = nullptr;
 menu_entry const* menu_ptr                        = nullptr;
 
@@ -163,23 +168,32 @@ windower::hooklib::hook<void(), renderer const> draw_scene;
 
 }
 
+// The client creates the dictionary some time after the hooks are installed,
+// so it is read through the pointer install() found until it shows up. Only
+// called on the game thread.
+autotranslate_dictionary const* get_autotranslate_dictionary() noexcept
+{
+    if (!hooks::autotranslate_ptr)
+    {
+        if (auto const owner = *hooks::autotranslate_owner_ptr)
+        {
+            hooks::autotranslate_ptr = *(owner + 0x7E6C);
+        }
+    }
+    return hooks::autotranslate_ptr;
+}
+
 template<std::size_t N>
 std::string_view lookup_autotranslate_impl(
-    char32_t code_point, std::array<char, N>& shift_jis_buffer) noexcept
+    char32_t code_point, std::array<char, N>& shift_jis_buffer,
+    windower::client_language language =
+        windower::client_language::english) noexcept
 {
     using namespace windower;
 
-    if (!hooks::autotranslate_ptr)
+    if (!get_autotranslate_dictionary())
     {
-        if (auto const temp =
-                **scan(u8"ffximain.dll", signatures::autotranslate_ptr))
-        {
-            hooks::autotranslate_ptr = *(temp + 0x7E6C);
-        }
-        else
-        {
-            return {};
-        }
+        return {};
     }
 
     std::uint32_t code = 0;
@@ -207,7 +221,7 @@ std::string_view lookup_autotranslate_impl(
     }
     else if (code_point >= U'\U00100001' && code_point <= U'\U0010FFFD')
     {
-        code &= 0xFFFF;
+        code_point &= 0xFFFF;
         code = code_point | ((code_point & 0xFF00) == 0 ? 0x0902FF00
                              : (code_point & 0xFF) == 0 ? 0x0A0200FF
                                                         : 0x07020000);
@@ -217,6 +231,7 @@ std::string_view lookup_autotranslate_impl(
     {
         return {};
     }
+    code = code & 0xFF00FFFF | static_cast<std::uint32_t>(language) << 16;
 
     auto size = hooks::lookup_autotranslate(
         hooks::autotranslate_ptr, change_endian(code), shift_jis_buffer.data(),
@@ -224,6 +239,199 @@ std::string_view lookup_autotranslate_impl(
     return {shift_jis_buffer.data(), size <= N ? size : 0};
 }
 
+// Returns the text of an autotranslate entry, or an empty string if the
+// client has no such entry.
+std::u8string lookup_autotranslate_text(
+    char32_t code_point, windower::client_language language)
+{
+    std::array<char, 450> buffer{};
+    auto const shift_jis =
+        lookup_autotranslate_impl(code_point, buffer, language);
+    return windower::to_u8string(windower::sjis_string_view{
+        reinterpret_cast<windower::sjis_char const*>(shift_jis.data()),
+        shift_jis.size()});
+}
+
+constexpr auto first_autotranslate_code_point = U'\U000F0101';
+
+// Returns the next code point after the given one that can name an
+// autotranslate entry, or U'\0' after the last one.
+constexpr char32_t next_autotranslate_code_point(char32_t code_point) noexcept
+{
+    ++code_point;
+    if (code_point <= U'\U000F7FFF')
+    {
+        return (code_point & 0xFF) == 0 ? code_point + 1 : code_point;
+    }
+    if (code_point <= U'\U000FFFFD')
+    {
+        return code_point;
+    }
+    if (code_point < U'\U00100000')
+    {
+        return U'\U00100000';
+    }
+    return code_point <= U'\U0010FFFD' ? code_point : U'\0';
+}
+
+// Every autotranslate entry of the client in both languages, read out of the
+// client's dictionary once and then shared read-only by all interpreters.
+// The client's lookup may only be called on the game thread, so the index is
+// filled a slice at a time by build().
+class autotranslate_index
+{
+public:
+    // Reads up to budget more code points and returns true once every code
+    // point has been read in both languages.
+    bool build(std::size_t budget)
+    {
+        for (; m_pass < passes.size() && budget > 0; --budget)
+        {
+            auto const language = gsl::at(passes, m_pass);
+            auto& index         = get(language);
+            auto const text = lookup_autotranslate_text(m_next, language);
+            if (!text.empty())
+            {
+                index.insert(m_next, text);
+            }
+
+            m_next = next_autotranslate_code_point(m_next);
+            if (m_next == U'\0')
+            {
+                index.entries.shrink_to_fit();
+                index.text.shrink_to_fit();
+                m_next = first_autotranslate_code_point;
+                ++m_pass;
+            }
+        }
+        return m_pass == passes.size();
+    }
+
+    // True if the dictionary had no entries, which happens when it is read
+    // before the client has finished loading it.
+    bool empty() const noexcept
+    {
+        return m_japanese.entries.empty() && m_english.entries.empty();
+    }
+
+    std::u8string lookup(
+        char32_t code_point, windower::client_language language) const
+    {
+        auto const& index = get(language);
+        auto const it     = std::lower_bound(
+            index.entries.begin(), index.entries.end(), code_point,
+            [](entry const& entry, char32_t code_point) noexcept {
+                return entry.code_point < code_point;
+            });
+        if (it == index.entries.end() || it->code_point != code_point)
+        {
+            return {};
+        }
+        return std::u8string{
+            std::u8string_view{index.text}.substr(it->offset, it->size)};
+    }
+
+    char32_t
+    find(std::u8string_view text, windower::client_language language) const
+    {
+        auto const& index = get(language);
+        auto const it =
+            index.code_points.find(windower::nfkc_fold_case(text));
+        return it == index.code_points.end() ? U'\0' : it->second;
+    }
+
+private:
+    struct entry
+    {
+        char32_t code_point;
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
+
+    struct language_index
+    {
+        std::vector<entry> entries;
+        std::u8string text;
+        std::unordered_map<std::u8string, char32_t> code_points;
+
+        // Code points arrive in ascending order, so entries stay sorted.
+        // Where several entries share a text the lowest code point wins.
+        void insert(char32_t code_point, std::u8string_view value)
+        {
+            entries.push_back(
+                {code_point, gsl::narrow<std::uint32_t>(text.size()),
+                 gsl::narrow<std::uint32_t>(value.size())});
+            text.append(value);
+            code_points.try_emplace(
+                windower::nfkc_fold_case(value), code_point);
+        }
+    };
+
+    language_index& get(windower::client_language language) noexcept
+    {
+        return language == windower::client_language::japanese ? m_japanese
+                                                                : m_english;
+    }
+
+    language_index const&
+    get(windower::client_language language) const noexcept
+    {
+        return language == windower::client_language::japanese ? m_japanese
+                                                                : m_english;
+    }
+
+    static constexpr std::array passes{
+        windower::client_language::japanese,
+        windower::client_language::english};
+
+    language_index m_japanese;
+    language_index m_english;
+    std::size_t m_pass = 0;
+    char32_t m_next    = first_autotranslate_code_point;
+};
+
+// Code points read per frame. A full build reads about 262,000, so the index
+// is ready a couple of seconds after the client has loaded its dictionary.
+constexpr std::size_t autotranslate_index_slice = 4096;
+
+std::unique_ptr<autotranslate_index> autotranslate_index_storage;
+bool autotranslate_index_complete = false;
+
+// Reads the next slice of the index, once the client's dictionary exists.
+// An index that comes out empty was read before the client had filled the
+// dictionary, so it is discarded and read again.
+void build_autotranslate_index()
+{
+    if (autotranslate_index_complete || !get_autotranslate_dictionary() ||
+        !hooks::lookup_autotranslate)
+    {
+        return;
+    }
+
+    if (!autotranslate_index_storage)
+    {
+        autotranslate_index_storage = std::make_unique<autotranslate_index>();
+    }
+    if (autotranslate_index_storage->build(autotranslate_index_slice))
+    {
+        if (autotranslate_index_storage->empty())
+        {
+            autotranslate_index_storage.reset();
+        }
+        else
+        {
+            autotranslate_index_complete = true;
+        }
+    }
+}
+
+// Returns the index once it has been built, or nullptr before that.
+autotranslate_index const* get_autotranslate_index() noexcept
+{
+    return autotranslate_index_complete ? autotranslate_index_storage.get()
+                                        : nullptr;
+}
+
 namespace callbacks
 {
 
@@ -419,6 +627,8 @@ void draw_scene(renderer const* renderer) noexcept
 {
     hooks::draw_scene(renderer);
 
+    build_autotranslate_index();
+
     auto& core = windower::core::instance();
 
     core.update();
@@ -454,29 +664,39 @@ void windower::ffximain::install()
     {
         command_tag = std::make_shared<int>();
 
-        hooks::chat_log_ptr = scan(u8"ffximain.dll", signatures::chat_log_ptr);
-        hooks::chat_mode_ptr =
-            scan(u8"ffximain.dll", signatures::chat_mode_ptr);
-        hooks::menu_ptr = scan(u8"ffximain.dll", signatures::menu_ptr);
-
-        hooks::add_to_chat = hooklib::make_hook_thiscall(
-            scan(u8"ffximain.dll", signatures::add_to_chat),
-            callbacks::add_to_chat);
-        hooks::input_command = hooklib::make_hook(
-            scan(u8"ffximain.dll", signatures::input_command),
-            callbacks::input_command);
-        hooks::decode_packet = hooklib::make_hook(
-            scan(u8"ffximain.dll", signatures::decode_packet),
-            callbacks::decode_packet);
-        hooks::encode_packet = hooklib::make_hook(
-            scan(u8"ffximain.dll", signatures::encode_packet),
-            callbacks::encode_packet);
-        hooks::lookup_autotranslate = hooklib::make_hook_thiscall(
-            scan(u8"ffximain.dll", signatures::autotranslate_lookup),
-            callbacks::lookup_autotranslate);
-        hooks::draw_scene = hooklib::make_hook_thiscall(
-            scan(u8"ffximain.dll", signatures::draw_scene),
-            callbacks::draw_scene);
+        auto const [
+            chat_log_ptr, chat_mode_ptr, autotranslate_ptr, menu_ptr,
+            add_to_chat, input_command, decode_packet, encode_packet,
+            lookup_autotranslate, draw_scene] =
+            scan_all(
+                u8"ffximain.dll", signatures::chat_log_ptr,
+                signatures::chat_mode_ptr, signatures::autotranslate_ptr,
+                signatures::menu_ptr, signatures::add_to_chat,
+                signatures::input_command, signatures::decode_packet,
+                signatures::encode_packet, signatures::autotranslate_lookup,
+                signatures::draw_scene);
+
+        hooks::chat_log_ptr            = chat_log_ptr;
+        hooks::chat_mode_ptr           = chat_mode_ptr;
+        hooks::autotranslate_owner_ptr = *autotranslate_ptr;
+        hooks::menu_ptr                = menu_ptr;
+
+        {
+            hooklib::trampoline::install_batch const batch;
+
+            hooks::add_to_chat = hooklib::make_hook_thiscall(
+                add_to_chat, callbacks::add_to_chat);
+            hooks::input_command =
+                hooklib::make_hook(input_command, callbacks::input_command);
+            hooks::decode_packet =
+                hooklib::make_hook(decode_packet, callbacks::decode_packet);
+            hooks::encode_packet =
+                hooklib::make_hook(encode_packet, callbacks::encode_packet);
+            hooks::lookup_autotranslate = hooklib::make_hook_thiscall(
+                lookup_autotranslate, callbacks::lookup_autotranslate);
+            hooks::draw_scene =
+                hooklib::make_hook_thiscall(draw_scene, callbacks::draw_scene);
+        }
 
         static constexpr auto resource_name = L"client-commands";
         auto const library = static_cast<::HMODULE>(windower_module());
@@ -518,6 +738,9 @@ void windower::ffximain::uninstall() noexcept
     command_tag.reset();
     command_manager::instance().purge();
 
+    autotranslate_index_storage.reset();
+    autotranslate_index_complete = false;
+
     hooks::encode_packet        = {};
     hooks::decode_packet        = {};
     hooks::input_command        = {};
@@ -525,16 +748,34 @@ void windower::ffximain::uninstall() noexcept
     hooks::lookup_autotranslate = {};
     hooks::draw_scene           = {};
 
-    hooks::chat_log_ptr      = nullptr;
-    hooks::chat_mode_ptr     = nullptr;
-    hooks::autotranslate_ptr = nullptr;
+    hooks::chat_log_ptr            = nullptr;
+    hooks::chat_mode_ptr           = nullptr;
+    hooks::autotranslate_owner_ptr = {};
+    hooks::autotranslate_ptr       = nullptr;
 }
 
-std::u8string windower::ffximain::lookup_autotranslate(char32_t code_point)
+std::u8string windower::ffximain::lookup_autotranslate(
+    char32_t code_point, client_language language)
 {
-    std::array<char, 450> shift_jis_buffer{};
-    auto const view = lookup_autotranslate_impl(code_point, shift_jis_buffer);
-    return to_u8string(view);
+    if (auto const index = get_autotranslate_index())
+    {
+        return index->lookup(code_point, language);
+    }
+    if (!get_autotranslate_dictionary() || !hooks::lookup_autotranslate)
+    {
+        return {};
+    }
+    return lookup_autotranslate_text(code_point, language);
+}
+
+char32_t windower::ffximain::find_autotranslate(
+    std::u8string_view text, client_language language)
+{
+    if (auto const index = get_autotranslate_index())
+    {
+        return index->find(text, language);
+    }
+    return U'\0';
 }
 
 void windower::ffximain::add_to_chat(
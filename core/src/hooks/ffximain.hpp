@@ -25,6 +25,8 @@
 #ifndef WINDOWER_HOOKS_FFXIMAIN_HPP
 #define WINDOWER_HOOKS_FFXIMAIN_HPP
 
+#include "unicode.hpp"
+
 #include <array>
 #include <bit>
 #include <cstddef>
@@ -41,7 +43,12 @@ public:
     static void install();
     static void uninstall() noexcept;
 
-    static std::u8string lookup_autotranslate(char32_t code_point);
+    static std::u8string lookup_autotranslate(
+        char32_t code_point,
+        client_language language = client_language::english);
+    static char32_t find_autotranslate(
+        std::u8string_view text,
+        client_language language = client_language::english);
     static void add_to_chat(
         std::u8string_view text, std::uint8_t type = 206,
         bool indented = false);
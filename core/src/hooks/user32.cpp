@@ -659,6 +659,8 @@ void windower::user32::install()
 {
     current_cursor = ::GetCursor();
 
+    hooklib::trampoline::install_batch const batch;
+
     hooks::RegisterClassA = hooklib::make_hook(
         u8"user32.dll", u8"RegisterClassA", callbacks::RegisterClassA);
     hooks::RegisterClassExW = hooklib::make_hook(
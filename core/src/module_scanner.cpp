@@ -0,0 +1,407 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "scanner.hpp"
+
+#include "handle.hpp"
+#include "library.hpp"
+#include "pe_image.hpp"
+#include "utility.hpp"
+
+#include <windows.h>
+
+#include <tlhelp32.h>
+
+#include <gsl/gsl>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+class fnv1a
+{
+public:
+    fnv1a& operator()(std::span<std::byte const> bytes) noexcept
+    {
+        for (auto const b : bytes)
+        {
+            m_value ^= std::to_integer<std::uint64_t>(b);
+            m_value *= 0x00000100000001B3;
+        }
+        return *this;
+    }
+
+    template<typename T>
+    requires std::is_trivially_copyable_v<T>
+    fnv1a& operator()(T const& value) noexcept
+    {
+        return (*this)(std::as_bytes(std::span{&value, 1}));
+    }
+
+    std::uint64_t value() const noexcept { return m_value; }
+
+private:
+    std::uint64_t m_value = 0xCBF29CE484222325;
+};
+
+// Identifies a particular build of a module: its file name, link timestamp,
+// image size and section layout. Any client update changes at least one.
+std::uint64_t
+module_key(::HMODULE module, windower::pe_image const& image) noexcept
+{
+    std::array<::WCHAR, MAX_PATH> buffer{};
+    auto const length = ::GetModuleFileNameW(
+        module, buffer.data(), gsl::narrow_cast<::DWORD>(buffer.size()));
+    std::wstring_view name{buffer.data(), length};
+    name = name.substr(name.find_last_of(L"\\/") + 1);
+    std::wstring lower{name};
+    ::CharLowerBuffW(lower.data(), gsl::narrow_cast<::DWORD>(lower.size()));
+
+    fnv1a hash;
+    hash(std::as_bytes(std::span{lower}));
+    hash(image.timestamp());
+    hash(image.image_size());
+    hash(std::as_bytes(image.sections()));
+    return hash.value();
+}
+
+// Returns the keys of every module currently loaded in the process.
+std::unordered_set<std::uint64_t> loaded_module_keys()
+{
+    std::unordered_set<std::uint64_t> result;
+    windower::handle snapshot = ::CreateToolhelp32Snapshot(
+        TH32CS_SNAPMODULE, ::GetCurrentProcessId());
+    if (snapshot)
+    {
+        MODULEENTRY32W entry = {};
+        entry.dwSize         = sizeof entry;
+        if (::Module32FirstW(snapshot, &entry))
+        {
+            do
+            {
+                windower::pe_image const image{
+                    reinterpret_cast<std::byte*>(entry.modBaseAddr)};
+                if (image)
+                {
+                    result.insert(module_key(entry.hModule, image));
+                }
+            } while (::Module32NextW(snapshot, &entry));
+        }
+    }
+    return result;
+}
+
+std::uint64_t signature_key(windower::signature const& sig) noexcept
+{
+    fnv1a hash;
+    hash(sig.size());
+    hash(sig.data());
+    hash(sig.mask());
+    return hash.value();
+}
+
+// Remembers where signatures matched, as RVAs per module build, across
+// launches. Entries are only hints: a cached location is verified against
+// the signature before it is used, and a mismatch falls back to a scan.
+class scan_cache
+{
+public:
+    static scan_cache& instance() noexcept
+    {
+        static scan_cache instance;
+        return instance;
+    }
+
+    std::optional<std::uint32_t>
+    find(std::uint64_t module, std::uint64_t signature) noexcept
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        load();
+        if (auto const it = m_entries.find({module, signature});
+            it != m_entries.end())
+        {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    void insert(
+        std::uint64_t module, std::uint64_t signature,
+        std::uint32_t rva) noexcept
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        load();
+        try
+        {
+            auto& entry = m_entries[{module, signature}];
+            m_dirty     = m_dirty || entry != rva;
+            entry       = rva;
+        }
+        catch (std::bad_alloc const&)
+        {}
+    }
+
+    // Rewrites the file if anything changed, dropping the entries of modules
+    // that are not loaded. Those belong to old client builds, or to modules
+    // an addon scanned once, and would otherwise accumulate forever. If the
+    // module list cannot be read, nothing is dropped.
+    void save() noexcept
+    {
+        namespace fs = std::filesystem;
+
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (!m_dirty)
+            {
+                return;
+            }
+        }
+
+        try
+        {
+            auto const loaded = loaded_module_keys();
+
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_dirty = false;
+            if (!loaded.empty())
+            {
+                std::erase_if(m_entries, [&](auto const& entry) {
+                    return !loaded.contains(entry.first.module);
+                });
+            }
+
+            auto const path = cache_path();
+            fs::create_directories(path.parent_path());
+            std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+            write(stream, magic);
+            write(stream, gsl::narrow_cast<std::uint32_t>(m_entries.size()));
+            for (auto const& [key, rva] : m_entries)
+            {
+                write(stream, key.module);
+                write(stream, key.signature);
+                write(stream, rva);
+            }
+        }
+        catch (std::exception const&)
+        {}
+    }
+
+private:
+    static constexpr std::uint32_t magic = 0x31435357; // "WSC1"
+
+    struct key
+    {
+        std::uint64_t module;
+        std::uint64_t signature;
+
+        bool operator==(key const&) const noexcept = default;
+    };
+
+    struct key_hash
+    {
+        std::size_t operator()(key const& key) const noexcept
+        {
+            return gsl::narrow_cast<std::size_t>(
+                key.module ^ (key.signature * 0x9E3779B97F4A7C15));
+        }
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<key, std::uint32_t, key_hash> m_entries;
+    bool m_loaded = false;
+    bool m_dirty  = false;
+
+    static std::filesystem::path cache_path()
+    {
+        return windower::temp_path() / u8"scan_cache";
+    }
+
+    template<typename T>
+    static void write(std::ostream& stream, T const& value)
+    {
+        GSL_SUPPRESS(type.1)
+        {
+            stream.write(reinterpret_cast<char const*>(&value), sizeof value);
+        }
+    }
+
+    template<typename T>
+    static bool read(std::istream& stream, T& value)
+    {
+        GSL_SUPPRESS(type.1)
+        {
+            return static_cast<bool>(
+                stream.read(reinterpret_cast<char*>(&value), sizeof value));
+        }
+    }
+
+    void load() noexcept
+    {
+        if (m_loaded)
+        {
+            return;
+        }
+        m_loaded = true;
+
+        try
+        {
+            std::ifstream stream{cache_path(), std::ios::binary};
+            auto file_magic = std::uint32_t{};
+            auto count      = std::uint32_t{};
+            if (!read(stream, file_magic) || file_magic != magic ||
+                !read(stream, count))
+            {
+                return;
+            }
+            for (auto i = std::uint32_t{}; i < count; ++i)
+            {
+                key key{};
+                auto rva = std::uint32_t{};
+                if (!read(stream, key.module) ||
+                    !read(stream, key.signature) || !read(stream, rva))
+                {
+                    break;
+                }
+                m_entries.insert_or_assign(key, rva);
+            }
+        }
+        catch (std::exception const&)
+        {
+            m_entries.clear();
+        }
+    }
+};
+
+std::byte* module_base(windower::library const& library) noexcept
+{
+    return library;
+}
+
+}
+
+void windower::scan(
+    library const& library, signature const& sig,
+    std::span<address> results) noexcept
+{
+    pe_image const image{module_base(library)};
+    if (!image)
+    {
+        std::fill(results.begin(), results.end(), nullptr);
+        return;
+    }
+
+    // Only first matches are cached; asking for several results always
+    // scans so that their order and count stay exact.
+    auto const module = module_key(library, image);
+    auto const key    = signature_key(sig);
+    auto& cache       = scan_cache::instance();
+    if (results.size() == 1)
+    {
+        if (auto const rva = cache.find(module, key);
+            rva && matches(image, *rva, sig))
+        {
+            results[0] = resolve(image, *rva, sig);
+            return;
+        }
+    }
+
+    std::vector<std::uint32_t> rvas(results.size());
+    auto const count = locate(image, sig, rvas);
+    if (count != 0)
+    {
+        cache.insert(module, key, rvas[0]);
+        cache.save();
+    }
+    for (auto i = std::size_t{}; i < results.size(); ++i)
+    {
+        results[i] = i < count ? resolve(image, rvas[i], sig) : address{};
+    }
+}
+
+void windower::scan_all(
+    library const& library, std::span<signature const* const> signatures,
+    std::span<address> results) noexcept
+{
+    std::fill(results.begin(), results.end(), nullptr);
+    pe_image const image{module_base(library)};
+    if (!image)
+    {
+        return;
+    }
+
+    auto const module = module_key(library, image);
+    auto& cache       = scan_cache::instance();
+
+    std::vector<signature const*> pending;
+    std::vector<std::size_t> indices;
+    for (auto i = std::size_t{};
+         i < std::min(signatures.size(), results.size()); ++i)
+    {
+        auto const& sig = *signatures[i];
+        if (auto const rva = cache.find(module, signature_key(sig));
+            rva && matches(image, *rva, sig))
+        {
+            results[i] = resolve(image, *rva, sig);
+            continue;
+        }
+        pending.push_back(&sig);
+        indices.push_back(i);
+    }
+
+    if (pending.empty())
+    {
+        return;
+    }
+
+    std::vector<std::optional<std::uint32_t>> rvas(pending.size());
+    locate_all(image, pending, rvas);
+    for (auto i = std::size_t{}; i < pending.size(); ++i)
+    {
+        if (rvas[i])
+        {
+            auto const& sig = *pending[i];
+            cache.insert(module, signature_key(sig), *rvas[i]);
+            results[indices[i]] = resolve(image, *rvas[i], sig);
+        }
+    }
+    cache.save();
+}
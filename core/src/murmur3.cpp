@@ -0,0 +1,137 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "murmur3.hpp"
+
+#include <gsl/gsl>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace
+{
+
+constexpr std::uint32_t murmur3_c1 = 0xCC9E2D51;
+constexpr std::uint32_t murmur3_c2 = 0x1B873593;
+
+constexpr std::uint32_t scramble(std::uint32_t k) noexcept
+{
+    return std::rotl(k * murmur3_c1, 15) * murmur3_c2;
+}
+
+constexpr std::uint32_t block(std::uint32_t h, std::uint32_t k) noexcept
+{
+    return std::rotl(h ^ scramble(k), 13) * 5 + 0xE6546B64;
+}
+
+constexpr std::uint32_t
+finish(std::uint32_t h, std::uint32_t tail, std::uint32_t length) noexcept
+{
+    if (tail != 0)
+    {
+        h ^= scramble(tail);
+    }
+    h ^= length;
+    h = (h ^ (h >> 16)) * 0x85EBCA6B;
+    h = (h ^ (h >> 13)) * 0xC2B2AE35;
+    return h ^ (h >> 16);
+}
+
+std::uint32_t load_block(std::byte const* data) noexcept
+{
+    std::uint32_t result;
+    std::memcpy(&result, data, sizeof result);
+    return result;
+}
+
+std::uint32_t load_tail(std::span<std::byte const> data) noexcept
+{
+    auto tail = std::uint32_t{};
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        tail |= std::to_integer<std::uint32_t>(data[i]) << (i * 8);
+    }
+    return tail;
+}
+
+}
+
+std::uint32_t windower::murmur3::hash(
+    std::span<std::byte const> data, std::uint32_t seed) noexcept
+{
+    auto h           = seed;
+    auto const count = data.size() & ~std::size_t{3};
+    for (std::size_t i = 0; i < count; i += 4)
+    {
+        h = block(h, load_block(data.data() + i));
+    }
+    return finish(
+        h, load_tail(data.subspan(count)),
+        gsl::narrow_cast<std::uint32_t>(data.size()));
+}
+
+void windower::murmur3::reset(std::uint32_t seed) noexcept
+{
+    m_hash      = seed;
+    m_tail      = 0;
+    m_tail_size = 0;
+    m_length    = 0;
+}
+
+void windower::murmur3::update(std::span<std::byte const> data) noexcept
+{
+    m_length += gsl::narrow_cast<std::uint32_t>(data.size());
+    while (m_tail_size != 0 && !data.empty())
+    {
+        m_tail |= std::to_integer<std::uint32_t>(data.front())
+               << (m_tail_size * 8);
+        data = data.subspan(1);
+        if (++m_tail_size == 4)
+        {
+            m_hash      = block(m_hash, m_tail);
+            m_tail      = 0;
+            m_tail_size = 0;
+        }
+    }
+
+    auto const count = data.size() & ~std::size_t{3};
+    for (std::size_t i = 0; i < count; i += 4)
+    {
+        m_hash = block(m_hash, load_block(data.data() + i));
+    }
+    if (count != data.size())
+    {
+        m_tail      = load_tail(data.subspan(count));
+        m_tail_size = gsl::narrow_cast<std::uint32_t>(data.size() - count);
+    }
+}
+
+std::uint32_t windower::murmur3::digest() const noexcept
+{
+    return finish(m_hash, m_tail, m_length);
+}
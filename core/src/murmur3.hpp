@@ -0,0 +1,57 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef WINDOWER_MURMUR3_HPP
+#define WINDOWER_MURMUR3_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace windower
+{
+
+// 32-bit MurmurHash3 (x86_32). The incremental state is plain data so that
+// core.hash can hand it to Lua as an FFI struct; hash.lua mirrors its layout.
+class murmur3
+{
+public:
+    static std::uint32_t
+    hash(std::span<std::byte const> data, std::uint32_t seed) noexcept;
+
+    void reset(std::uint32_t seed) noexcept;
+    void update(std::span<std::byte const> data) noexcept;
+    std::uint32_t digest() const noexcept;
+
+private:
+    std::uint32_t m_hash;
+    std::uint32_t m_tail;
+    std::uint32_t m_tail_size;
+    std::uint32_t m_length;
+};
+
+}
+
+#endif
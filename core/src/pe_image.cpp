@@ -0,0 +1,259 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pe_image.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <optional>
+#include <utility>
+
+namespace
+{
+
+// Reads little-endian header fields without assuming the buffer is aligned,
+// refusing any read past the end of the available bytes.
+class header_reader
+{
+public:
+    header_reader(std::byte const* data, std::size_t size) noexcept :
+        m_data{data}, m_size{size}
+    {}
+
+    template<typename T>
+    std::optional<T> read(std::size_t offset) const noexcept
+    {
+        if (offset > m_size || m_size - offset < sizeof(T))
+        {
+            return std::nullopt;
+        }
+        T result;
+        std::memcpy(&result, std::next(m_data, offset), sizeof(T));
+        return result;
+    }
+
+private:
+    std::byte const* m_data;
+    std::size_t m_size;
+};
+
+}
+
+struct windower::pe_image::headers
+{
+    struct raw_section
+    {
+        pe_section section;
+        std::uint32_t raw_size;
+        std::uint32_t raw_offset;
+    };
+
+    std::uint32_t timestamp;
+    std::uint32_t image_size;
+    std::uint32_t headers_size;
+    std::vector<raw_section> sections;
+
+    static std::optional<headers> parse(header_reader const& reader)
+    {
+        constexpr auto dos_signature      = std::uint16_t{0x5A4D};
+        constexpr auto nt_signature       = std::uint32_t{0x00004550};
+        constexpr auto machine_i386       = std::uint16_t{0x014C};
+        constexpr auto file_header_size   = std::size_t{20};
+        constexpr auto section_entry_size = std::size_t{40};
+
+        auto const magic = reader.read<std::uint16_t>(0);
+        auto const nt    = reader.read<std::uint32_t>(0x3C);
+        if (!magic || *magic != dos_signature || !nt ||
+            reader.read<std::uint32_t>(*nt) != nt_signature ||
+            reader.read<std::uint16_t>(*nt + 4) != machine_i386)
+        {
+            return std::nullopt;
+        }
+
+        auto const file_header   = std::size_t{*nt} + 4;
+        auto const section_count = reader.read<std::uint16_t>(file_header + 2);
+        auto const timestamp     = reader.read<std::uint32_t>(file_header + 4);
+        auto const optional_size = reader.read<std::uint16_t>(file_header + 16);
+
+        auto const optional     = file_header + file_header_size;
+        auto const image_size   = reader.read<std::uint32_t>(optional + 56);
+        auto const headers_size = reader.read<std::uint32_t>(optional + 60);
+        if (!section_count || !timestamp || !optional_size || !image_size ||
+            !headers_size)
+        {
+            return std::nullopt;
+        }
+
+        headers result{*timestamp, *image_size, *headers_size, {}};
+        result.sections.reserve(*section_count);
+        auto const table = optional + *optional_size;
+        for (auto i = std::size_t{}; i < *section_count; ++i)
+        {
+            auto const entry           = table + i * section_entry_size;
+            auto const virtual_size    = reader.read<std::uint32_t>(entry + 8);
+            auto const virtual_address = reader.read<std::uint32_t>(entry + 12);
+            auto const raw_size        = reader.read<std::uint32_t>(entry + 16);
+            auto const raw_offset      = reader.read<std::uint32_t>(entry + 20);
+            auto const characteristics = reader.read<std::uint32_t>(entry + 36);
+            if (!virtual_size || !virtual_address || !raw_size || !raw_offset ||
+                !characteristics)
+            {
+                return std::nullopt;
+            }
+            result.sections.push_back(
+                {{*virtual_address, *virtual_size, *characteristics},
+                 *raw_size,
+                 *raw_offset});
+        }
+        return result;
+    }
+};
+
+windower::pe_image
+windower::pe_image::load(std::filesystem::path const& path)
+{
+    std::ifstream stream{path, std::ios::binary | std::ios::ate};
+    if (!stream)
+    {
+        return {};
+    }
+    auto const file_size = static_cast<std::size_t>(stream.tellg());
+    std::vector<std::byte> file(file_size);
+    stream.seekg(0);
+    GSL_SUPPRESS(type.1)
+    {
+        if (!stream.read(
+                reinterpret_cast<char*>(file.data()),
+                gsl::narrow<std::streamsize>(file.size())))
+        {
+            return {};
+        }
+    }
+
+    auto const headers = headers::parse({file.data(), file.size()});
+    if (!headers || headers->headers_size > headers->image_size)
+    {
+        return {};
+    }
+
+    // Lay the file out the way the loader would: headers at the start and
+    // each section's raw data at its virtual address, zero-filled past the
+    // end of the raw data.
+    auto storage = std::make_shared<std::byte[]>(headers->image_size);
+    auto const image =
+        std::span<std::byte>{storage.get(), headers->image_size};
+    auto const header_bytes =
+        std::min<std::size_t>(headers->headers_size, file.size());
+    std::copy_n(file.begin(), header_bytes, image.begin());
+    for (auto const& raw : headers->sections)
+    {
+        auto const address = std::size_t{raw.section.virtual_address};
+        if (address >= image.size() || raw.raw_offset >= file.size())
+        {
+            continue;
+        }
+        auto const size = std::min<std::size_t>(
+            {raw.raw_size, raw.section.virtual_size, image.size() - address,
+             file.size() - raw.raw_offset});
+        std::copy_n(
+            std::next(file.begin(), raw.raw_offset), size,
+            std::next(image.begin(), address));
+    }
+
+    pe_image result{storage.get(), *headers};
+    result.m_storage = std::move(storage);
+    return result;
+}
+
+windower::pe_image::pe_image(std::byte* base) noexcept
+{
+    if (!base)
+    {
+        return;
+    }
+
+    // A mapped module's headers are trusted: the loader has already
+    // validated them.
+    try
+    {
+        if (auto const headers = headers::parse(
+                {base, std::numeric_limits<std::size_t>::max()}))
+        {
+            *this = pe_image{base, *headers};
+        }
+    }
+    catch (std::bad_alloc const&)
+    {}
+}
+
+windower::pe_image::pe_image(std::byte* base, headers const& headers) :
+    m_base{base}, m_timestamp{headers.timestamp},
+    m_image_size{headers.image_size}
+{
+    m_sections.reserve(headers.sections.size());
+    for (auto const& raw : headers.sections)
+    {
+        m_sections.push_back(raw.section);
+    }
+}
+
+windower::pe_image::operator bool() const noexcept
+{
+    return m_base != nullptr;
+}
+
+std::byte* windower::pe_image::base() const noexcept { return m_base; }
+
+std::uint32_t windower::pe_image::timestamp() const noexcept
+{
+    return m_timestamp;
+}
+
+std::uint32_t windower::pe_image::image_size() const noexcept
+{
+    return m_image_size;
+}
+
+std::span<windower::pe_section const>
+windower::pe_image::sections() const noexcept
+{
+    return m_sections;
+}
+
+std::span<std::byte>
+windower::pe_image::section_data(pe_section const& section) const noexcept
+{
+    if (section.virtual_address >= m_image_size)
+    {
+        return {};
+    }
+    auto const size = std::min(
+        section.virtual_size, m_image_size - section.virtual_address);
+    return {std::next(m_base, section.virtual_address), size};
+}
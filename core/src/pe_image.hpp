@@ -0,0 +1,83 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_PE_IMAGE_HPP
+#define WINDOWER_PE_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace windower
+{
+
+struct pe_section
+{
+    std::uint32_t virtual_address;
+    std::uint32_t virtual_size;
+    std::uint32_t characteristics;
+
+    constexpr bool executable() const noexcept
+    {
+        return (characteristics & 0x20000000) != 0;
+    }
+};
+
+// A 32-bit PE image laid out at its virtual addresses. Images either refer
+// to a module already mapped by the loader or own a copy read from disk, so
+// the same scanning code runs in process and offline.
+class pe_image
+{
+public:
+    static pe_image load(std::filesystem::path const& path);
+
+    pe_image() noexcept = default;
+    explicit pe_image(std::byte* base) noexcept;
+
+    explicit operator bool() const noexcept;
+
+    std::byte* base() const noexcept;
+    std::uint32_t timestamp() const noexcept;
+    std::uint32_t image_size() const noexcept;
+    std::span<pe_section const> sections() const noexcept;
+    std::span<std::byte> section_data(pe_section const& section) const noexcept;
+
+private:
+    std::shared_ptr<std::byte[]> m_storage;
+    std::byte* m_base          = nullptr;
+    std::uint32_t m_timestamp  = 0;
+    std::uint32_t m_image_size = 0;
+    std::vector<pe_section> m_sections;
+
+    struct headers;
+
+    pe_image(std::byte* base, headers const& headers);
+};
+
+}
+
+#endif
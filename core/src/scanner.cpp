@@ -24,115 +24,541 @@
 
 #include "scanner.hpp"
 
-#include "library.hpp"
+#include "pe_image.hpp"
 
-#include <windows.h>
+#include <gsl/gsl>
+
+#include <emmintrin.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <bit>
 #include <cstddef>
-#include <functional>
+#include <cstdint>
+#include <exception>
+#include <numeric>
 #include <optional>
 #include <span>
+#include <thread>
+#include <vector>
 
 namespace
 {
 
-std::span<::IMAGE_SECTION_HEADER const>
-get_sections(windower::library const& library) noexcept
+// Rough ranking of the bytes that dominate x86 code, most common first.
+// Anchoring on bytes outside this list keeps the candidate count low.
+constexpr std::array<std::uint8_t, 256> byte_frequency = [] {
+    constexpr std::array<std::uint8_t, 48> common{
+        0x00, 0xFF, 0x8B, 0x89, 0x45, 0x24, 0x04, 0x08, 0x0F, 0x83,
+        0xE8, 0x85, 0x75, 0x74, 0x50, 0x55, 0xEC, 0x8D, 0xC0, 0x01,
+        0x10, 0x4D, 0x56, 0x57, 0x51, 0x53, 0x5D, 0x5E, 0x5F, 0x6A,
+        0x33, 0xC3, 0xCC, 0x90, 0x44, 0x0C, 0x14, 0x18, 0xF8, 0xFC,
+        0x40, 0xC7, 0x46, 0x4E, 0x02, 0x03, 0x84, 0xEB,
+    };
+    std::array<std::uint8_t, 256> result{};
+    for (auto i = std::size_t{}; i < common.size(); ++i)
+    {
+        result.at(common.at(i)) =
+            gsl::narrow_cast<std::uint8_t>(common.size() - i);
+    }
+    return result;
+}();
+
+struct anchor_pair
+{
+    std::size_t first;
+    std::size_t second;
+};
+
+// A signature made only of wildcards has nothing to search for. It would
+// match everywhere, so every search treats it as never matching instead.
+bool has_fixed_byte(windower::signature const& sig) noexcept
 {
-    std::byte const* const base = library;
+    auto const mask = sig.mask();
+    return std::find(mask.begin(), mask.end(), std::byte{0xFF}) != mask.end();
+}
+
+// Picks the two least common non-wildcard bytes of the signature, or nothing
+// if it has none.
+std::optional<anchor_pair>
+select_anchors(windower::signature const& sig) noexcept
+{
+    auto const sig_data = sig.data();
+    auto const sig_mask = sig.mask();
+    auto const rank     = [&](std::size_t i) {
+        return byte_frequency.at(std::to_integer<std::uint8_t>(sig_data[i]));
+    };
 
-    auto dos_header = std::bit_cast<::IMAGE_DOS_HEADER const*>(base);
-    if (dos_header->e_magic != IMAGE_DOS_SIGNATURE)
+    auto first  = sig.size();
+    auto second = sig.size();
+    for (auto i = std::size_t{}; i < sig.size(); ++i)
     {
-        return {};
+        if (sig_mask[i] != std::byte{0xFF})
+        {
+            continue;
+        }
+        if (first == sig.size() || rank(i) < rank(first))
+        {
+            second = first;
+            first  = i;
+        }
+        else if (second == sig.size() || rank(i) < rank(second))
+        {
+            second = i;
+        }
     }
-
-    auto nt_header = std::bit_cast<::IMAGE_NT_HEADERS const*>(
-        std::next(base, dos_header->e_lfanew));
-    if (nt_header->Signature != IMAGE_NT_SIGNATURE ||
-        nt_header->FileHeader.Machine != IMAGE_FILE_MACHINE_I386)
+    if (first == sig.size())
     {
-        return {};
+        return std::nullopt;
     }
-
-    return std::span<::IMAGE_SECTION_HEADER const>{
-        std::bit_cast<::IMAGE_SECTION_HEADER const*>(std::next(
-            base, dos_header->e_lfanew + sizeof(nt_header->Signature) +
-                      sizeof(nt_header->FileHeader) +
-                      nt_header->FileHeader.SizeOfOptionalHeader)),
-        nt_header->FileHeader.NumberOfSections};
+    return anchor_pair{first, second == sig.size() ? first : second};
 }
 
-std::span<std::byte> get_data(
-    windower::library const& library,
-    ::IMAGE_SECTION_HEADER const& section) noexcept
+// Checks the whole signature against the start of data. The signature's
+// data and mask arrays are zero-padded to max_size, so when the section has
+// that much room left they can be compared a full vector at a time.
+bool matches_at(
+    std::span<std::byte const> data, windower::signature const& sig) noexcept
 {
-    if ((section.Characteristics & IMAGE_SCN_MEM_EXECUTE) == 0)
+    auto const sig_data = sig.data();
+    auto const sig_mask = sig.mask();
+    if (data.size() < windower::signature::max_size)
+    {
+        for (auto i = std::size_t{}; i < sig.size(); ++i)
+        {
+            if ((data[i] & sig_mask[i]) != sig_data[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
     {
-        return {};
+        auto difference = _mm_setzero_si128();
+        for (auto i = std::size_t{}; i < sig.size(); i += 16)
+        {
+            auto const chunk = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(data.data() + i));
+            auto const mask = _mm_load_si128(
+                reinterpret_cast<__m128i const*>(sig_mask.data() + i));
+            auto const expected = _mm_load_si128(
+                reinterpret_cast<__m128i const*>(sig_data.data() + i));
+            difference = _mm_or_si128(
+                difference,
+                _mm_xor_si128(_mm_and_si128(chunk, mask), expected));
+        }
+        return _mm_movemask_epi8(
+                   _mm_cmpeq_epi8(difference, _mm_setzero_si128())) == 0xFFFF;
     }
-    std::byte* const base = library;
-    auto const ptr        = std::next(base, section.VirtualAddress);
-    auto const size       = section.Misc.VirtualSize;
-    return std::span<std::byte>{ptr, size};
 }
 
 std::span<std::byte>::iterator
-match(std::span<std::byte> data, windower::signature const& sig)
+match(std::span<std::byte> data, windower::signature const& sig) noexcept
 {
+    auto const anchor_choice = select_anchors(sig);
+    if (!anchor_choice || sig.size() > data.size())
+    {
+        return data.end();
+    }
+
     auto const sig_data = sig.data();
-    auto const sig_mask = sig.mask();
-    auto it             = data.begin();
-    auto end            = std::prev(data.end(), sig.size());
-    while (true)
+    auto const anchors  = *anchor_choice;
+    auto const first    = sig_data[anchors.first];
+    auto const second   = sig_data[anchors.second];
+    auto const bytes    = data.data();
+    auto const last     = data.size() - sig.size();
+    auto i              = std::size_t{};
+
+    // Sixteen candidate positions are filtered at once by comparing both
+    // anchor bytes; only positions where both agree are verified in full.
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
     {
-        it = std::find(it, end, *sig_data.begin());
-        if (it == end)
+        auto const first_vector =
+            _mm_set1_epi8(std::to_integer<char>(first));
+        auto const second_vector =
+            _mm_set1_epi8(std::to_integer<char>(second));
+        for (; i + 16 <= last + 1; i += 16)
         {
-            return data.end();
+            auto const first_chunk = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(bytes + i + anchors.first));
+            auto const second_chunk = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(bytes + i + anchors.second));
+            auto candidates = static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(first_chunk, first_vector),
+                    _mm_cmpeq_epi8(second_chunk, second_vector))));
+            while (candidates != 0)
+            {
+                auto const candidate = i + std::countr_zero(candidates);
+                if (matches_at(data.subspan(candidate), sig))
+                {
+                    return std::next(data.begin(), candidate);
+                }
+                candidates &= candidates - 1;
+            }
         }
-        auto const is_match = std::equal(
-            sig_data.begin() + 1, sig_data.end(), it + 1,
-            [mask_it = sig_mask.begin() + 1](auto a, auto b) mutable {
-                return a == (b & *mask_it++);
-            });
-        if (is_match)
+    }
+
+    for (; i <= last; ++i)
+    {
+        if (data[i + anchors.first] == first &&
+            data[i + anchors.second] == second &&
+            matches_at(data.subspan(i), sig))
+        {
+            return std::next(data.begin(), i);
+        }
+    }
+    return data.end();
+}
+
+struct pending_signature
+{
+    windower::signature const* sig;
+    std::size_t anchor;
+    std::size_t index;
+};
+
+// Sections at least this large in total are scanned in parallel, split
+// into chunks of chunk_size candidate positions.
+constexpr std::size_t parallel_threshold = 0x400000;
+constexpr std::size_t chunk_size         = 0x100000;
+
+// A run of candidate match positions in one section. The data extends past
+// the owned positions by the overlap, so that matches starting near the end
+// of a chunk can still be verified; matches starting in the overlap belong
+// to the next chunk.
+struct chunk
+{
+    std::uint32_t rva;
+    std::span<std::byte> data;
+    std::size_t length;
+};
+
+bool is_parallel(windower::pe_image const& image) noexcept
+{
+    auto total = std::size_t{};
+    for (auto const& section : image.sections())
+    {
+        if (section.executable())
+        {
+            total += image.section_data(section).size();
+        }
+    }
+    return total >= parallel_threshold &&
+           std::thread::hardware_concurrency() > 1;
+}
+
+std::vector<chunk> split(
+    windower::pe_image const& image, std::size_t overlap, bool parallel)
+{
+    std::vector<chunk> result;
+    for (auto const& section : image.sections())
+    {
+        if (!section.executable())
+        {
+            continue;
+        }
+        auto const data = image.section_data(section);
+        auto const step = parallel ? chunk_size : data.size();
+        for (auto begin = std::size_t{}; begin < data.size(); begin += step)
+        {
+            auto const length = std::min(step, data.size() - begin);
+            auto const size   = std::min(length + overlap, data.size() - begin);
+            result.push_back(
+                {section.virtual_address +
+                     gsl::narrow_cast<std::uint32_t>(begin),
+                 data.subspan(begin, size), length});
+        }
+    }
+    return result;
+}
+
+// Runs work(i) for every chunk index, spreading the indices over worker
+// threads and the calling thread. Lower indices are handed out first.
+template<typename F>
+void for_each_chunk(std::size_t count, F const& work) noexcept
+{
+    std::atomic<std::size_t> next{0};
+    auto const run = [&]() noexcept {
+        for (auto i = next++; i < count; i = next++)
+        {
+            work(i);
+        }
+    };
+
+    auto const workers =
+        std::min<std::size_t>(std::thread::hardware_concurrency(), count);
+    std::vector<std::thread> threads;
+    try
+    {
+        threads.reserve(workers);
+        for (auto i = std::size_t{1}; i < workers; ++i)
+        {
+            threads.emplace_back(run);
+        }
+    }
+    catch (std::exception const&)
+    {}
+    run();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void lower(std::atomic<std::size_t>& value, std::size_t bound) noexcept
+{
+    auto current = value.load(std::memory_order_relaxed);
+    while (bound < current &&
+           !value.compare_exchange_weak(
+               current, bound, std::memory_order_relaxed))
+    {}
+}
+
+// Stores the RVAs of up to limit matches owned by the chunk.
+template<typename Output>
+void locate_in(
+    chunk const& chunk, windower::signature const& sig, std::size_t limit,
+    Output output)
+{
+    auto data = chunk.data;
+    auto it   = match(data, sig);
+    for (auto found = std::size_t{}; found < limit && it != data.end();
+         ++found)
+    {
+        auto const offset = gsl::narrow_cast<std::size_t>(
+            std::distance(chunk.data.begin(), it));
+        if (offset >= chunk.length)
+        {
+            break;
+        }
+        output(chunk.rva + gsl::narrow_cast<std::uint32_t>(offset));
+        data = chunk.data.subspan(offset + 1);
+        it   = match(data, sig);
+    }
+}
+
+// Stores the first match owned by the chunk for each listed signature.
+void locate_all_in(
+    chunk const& chunk, std::span<windower::signature const* const> signatures,
+    std::span<std::size_t const> indices,
+    std::span<std::optional<std::uint32_t>> rvas)
+{
+    // Signatures are bucketed by their first non-wildcard byte, so each byte
+    // of code costs one table lookup no matter how many signatures remain.
+    std::array<std::vector<pending_signature>, 256> buckets;
+    auto remaining = std::size_t{};
+    for (auto const index : indices)
+    {
+        auto const& sig   = *signatures[index];
+        auto const mask   = sig.mask();
+        auto const anchor = static_cast<std::size_t>(std::distance(
+            mask.begin(),
+            std::find(mask.begin(), mask.end(), std::byte{0xFF})));
+        if (anchor == sig.size())
+        {
+            continue;
+        }
+        auto const first = std::to_integer<std::uint8_t>(sig.data()[anchor]);
+        buckets[first].push_back({&sig, anchor, index});
+        ++remaining;
+    }
+
+    auto const data = chunk.data;
+    for (auto i = std::size_t{}; remaining != 0 && i < data.size(); ++i)
+    {
+        auto& bucket = buckets[std::to_integer<std::uint8_t>(data[i])];
+        for (auto it = bucket.begin(); it != bucket.end();)
         {
-            return it;
+            auto const& sig  = *it->sig;
+            auto const start = i - it->anchor;
+            if (i < it->anchor || start >= chunk.length ||
+                start + sig.size() > data.size() ||
+                !matches_at(data.subspan(start), sig))
+            {
+                ++it;
+                continue;
+            }
+            rvas[it->index] =
+                chunk.rva + gsl::narrow_cast<std::uint32_t>(start);
+            it = bucket.erase(it);
+            --remaining;
         }
-        ++it;
     }
 }
 
 }
 
-void windower::scan(
-    library const& library, signature const& sig,
-    std::span<address> results) noexcept
+std::size_t windower::locate(
+    pe_image const& image, signature const& sig,
+    std::span<std::uint32_t> rvas) noexcept
 {
-    if (library)
+    if (rvas.empty() || !has_fixed_byte(sig))
+    {
+        return 0;
+    }
+
+    auto const parallel = is_parallel(image);
+    auto const chunks   = split(image, sig.size() - 1, parallel);
+    auto count          = std::size_t{};
+    if (!parallel)
     {
-        for (auto const& section : get_sections(library))
+        for (auto const& chunk : chunks)
         {
-            auto section_data = get_data(library, section);
-            auto it           = match(section_data, sig);
-            while (!results.empty() && it != section_data.end())
+            locate_in(chunk, sig, rvas.size() - count, [&](std::uint32_t rva) {
+                rvas[count++] = rva;
+            });
+            if (count == rvas.size())
             {
-                auto result = address{&*it};
-                result += sig.offset();
-                *results.begin() = sig.dereference() ? *result : result;
-                results          = results.subspan(1);
-                section_data     = section_data.subspan(
-                        std::distance(section_data.begin(), it));
-                it = match(section_data, sig);
+                break;
             }
-            if (results.empty())
+        }
+        return count;
+    }
+
+    // Chunks after one that alone holds enough matches cannot contribute,
+    // so they are skipped once such a chunk is known.
+    std::vector<std::vector<std::uint32_t>> found(chunks.size());
+    std::atomic<std::size_t> cutoff{chunks.size()};
+    for_each_chunk(chunks.size(), [&](std::size_t index) noexcept {
+        if (index > cutoff.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        auto& output = found[index];
+        locate_in(chunks[index], sig, rvas.size(), [&](std::uint32_t rva) {
+            output.push_back(rva);
+        });
+        if (output.size() == rvas.size())
+        {
+            lower(cutoff, index);
+        }
+    });
+
+    for (auto const& chunk_rvas : found)
+    {
+        for (auto const rva : chunk_rvas)
+        {
+            if (count == rvas.size())
             {
-                return;
+                return count;
             }
+            rvas[count++] = rva;
         }
     }
-    std::fill(results.begin(), results.end(), nullptr);
+    return count;
+}
+
+void windower::locate_all(
+    pe_image const& image, std::span<signature const* const> signatures,
+    std::span<std::optional<std::uint32_t>> rvas) noexcept
+{
+    std::fill(rvas.begin(), rvas.end(), std::nullopt);
+
+    auto const count = std::min(signatures.size(), rvas.size());
+    auto overlap     = std::size_t{};
+    for (auto i = std::size_t{}; i < count; ++i)
+    {
+        overlap = std::max(overlap, signatures[i]->size());
+    }
+    if (overlap == 0)
+    {
+        return;
+    }
+
+    auto const parallel = is_parallel(image);
+    auto const chunks   = split(image, overlap - 1, parallel);
+    if (!parallel)
+    {
+        std::vector<std::size_t> indices(count);
+        std::iota(indices.begin(), indices.end(), std::size_t{});
+        for (auto const& chunk : chunks)
+        {
+            std::erase_if(indices, [&](std::size_t i) {
+                return rvas[i].has_value();
+            });
+            if (indices.empty())
+            {
+                break;
+            }
+            locate_all_in(chunk, signatures, indices, rvas);
+        }
+        return;
+    }
+
+    // Each chunk records its own first matches; the lowest chunk with a
+    // match wins. A chunk skips signatures already found in an earlier one.
+    std::vector<std::atomic<std::size_t>> best(count);
+    for (auto& value : best)
+    {
+        value.store(chunks.size(), std::memory_order_relaxed);
+    }
+    std::vector<std::vector<std::optional<std::uint32_t>>> found(chunks.size());
+    for_each_chunk(chunks.size(), [&](std::size_t index) noexcept {
+        std::vector<std::size_t> indices;
+        for (auto i = std::size_t{}; i < count; ++i)
+        {
+            if (best[i].load(std::memory_order_relaxed) > index)
+            {
+                indices.push_back(i);
+            }
+        }
+        if (indices.empty())
+        {
+            return;
+        }
+        auto& output = found[index];
+        output.resize(count);
+        locate_all_in(chunks[index], signatures, indices, output);
+        for (auto const i : indices)
+        {
+            if (output[i])
+            {
+                lower(best[i], index);
+            }
+        }
+    });
+
+    for (auto i = std::size_t{}; i < count; ++i)
+    {
+        if (auto const index = best[i].load(); index < chunks.size())
+        {
+            rvas[i] = found[index][i];
+        }
+    }
+}
+
+bool windower::matches(
+    pe_image const& image, std::uint32_t rva, signature const& sig) noexcept
+{
+    if (!has_fixed_byte(sig))
+    {
+        return false;
+    }
+    for (auto const& section : image.sections())
+    {
+        auto const data = image.section_data(section);
+        if (!section.executable() || rva < section.virtual_address ||
+            rva - section.virtual_address >= data.size())
+        {
+            continue;
+        }
+        auto const offset = rva - section.virtual_address;
+        return offset + sig.size() <= data.size() &&
+               matches_at(data.subspan(offset), sig);
+    }
+    return false;
+}
+
+windower::address windower::resolve(
+    pe_image const& image, std::uint32_t rva, signature const& sig) noexcept
+{
+    auto result = address{std::next(image.base(), rva)};
+    result += sig.offset();
+    return sig.dereference() ? *result : result;
 }
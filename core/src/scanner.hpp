@@ -27,6 +27,7 @@
 
 #include "errors/syntax_error.hpp"
 #include "library.hpp"
+#include "pe_image.hpp"
 #include "utility.hpp"
 
 #include <gsl/gsl>
@@ -35,8 +36,10 @@
 #include <bit>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <new>
+#include <optional>
 #include <span>
 #include <string_view>
 #include <type_traits>
@@ -274,6 +277,37 @@ private:
     }
 };
 
+// Searches the executable sections of an image, storing the RVA of up to
+// rvas.size() matches in address order, and returns how many were found.
+// RVAs locate the start of a match, before offset and dereference apply.
+// A signature made only of wildcards never matches, here or in locate_all
+// and matches.
+std::size_t locate(
+    pe_image const& image, signature const& sig,
+    std::span<std::uint32_t> rvas) noexcept;
+
+inline std::optional<std::uint32_t>
+locate(pe_image const& image, signature const& sig) noexcept
+{
+    std::uint32_t rva = 0;
+    if (locate(image, sig, {&rva, 1}) == 0)
+    {
+        return std::nullopt;
+    }
+    return rva;
+}
+
+// Locates the first match of several signatures in a single pass.
+void locate_all(
+    pe_image const& image, std::span<signature const* const> signatures,
+    std::span<std::optional<std::uint32_t>> rvas) noexcept;
+
+bool matches(
+    pe_image const& image, std::uint32_t rva, signature const& sig) noexcept;
+
+address resolve(
+    pe_image const& image, std::uint32_t rva, signature const& sig) noexcept;
+
 void scan(
     library const& library, signature const& sig,
     std::span<address> results) noexcept;
@@ -315,6 +349,30 @@ scan(std::u8string_view library_name, signature const& sig) noexcept
     return results;
 }
 
+// Resolves several signatures with a single pass over the library's code,
+// storing the first match of each signature in the corresponding result.
+void scan_all(
+    library const& library, std::span<signature const* const> signatures,
+    std::span<address> results) noexcept;
+
+template<std::same_as<signature>... Signatures>
+std::array<address, sizeof...(Signatures)>
+scan_all(library const& library, Signatures const&... signatures) noexcept
+{
+    std::array<signature const*, sizeof...(Signatures)> const pointers{
+        &signatures...};
+    std::array<address, sizeof...(Signatures)> results;
+    scan_all(library, pointers, results);
+    return results;
+}
+
+template<std::same_as<signature>... Signatures>
+std::array<address, sizeof...(Signatures)> scan_all(
+    std::u8string_view library_name, Signatures const&... signatures) noexcept
+{
+    return scan_all(library{library_name}, signatures...);
+}
+
 }
 
 #endif
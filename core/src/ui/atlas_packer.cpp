@@ -0,0 +1,168 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/atlas_packer.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+namespace windower::ui
+{
+
+atlas_packer::atlas_packer(
+    std::uint16_t width, std::uint16_t height) noexcept :
+    m_width{width}, m_height{height}
+{
+    clear();
+}
+
+std::uint16_t atlas_packer::width() const noexcept { return m_width; }
+
+std::uint16_t atlas_packer::height() const noexcept { return m_height; }
+
+std::uint32_t atlas_packer::used_area() const noexcept { return m_used_area; }
+
+std::optional<atlas_region>
+atlas_packer::insert(std::uint16_t width, std::uint16_t height) noexcept
+{
+    if (width == 0 || height == 0)
+    {
+        return std::nullopt;
+    }
+
+    auto best_index = m_skyline.size();
+    auto best_y     = std::uint16_t{};
+    auto best_top   = std::numeric_limits<std::uint32_t>::max();
+    auto best_width = std::numeric_limits<std::uint16_t>::max();
+    for (auto i = std::size_t{0}; i < m_skyline.size(); ++i)
+    {
+        if (auto const y = fit(i, width, height))
+        {
+            auto const top           = std::uint32_t{*y} + height;
+            auto const segment_width = gsl::at(m_skyline, i).width;
+            if (top < best_top ||
+                (top == best_top && segment_width < best_width))
+            {
+                best_index = i;
+                best_y     = *y;
+                best_top   = top;
+                best_width = segment_width;
+            }
+        }
+    }
+
+    if (best_index == m_skyline.size())
+    {
+        return std::nullopt;
+    }
+
+    auto const region =
+        atlas_region{gsl::at(m_skyline, best_index).x, best_y, width, height};
+
+    auto const it = std::next(
+        m_skyline.begin(), gsl::narrow_cast<std::ptrdiff_t>(best_index));
+    m_skyline.insert(
+        it,
+        {region.x, gsl::narrow_cast<std::uint16_t>(best_top), region.width});
+
+    // The new segment covers part of the ones after it; drop those it hides
+    // completely and shorten the first one it only overlaps.
+    for (auto i = best_index + 1; i < m_skyline.size();)
+    {
+        auto const& previous = gsl::at(m_skyline, i - 1);
+        auto& current        = gsl::at(m_skyline, i);
+        auto const end       = previous.x + previous.width;
+        if (current.x >= end)
+        {
+            break;
+        }
+        auto const overlap = end - current.x;
+        if (current.width > overlap)
+        {
+            current.x     = gsl::narrow_cast<std::uint16_t>(end);
+            current.width = gsl::narrow_cast<std::uint16_t>(
+                current.width - overlap);
+            break;
+        }
+        m_skyline.erase(
+            std::next(m_skyline.begin(), gsl::narrow_cast<std::ptrdiff_t>(i)));
+    }
+
+    for (auto i = std::size_t{0}; i + 1 < m_skyline.size();)
+    {
+        auto& current    = gsl::at(m_skyline, i);
+        auto const& next = gsl::at(m_skyline, i + 1);
+        if (current.y == next.y)
+        {
+            current.width = gsl::narrow_cast<std::uint16_t>(
+                current.width + next.width);
+            m_skyline.erase(std::next(
+                m_skyline.begin(), gsl::narrow_cast<std::ptrdiff_t>(i + 1)));
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    m_used_area += region.area();
+    return region;
+}
+
+void atlas_packer::clear() noexcept
+{
+    m_skyline.clear();
+    m_skyline.push_back({0, 0, m_width});
+    m_used_area = 0;
+}
+
+std::optional<std::uint16_t> atlas_packer::fit(
+    std::size_t index, std::uint16_t width, std::uint16_t height) const noexcept
+{
+    if (gsl::at(m_skyline, index).x + width > m_width)
+    {
+        return std::nullopt;
+    }
+
+    auto y         = std::uint16_t{};
+    auto remaining = std::int32_t{width};
+    for (auto i = index; remaining > 0; ++i)
+    {
+        auto const& segment = gsl::at(m_skyline, i);
+        y                   = std::max(y, segment.y);
+        if (y + height > m_height)
+        {
+            return std::nullopt;
+        }
+        remaining -= segment.width;
+    }
+    return y;
+}
+
+}
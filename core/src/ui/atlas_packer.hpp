@@ -0,0 +1,92 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_ATLAS_PACKER_HPP
+#define WINDOWER_UI_ATLAS_PACKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace windower::ui
+{
+
+class atlas_region
+{
+public:
+    std::uint16_t x      = 0;
+    std::uint16_t y      = 0;
+    std::uint16_t width  = 0;
+    std::uint16_t height = 0;
+
+    constexpr std::uint32_t area() const noexcept
+    {
+        return std::uint32_t{width} * height;
+    }
+
+    constexpr bool operator==(atlas_region const&) const noexcept = default;
+};
+
+// Places rectangles in a fixed-size page using a skyline: the page is
+// described by the top edge of the space filled so far, and each
+// rectangle goes where it leaves that edge lowest. Regions can't be freed
+// individually; callers track how much of the page is still live and
+// repack it from scratch once enough of it has gone to waste.
+class atlas_packer
+{
+public:
+    atlas_packer(std::uint16_t width, std::uint16_t height) noexcept;
+
+    std::uint16_t width() const noexcept;
+    std::uint16_t height() const noexcept;
+    std::uint32_t used_area() const noexcept;
+
+    std::optional<atlas_region>
+    insert(std::uint16_t width, std::uint16_t height) noexcept;
+
+    void clear() noexcept;
+
+private:
+    class segment
+    {
+    public:
+        std::uint16_t x;
+        std::uint16_t y;
+        std::uint16_t width;
+    };
+
+    std::optional<std::uint16_t> fit(
+        std::size_t index, std::uint16_t width,
+        std::uint16_t height) const noexcept;
+
+    std::uint16_t m_width;
+    std::uint16_t m_height;
+    std::uint32_t m_used_area = 0;
+    std::vector<segment> m_skyline;
+};
+
+}
+
+#endif
@@ -420,4 +420,29 @@ bool bitmap::copy_to(::IDirect3DTexture8* texture) const noexcept
            SUCCEEDED(texture->UnlockRect(0));
 }
 
+bool bitmap::copy_to(
+    ::IDirect3DTexture8* texture, ::RECT const& bounds) const noexcept
+{
+    if (!texture)
+    {
+        return false;
+    }
+
+    auto rect   = ::WICRect{};
+    rect.Width  = gsl::narrow<::INT>(bounds.right - bounds.left);
+    rect.Height = gsl::narrow<::INT>(bounds.bottom - bounds.top);
+    auto data   = ::D3DLOCKED_RECT{};
+    if (FAILED(texture->LockRect(0, &data, &bounds, 0)))
+    {
+        return false;
+    }
+    // The locked rectangle is part of a larger surface, so the buffer ends
+    // with the last row of the rectangle rather than a full pitch.
+    auto const size = gsl::narrow<::UINT>(
+        data.Pitch * (rect.Height - 1) + rect.Width * 4);
+    return SUCCEEDED(m_bitmap->CopyPixels(
+               &rect, data.Pitch, size, static_cast<::BYTE*>(data.pBits))) &&
+           SUCCEEDED(texture->UnlockRect(0));
+}
+
 }
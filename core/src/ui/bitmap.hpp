@@ -69,6 +69,7 @@ public:
 
     color sample(context&, vector const&) const noexcept;
     bool copy_to(::IDirect3DTexture8*) const noexcept;
+    bool copy_to(::IDirect3DTexture8*, ::RECT const&) const noexcept;
 
 private:
     winrt::com_ptr<::IWICBitmapSource> m_bitmap;
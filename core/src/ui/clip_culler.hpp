@@ -0,0 +1,158 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_CLIP_CULLER_HPP
+#define WINDOWER_UI_CLIP_CULLER_HPP
+
+#include "ui/rectangle.hpp"
+#include "ui/vertex.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace windower::ui
+{
+
+// Culls a triangle list against a clip rectangle. A list that lies entirely
+// outside is dropped, one that lies inside is kept whole, and one that
+// straddles the clip rectangle is culled triangle by triangle, so that the
+// hidden parts of a partly scrolled out widget never reach the buffers.
+//
+// Culling is conservative: anything that reaches within half a pixel of the
+// clip rectangle is kept, since vertices sit half a pixel off the grid.
+class clip_culler
+{
+public:
+    clip_culler(
+        std::span<vertex const> vertices,
+        std::span<std::uint16_t const> indices,
+        rectangle const& clip) noexcept :
+        m_vertices{vertices},
+        m_indices{indices}, m_clip{clip}, m_extent{bounds(vertices)},
+        m_inside{contains(clip, m_extent)}
+    {
+        auto const triangles = indices.size() / 3;
+        if (!visible(m_extent, clip))
+        {
+            return;
+        }
+        if (m_inside)
+        {
+            m_kept = triangles;
+            return;
+        }
+        for (auto triangle = std::size_t{}; triangle < triangles; ++triangle)
+        {
+            m_kept += keep(triangle);
+        }
+    }
+
+    rectangle const& extent() const noexcept { return m_extent; }
+
+    // Zero when nothing is visible.
+    std::size_t kept() const noexcept { return m_kept; }
+
+    // Writes the indices of the kept triangles, offset by base; the target
+    // holds kept() * 3 of them. A reflected list is written back to front,
+    // which reverses the winding of every triangle.
+    void copy(
+        std::span<std::uint16_t> target, std::size_t base,
+        bool reflected) const noexcept
+    {
+        auto const triangles = m_indices.size() / 3;
+        auto next            = target.begin();
+        for (auto n = std::size_t{}; n < triangles; ++n)
+        {
+            auto const triangle = reflected ? triangles - 1 - n : n;
+            if (!keep(triangle))
+            {
+                continue;
+            }
+            auto const corners = m_indices.subspan(triangle * 3, 3);
+            for (auto k = std::size_t{}; k < 3; ++k)
+            {
+                auto const corner = gsl::at(corners, reflected ? 2 - k : k);
+                *next++ = gsl::narrow_cast<std::uint16_t>(corner + base);
+            }
+        }
+    }
+
+private:
+    static rectangle bounds(std::span<vertex const> vertices) noexcept
+    {
+        if (vertices.empty())
+        {
+            return {};
+        }
+        auto const [x0, x1] = std::ranges::minmax(vertices, {}, &vertex::x);
+        auto const [y0, y1] = std::ranges::minmax(vertices, {}, &vertex::y);
+        return {x0.x, y0.y, x1.x, y1.y};
+    }
+
+    static constexpr bool
+    visible(rectangle const& extent, rectangle const& clip) noexcept
+    {
+        return extent.x1 > clip.x0 - .5f && extent.x0 < clip.x1 - .5f &&
+               extent.y1 > clip.y0 - .5f && extent.y0 < clip.y1 - .5f;
+    }
+
+    static constexpr bool
+    contains(rectangle const& clip, rectangle const& extent) noexcept
+    {
+        return extent.x0 >= clip.x0 && extent.x1 <= clip.x1 &&
+               extent.y0 >= clip.y0 && extent.y1 <= clip.y1;
+    }
+
+    bool keep(std::size_t triangle) const noexcept
+    {
+        if (m_inside)
+        {
+            return true;
+        }
+        auto const& a = gsl::at(m_vertices, gsl::at(m_indices, triangle * 3));
+        auto const& b =
+            gsl::at(m_vertices, gsl::at(m_indices, triangle * 3 + 1));
+        auto const& c =
+            gsl::at(m_vertices, gsl::at(m_indices, triangle * 3 + 2));
+        return visible(
+            {std::min({a.x, b.x, c.x}), std::min({a.y, b.y, c.y}),
+             std::max({a.x, b.x, c.x}), std::max({a.y, b.y, c.y})},
+            m_clip);
+    }
+
+    std::span<vertex const> m_vertices;
+    std::span<std::uint16_t const> m_indices;
+    rectangle m_clip;
+    rectangle m_extent;
+    bool m_inside;
+    std::size_t m_kept = 0;
+};
+
+}
+
+#endif
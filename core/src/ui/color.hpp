@@ -25,7 +25,9 @@
 #ifndef WINDOWER_UI_COLOR_HPP
 #define WINDOWER_UI_COLOR_HPP
 
-#include <d3d8.h>
+#if defined(_WIN32)
+#    include <d3d8.h>
+#endif
 
 #include <gsl/gsl>
 
@@ -72,10 +74,12 @@ struct color
         return std::bit_cast<std::int32_t>(std::uint32_t{*this});
     }
 
+#if defined(_WIN32)
     constexpr operator ::D3DCOLORVALUE() const noexcept
     {
         return {r / 255.f, g / 255.f, b / 255.f, a / 255.f};
     }
+#endif
 
     constexpr float hue() const noexcept
     {
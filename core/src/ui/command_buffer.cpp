@@ -24,21 +24,146 @@
 
 #include "ui/command_buffer.hpp"
 
+#include "ui/commands.hpp"
+#include "ui/data_buffer_traits.hpp"
+#include "ui/rectangle.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vertex.hpp"
+#include "utility.hpp"
+
 #include <d3d8.h>
 
 #include <gsl/gsl>
 
 #include <algorithm>
+#include <array>
 #include <bit>
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
 
 namespace windower::ui
 {
+namespace
+{
+
+// Limits how far ahead a draw is searched for a later draw that can join
+// it, keeping the pass linear in long runs of draws.
+constexpr std::size_t sort_window = 32;
+
+using draw_state = std::array<std::uintptr_t, 3>;
+
+class pending_draw
+{
+public:
+    draw_state state;
+    draw_triangle_list_command command;
+};
+
+constexpr bool overlaps(rectangle const& a, rectangle const& b) noexcept
+{
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+void restore_state(command_buffer& commands, draw_state const& state) noexcept
+{
+    using vertex_buffer = data_buffer_traits<vertex>;
+    using index_buffer  = data_buffer_traits<std::uint16_t>;
+
+    auto const value = [&](command_buffer::state_id id) noexcept {
+        return gsl::at(state, gsl::narrow_cast<std::size_t>(id));
+    };
+
+    commands.emplace<set_data_buffer_command<vertex>>(
+        std::bit_cast<vertex_buffer::pointer>(value(vertex_buffer::state_id)));
+    commands.emplace<set_data_buffer_command<std::uint16_t>>(
+        std::bit_cast<index_buffer::pointer>(value(index_buffer::state_id)));
+    commands.emplace<set_texture_command>(
+        std::bit_cast<set_texture_command::pointer>(
+            value(command_buffer::state_id::texture)));
+}
+
+void flush(command_buffer& commands, std::vector<pending_draw>& draws) noexcept
+{
+    std::vector<bool> done(draws.size());
+    for (auto i = std::size_t{}; i < draws.size(); ++i)
+    {
+        if (gsl::at(done, i))
+        {
+            continue;
+        }
+
+        auto const& first = gsl::at(draws, i);
+        restore_state(commands, first.state);
+        commands.emplace<draw_triangle_list_command>(first.command);
+        gsl::at(done, i) = true;
 
-void command_buffer::wrapped_command::execute(
-    ::IDirect3DDevice8* d3d_device) const noexcept
+        auto const last = std::min(draws.size(), i + 1 + sort_window);
+        for (auto j = i + 1; j < last; ++j)
+        {
+            auto const& next = gsl::at(draws, j);
+            if (gsl::at(done, j) || next.state != first.state)
+            {
+                continue;
+            }
+
+            // A draw may only move ahead of the draws it does not overlap.
+            auto const bounds = next.command.bounds();
+            auto blocked      = false;
+            for (auto k = i + 1; k < j && !blocked; ++k)
+            {
+                blocked = !gsl::at(done, k) &&
+                          overlaps(gsl::at(draws, k).command.bounds(), bounds);
+            }
+            if (!blocked)
+            {
+                commands.emplace<draw_triangle_list_command>(next.command);
+                gsl::at(done, j) = true;
+            }
+        }
+    }
+    draws.clear();
+}
+
+}
+
+template<typename F>
+std::size_t
+command_buffer::visit(std::size_t offset, F&& visitor) const noexcept
 {
-    m_execute(m_data, d3d_device);
+    auto const dispatch = [&]<command C>(std::type_identity<C>) noexcept {
+        visitor(read<C>(offset));
+        return offset + 1 + sizeof(C);
+    };
+
+    switch (opcode(offset))
+    {
+    case command_opcode::set_texture:
+        return dispatch(std::type_identity<set_texture_command>{});
+    case command_opcode::set_texture_wrap:
+        return dispatch(std::type_identity<set_texture_wrap_command>{});
+    case command_opcode::set_vertex_buffer:
+        return dispatch(std::type_identity<set_data_buffer_command<vertex>>{});
+    case command_opcode::set_index_buffer:
+        return dispatch(
+            std::type_identity<set_data_buffer_command<std::uint16_t>>{});
+    case command_opcode::set_clip:
+        return dispatch(std::type_identity<set_clip_command>{});
+    case command_opcode::draw_line_strip:
+        return dispatch(std::type_identity<draw_line_strip_command>{});
+    case command_opcode::draw_triangle_list:
+        return dispatch(std::type_identity<draw_triangle_list_command>{});
+    case command_opcode::begin_mask:
+        return dispatch(std::type_identity<begin_mask_command>{});
+    case command_opcode::apply_mask:
+        return dispatch(std::type_identity<apply_mask_command>{});
+    case command_opcode::end_mask:
+        return dispatch(std::type_identity<end_mask_command>{});
+    }
+    fail_fast();
 }
 
 std::uintptr_t command_buffer::state(state_id id) const noexcept
@@ -66,11 +191,62 @@ void command_buffer::state(state_id id, void const* value) noexcept
     state(id, std::bit_cast<std::uintptr_t>(value));
 }
 
-void command_buffer::execute(::IDirect3DDevice8* device) const noexcept
+void command_buffer::sort_draws() noexcept
+{
+    command_buffer sorted;
+    sorted.m_stream.reserve(m_stream.size());
+
+    auto current = draw_state{};
+    std::vector<pending_draw> draws;
+
+    auto const track = [&](state_id id, auto ptr) noexcept {
+        gsl::at(current, gsl::narrow_cast<std::size_t>(id)) =
+            std::bit_cast<std::uintptr_t>(ptr);
+    };
+
+    for (auto offset = std::size_t{}; offset < m_stream.size();)
+    {
+        offset = visit(offset, [&]<command C>(C const& command) noexcept {
+            if constexpr (std::same_as<C, set_texture_command>)
+            {
+                track(state_id::texture, command.value());
+            }
+            else if constexpr (std::same_as<C, set_data_buffer_command<vertex>>)
+            {
+                track(state_id::vertex_buffer, command.value());
+            }
+            else if constexpr (std::same_as<
+                                   C, set_data_buffer_command<std::uint16_t>>)
+            {
+                track(state_id::index_buffer, command.value());
+            }
+            else if constexpr (std::same_as<C, draw_triangle_list_command>)
+            {
+                draws.push_back({current, command});
+            }
+            else
+            {
+                flush(sorted, draws);
+                if constexpr (std::same_as<C, draw_line_strip_command>)
+                {
+                    restore_state(sorted, current);
+                }
+                sorted.emplace<C>(command);
+            }
+        });
+    }
+    flush(sorted, draws);
+
+    *this = std::move(sorted);
+}
+
+void command_buffer::execute(render_device& device) const noexcept
 {
-    for (auto const& c : m_commands)
+    for (auto offset = std::size_t{}; offset < m_stream.size();)
     {
-        c.execute(device);
+        offset = visit(offset, [&device](auto const& command) noexcept {
+            command.execute(device);
+        });
     }
 }
 
@@ -78,7 +254,8 @@ void command_buffer::clear() noexcept
 {
     namespace range = std::ranges;
 
-    m_commands.clear();
+    m_stream.clear();
+    m_last = no_command;
     range::fill(m_state, 0);
 }
 
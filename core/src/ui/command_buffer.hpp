@@ -25,39 +25,62 @@
 #ifndef WINDOWER_UI_COMMAND_BUFFER_HPP
 #define WINDOWER_UI_COMMAND_BUFFER_HPP
 
-#include "ui/static_any.hpp"
-
 #include <d3d8.h>
 
+#include <gsl/gsl>
+
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace windower::ui
 {
 
-constexpr std::size_t max_command_size = 16;
+constexpr std::size_t max_command_size = 32;
+
+enum class command_opcode : std::uint8_t
+{
+    set_texture,
+    set_texture_wrap,
+    set_vertex_buffer,
+    set_index_buffer,
+    set_clip,
+    draw_line_strip,
+    draw_triangle_list,
+    begin_mask,
+    apply_mask,
+    end_mask,
+};
 
 class command_buffer;
+class render_device;
 
 template<typename T>
-concept command = requires(T const& value, ::IDirect3DDevice8* d3d_device)
+concept command = requires(T const& value, render_device& device)
 {
     // clang-format off
+    requires std::is_trivially_copyable_v<T>;
     requires sizeof(T) <= max_command_size;
-    requires alignof(T) <= alignof(std::max_align_t);
-    { value.execute(d3d_device) } noexcept;
+    { T::opcode } -> std::convertible_to<command_opcode>;
+    { value.execute(device) } noexcept;
     // clang-format on
 };
 
 template<typename T, typename... A>
-concept stitchable_command = requires(T const& value, A&&... args)
+concept stitchable_command = requires(T& value, A&&... args)
 {
     // clang-format off
     requires command<T>;
-    { value.stitch(std::forward<A>(args)...) } noexcept;
+    { value.stitch(std::forward<A>(args)...) } noexcept ->
+        std::convertible_to<bool>;
     // clang-format on
 };
 
@@ -72,6 +95,8 @@ concept stateful_command =
     // clang-format on
 };
 
+// Commands are packed back to back as an opcode byte followed by the
+// command's bytes, and replayed by switching on the opcode.
 class command_buffer
 {
 public:
@@ -100,17 +125,17 @@ public:
         {
             if constexpr (stitchable_command<C, A...>)
             {
-                if (!m_commands.empty())
+                if (m_last != no_command && opcode(m_last) == C::opcode)
                 {
-                    if (auto ptr = m_commands.back().as<C>())
+                    auto last = read<C>(m_last);
+                    if (last.stitch(args...))
                     {
-                        ptr->stitch(std::forward<A>(args)...);
+                        write(m_last, last);
                         return;
                     }
                 }
             }
-            m_commands.emplace_back(
-                std::in_place_type<C>, std::forward<A>(args)...);
+            append(C{std::forward<A>(args)...});
         }
     }
 
@@ -120,39 +145,55 @@ public:
     void state(state_id id, std::uintptr_t value) noexcept;
     void state(state_id id, void const* value) noexcept;
 
-    void execute(::IDirect3DDevice8* device) const noexcept;
+    // Reorders the triangle lists between clip and mask changes so that draws
+    // sharing a texture and buffers run together, without moving a draw past
+    // one it overlaps, and merges them where their ranges are contiguous.
+    void sort_draws() noexcept;
+
+    void execute(render_device& device) const noexcept;
     void clear() noexcept;
 
 private:
-    class wrapped_command
+    static constexpr std::size_t no_command =
+        std::numeric_limits<std::size_t>::max();
+
+    std::vector<std::byte> m_stream;
+    std::size_t m_last = no_command;
+    std::array<std::uintptr_t, 3> m_state = {};
+
+    command_opcode opcode(std::size_t offset) const noexcept
     {
-    public:
-        template<command C, typename... A>
-        wrapped_command(std::in_place_type_t<C> tag, A&&... args) noexcept :
-            m_execute{[](static_any<max_command_size> const& data,
-                         ::IDirect3DDevice8* d3d_device) noexcept {
-                data.value<C>()->execute(d3d_device);
-            }},
-            m_data{tag, std::forward<A>(args)...}
-        {}
-
-        template<command C>
-        auto as() noexcept
-        {
-            return m_data.value<C>();
-        }
+        return static_cast<command_opcode>(gsl::at(m_stream, offset));
+    }
 
-        void execute(::IDirect3DDevice8* d3d_device) const noexcept;
+    template<command C>
+    C read(std::size_t offset) const noexcept
+    {
+        auto const source = std::span{m_stream}.subspan(offset + 1, sizeof(C));
+        std::array<std::byte, sizeof(C)> bytes;
+        std::ranges::copy(source, bytes.begin());
+        return std::bit_cast<C>(bytes);
+    }
 
-    private:
-        void (*m_execute)(
-            static_any<max_command_size> const& data,
-            ::IDirect3DDevice8* d3d_device) noexcept;
-        static_any<max_command_size> m_data;
-    };
+    template<command C>
+    void write(std::size_t offset, C const& value) noexcept
+    {
+        using bytes = std::array<std::byte, sizeof(C)>;
+        auto const target = std::span{m_stream}.subspan(offset + 1, sizeof(C));
+        std::ranges::copy(std::bit_cast<bytes>(value), target.begin());
+    }
 
-    std::vector<wrapped_command> m_commands;
-    std::array<std::uintptr_t, 3> m_state = {};
+    template<command C>
+    void append(C const& value) noexcept
+    {
+        m_last = m_stream.size();
+        m_stream.resize(m_last + 1 + sizeof(C));
+        gsl::at(m_stream, m_last) = static_cast<std::byte>(C::opcode);
+        write(m_last, value);
+    }
+
+    template<typename F>
+    std::size_t visit(std::size_t offset, F&& visitor) const noexcept;
 };
 
 }
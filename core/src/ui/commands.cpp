@@ -25,13 +25,17 @@
 #include "ui/commands.hpp"
 
 #include "ui/command_buffer.hpp"
+#include "ui/d3d8_render_device.hpp"
 #include "ui/rectangle.hpp"
+#include "ui/render_device.hpp"
 
 #include <d3d8.h>
 
 #include <gsl/gsl>
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 
 namespace windower::ui
 {
@@ -50,32 +54,36 @@ bool set_texture_command::check_state(
 
 set_texture_command::set_texture_command(pointer ptr) noexcept : m_ptr{ptr} {}
 
-void set_texture_command::execute(::IDirect3DDevice8* d3d_device) const noexcept
+set_texture_command::pointer set_texture_command::value() const noexcept
 {
-    Expects(d3d_device != nullptr);
+    return m_ptr;
+}
 
-    d3d_device->SetTexture(0, m_ptr);
+void set_texture_command::execute(render_device& device) const noexcept
+{
+    device.set_texture(to_handle(m_ptr));
 }
 
-void set_texture_command::stitch(pointer ptr) noexcept { m_ptr = ptr; }
+bool set_texture_command::stitch(pointer ptr) noexcept
+{
+    m_ptr = ptr;
+    return true;
+}
 
 set_texture_wrap_command::set_texture_wrap_command(bool wrap) noexcept :
     m_wrap{wrap}
 {}
 
-void set_texture_wrap_command::execute(
-    ::IDirect3DDevice8* d3d_device) const noexcept
+void set_texture_wrap_command::execute(render_device& device) const noexcept
 {
-    Expects(d3d_device != nullptr);
-
-    auto const value = m_wrap ? D3DTADDRESS_WRAP : D3DTADDRESS_CLAMP;
-
-    d3d_device->SetTextureStageState(0, D3DTSS_ADDRESSU, value);
-    d3d_device->SetTextureStageState(0, D3DTSS_ADDRESSV, value);
-    d3d_device->SetTextureStageState(0, D3DTSS_ADDRESSW, value);
+    device.set_texture_wrap(m_wrap);
 }
 
-void set_texture_wrap_command::stitch(bool wrap) noexcept { m_wrap = wrap; }
+bool set_texture_wrap_command::stitch(bool wrap) noexcept
+{
+    m_wrap = wrap;
+    return true;
+}
 
 set_clip_command::set_clip_command(rectangle const& clip_rect) noexcept :
     m_x{gsl::narrow_cast<std::uint32_t>(clip_rect.x0)},
@@ -84,79 +92,87 @@ set_clip_command::set_clip_command(rectangle const& clip_rect) noexcept :
     m_height{gsl::narrow_cast<std::uint32_t>(clip_rect.height())}
 {}
 
-void set_clip_command::execute(::IDirect3DDevice8* d3d_device) const noexcept
+void set_clip_command::execute(render_device& device) const noexcept
 {
-    Expects(d3d_device != nullptr);
-
-    ::D3DVIEWPORT8 const viewport{m_x, m_y, m_width, m_height, 0.f, 1.f};
-    d3d_device->SetViewport(&viewport);
+    device.set_clip({m_x, m_y, m_width, m_height});
 }
 
-void set_clip_command::stitch(rectangle const& clip_rect) noexcept
+bool set_clip_command::stitch(rectangle const& clip_rect) noexcept
 {
     m_x      = gsl::narrow_cast<std::uint32_t>(clip_rect.x0);
     m_y      = gsl::narrow_cast<std::uint32_t>(clip_rect.y0);
     m_width  = gsl::narrow_cast<std::uint32_t>(clip_rect.width());
     m_height = gsl::narrow_cast<std::uint32_t>(clip_rect.height());
+    return true;
 }
 
 draw_line_strip_command::draw_line_strip_command(
     std::uint16_t vertex_offset, std::uint16_t vertex_count,
-    std::uint16_t index_offset, std::uint16_t index_count) noexcept :
+    std::uint16_t index_offset, std::uint16_t index_count,
+    rectangle const& bounds) noexcept :
     draw_primitive_command_base{
         vertex_offset, vertex_count, index_offset,
-        gsl::narrow_cast<std::uint16_t>(index_count - 1)}
+        gsl::narrow_cast<std::uint16_t>(index_count - 1), bounds}
 {}
 
 draw_triangle_list_command::draw_triangle_list_command(
     std::uint16_t vertex_offset, std::uint16_t vertex_count,
-    std::uint16_t index_offset, std::uint16_t index_count) noexcept :
+    std::uint16_t index_offset, std::uint16_t index_count,
+    rectangle const& bounds) noexcept :
     draw_primitive_command_base{
         vertex_offset, vertex_count, index_offset,
-        gsl::narrow_cast<std::uint16_t>(index_count / 3)}
+        gsl::narrow_cast<std::uint16_t>(index_count / 3), bounds}
 {
     Expects(index_count % 3 == 0);
 }
 
-void draw_triangle_list_command::stitch(
+bool draw_triangle_list_command::stitch(
     std::uint16_t vertex_offset, std::uint16_t vertex_count,
-    std::uint16_t index_offset, std::uint16_t index_count) noexcept
+    std::uint16_t index_offset, std::uint16_t index_count,
+    rectangle const& bounds) noexcept
 {
-    Expects(index_count % 3 == 0);
-    Expects(m_vertex_offset + m_vertex_count == vertex_offset);
-    Expects(m_index_offset + m_primitive_count * 3 == index_offset);
-
-    this->m_vertex_count += vertex_count;
-    this->m_primitive_count += index_count / 3;
+    return stitch(draw_triangle_list_command{
+        vertex_offset, vertex_count, index_offset, index_count, bounds});
 }
 
-void begin_mask_command::execute(::IDirect3DDevice8* d3d_device) const noexcept
+bool draw_triangle_list_command::stitch(
+    draw_triangle_list_command const& other) noexcept
 {
-    Expects(d3d_device != nullptr);
-
-    d3d_device->Clear(0, nullptr, D3DCLEAR_STENCIL, 0, 0.f, 0);
-    d3d_device->SetRenderState(D3DRS_ALPHATESTENABLE, TRUE);
-    d3d_device->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
-    d3d_device->SetRenderState(D3DRS_STENCILENABLE, TRUE);
-    d3d_device->SetRenderState(D3DRS_STENCILFUNC, D3DCMP_ALWAYS);
-    d3d_device->SetRenderState(D3DRS_COLORWRITEENABLE, 0);
+    // Draws can only be merged when both ranges continue where this draw's
+    // ranges end, which is not the case once draws have been reordered.
+    if (m_vertex_offset + m_vertex_count != other.m_vertex_offset ||
+        m_index_offset + m_primitive_count * 3 != other.m_index_offset ||
+        m_vertex_count + other.m_vertex_count >
+            std::numeric_limits<std::uint16_t>::max() ||
+        m_primitive_count + other.m_primitive_count >
+            std::numeric_limits<std::uint16_t>::max())
+    {
+        return false;
+    }
+
+    m_vertex_count += other.m_vertex_count;
+    m_primitive_count += other.m_primitive_count;
+    m_bounds = {
+        std::min(m_bounds.x0, other.m_bounds.x0),
+        std::min(m_bounds.y0, other.m_bounds.y0),
+        std::max(m_bounds.x1, other.m_bounds.x1),
+        std::max(m_bounds.y1, other.m_bounds.y1)};
+    return true;
 }
 
-void apply_mask_command::execute(::IDirect3DDevice8* d3d_device) const noexcept
+void begin_mask_command::execute(render_device& device) const noexcept
 {
-    Expects(d3d_device != nullptr);
-
-    d3d_device->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
-    d3d_device->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
-    d3d_device->SetRenderState(D3DRS_STENCILFUNC, D3DCMP_EQUAL);
-    d3d_device->SetRenderState(D3DRS_COLORWRITEENABLE, 0x0000000F);
+    device.begin_mask();
 }
 
-void end_mask_command::execute(::IDirect3DDevice8* d3d_device) const noexcept
+void apply_mask_command::execute(render_device& device) const noexcept
 {
-    Expects(d3d_device != nullptr);
+    device.apply_mask();
+}
 
-    d3d_device->SetRenderState(D3DRS_STENCILENABLE, FALSE);
+void end_mask_command::execute(render_device& device) const noexcept
+{
+    device.end_mask();
 }
 
 }
@@ -28,6 +28,7 @@
 #include "ui/command_buffer.hpp"
 #include "ui/data_buffer_traits.hpp"
 #include "ui/rectangle.hpp"
+#include "ui/render_device.hpp"
 
 #include <d3d8.h>
 
@@ -43,12 +44,16 @@ public:
     using pointer = ::IDirect3DBaseTexture8*;
     using const_pointer = ::IDirect3DBaseTexture8 const*;
 
+    static constexpr command_opcode opcode = command_opcode::set_texture;
+
     static bool check_state(command_buffer&, const_pointer) noexcept;
 
     set_texture_command(pointer) noexcept;
 
-    void execute(::IDirect3DDevice8*) const noexcept;
-    void stitch(pointer) noexcept;
+    pointer value() const noexcept;
+
+    void execute(render_device&) const noexcept;
+    bool stitch(pointer) noexcept;
 
 private:
     pointer m_ptr;
@@ -57,10 +62,12 @@ private:
 class set_texture_wrap_command
 {
 public:
+    static constexpr command_opcode opcode = command_opcode::set_texture_wrap;
+
     set_texture_wrap_command(bool) noexcept;
 
-    void execute(::IDirect3DDevice8*) const noexcept;
-    void stitch(bool) noexcept;
+    void execute(render_device&) const noexcept;
+    bool stitch(bool) noexcept;
 
 private:
     bool m_wrap;
@@ -73,6 +80,8 @@ public:
     using pointer = typename data_buffer_traits<T>::pointer;
     using const_pointer = typename data_buffer_traits<T>::const_pointer;
 
+    static constexpr command_opcode opcode = data_buffer_traits<T>::opcode;
+
     static bool
     check_state(command_buffer& commands, const_pointer ptr) noexcept
     {
@@ -87,14 +96,18 @@ public:
 
     set_data_buffer_command(pointer ptr) noexcept : m_ptr{ptr} {}
 
-    void execute(::IDirect3DDevice8* d3d_device) const noexcept
-    {
-        Expects(d3d_device != nullptr);
+    pointer value() const noexcept { return m_ptr; }
 
-        data_buffer_traits<T>::set_buffer(d3d_device, m_ptr);
+    void execute(render_device& device) const noexcept
+    {
+        data_buffer_traits<T>::set_buffer(device, m_ptr);
     }
 
-    void stitch(pointer ptr) noexcept { m_ptr = ptr; }
+    bool stitch(pointer ptr) noexcept
+    {
+        m_ptr = ptr;
+        return true;
+    }
 
 private:
     pointer m_ptr;
@@ -103,10 +116,12 @@ private:
 class set_clip_command
 {
 public:
+    static constexpr command_opcode opcode = command_opcode::set_clip;
+
     set_clip_command(rectangle const&) noexcept;
 
-    void execute(::IDirect3DDevice8*) const noexcept;
-    void stitch(rectangle const&) noexcept;
+    void execute(render_device&) const noexcept;
+    bool stitch(rectangle const&) noexcept;
 
 private:
     ::DWORD m_x;
@@ -115,28 +130,30 @@ private:
     ::DWORD m_height;
 };
 
-template<::D3DPRIMITIVETYPE Primitive>
+template<primitive_type Primitive>
 class draw_primitive_command_base
 {
 public:
     draw_primitive_command_base(
         std::uint16_t vertex_offset, std::uint16_t vertex_count,
-        std::uint16_t index_offset, std::uint16_t primitive_count) noexcept :
-        m_vertex_offset{vertex_offset},
-        m_vertex_count{vertex_count}, m_index_offset{index_offset},
-        m_primitive_count{primitive_count}
+        std::uint16_t index_offset, std::uint16_t primitive_count,
+        rectangle const& bounds) noexcept :
+        m_bounds{bounds},
+        m_vertex_offset{vertex_offset}, m_vertex_count{vertex_count},
+        m_index_offset{index_offset}, m_primitive_count{primitive_count}
     {}
 
-    void execute(::IDirect3DDevice8* d3d_device) const noexcept
-    {
-        Expects(d3d_device != nullptr);
+    rectangle const& bounds() const noexcept { return m_bounds; }
 
-        d3d_device->DrawIndexedPrimitive(
+    void execute(render_device& device) const noexcept
+    {
+        device.draw_indexed(
             Primitive, m_vertex_offset, m_vertex_count, m_index_offset,
             m_primitive_count);
     }
 
 protected:
+    rectangle m_bounds;
     std::uint16_t m_vertex_offset{0};
     std::uint16_t m_vertex_count{0};
     std::uint16_t m_index_offset{0};
@@ -144,49 +161,64 @@ protected:
 };
 
 class draw_line_strip_command :
-    public draw_primitive_command_base<::D3DPT_LINESTRIP>
+    public draw_primitive_command_base<primitive_type::line_strip>
 {
 public:
+    static constexpr command_opcode opcode = command_opcode::draw_line_strip;
+
     draw_line_strip_command(
         std::uint16_t vertex_offset, std::uint16_t vertex_count,
-        std::uint16_t index_offset, std::uint16_t index_count) noexcept;
+        std::uint16_t index_offset, std::uint16_t index_count,
+        rectangle const& bounds) noexcept;
 };
 
 class draw_triangle_list_command :
-    public draw_primitive_command_base<::D3DPT_TRIANGLELIST>
+    public draw_primitive_command_base<primitive_type::triangle_list>
 {
 public:
+    static constexpr command_opcode opcode =
+        command_opcode::draw_triangle_list;
+
     draw_triangle_list_command(
         std::uint16_t vertex_offset, std::uint16_t vertex_count,
-        std::uint16_t index_offset, std::uint16_t index_count) noexcept;
+        std::uint16_t index_offset, std::uint16_t index_count,
+        rectangle const& bounds) noexcept;
 
-    void stitch(
+    bool stitch(
         std::uint16_t vertex_offset, std::uint16_t vertex_count,
-        std::uint16_t index_offset, std::uint16_t index_count) noexcept;
+        std::uint16_t index_offset, std::uint16_t index_count,
+        rectangle const& bounds) noexcept;
+    bool stitch(draw_triangle_list_command const& other) noexcept;
 };
 
 class begin_mask_command
 {
 public:
+    static constexpr command_opcode opcode = command_opcode::begin_mask;
+
     begin_mask_command() noexcept = default;
 
-    void execute(::IDirect3DDevice8* d3d_device) const noexcept;
+    void execute(render_device& device) const noexcept;
 };
 
 class apply_mask_command
 {
 public:
+    static constexpr command_opcode opcode = command_opcode::apply_mask;
+
     apply_mask_command() noexcept = default;
 
-    void execute(::IDirect3DDevice8* d3d_device) const noexcept;
+    void execute(render_device& device) const noexcept;
 };
 
 class end_mask_command
 {
 public:
+    static constexpr command_opcode opcode = command_opcode::end_mask;
+
     end_mask_command() noexcept = default;
 
-    void execute(::IDirect3DDevice8* d3d_device) const noexcept;
+    void execute(render_device& device) const noexcept;
 };
 
 }
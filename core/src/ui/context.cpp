@@ -24,17 +24,22 @@
 
 #include "ui/context.hpp"
 
+#include "core.hpp"
 #include "hooks/ffximain.hpp"
 #include "hooks/user32.hpp"
 #include "ui/bitmap.hpp"
+#include "ui/clip_culler.hpp"
 #include "ui/command_buffer.hpp"
 #include "ui/commands.hpp"
+#include "ui/d3d8_render_device.hpp"
 #include "ui/data_buffer.hpp"
 #include "ui/dwrite_iids.hpp"
+#include "ui/frame_capture.hpp"
 #include "ui/id.hpp"
 #include "ui/layer.hpp"
 #include "ui/mouse.hpp"
 #include "ui/primitives.hpp"
+#include "ui/render_device.hpp"
 #include "ui/text_layout_engine.hpp"
 #include "ui/text_rasterizer.hpp"
 #include "ui/texture_cache.hpp"
@@ -53,10 +58,14 @@
 #include <gsl/gsl>
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <new>
 #include <optional>
 #include <span>
+#include <utility>
 
 namespace windower::ui
 {
@@ -68,39 +77,31 @@ constexpr float calculate_rhw(float depth) noexcept
     return 10.f - 10.f * depth;
 }
 
-template<typename T>
+// Copies the part of a triangle list that the clip rectangle doesn't cull
+// into the buffers.
 void primitive_command(
     std::span<vertex const> vertices, std::span<std::uint16_t const> indices,
-    ::IDirect3DDevice8* d3d_device, data_buffer<vertex>& v_buffer,
+    rectangle const& clip, ::IDirect3DDevice8* d3d_device,
+    data_buffer<vertex>& v_buffer,
     windower::ui::data_buffer<std::uint16_t>& i_buffer,
     windower::ui::command_buffer& commands, bool reflected) noexcept
 {
-    namespace range = std::ranges;
+    clip_culler const culler{vertices, indices, clip};
+    if (culler.kept() == 0)
+    {
+        return;
+    }
 
     auto v = v_buffer.allocate(d3d_device, commands, vertices.size());
-    auto i = i_buffer.allocate(d3d_device, commands, indices.size());
-    commands.emplace<T>(
+    auto i = i_buffer.allocate(d3d_device, commands, culler.kept() * 3);
+    commands.emplace<draw_triangle_list_command>(
         gsl::narrow_cast<std::uint16_t>(v.offset),
         gsl::narrow_cast<std::uint16_t>(v.data.size()),
         gsl::narrow_cast<std::uint16_t>(i.offset),
-        gsl::narrow_cast<std::uint16_t>(i.data.size()));
+        gsl::narrow_cast<std::uint16_t>(i.data.size()), culler.extent());
 
-    range::copy(vertices, v.data.begin());
-    if (reflected)
-    {
-        range::transform(
-            range::reverse_view{indices}, i.data.begin(),
-            [offset = v.offset](auto idx) {
-                return gsl::narrow_cast<std::uint16_t>(idx + offset);
-            });
-    }
-    else
-    {
-        range::transform(
-            indices, i.data.begin(), [offset = v.offset](auto idx) {
-                return gsl::narrow_cast<std::uint16_t>(idx + offset);
-            });
-    }
+    std::ranges::copy(vertices, v.data.begin());
+    culler.copy(i.data, v.offset, reflected);
 }
 
 }
@@ -110,7 +111,7 @@ context::context(
     dimension const& screen_size, dimension const& ui_size,
     dimension const& render_size) noexcept :
     m_hwnd{hwnd},
-    m_d3d_device{d3d_device}
+    m_d3d_device{d3d_device}, m_render_device{d3d_device}
 {
     if (FAILED(::CoCreateInstance(
             ::CLSID_WICImagingFactory, nullptr, ::CLSCTX_INPROC_SERVER,
@@ -336,6 +337,7 @@ void context::skin(std::u8string_view skin) noexcept
 {
     m_skin = skin;
     load_colors(skin, 128);
+    m_window_manager.invalidate();
 }
 
 color context::system_color(ui::system_color color) const noexcept
@@ -536,6 +538,48 @@ bool context::layout_mode() const noexcept { return m_layout_mode; }
 
 void context::layout_mode(bool enabled) noexcept { m_layout_mode = enabled; }
 
+bool context::sort_commands() const noexcept { return m_sort_commands; }
+
+void context::sort_commands(bool enabled) noexcept
+{
+    m_sort_commands = enabled;
+}
+
+std::size_t context::vertex_capacity() const noexcept
+{
+    return m_vertex_buffer.capacity();
+}
+
+void context::vertex_capacity(std::size_t count) noexcept
+{
+    m_vertex_buffer.capacity(count);
+}
+
+std::size_t context::index_capacity() const noexcept
+{
+    return m_index_buffer.capacity();
+}
+
+void context::index_capacity(std::size_t count) noexcept
+{
+    m_index_buffer.capacity(count);
+}
+
+frame_stats const& context::frame_stats() const noexcept
+{
+    return m_frame_stats;
+}
+
+bool context::highlight_rerecorded() const noexcept
+{
+    return m_highlight_rerecorded;
+}
+
+void context::highlight_rerecorded(bool enabled) noexcept
+{
+    m_highlight_rerecorded = enabled;
+}
+
 vector context::origin() const noexcept
 {
     auto const& wnd_ctx = m_window_stack.back();
@@ -611,6 +655,13 @@ context::begin_window(std::intptr_t id, layer layer, float depth) noexcept
     wnd_ctx.window->m_origin      = {};
     wnd_ctx.window->m_bounds      = layer_bounds;
     wnd_ctx.window->m_zoom_factor = 1;
+    wnd_ctx.window->m_recording.clear();
+    wnd_ctx.retained = true;
+    if (wnd_ctx.window->m_invalidated)
+    {
+        wnd_ctx.window->m_retained.clear();
+        wnd_ctx.window->m_invalidated = false;
+    }
 
     wnd_ctx.transform_stack.emplace_back();
     wnd_ctx.offset_stack.emplace_back();
@@ -623,9 +674,94 @@ context::begin_window(std::intptr_t id, layer layer, float depth) noexcept
 
 void context::end_window() noexcept
 {
+    auto& wnd_ctx = m_window_stack.back();
+    auto& wnd     = *wnd_ctx.window;
+
+    // Output replayed before an invalidation in the middle of the window
+    // is not trusted for the next frame either.
+    wnd.m_rerecorded = wnd_ctx.rerecorded || wnd.m_invalidated ||
+                       wnd_ctx.call_index != wnd.m_retained.size();
+    if (wnd.m_invalidated)
+    {
+        wnd.m_recording.clear();
+        wnd.m_invalidated = false;
+    }
+    std::swap(wnd.m_retained, wnd.m_recording);
+    wnd.m_recording.clear();
+    wnd_ctx.retained = false;
+
+    if (m_highlight_rerecorded && wnd.m_rerecorded)
+    {
+        draw_rerecorded_highlight();
+    }
+
+    if (m_sort_commands)
+    {
+        commands().sort_draws();
+    }
     m_window_stack.pop_back();
+    auto const& parent_ctx = m_window_stack.back();
+    commands().emplace<set_clip_command>(parent_ctx.clip_stack.back());
+}
+
+void context::invalidate() noexcept
+{
+    if (auto const& wnd_ctx = m_window_stack.back(); wnd_ctx.retained)
+    {
+        wnd_ctx.window->invalidate();
+    }
+    else
+    {
+        m_window_manager.invalidate();
+    }
+}
+
+bool context::begin_primitive(primitive_inputs inputs) noexcept
+{
     auto& wnd_ctx = m_window_stack.back();
-    commands().emplace<set_clip_command>(wnd_ctx.clip_stack.back());
+    if (!wnd_ctx.retained || wnd_ctx.primitive_depth++ != 0)
+    {
+        return false;
+    }
+
+    auto const [depth, rhw] = context::depth();
+    inputs.add(current_transform());
+    inputs.add(origin());
+    inputs.add(zoom_factor());
+    inputs.add(scale_factor());
+    inputs.add(depth);
+    inputs.add(m_texture_region);
+
+    auto& wnd        = *wnd_ctx.window;
+    auto const index = wnd_ctx.call_index++;
+    wnd.m_recording.begin_call(inputs.key(), inputs.reference());
+    if (wnd.m_invalidated || !wnd.m_retained.matches(index, inputs.key()))
+    {
+        wnd_ctx.rerecorded = true;
+        return false;
+    }
+
+    for (auto const& op : wnd.m_retained.ops(index))
+    {
+        if (op.sets_texture)
+        {
+            set_texture(op.texture);
+        }
+        else
+        {
+            draw_triangle_list(
+                wnd.m_retained.vertices(op), wnd.m_retained.indices(op));
+        }
+    }
+    return true;
+}
+
+void context::end_primitive() noexcept
+{
+    if (auto& wnd_ctx = m_window_stack.back(); wnd_ctx.retained)
+    {
+        --wnd_ctx.primitive_depth;
+    }
 }
 
 std::optional<vector> context::to_widget(vector const&) const noexcept
@@ -711,30 +847,42 @@ void context::pop_offset() noexcept
 
 void context::set_texture(texture_token texture) noexcept
 {
+    if (auto const recording = context::recording())
+    {
+        recording->set_texture(texture);
+    }
     commands().emplace<set_texture_command>(texture.m_value);
+    m_texture_region = texture.m_region;
+}
+
+rectangle const& context::texture_region() const noexcept
+{
+    return m_texture_region;
 }
 
 void context::draw_triangle_list(
     std::initializer_list<vertex> vertices,
     std::initializer_list<std::uint16_t> indices, bool reflected) noexcept
 {
-    if (!m_window_stack.back().fully_clipped)
-    {
-        primitive_command<draw_triangle_list_command>(
-            vertices, indices, m_d3d_device, m_vertex_buffer, m_index_buffer,
-            commands(), reflected);
-    }
+    draw_triangle_list(
+        std::span{vertices.begin(), vertices.size()},
+        std::span{indices.begin(), indices.size()}, reflected);
 }
 
 void context::draw_triangle_list(
     std::span<vertex const> vertices, std::span<std::uint16_t const> indices,
     bool reflected) noexcept
 {
+    if (auto const recording = context::recording())
+    {
+        recording->draw(vertices, indices, reflected);
+    }
     if (!m_window_stack.back().fully_clipped)
     {
-        primitive_command<draw_triangle_list_command>(
-            vertices, indices, m_d3d_device, m_vertex_buffer, m_index_buffer,
-            commands(), reflected);
+        primitive_command(
+            vertices, indices, m_window_stack.back().clip_stack.back(),
+            m_d3d_device, m_vertex_buffer, m_index_buffer, commands(),
+            reflected);
     }
 }
 
@@ -837,9 +985,49 @@ std::optional<::LRESULT> context::process_message(::MSG const& message) noexcept
 
 void context::begin_frame() noexcept
 {
+    m_frame_stats.vertices = m_vertex_buffer.statistics();
+    m_frame_stats.indices  = m_index_buffer.statistics();
+
+    if (m_capture)
+    {
+        m_vertex_buffer.capture(nullptr);
+        m_index_buffer.capture(nullptr);
+        if (!m_capture->save(m_capture_path))
+        {
+            core::output(
+                u8"core",
+                u8"Failed to save the frame capture to " +
+                    m_capture_path.u8string());
+        }
+        m_capture.reset();
+    }
+
     m_vertex_buffer.clear();
     m_index_buffer.clear();
 
+    if (!m_capture_request.empty())
+    {
+        auto held_buttons = std::uint8_t{};
+        for (auto i = std::uint8_t{}; i < 5; ++i)
+        {
+            if (m_mouse.is_held(mouse_button{i}))
+            {
+                held_buttons |= gsl::narrow_cast<std::uint8_t>(1 << i);
+            }
+        }
+
+        m_capture_path = std::exchange(m_capture_request, {});
+        m_capture.emplace(
+            screen_size(),
+            frame_capture::input_record{
+                .mouse_position = m_mouse.position(),
+                .scroll_offset  = m_mouse.scroll_offset(),
+                .held_buttons   = held_buttons,
+                .layout_mode    = m_layout_mode});
+        m_vertex_buffer.capture(&*m_capture);
+        m_index_buffer.capture(&*m_capture);
+    }
+
     m_window_stack.clear();
 
     m_screen.commands().clear();
@@ -925,7 +1113,7 @@ void context::end_frame() noexcept
 {
     m_mouse.update();
     m_text_layout_engine.update();
-    m_texture_cache.update();
+    m_texture_cache.update(*this);
     if (m_cursor)
     {
         auto const cursor_index  = gsl::narrow_cast<std::int8_t>(*m_cursor);
@@ -940,35 +1128,70 @@ void context::end_frame() noexcept
 }
 
 void context::render(ui::layer layer) noexcept
+{
+    m_d3d_device->BeginScene();
+
+    m_d3d_device->CaptureStateBlock(m_previous_state);
+    m_d3d_device->ApplyStateBlock(m_default_state);
+
+    render(layer, m_render_device);
+
+    m_d3d_device->ApplyStateBlock(m_previous_state);
+
+    m_d3d_device->EndScene();
+}
+
+// Replays a layer's commands on the given device. Unlike render(layer),
+// this leaves scene and state management to the caller, which lets the
+// commands run against a device that isn't backed by Direct3D.
+void context::render(ui::layer layer, render_device& device) noexcept
 {
     namespace view = std::ranges::views;
 
     m_vertex_buffer.finalize();
     m_index_buffer.finalize();
 
-    m_d3d_device->BeginScene();
-
-    m_d3d_device->CaptureStateBlock(m_previous_state);
-    m_d3d_device->ApplyStateBlock(m_default_state);
+    auto const execute = [&](window const& wnd) noexcept {
+        if (m_capture)
+        {
+            m_capture->begin_window(
+                wnd.m_id, wnd.layer(), wnd.depth(), wnd.bounds());
+            capture_render_device recorder{*m_capture, device};
+            wnd.commands().execute(recorder);
+        }
+        else
+        {
+            wnd.commands().execute(device);
+        }
+    };
 
     if (m_screen.layer() == layer)
     {
-        m_screen.commands().execute(m_d3d_device);
+        if (m_sort_commands)
+        {
+            m_screen.commands().sort_draws();
+        }
+        execute(m_screen);
     }
 
     if (m_layout_grid.layer() == layer)
     {
-        m_layout_grid.commands().execute(m_d3d_device);
+        if (m_sort_commands)
+        {
+            m_layout_grid.commands().sort_draws();
+        }
+        execute(m_layout_grid);
     }
 
     for (auto& window : m_window_manager.z_order(layer) | view::reverse)
     {
-        window->commands().execute(m_d3d_device);
+        execute(*window);
     }
+}
 
-    m_d3d_device->ApplyStateBlock(m_previous_state);
-
-    m_d3d_device->EndScene();
+void context::capture_frame(std::filesystem::path path) noexcept
+{
+    m_capture_request = std::move(path);
 }
 
 mouse& context::mouse() noexcept { return m_mouse; }
@@ -1017,6 +1240,16 @@ command_buffer& context::commands() noexcept
     return m_window_stack.back().window->commands();
 }
 
+retained_commands* context::recording() noexcept
+{
+    auto& wnd_ctx = m_window_stack.back();
+    if (wnd_ctx.retained && wnd_ctx.primitive_depth != 0)
+    {
+        return &wnd_ctx.window->m_recording;
+    }
+    return nullptr;
+}
+
 void context::draw_layout_grid() noexcept
 {
     static constexpr auto guide = nine_patch{{10, 126, 74, 190}, {20}, {18}};
@@ -1025,7 +1258,8 @@ void context::draw_layout_grid() noexcept
     auto const depth = m_layout_grid.depth();
     auto const rhw   = calculate_rhw(depth);
 
-    auto const& texture = load_texture(*this, u8":layout-grid", 1);
+    auto const& texture = load_texture(
+        *this, u8":layout-grid", 1, texture_placement::standalone);
     auto const& size    = descriptor(layer).size;
     auto const& scale   = descriptor(layer).scale_factor;
 
@@ -1066,42 +1300,25 @@ void context::draw_layout_grid() noexcept
         gsl::narrow_cast<std::uint16_t>(v.offset),
         gsl::narrow_cast<std::uint16_t>(v.data.size()),
         gsl::narrow_cast<std::uint16_t>(i.offset),
-        gsl::narrow_cast<std::uint16_t>(i.data.size()));
-
-    gsl::at(v.data, v.offset + 0) = {grid_x0, grid_y0, depth, rhw, tx0, ty0};
-    gsl::at(v.data, v.offset + 1) = {grid_x1, grid_y0, depth, rhw, 0.f, ty0};
-    gsl::at(v.data, v.offset + 2) = {grid_x2, grid_y0, depth, rhw, tx1, ty0};
-    gsl::at(v.data, v.offset + 3) = {grid_x0, grid_y1, depth, rhw, tx0, 0.f};
-    gsl::at(v.data, v.offset + 4) = {grid_x1, grid_y1, depth, rhw, 0.f, 0.f};
-    gsl::at(v.data, v.offset + 5) = {grid_x2, grid_y1, depth, rhw, tx1, 0.f};
-    gsl::at(v.data, v.offset + 6) = {grid_x0, grid_y2, depth, rhw, tx0, ty1};
-    gsl::at(v.data, v.offset + 7) = {grid_x1, grid_y2, depth, rhw, 0.f, ty1};
-    gsl::at(v.data, v.offset + 8) = {grid_x2, grid_y2, depth, rhw, tx1, ty1};
-
-    gsl::at(i.data, i.offset + 0)  = 0;
-    gsl::at(i.data, i.offset + 1)  = 1;
-    gsl::at(i.data, i.offset + 2)  = 3;
-    gsl::at(i.data, i.offset + 3)  = 4;
-    gsl::at(i.data, i.offset + 4)  = 3;
-    gsl::at(i.data, i.offset + 5)  = 1;
-    gsl::at(i.data, i.offset + 6)  = 1;
-    gsl::at(i.data, i.offset + 7)  = 2;
-    gsl::at(i.data, i.offset + 8)  = 4;
-    gsl::at(i.data, i.offset + 9)  = 5;
-    gsl::at(i.data, i.offset + 10) = 4;
-    gsl::at(i.data, i.offset + 11) = 2;
-    gsl::at(i.data, i.offset + 12) = 3;
-    gsl::at(i.data, i.offset + 13) = 4;
-    gsl::at(i.data, i.offset + 14) = 6;
-    gsl::at(i.data, i.offset + 15) = 7;
-    gsl::at(i.data, i.offset + 16) = 6;
-    gsl::at(i.data, i.offset + 17) = 4;
-    gsl::at(i.data, i.offset + 18) = 4;
-    gsl::at(i.data, i.offset + 19) = 5;
-    gsl::at(i.data, i.offset + 20) = 7;
-    gsl::at(i.data, i.offset + 21) = 8;
-    gsl::at(i.data, i.offset + 22) = 7;
-    gsl::at(i.data, i.offset + 23) = 5;
+        gsl::narrow_cast<std::uint16_t>(i.data.size()),
+        rectangle{grid_x0, grid_y0, grid_x2, grid_y2});
+
+    gsl::at(v.data, 0) = {grid_x0, grid_y0, depth, rhw, tx0, ty0};
+    gsl::at(v.data, 1) = {grid_x1, grid_y0, depth, rhw, 0.f, ty0};
+    gsl::at(v.data, 2) = {grid_x2, grid_y0, depth, rhw, tx1, ty0};
+    gsl::at(v.data, 3) = {grid_x0, grid_y1, depth, rhw, tx0, 0.f};
+    gsl::at(v.data, 4) = {grid_x1, grid_y1, depth, rhw, 0.f, 0.f};
+    gsl::at(v.data, 5) = {grid_x2, grid_y1, depth, rhw, tx1, 0.f};
+    gsl::at(v.data, 6) = {grid_x0, grid_y2, depth, rhw, tx0, ty1};
+    gsl::at(v.data, 7) = {grid_x1, grid_y2, depth, rhw, 0.f, ty1};
+    gsl::at(v.data, 8) = {grid_x2, grid_y2, depth, rhw, tx1, ty1};
+
+    constexpr std::array<std::uint16_t, 24> grid_indices{
+        0, 1, 3, 4, 3, 1, 1, 2, 4, 5, 4, 2, 3, 4, 6, 7, 6, 4, 4, 5, 7, 8, 7, 5};
+    std::ranges::transform(
+        grid_indices, i.data.begin(), [offset = v.offset](auto idx) {
+            return gsl::narrow_cast<std::uint16_t>(idx + offset);
+        });
 
     commands.emplace<set_texture_wrap_command>(false);
 
@@ -1182,6 +1399,28 @@ void context::draw_layout_grid() noexcept
     m_window_stack.pop_back();
 }
 
+void context::draw_rerecorded_highlight() noexcept
+{
+    auto const& wnd         = *m_window_stack.back().window;
+    auto const scale        = scale_factor();
+    auto const [depth, rhw] = context::depth();
+    auto const& bounds      = wnd.bounds();
+
+    auto const x0 = std::round(scale.x * bounds.x0) - .5f;
+    auto const y0 = std::round(scale.y * bounds.y0) - .5f;
+    auto const x1 = std::round(scale.x * bounds.x1) - .5f;
+    auto const y1 = std::round(scale.y * bounds.y1) - .5f;
+    auto const c  = to_associated_alpha({255, 0, 255, 64});
+
+    set_texture(no_texture);
+    draw_triangle_list(
+        {{x0, y0, depth, rhw, 0, 0, c},
+         {x1, y0, depth, rhw, 0, 0, c},
+         {x0, y1, depth, rhw, 0, 0, c},
+         {x1, y1, depth, rhw, 0, 0, c}},
+        {0, 1, 2, 3, 2, 1});
+}
+
 void context::load_colors(
     std::u8string_view skin, std::size_t offset, std::size_t count) noexcept
 {
@@ -28,10 +28,15 @@
 #include "hooks/ffximain.hpp"
 #include "ui/command_buffer.hpp"
 #include "ui/cursor.hpp"
+#include "ui/d3d8_render_device.hpp"
 #include "ui/data_buffer.hpp"
+#include "ui/frame_capture.hpp"
 #include "ui/id.hpp"
 #include "ui/layer.hpp"
 #include "ui/mouse.hpp"
+#include "ui/render_device.hpp"
+#include "ui/retained_commands.hpp"
+#include "ui/ring_allocator.hpp"
 #include "ui/static_any.hpp"
 #include "ui/text_layout_engine.hpp"
 #include "ui/text_rasterizer.hpp"
@@ -53,7 +58,9 @@
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <initializer_list>
 #include <optional>
 #include <span>
@@ -113,6 +120,14 @@ enum class system_cursor : std::int8_t
     north_west_alt = 17,
 };
 
+// Statistics for the most recently completed frame.
+class frame_stats
+{
+public:
+    ring_statistics vertices;
+    ring_statistics indices;
+};
+
 class context
 {
 public:
@@ -201,6 +216,19 @@ public:
     bool layout_mode() const noexcept;
     void layout_mode(bool enabled) noexcept;
 
+    bool sort_commands() const noexcept;
+    void sort_commands(bool enabled) noexcept;
+
+    std::size_t vertex_capacity() const noexcept;
+    void vertex_capacity(std::size_t count) noexcept;
+    std::size_t index_capacity() const noexcept;
+    void index_capacity(std::size_t count) noexcept;
+
+    ui::frame_stats const& frame_stats() const noexcept;
+
+    bool highlight_rerecorded() const noexcept;
+    void highlight_rerecorded(bool enabled) noexcept;
+
     color system_color(system_color color) const noexcept;
 
     bool enabled() const noexcept;
@@ -222,6 +250,15 @@ public:
     window& begin_window(std::intptr_t id, layer layer, float depth) noexcept;
     void end_window() noexcept;
 
+    // Discards the retained output of the current window, or of every
+    // window when called outside of one.
+    void invalidate() noexcept;
+
+    // Returns true if the output recorded for this call last frame was
+    // replayed, in which case the caller must not generate it again.
+    bool begin_primitive(primitive_inputs inputs) noexcept;
+    void end_primitive() noexcept;
+
     std::optional<vector> to_widget(vector const&) const noexcept;
 
     vector origin() const noexcept;
@@ -235,6 +272,7 @@ public:
     bool interactable(layer layer) const noexcept;
 
     void set_texture(texture_token texture) noexcept;
+    rectangle const& texture_region() const noexcept;
 
     void draw_triangle_list(
         std::initializer_list<vertex> vertices,
@@ -252,6 +290,11 @@ public:
     void begin_frame() noexcept;
     void end_frame() noexcept;
     void render(layer layer) noexcept;
+    void render(layer layer, render_device& device) noexcept;
+
+    // Records the next frame, from begin_frame until the one after it, and
+    // saves it to the given path.
+    void capture_frame(std::filesystem::path path) noexcept;
 
     mouse& mouse() noexcept;
     texture_cache& texture_cache() noexcept;
@@ -279,12 +322,17 @@ private:
         std::vector<vector> offset_stack;
         std::vector<rectangle> clip_stack;
         std::vector<bool> enabled_stack;
-        bool fully_clipped = false;
+        bool fully_clipped          = false;
+        bool retained               = false;
+        bool rerecorded             = false;
+        std::size_t primitive_depth = 0;
+        std::size_t call_index      = 0;
     };
 
     ::HWND m_hwnd;
 
     gsl::not_null<::IDirect3DDevice8*> m_d3d_device;
+    d3d8_render_device m_render_device;
     winrt::com_ptr<::IWICImagingFactory> m_wic_factory;
     winrt::com_ptr<::IDWriteFactory> m_dwrite_factory;
 
@@ -302,9 +350,15 @@ private:
     window m_layout_grid;
     window_manager m_window_manager;
     std::vector<window_context> m_window_stack;
+    rectangle m_texture_region = {0.f, 0.f, 1.f, 1.f};
 
     data_buffer<vertex> m_vertex_buffer;
     data_buffer<std::uint16_t> m_index_buffer;
+    ui::frame_stats m_frame_stats;
+
+    std::filesystem::path m_capture_request;
+    std::filesystem::path m_capture_path;
+    std::optional<frame_capture> m_capture;
 
     std::u8string m_skin;
     std::array<color, 256> m_colors  = {};
@@ -323,7 +377,9 @@ private:
     id m_scroll_id;
     id m_scroll_requested_id;
 
-    bool m_layout_mode = false;
+    bool m_layout_mode          = false;
+    bool m_sort_commands        = true;
+    bool m_highlight_rerecorded = false;
 
     shared_window_config const* m_client_shared = nullptr;
     window_config const* m_client_log1          = nullptr;
@@ -332,8 +388,10 @@ private:
     layer_descriptor& descriptor(layer) noexcept;
     layer_descriptor const& descriptor(layer) const noexcept;
     command_buffer& commands() noexcept;
+    retained_commands* recording() noexcept;
 
     void draw_layout_grid() noexcept;
+    void draw_rerecorded_highlight() noexcept;
     void load_colors(
         std::u8string_view skin, std::size_t offset = 0,
         std::size_t count = 128) noexcept;
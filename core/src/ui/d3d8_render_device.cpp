@@ -0,0 +1,136 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/d3d8_render_device.hpp"
+
+#include "ui/render_device.hpp"
+#include "ui/vertex.hpp"
+
+#include <d3d8.h>
+
+#include <gsl/gsl>
+
+#include <bit>
+#include <cstdint>
+
+namespace windower::ui
+{
+namespace
+{
+
+template<typename T, typename H>
+T* from_handle(H handle) noexcept
+{
+    return std::bit_cast<T*>(static_cast<std::uintptr_t>(handle));
+}
+
+}
+
+d3d8_render_device::d3d8_render_device(
+    gsl::not_null<::IDirect3DDevice8*> d3d_device) noexcept :
+    m_d3d_device{d3d_device}
+{}
+
+texture_extent
+d3d8_render_device::extent(texture_handle texture) const noexcept
+{
+    auto const ptr = from_handle<::IDirect3DBaseTexture8>(texture);
+    if (!ptr || ptr->GetType() != ::D3DRTYPE_TEXTURE)
+    {
+        return {};
+    }
+
+    ::D3DSURFACE_DESC desc{};
+    static_cast<::IDirect3DTexture8*>(ptr)->GetLevelDesc(0, &desc);
+    return {desc.Width, desc.Height};
+}
+
+void d3d8_render_device::set_texture(texture_handle texture) noexcept
+{
+    m_d3d_device->SetTexture(0, from_handle<::IDirect3DBaseTexture8>(texture));
+}
+
+void d3d8_render_device::set_texture_wrap(bool wrap) noexcept
+{
+    auto const value = wrap ? D3DTADDRESS_WRAP : D3DTADDRESS_CLAMP;
+
+    m_d3d_device->SetTextureStageState(0, D3DTSS_ADDRESSU, value);
+    m_d3d_device->SetTextureStageState(0, D3DTSS_ADDRESSV, value);
+    m_d3d_device->SetTextureStageState(0, D3DTSS_ADDRESSW, value);
+}
+
+void d3d8_render_device::set_vertex_buffer(
+    vertex_buffer_handle buffer) noexcept
+{
+    m_d3d_device->SetStreamSource(
+        0, from_handle<::IDirect3DVertexBuffer8>(buffer), sizeof(vertex));
+}
+
+void d3d8_render_device::set_index_buffer(index_buffer_handle buffer) noexcept
+{
+    m_d3d_device->SetIndices(from_handle<::IDirect3DIndexBuffer8>(buffer), 0);
+}
+
+void d3d8_render_device::set_clip(render_viewport const& viewport) noexcept
+{
+    ::D3DVIEWPORT8 const d3d_viewport = {
+        viewport.x, viewport.y, viewport.width, viewport.height,
+        viewport.min_z, viewport.max_z};
+    m_d3d_device->SetViewport(&d3d_viewport);
+}
+
+void d3d8_render_device::draw_indexed(
+    primitive_type type, std::uint32_t min_index,
+    std::uint32_t vertex_count, std::uint32_t first_index,
+    std::uint32_t primitive_count) noexcept
+{
+    m_d3d_device->DrawIndexedPrimitive(
+        static_cast<::D3DPRIMITIVETYPE>(type), min_index, vertex_count,
+        first_index, primitive_count);
+}
+
+void d3d8_render_device::begin_mask() noexcept
+{
+    m_d3d_device->Clear(0, nullptr, D3DCLEAR_STENCIL, 0, 0.f, 0);
+    m_d3d_device->SetRenderState(D3DRS_ALPHATESTENABLE, TRUE);
+    m_d3d_device->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+    m_d3d_device->SetRenderState(D3DRS_STENCILENABLE, TRUE);
+    m_d3d_device->SetRenderState(D3DRS_STENCILFUNC, D3DCMP_ALWAYS);
+    m_d3d_device->SetRenderState(D3DRS_COLORWRITEENABLE, 0);
+}
+
+void d3d8_render_device::apply_mask() noexcept
+{
+    m_d3d_device->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
+    m_d3d_device->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
+    m_d3d_device->SetRenderState(D3DRS_STENCILFUNC, D3DCMP_EQUAL);
+    m_d3d_device->SetRenderState(D3DRS_COLORWRITEENABLE, 0x0000000F);
+}
+
+void d3d8_render_device::end_mask() noexcept
+{
+    m_d3d_device->SetRenderState(D3DRS_STENCILENABLE, FALSE);
+}
+
+}
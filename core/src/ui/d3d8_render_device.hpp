@@ -0,0 +1,82 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef WINDOWER_UI_D3D8_RENDER_DEVICE_HPP
+#define WINDOWER_UI_D3D8_RENDER_DEVICE_HPP
+
+#include "ui/render_device.hpp"
+
+#include <d3d8.h>
+
+#include <gsl/gsl>
+
+#include <bit>
+#include <cstdint>
+
+namespace windower::ui
+{
+
+inline texture_handle to_handle(::IDirect3DBaseTexture8* texture) noexcept
+{
+    return texture_handle{std::bit_cast<std::uintptr_t>(texture)};
+}
+
+inline vertex_buffer_handle
+to_handle(::IDirect3DVertexBuffer8* buffer) noexcept
+{
+    return vertex_buffer_handle{std::bit_cast<std::uintptr_t>(buffer)};
+}
+
+inline index_buffer_handle to_handle(::IDirect3DIndexBuffer8* buffer) noexcept
+{
+    return index_buffer_handle{std::bit_cast<std::uintptr_t>(buffer)};
+}
+
+class d3d8_render_device final : public render_device
+{
+public:
+    explicit d3d8_render_device(
+        gsl::not_null<::IDirect3DDevice8*> d3d_device) noexcept;
+
+    texture_extent extent(texture_handle texture) const noexcept override;
+
+    void set_texture(texture_handle texture) noexcept override;
+    void set_texture_wrap(bool wrap) noexcept override;
+    void set_vertex_buffer(vertex_buffer_handle buffer) noexcept override;
+    void set_index_buffer(index_buffer_handle buffer) noexcept override;
+    void set_clip(render_viewport const& viewport) noexcept override;
+    void draw_indexed(
+        primitive_type type, std::uint32_t min_index,
+        std::uint32_t vertex_count, std::uint32_t first_index,
+        std::uint32_t primitive_count) noexcept override;
+    void begin_mask() noexcept override;
+    void apply_mask() noexcept override;
+    void end_mask() noexcept override;
+
+private:
+    gsl::not_null<::IDirect3DDevice8*> m_d3d_device;
+};
+
+}
+
+#endif
@@ -27,15 +27,22 @@
 
 #include "ui/commands.hpp"
 #include "ui/command_buffer.hpp"
+#include "ui/d3d8_render_device.hpp"
 #include "ui/data_buffer_traits.hpp"
+#include "ui/frame_capture.hpp"
+#include "ui/ring_allocator.hpp"
 
 #include <d3d8.h>
 
+#include <gsl/gsl>
+
+#include <algorithm>
 #include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <span>
 #include <type_traits>
+#include <vector>
 
 namespace windower::ui
 {
@@ -55,24 +62,71 @@ class data_buffer
     static_assert(std::is_trivially_copyable_v<T>);
 
 public:
-    static constexpr std::size_t segment_capacity = 0x4000 / sizeof(T);
+    // Draw commands address elements with 16-bit offsets, and every ring
+    // must fit the largest list a single draw call writes.
+    static constexpr std::size_t min_capacity = 0x400;
+    static constexpr std::size_t max_capacity = 0x10000;
+    static constexpr std::size_t default_capacity =
+        std::min(0x40000 / sizeof(T), max_capacity);
     static constexpr command_buffer::state_id state_id =
         data_buffer_traits<T>::state_id;
 
+    explicit data_buffer(std::size_t capacity = default_capacity) noexcept :
+        m_rings{std::clamp(capacity, min_capacity, max_capacity)},
+        m_requested_capacity{m_rings.capacity()}
+    {}
+
+    std::size_t capacity() const noexcept { return m_requested_capacity; }
+
+    // Takes effect at the start of the next frame.
+    void capacity(std::size_t capacity) noexcept
+    {
+        m_requested_capacity =
+            std::clamp(capacity, min_capacity, max_capacity);
+    }
+
+    ring_statistics const& statistics() const noexcept
+    {
+        return m_rings.statistics();
+    }
+
+    // Copies everything written from now on into the capture, until it's
+    // reset to null. Locked memory is write-only, so while capturing the
+    // data is written to a shadow copy first and copied to the ring when
+    // the lock is released.
+    void capture(frame_capture* capture) noexcept { m_capture = capture; }
+
     void clear() noexcept
     {
-        m_buffers.erase(m_buffers.begin() + m_next, m_buffers.end());
-        m_next = 0;
+        finalize();
+        if (m_requested_capacity != m_rings.capacity())
+        {
+            m_rings.reset(m_requested_capacity);
+        }
+        m_rings.begin_frame();
     }
 
     void finalize() noexcept
     {
         if (m_current_buffer)
         {
+            if (!m_shadow.empty())
+            {
+                auto const written = std::span<T const>{m_shadow}.first(
+                    m_reserved - m_data.size());
+                std::ranges::copy(written, m_locked.begin());
+                if (m_capture)
+                {
+                    m_capture->record(
+                        to_handle(m_current_buffer), m_offset, written);
+                }
+                m_shadow.clear();
+            }
             m_current_buffer->Unlock();
+            m_rings.commit(m_reserved - m_data.size());
         }
         m_current_buffer = nullptr;
-        m_data = {};
+        m_data           = {};
     }
 
     data_segment<T> allocate(
@@ -86,20 +140,14 @@ public:
         ::IDirect3DDevice8* d3d_device, command_buffer& command_buffer,
         std::size_t min_count, std::size_t max_count) noexcept
     {
-        if (m_data.size() <= min_count)
+        if (m_data.size() < min_count)
         {
             finalize();
-            allocate_next(d3d_device);
-            command_buffer.emplace<set_data_buffer_command<T>>(
-                m_current_buffer);
+            lock_next(d3d_device, min_count);
         }
 
         command_buffer.emplace<set_data_buffer_command<T>>(m_current_buffer);
-        auto const count = std::min(max_count, m_data.size());
-        auto const data = m_data.subspan(0, count);
-        auto const offset = segment_capacity - m_data.size();
-        m_data = m_data.subspan(count);
-        return {data, offset};
+        return take(max_count);
     }
 
     data_segment<T>
@@ -112,43 +160,65 @@ public:
         ::IDirect3DDevice8* d3d_device, std::size_t min_count,
         std::size_t max_count) noexcept
     {
-        if (m_data.size() <= min_count)
+        if (m_data.size() < min_count)
         {
             finalize();
-            allocate_next(d3d_device);
+            lock_next(d3d_device, min_count);
             data_buffer_traits<T>::set_buffer(d3d_device, m_current_buffer);
         }
 
-        auto const count = std::min(max_count, m_data.size());
-        auto const data = m_data.subspan(0, count);
-        auto const offset = segment_capacity - m_data.size();
-        m_data = m_data.subspan(count);
-        return {data, offset};
+        return take(max_count);
     }
 
 private:
+    using com_pointer = typename data_buffer_traits<T>::com_pointer;
+
     std::span<T> m_data;
+    std::span<T> m_locked;
+    std::vector<T> m_shadow;
     typename data_buffer_traits<T>::pointer m_current_buffer = nullptr;
-    std::vector<typename data_buffer_traits<T>::com_pointer> m_buffers;
-    std::size_t m_next = 0;
+    ring_allocator<com_pointer> m_rings;
+    std::size_t m_requested_capacity;
+    std::size_t m_offset     = 0;
+    std::size_t m_reserved   = 0;
+    frame_capture* m_capture = nullptr;
 
-    void allocate_next(::IDirect3DDevice8* d3d_device) noexcept
+    data_segment<T> take(std::size_t max_count) noexcept
     {
-        struct helper
-        {
-            T data[segment_capacity];
-        };
+        auto const count  = std::min(max_count, m_data.size());
+        auto const data   = m_data.subspan(0, count);
+        auto const offset = m_offset + m_reserved - m_data.size();
+        m_data            = m_data.subspan(count);
+        return {data, offset};
+    }
 
-        if (m_next >= m_buffers.size())
+    void
+    lock_next(::IDirect3DDevice8* d3d_device, std::size_t min_count) noexcept
+    {
+        auto const next = m_rings.reserve(min_count, [=](std::size_t size) {
+            return data_buffer_traits<T>::allocate(d3d_device, size);
+        });
+
+        // Appending never touches data the device may still be reading, so
+        // only a wrap needs to discard the ring.
+        auto const flags =
+            (next.discard ? D3DLOCK_DISCARD : D3DLOCK_NOOVERWRITE) |
+            D3DLOCK_NOSYSLOCK;
+
+        ::BYTE* ptr = nullptr;
+        m_current_buffer = next.ring->get();
+        m_current_buffer->Lock(
+            gsl::narrow_cast<::UINT>(next.offset * sizeof(T)),
+            gsl::narrow_cast<::UINT>(next.count * sizeof(T)), &ptr, flags);
+        m_locked   = {static_cast<T*>(static_cast<void*>(ptr)), next.count};
+        m_data     = m_locked;
+        if (m_capture)
         {
-            m_buffers.push_back(
-                data_buffer_traits<T>::allocate(d3d_device, segment_capacity));
+            m_shadow.resize(next.count);
+            m_data = m_shadow;
         }
-        m_current_buffer = gsl::at(m_buffers, m_next).get();
-        ::BYTE* ptr = nullptr;
-        m_current_buffer->Lock(0, 0, &ptr, D3DLOCK_DISCARD | D3DLOCK_NOSYSLOCK);
-        m_data = std::span<T>{(new (ptr) helper)->data};
-        ++m_next;
+        m_offset   = next.offset;
+        m_reserved = next.count;
     }
 };
 
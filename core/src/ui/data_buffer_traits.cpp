@@ -25,6 +25,8 @@
 #include "ui/data_buffer_traits.hpp"
 
 #include "ui/context.hpp"
+#include "ui/d3d8_render_device.hpp"
+#include "ui/render_device.hpp"
 #include "ui/vertex.hpp"
 
 #include <gsl/gsl>
@@ -51,6 +53,12 @@ void data_buffer_traits<vertex>::set_buffer(
     d3d_device->SetStreamSource(0, ptr, sizeof(vertex));
 }
 
+void data_buffer_traits<vertex>::set_buffer(
+    render_device& device, pointer ptr) noexcept
+{
+    device.set_vertex_buffer(to_handle(ptr));
+}
+
 data_buffer_traits<std::uint16_t>::com_pointer
 data_buffer_traits<std::uint16_t>::allocate(
     gsl::not_null<::IDirect3DDevice8*> d3d_device, std::size_t size) noexcept
@@ -68,4 +76,10 @@ void data_buffer_traits<std::uint16_t>::set_buffer(
     d3d_device->SetIndices(ptr, 0);
 }
 
+void data_buffer_traits<std::uint16_t>::set_buffer(
+    render_device& device, pointer ptr) noexcept
+{
+    device.set_index_buffer(to_handle(ptr));
+}
+
 }
@@ -37,6 +37,8 @@
 namespace windower::ui
 {
 
+class render_device;
+
 template<typename>
 class data_buffer_traits;
 
@@ -51,12 +53,14 @@ public:
 
     static constexpr command_buffer::state_id state_id =
         command_buffer::state_id::vertex_buffer;
+    static constexpr command_opcode opcode = command_opcode::set_vertex_buffer;
 
     static com_pointer allocate(
         gsl::not_null<::IDirect3DDevice8*> d3d_device,
         std::size_t size) noexcept;
     static void set_buffer(
         gsl::not_null<::IDirect3DDevice8*> d3d_device, pointer ptr) noexcept;
+    static void set_buffer(render_device& device, pointer ptr) noexcept;
 };
 
 template<>
@@ -70,12 +74,14 @@ public:
 
     static constexpr command_buffer::state_id state_id =
         command_buffer::state_id::index_buffer;
+    static constexpr command_opcode opcode = command_opcode::set_index_buffer;
 
     static com_pointer allocate(
         gsl::not_null<::IDirect3DDevice8*> d3d_device,
         std::size_t size) noexcept;
     static void set_buffer(
         gsl::not_null<::IDirect3DDevice8*> d3d_device, pointer ptr) noexcept;
+    static void set_buffer(render_device& device, pointer ptr) noexcept;
 };
 
 }
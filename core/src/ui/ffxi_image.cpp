@@ -136,6 +136,38 @@ bool ffxi_image::copy_to(::IDirect3DTexture8* texture) const noexcept
     return SUCCEEDED(texture->UnlockRect(0));
 }
 
+bool ffxi_image::copy_to(
+    ::IDirect3DTexture8* texture, ::RECT const& bounds) const noexcept
+{
+    if (d3d_format() != ::D3DFMT_A8R8G8B8)
+    {
+        return false;
+    }
+
+    auto data = ::D3DLOCKED_RECT{};
+    if (!texture || FAILED(texture->LockRect(0, &data, &bounds, 0)))
+    {
+        return false;
+    }
+
+    auto const width =
+        gsl::narrow_cast<std::size_t>(bounds.right - bounds.left);
+    auto const height =
+        gsl::narrow_cast<std::size_t>(bounds.bottom - bounds.top);
+    auto const pitch  = gsl::narrow_cast<std::size_t>(data.Pitch);
+    auto const buffer = std::span{
+        static_cast<std::byte*>(data.pBits), pitch * (height - 1) + width * 4};
+
+    switch (m_bitmap_header.biBitCount)
+    {
+    case 0x08: copy_indexed_to(buffer, data.Pitch); break;
+    case 0x20: copy_rgba_to(buffer, data.Pitch); break;
+    default: return false;
+    }
+
+    return SUCCEEDED(texture->UnlockRect(0));
+}
+
 void ffxi_image::copy_indexed_to(
     std::span<std::byte> buffer, std::int32_t stride) const noexcept
 {
@@ -53,6 +53,7 @@ public:
     ui::dimension raw_size() const noexcept;
 
     bool copy_to(::IDirect3DTexture8*) const noexcept;
+    bool copy_to(::IDirect3DTexture8*, ::RECT const&) const noexcept;
 
 private:
     std::uint8_t m_type;
@@ -0,0 +1,536 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/frame_capture.hpp"
+
+#include "ui/dimension.hpp"
+#include "ui/layer.hpp"
+#include "ui/rectangle.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vector.hpp"
+#include "ui/vertex.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace windower::ui
+{
+namespace
+{
+
+using call_type = frame_capture::call_type;
+
+constexpr std::uint32_t magic = 0x31435557; // "WUC1"
+
+// The serialized sizes of the fixed records, used to reject counts that
+// claim more records than the file holds.
+constexpr std::size_t window_record_size = 37;
+constexpr std::size_t call_size          = 25;
+constexpr std::size_t texture_size       = 8;
+constexpr std::size_t segment_size       = 12;
+
+template<typename H>
+std::uint32_t identify(std::vector<H>& handles, H handle) noexcept
+{
+    if (handle == H::none)
+    {
+        return 0;
+    }
+    auto const it = std::ranges::find(handles, handle);
+    if (it == handles.end())
+    {
+        handles.push_back(handle);
+        return gsl::narrow_cast<std::uint32_t>(handles.size());
+    }
+    return gsl::narrow_cast<std::uint32_t>(it - handles.begin() + 1);
+}
+
+// Captures are written field by field, so that the layout doesn't depend
+// on the padding of the platform that wrote them.
+class writer
+{
+public:
+    explicit writer(std::ostream& stream) noexcept : m_stream{stream} {}
+
+    template<typename T>
+    requires std::is_trivially_copyable_v<T>
+    writer& operator()(T const& value)
+    {
+        return bytes(std::as_bytes(std::span{&value, 1}));
+    }
+
+    writer& operator()(rectangle const& value)
+    {
+        return (*this)(value.x0)(value.y0)(value.x1)(value.y1);
+    }
+
+    writer& operator()(vector const& value)
+    {
+        return (*this)(value.x)(value.y);
+    }
+
+    writer& bytes(std::span<std::byte const> bytes)
+    {
+        GSL_SUPPRESS(type.1)
+        {
+            m_stream.write(
+                reinterpret_cast<char const*>(bytes.data()),
+                gsl::narrow_cast<std::streamsize>(bytes.size()));
+        }
+        return *this;
+    }
+
+private:
+    std::ostream& m_stream;
+};
+
+class reader
+{
+public:
+    explicit reader(std::istream& stream) noexcept : m_stream{stream} {}
+
+    explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(m_stream);
+    }
+
+    template<typename T>
+    requires std::is_trivially_copyable_v<T>
+    reader& operator()(T& value)
+    {
+        return bytes(std::as_writable_bytes(std::span{&value, 1}));
+    }
+
+    reader& operator()(rectangle& value)
+    {
+        return (*this)(value.x0)(value.y0)(value.x1)(value.y1);
+    }
+
+    reader& operator()(vector& value) { return (*this)(value.x)(value.y); }
+
+    reader& bytes(std::span<std::byte> bytes)
+    {
+        GSL_SUPPRESS(type.1)
+        {
+            m_stream.read(
+                reinterpret_cast<char*>(bytes.data()),
+                gsl::narrow_cast<std::streamsize>(bytes.size()));
+        }
+        return *this;
+    }
+
+    // Guards against a damaged count allocating more than the file holds.
+    bool count(std::uint32_t& value, std::size_t element_size)
+    {
+        if (!(*this)(value))
+        {
+            return false;
+        }
+        auto const position = m_stream.tellg();
+        m_stream.seekg(0, std::ios::end);
+        auto const remaining = m_stream.tellg() - position;
+        m_stream.seekg(position);
+        return std::uint64_t{value} * element_size <=
+               gsl::narrow_cast<std::uint64_t>(remaining);
+    }
+
+private:
+    std::istream& m_stream;
+};
+
+template<typename T>
+void write_segments(
+    writer& write,
+    std::span<frame_capture::buffer_segment<T> const> segments)
+{
+    write(gsl::narrow_cast<std::uint32_t>(segments.size()));
+    for (auto const& segment : segments)
+    {
+        write(segment.buffer)(segment.offset);
+        write(gsl::narrow_cast<std::uint32_t>(segment.data.size()));
+        write.bytes(std::as_bytes(std::span{segment.data}));
+    }
+}
+
+template<typename T>
+bool read_segments(
+    reader& read, std::vector<frame_capture::buffer_segment<T>>& segments)
+{
+    std::uint32_t count = 0;
+    if (!read.count(count, segment_size))
+    {
+        return false;
+    }
+    segments.resize(count);
+    for (auto& segment : segments)
+    {
+        std::uint32_t size = 0;
+        read(segment.buffer)(segment.offset);
+        if (!read.count(size, sizeof(T)))
+        {
+            return false;
+        }
+        segment.data.resize(size);
+        read.bytes(std::as_writable_bytes(std::span{segment.data}));
+    }
+    return static_cast<bool>(read);
+}
+
+}
+
+frame_capture::frame_capture(
+    dimension const& screen_size, input_record const& input) noexcept :
+    m_screen_size{screen_size},
+    m_input{input}
+{}
+
+dimension const& frame_capture::screen_size() const noexcept
+{
+    return m_screen_size;
+}
+
+frame_capture::input_record const& frame_capture::input() const noexcept
+{
+    return m_input;
+}
+
+std::span<frame_capture::window_record const>
+frame_capture::windows() const noexcept
+{
+    return m_windows;
+}
+
+std::span<frame_capture::call const> frame_capture::calls() const noexcept
+{
+    return m_calls;
+}
+
+std::span<frame_capture::texture_record const>
+frame_capture::textures() const noexcept
+{
+    return m_textures;
+}
+
+std::span<frame_capture::buffer_segment<vertex> const>
+frame_capture::vertex_segments() const noexcept
+{
+    return m_vertex_segments;
+}
+
+std::span<frame_capture::buffer_segment<std::uint16_t> const>
+frame_capture::index_segments() const noexcept
+{
+    return m_index_segments;
+}
+
+void frame_capture::begin_window(
+    std::uint64_t id, ui::layer layer, float depth,
+    rectangle const& bounds) noexcept
+{
+    m_windows.push_back(
+        {.id         = id,
+         .layer      = layer,
+         .depth      = depth,
+         .bounds     = bounds,
+         .first_call = gsl::narrow_cast<std::uint32_t>(m_calls.size()),
+         .call_count = 0});
+}
+
+void frame_capture::record(
+    vertex_buffer_handle buffer, std::size_t offset,
+    std::span<vertex const> vertices) noexcept
+{
+    if (!vertices.empty())
+    {
+        m_vertex_segments.push_back(
+            {identify(buffer), gsl::narrow_cast<std::uint32_t>(offset),
+             {vertices.begin(), vertices.end()}});
+    }
+}
+
+void frame_capture::record(
+    index_buffer_handle buffer, std::size_t offset,
+    std::span<std::uint16_t const> indices) noexcept
+{
+    if (!indices.empty())
+    {
+        m_index_segments.push_back(
+            {identify(buffer), gsl::narrow_cast<std::uint32_t>(offset),
+             {indices.begin(), indices.end()}});
+    }
+}
+
+void frame_capture::record(
+    call_type type, std::initializer_list<std::uint32_t> arguments) noexcept
+{
+    Expects(arguments.size() <= std::tuple_size_v<decltype(call::arguments)>);
+
+    auto& entry = m_calls.emplace_back(call{type, {}});
+    std::ranges::copy(arguments, entry.arguments.begin());
+    if (!m_windows.empty())
+    {
+        ++m_windows.back().call_count;
+    }
+}
+
+std::uint32_t frame_capture::identify(
+    texture_handle texture, texture_extent const& extent) noexcept
+{
+    auto const id = ui::identify(m_texture_handles, texture);
+    if (id > m_textures.size())
+    {
+        m_textures.push_back({extent.width, extent.height});
+    }
+    return id;
+}
+
+std::uint32_t frame_capture::identify(vertex_buffer_handle buffer) noexcept
+{
+    return ui::identify(m_vertex_handles, buffer);
+}
+
+std::uint32_t frame_capture::identify(index_buffer_handle buffer) noexcept
+{
+    return ui::identify(m_index_handles, buffer);
+}
+
+bool frame_capture::save(std::filesystem::path const& path) const noexcept
+{
+    namespace fs = std::filesystem;
+
+    try
+    {
+        fs::create_directories(path.parent_path());
+        std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+        writer write{stream};
+
+        write(magic);
+        write(m_screen_size.width)(m_screen_size.height);
+        write(m_input.mouse_position)(m_input.scroll_offset);
+        write(m_input.held_buttons)(m_input.layout_mode);
+
+        write(gsl::narrow_cast<std::uint32_t>(m_windows.size()));
+        for (auto const& window : m_windows)
+        {
+            write(window.id)(window.layer)(window.depth)(window.bounds);
+            write(window.first_call)(window.call_count);
+        }
+
+        write(gsl::narrow_cast<std::uint32_t>(m_calls.size()));
+        for (auto const& call : m_calls)
+        {
+            write(call.type)(call.arguments);
+        }
+
+        write(gsl::narrow_cast<std::uint32_t>(m_textures.size()));
+        for (auto const& texture : m_textures)
+        {
+            write(texture.width)(texture.height);
+        }
+
+        write_segments(write, vertex_segments());
+        write_segments(write, index_segments());
+
+        return static_cast<bool>(stream.flush());
+    }
+    catch (std::exception const&)
+    {
+        return false;
+    }
+}
+
+std::optional<frame_capture>
+frame_capture::load(std::filesystem::path const& path) noexcept
+{
+    try
+    {
+        std::ifstream stream{path, std::ios::binary};
+        reader read{stream};
+
+        std::uint32_t file_magic = 0;
+        if (!read(file_magic) || file_magic != magic)
+        {
+            return std::nullopt;
+        }
+
+        frame_capture capture;
+        auto& input = capture.m_input;
+        read(capture.m_screen_size.width)(capture.m_screen_size.height);
+        read(input.mouse_position)(input.scroll_offset);
+        read(input.held_buttons)(input.layout_mode);
+
+        std::uint32_t count = 0;
+        if (!read.count(count, window_record_size))
+        {
+            return std::nullopt;
+        }
+        capture.m_windows.resize(count);
+        for (auto& window : capture.m_windows)
+        {
+            read(window.id)(window.layer)(window.depth)(window.bounds);
+            read(window.first_call)(window.call_count);
+        }
+
+        if (!read.count(count, call_size))
+        {
+            return std::nullopt;
+        }
+        capture.m_calls.resize(count);
+        for (auto& call : capture.m_calls)
+        {
+            read(call.type)(call.arguments);
+        }
+
+        if (!read.count(count, texture_size))
+        {
+            return std::nullopt;
+        }
+        capture.m_textures.resize(count);
+        for (auto& texture : capture.m_textures)
+        {
+            read(texture.width)(texture.height);
+        }
+
+        if (!read_segments(read, capture.m_vertex_segments) ||
+            !read_segments(read, capture.m_index_segments))
+        {
+            return std::nullopt;
+        }
+
+        // A window's calls must lie within the call list.
+        auto const calls = capture.m_calls.size();
+        if (std::ranges::any_of(capture.m_windows, [&](auto const& window) {
+                return window.first_call > calls ||
+                       window.call_count > calls - window.first_call;
+            }))
+        {
+            return std::nullopt;
+        }
+
+        return capture;
+    }
+    catch (std::exception const&)
+    {
+        return std::nullopt;
+    }
+}
+
+capture_render_device::capture_render_device(
+    frame_capture& capture, render_device& target) noexcept :
+    m_capture{capture},
+    m_target{target}
+{}
+
+texture_extent
+capture_render_device::extent(texture_handle texture) const noexcept
+{
+    return m_target.extent(texture);
+}
+
+void capture_render_device::set_texture(texture_handle texture) noexcept
+{
+    m_capture.record(
+        call_type::set_texture,
+        {m_capture.identify(texture, m_target.extent(texture))});
+    m_target.set_texture(texture);
+}
+
+void capture_render_device::set_texture_wrap(bool wrap) noexcept
+{
+    m_capture.record(call_type::set_texture_wrap, {wrap});
+    m_target.set_texture_wrap(wrap);
+}
+
+void capture_render_device::set_vertex_buffer(
+    vertex_buffer_handle buffer) noexcept
+{
+    m_capture.record(
+        call_type::set_vertex_buffer, {m_capture.identify(buffer)});
+    m_target.set_vertex_buffer(buffer);
+}
+
+void capture_render_device::set_index_buffer(
+    index_buffer_handle buffer) noexcept
+{
+    m_capture.record(
+        call_type::set_index_buffer, {m_capture.identify(buffer)});
+    m_target.set_index_buffer(buffer);
+}
+
+void capture_render_device::set_clip(render_viewport const& viewport) noexcept
+{
+    m_capture.record(
+        call_type::set_clip,
+        {viewport.x, viewport.y, viewport.width, viewport.height,
+         std::bit_cast<std::uint32_t>(viewport.min_z),
+         std::bit_cast<std::uint32_t>(viewport.max_z)});
+    m_target.set_clip(viewport);
+}
+
+void capture_render_device::draw_indexed(
+    primitive_type type, std::uint32_t min_index,
+    std::uint32_t vertex_count, std::uint32_t first_index,
+    std::uint32_t primitive_count) noexcept
+{
+    m_capture.record(
+        call_type::draw_indexed,
+        {static_cast<std::uint32_t>(type), min_index, vertex_count,
+         first_index, primitive_count});
+    m_target.draw_indexed(
+        type, min_index, vertex_count, first_index, primitive_count);
+}
+
+void capture_render_device::begin_mask() noexcept
+{
+    m_capture.record(call_type::begin_mask, {});
+    m_target.begin_mask();
+}
+
+void capture_render_device::apply_mask() noexcept
+{
+    m_capture.record(call_type::apply_mask, {});
+    m_target.apply_mask();
+}
+
+void capture_render_device::end_mask() noexcept
+{
+    m_capture.record(call_type::end_mask, {});
+    m_target.end_mask();
+}
+
+}
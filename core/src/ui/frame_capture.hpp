@@ -0,0 +1,195 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_FRAME_CAPTURE_HPP
+#define WINDOWER_UI_FRAME_CAPTURE_HPP
+
+#include "ui/dimension.hpp"
+#include "ui/layer.hpp"
+#include "ui/rectangle.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vector.hpp"
+#include "ui/vertex.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace windower::ui
+{
+
+// Everything a frame submitted to the device: the windows in the order they
+// were rendered, the device calls each of them made, the vertex and index
+// data written during the frame, and the input state the frame was built
+// from. Device handles are replaced by small identifiers, so a capture can
+// be saved, loaded on another machine and replayed against any device.
+class frame_capture
+{
+public:
+    enum class call_type : std::uint8_t
+    {
+        set_texture,
+        set_texture_wrap,
+        set_vertex_buffer,
+        set_index_buffer,
+        set_clip,
+        draw_indexed,
+        begin_mask,
+        apply_mask,
+        end_mask,
+    };
+
+    class call
+    {
+    public:
+        call_type type;
+        std::array<std::uint32_t, 6> arguments;
+    };
+
+    class window_record
+    {
+    public:
+        std::uint64_t id;
+        ui::layer layer;
+        float depth;
+        rectangle bounds;
+        std::uint32_t first_call;
+        std::uint32_t call_count;
+    };
+
+    class input_record
+    {
+    public:
+        vector mouse_position;
+        vector scroll_offset;
+        std::uint8_t held_buttons;
+        bool layout_mode;
+    };
+
+    // Textures are identified rather than copied; only their size is kept.
+    class texture_record
+    {
+    public:
+        std::uint32_t width  = 0;
+        std::uint32_t height = 0;
+    };
+
+    template<typename T>
+    class buffer_segment
+    {
+    public:
+        std::uint32_t buffer;
+        std::uint32_t offset;
+        std::vector<T> data;
+    };
+
+    frame_capture() noexcept = default;
+    frame_capture(
+        dimension const& screen_size, input_record const& input) noexcept;
+
+    dimension const& screen_size() const noexcept;
+    input_record const& input() const noexcept;
+    std::span<window_record const> windows() const noexcept;
+    std::span<call const> calls() const noexcept;
+    std::span<texture_record const> textures() const noexcept;
+    std::span<buffer_segment<vertex> const> vertex_segments() const noexcept;
+    std::span<buffer_segment<std::uint16_t> const>
+    index_segments() const noexcept;
+
+    void begin_window(
+        std::uint64_t id, ui::layer layer, float depth,
+        rectangle const& bounds) noexcept;
+
+    // Offsets count elements from the start of the buffer.
+    void record(
+        vertex_buffer_handle buffer, std::size_t offset,
+        std::span<vertex const> vertices) noexcept;
+    void record(
+        index_buffer_handle buffer, std::size_t offset,
+        std::span<std::uint16_t const> indices) noexcept;
+    void record(
+        call_type type,
+        std::initializer_list<std::uint32_t> arguments) noexcept;
+
+    // Identifiers start at one; zero stands for no handle. The extent is
+    // kept the first time a texture is seen.
+    std::uint32_t
+    identify(texture_handle texture, texture_extent const& extent) noexcept;
+    std::uint32_t identify(vertex_buffer_handle buffer) noexcept;
+    std::uint32_t identify(index_buffer_handle buffer) noexcept;
+
+    bool save(std::filesystem::path const& path) const noexcept;
+    static std::optional<frame_capture>
+    load(std::filesystem::path const& path) noexcept;
+
+private:
+    dimension m_screen_size;
+    input_record m_input = {};
+    std::vector<window_record> m_windows;
+    std::vector<call> m_calls;
+    std::vector<texture_record> m_textures;
+    std::vector<buffer_segment<vertex>> m_vertex_segments;
+    std::vector<buffer_segment<std::uint16_t>> m_index_segments;
+
+    // Only meaningful while recording; a loaded capture has no handles.
+    std::vector<texture_handle> m_texture_handles;
+    std::vector<vertex_buffer_handle> m_vertex_handles;
+    std::vector<index_buffer_handle> m_index_handles;
+};
+
+// Forwards every call to another device and appends it to a capture.
+class capture_render_device final : public render_device
+{
+public:
+    capture_render_device(
+        frame_capture& capture, render_device& target) noexcept;
+
+    texture_extent extent(texture_handle texture) const noexcept override;
+
+    void set_texture(texture_handle texture) noexcept override;
+    void set_texture_wrap(bool wrap) noexcept override;
+    void set_vertex_buffer(vertex_buffer_handle buffer) noexcept override;
+    void set_index_buffer(index_buffer_handle buffer) noexcept override;
+    void set_clip(render_viewport const& viewport) noexcept override;
+    void draw_indexed(
+        primitive_type type, std::uint32_t min_index,
+        std::uint32_t vertex_count, std::uint32_t first_index,
+        std::uint32_t primitive_count) noexcept override;
+    void begin_mask() noexcept override;
+    void apply_mask() noexcept override;
+    void end_mask() noexcept override;
+
+private:
+    frame_capture& m_capture;
+    render_device& m_target;
+};
+
+}
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/frame_replay.hpp"
+
+#include "ui/frame_capture.hpp"
+#include "ui/headless_render_device.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vertex.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace windower::ui
+{
+namespace
+{
+
+using call_type = frame_capture::call_type;
+
+// Draw commands address at most this many elements of a buffer, so larger
+// segments can only come from a damaged capture.
+constexpr std::size_t max_buffer_size = 0x10000;
+
+template<typename H>
+H handle(std::uint32_t id) noexcept
+{
+    return H{id};
+}
+
+template<typename T>
+std::vector<std::vector<T>>
+merge(std::span<frame_capture::buffer_segment<T> const> segments) noexcept
+{
+    std::vector<std::vector<T>> buffers;
+    for (auto const& segment : segments)
+    {
+        auto const end = std::size_t{segment.offset} + segment.data.size();
+        if (segment.buffer == 0 || end > max_buffer_size)
+        {
+            continue;
+        }
+        if (buffers.size() < segment.buffer)
+        {
+            buffers.resize(segment.buffer);
+        }
+        auto& buffer = gsl::at(buffers, segment.buffer - 1);
+        if (buffer.size() < end)
+        {
+            buffer.resize(end);
+        }
+        std::ranges::copy(segment.data, buffer.begin() + segment.offset);
+    }
+    return buffers;
+}
+
+void replay(render_device& device, frame_capture::call const& call) noexcept
+{
+    auto const argument = [&call](std::size_t index) noexcept {
+        return gsl::at(call.arguments, index);
+    };
+
+    switch (call.type)
+    {
+    case call_type::set_texture:
+        device.set_texture(handle<texture_handle>(argument(0)));
+        break;
+    case call_type::set_texture_wrap:
+        device.set_texture_wrap(argument(0) != 0);
+        break;
+    case call_type::set_vertex_buffer:
+        device.set_vertex_buffer(handle<vertex_buffer_handle>(argument(0)));
+        break;
+    case call_type::set_index_buffer:
+        device.set_index_buffer(handle<index_buffer_handle>(argument(0)));
+        break;
+    case call_type::set_clip:
+        device.set_clip(
+            {argument(0), argument(1), argument(2), argument(3),
+             std::bit_cast<float>(argument(4)),
+             std::bit_cast<float>(argument(5))});
+        break;
+    case call_type::draw_indexed:
+        device.draw_indexed(
+            static_cast<primitive_type>(argument(0)), argument(1),
+            argument(2), argument(3), argument(4));
+        break;
+    case call_type::begin_mask: device.begin_mask(); break;
+    case call_type::apply_mask: device.apply_mask(); break;
+    case call_type::end_mask: device.end_mask(); break;
+    }
+}
+
+}
+
+frame_replay::frame_replay(frame_capture const& capture) noexcept :
+    m_capture{&capture},
+    m_vertices{merge(capture.vertex_segments())},
+    m_indices{merge(capture.index_segments())}
+{}
+
+void frame_replay::bind(headless_render_device& device) const noexcept
+{
+    for (auto i = std::size_t{}; i < m_vertices.size(); ++i)
+    {
+        auto const id = gsl::narrow_cast<std::uint32_t>(i + 1);
+        device.bind(handle<vertex_buffer_handle>(id), gsl::at(m_vertices, i));
+    }
+    for (auto i = std::size_t{}; i < m_indices.size(); ++i)
+    {
+        auto const id = gsl::narrow_cast<std::uint32_t>(i + 1);
+        device.bind(handle<index_buffer_handle>(id), gsl::at(m_indices, i));
+    }
+}
+
+std::vector<frame_replay::window_report>
+frame_replay::run(render_device& device) const noexcept
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<window_report> reports;
+    reports.reserve(m_capture->windows().size());
+    for (auto const& window : m_capture->windows())
+    {
+        auto const calls =
+            m_capture->calls().subspan(window.first_call, window.call_count);
+
+        auto& report = reports.emplace_back(window_report{
+            .id         = window.id,
+            .layer      = window.layer,
+            .calls      = calls.size(),
+            .draw_calls = 0,
+            .primitives = 0,
+            .duration   = {}});
+        for (auto const& call : calls)
+        {
+            if (call.type == call_type::draw_indexed)
+            {
+                ++report.draw_calls;
+                report.primitives += gsl::at(call.arguments, 4);
+            }
+        }
+
+        auto const start = clock::now();
+        for (auto const& call : calls)
+        {
+            replay(device, call);
+        }
+        report.duration = clock::now() - start;
+    }
+    return reports;
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_FRAME_REPLAY_HPP
+#define WINDOWER_UI_FRAME_REPLAY_HPP
+
+#include "ui/frame_capture.hpp"
+#include "ui/headless_render_device.hpp"
+#include "ui/layer.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vertex.hpp"
+
+#include <gsl/gsl>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace windower::ui
+{
+
+// Runs a captured frame against a render device, window by window, and
+// reports what each window cost. The device sees the capture's identifiers
+// in place of handles; binding a headless device first lets it rasterize
+// the frame from the captured vertex and index data. Texture contents
+// aren't captured, so textured draws show only their vertex colours.
+class frame_replay
+{
+public:
+    class window_report
+    {
+    public:
+        std::uint64_t id;
+        ui::layer layer;
+        std::size_t calls;
+        std::size_t draw_calls;
+        std::size_t primitives;
+        std::chrono::nanoseconds duration;
+    };
+
+    explicit frame_replay(frame_capture const& capture) noexcept;
+
+    // The bindings refer to data owned by the replay, which has to outlive
+    // the draws that use them.
+    void bind(headless_render_device& device) const noexcept;
+
+    std::vector<window_report> run(render_device& device) const noexcept;
+
+private:
+    gsl::not_null<frame_capture const*> m_capture;
+    std::vector<std::vector<vertex>> m_vertices;
+    std::vector<std::vector<std::uint16_t>> m_indices;
+};
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_GRID_INDICES_HPP
+#define WINDOWER_UI_GRID_INDICES_HPP
+
+#include <gsl/gsl>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace windower::ui
+{
+
+// The indices of a grid of quads, two clockwise triangles per cell. The
+// vertices are laid out row by row.
+template<std::size_t Columns, std::size_t Rows>
+constexpr auto grid_indices() noexcept
+{
+    static_assert(Columns >= 2 && Rows >= 2);
+
+    std::array<std::uint16_t, (Columns - 1) * (Rows - 1) * 6> indices{};
+    auto index = std::size_t{};
+    for (auto row = std::size_t{}; row < Rows - 1; ++row)
+    {
+        for (auto column = std::size_t{}; column < Columns - 1; ++column)
+        {
+            auto const corner = row * Columns + column;
+            for (auto const offset :
+                 {std::size_t{0}, std::size_t{1}, Columns, Columns,
+                  std::size_t{1}, Columns + 1})
+            {
+                gsl::at(indices, index++) =
+                    gsl::narrow_cast<std::uint16_t>(corner + offset);
+            }
+        }
+    }
+    return indices;
+}
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_GRID_VERTICES_HPP
+#define WINDOWER_UI_GRID_VERTICES_HPP
+
+#include "ui/color.hpp"
+#include "ui/transform.hpp"
+#include "ui/vertex.hpp"
+
+#include <gsl/gsl>
+
+#include <array>
+#include <cstddef>
+
+namespace windower::ui
+{
+
+// The corners of a grid of quads, such as the cells of a nine-patch, laid
+// out row by row to match grid_indices. The transform is affine, so every
+// corner is the sum of a term that depends only on its column and one that
+// depends only on its row; those are computed once each, which leaves a
+// flat loop of additions per row that the compiler can vectorize.
+template<std::size_t Columns, std::size_t Rows>
+std::array<vertex, Columns * Rows> grid_vertices(
+    transform const& transform, float origin_x, float origin_y,
+    std::array<float, Columns> const& xs, std::array<float, Rows> const& ys,
+    std::array<float, Columns> const& us, std::array<float, Rows> const& vs,
+    float depth, float rhw, color c) noexcept
+{
+    static_assert(Columns >= 2 && Rows >= 2);
+
+    auto const& row_0 = gsl::at(transform, 0);
+    auto const& row_1 = gsl::at(transform, 1);
+
+    std::array<float, Columns> column_x{};
+    std::array<float, Columns> column_y{};
+    for (auto column = std::size_t{}; column < Columns; ++column)
+    {
+        auto const x = gsl::at(xs, column);
+        gsl::at(column_x, column) =
+            gsl::at(row_0, 0) * x + (gsl::at(row_0, 2) + origin_x);
+        gsl::at(column_y, column) =
+            gsl::at(row_1, 0) * x + (gsl::at(row_1, 2) + origin_y);
+    }
+
+    std::array<vertex, Columns * Rows> vertices;
+    for (auto row = std::size_t{}; row < Rows; ++row)
+    {
+        auto const y     = gsl::at(ys, row);
+        auto const row_x = gsl::at(row_0, 1) * y;
+        auto const row_y = gsl::at(row_1, 1) * y;
+        auto const v     = gsl::at(vs, row);
+        for (auto column = std::size_t{}; column < Columns; ++column)
+        {
+            gsl::at(vertices, row * Columns + column) = {
+                gsl::at(column_x, column) + row_x,
+                gsl::at(column_y, column) + row_y,
+                depth,
+                rhw,
+                gsl::at(us, column),
+                v,
+                c};
+        }
+    }
+    return vertices;
+}
+
+}
+
+#endif
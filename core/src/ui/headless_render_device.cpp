@@ -0,0 +1,416 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/headless_render_device.hpp"
+
+#include "ui/color.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vertex.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace windower::ui
+{
+
+namespace
+{
+
+template<typename K, typename V>
+void assign(std::vector<std::pair<K, V>>& bindings, K key, V const& value)
+{
+    if (auto const it =
+            std::ranges::find(bindings, key, &std::pair<K, V>::first);
+        it != bindings.end())
+    {
+        it->second = value;
+    }
+    else
+    {
+        bindings.emplace_back(key, value);
+    }
+}
+
+template<typename K, typename V>
+V const* lookup(std::vector<std::pair<K, V>> const& bindings, K key) noexcept
+{
+    if (auto const it =
+            std::ranges::find(bindings, key, &std::pair<K, V>::first);
+        it != bindings.end())
+    {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+// Twice the signed area of the triangle p0, p1, (x, y). It's positive when
+// the point lies to the right of the edge, looking from p0 to p1 on screen.
+constexpr float
+edge(vertex const& p0, vertex const& p1, float x, float y) noexcept
+{
+    return (p1.x - p0.x) * (y - p0.y) - (p1.y - p0.y) * (x - p0.x);
+}
+
+// Pixels whose centre lies exactly on an edge belong to the triangle on its
+// top or left side, so that triangles sharing the edge don't both draw it.
+constexpr bool covers(float w, vertex const& p0, vertex const& p1) noexcept
+{
+    auto const dx = p1.x - p0.x;
+    auto const dy = p1.y - p0.y;
+    return w > 0.f || (w == 0.f && (dy < 0.f || (dy == 0.f && dx > 0.f)));
+}
+
+std::uint8_t channel(float value) noexcept
+{
+    return gsl::narrow_cast<std::uint8_t>(
+        std::clamp(std::lround(value), 0l, 255l));
+}
+
+std::uint8_t modulate(std::uint8_t lhs, std::uint8_t rhs) noexcept
+{
+    return gsl::narrow_cast<std::uint8_t>((lhs * rhs + 127) / 255);
+}
+
+color sample(
+    headless_render_device::texture_image const& texture, float u, float v,
+    bool wrap) noexcept
+{
+    auto const width  = texture.width;
+    auto const height = texture.height;
+    if (width == 0 || height == 0 ||
+        texture.pixels.size() < std::size_t{width} * height)
+    {
+        return colors::white;
+    }
+
+    auto const coordinate = [wrap](float t, std::uint32_t size) {
+        auto const normalized =
+            wrap ? t - std::floor(t) : std::clamp(t, 0.f, 1.f);
+        return std::min(
+            gsl::narrow_cast<std::uint32_t>(normalized * size), size - 1);
+    };
+
+    auto const x = coordinate(u, width);
+    auto const y = coordinate(v, height);
+    return gsl::at(texture.pixels, std::size_t{y} * width + x);
+}
+
+}
+
+headless_render_device::headless_render_device(
+    std::uint32_t width, std::uint32_t height) noexcept :
+    m_width{width},
+    m_height{height}, m_image(std::size_t{width} * height),
+    m_stencil(std::size_t{width} * height)
+{
+    clear();
+}
+
+std::uint32_t headless_render_device::width() const noexcept
+{
+    return m_width;
+}
+
+std::uint32_t headless_render_device::height() const noexcept
+{
+    return m_height;
+}
+
+std::span<color const> headless_render_device::image() const noexcept
+{
+    return m_image;
+}
+
+std::span<headless_render_device::draw_record const>
+headless_render_device::draws() const noexcept
+{
+    return m_draws;
+}
+
+void headless_render_device::bind(
+    vertex_buffer_handle buffer, std::span<vertex const> vertices) noexcept
+{
+    assign(m_vertex_bindings, buffer, vertices);
+}
+
+void headless_render_device::bind(
+    index_buffer_handle buffer,
+    std::span<std::uint16_t const> indices) noexcept
+{
+    assign(m_index_bindings, buffer, indices);
+}
+
+void headless_render_device::bind(
+    texture_handle texture, texture_image const& image) noexcept
+{
+    assign(m_texture_bindings, texture, image);
+}
+
+void headless_render_device::clear(color background) noexcept
+{
+    std::ranges::fill(m_image, background);
+    std::ranges::fill(m_stencil, std::uint8_t{0});
+    m_draws.clear();
+
+    m_texture       = texture_handle::none;
+    m_vertex_buffer = vertex_buffer_handle::none;
+    m_index_buffer  = index_buffer_handle::none;
+    m_clip          = {0, 0, m_width, m_height};
+    m_wrap          = false;
+    m_mask          = mask_state::disabled;
+}
+
+texture_extent
+headless_render_device::extent(texture_handle texture) const noexcept
+{
+    if (auto const image = lookup(m_texture_bindings, texture))
+    {
+        return {image->width, image->height};
+    }
+    return {};
+}
+
+void headless_render_device::set_texture(texture_handle texture) noexcept
+{
+    m_texture = texture;
+}
+
+void headless_render_device::set_texture_wrap(bool wrap) noexcept
+{
+    m_wrap = wrap;
+}
+
+void headless_render_device::set_vertex_buffer(
+    vertex_buffer_handle buffer) noexcept
+{
+    m_vertex_buffer = buffer;
+}
+
+void headless_render_device::set_index_buffer(
+    index_buffer_handle buffer) noexcept
+{
+    m_index_buffer = buffer;
+}
+
+void headless_render_device::set_clip(
+    render_viewport const& viewport) noexcept
+{
+    m_clip = viewport;
+}
+
+void headless_render_device::draw_indexed(
+    primitive_type type, [[maybe_unused]] std::uint32_t min_index,
+    [[maybe_unused]] std::uint32_t vertex_count, std::uint32_t first_index,
+    std::uint32_t primitive_count) noexcept
+{
+    auto rasterized = false;
+    if (type == primitive_type::triangle_list)
+    {
+        auto const vertices = lookup(m_vertex_bindings, m_vertex_buffer);
+        auto const indices  = lookup(m_index_bindings, m_index_buffer);
+        if (vertices && indices)
+        {
+            rasterized =
+                rasterize(*vertices, *indices, first_index, primitive_count);
+        }
+    }
+
+    m_draws.push_back(
+        {.type            = type,
+         .texture         = m_texture,
+         .vertex_buffer   = m_vertex_buffer,
+         .index_buffer    = m_index_buffer,
+         .clip            = m_clip,
+         .first_index     = first_index,
+         .primitive_count = primitive_count,
+         .wrap            = m_wrap,
+         .masked          = m_mask != mask_state::disabled,
+         .rasterized      = rasterized});
+}
+
+void headless_render_device::begin_mask() noexcept
+{
+    std::ranges::fill(m_stencil, std::uint8_t{0});
+    m_mask = mask_state::writing;
+}
+
+void headless_render_device::apply_mask() noexcept
+{
+    m_mask = mask_state::testing;
+}
+
+void headless_render_device::end_mask() noexcept
+{
+    m_mask = mask_state::disabled;
+}
+
+bool headless_render_device::rasterize(
+    std::span<vertex const> vertices, std::span<std::uint16_t const> indices,
+    std::uint32_t first_index, std::uint32_t primitive_count) noexcept
+{
+    auto const count = std::size_t{primitive_count} * 3;
+    if (first_index > indices.size() || count > indices.size() - first_index)
+    {
+        return false;
+    }
+
+    auto const triangles = indices.subspan(first_index, count);
+    if (std::ranges::any_of(
+            triangles, [&](auto index) { return index >= vertices.size(); }))
+    {
+        return false;
+    }
+
+    auto const texture = lookup(m_texture_bindings, m_texture);
+    for (auto i = std::size_t{0}; i < triangles.size(); i += 3)
+    {
+        rasterize(
+            gsl::at(vertices, gsl::at(triangles, i)),
+            gsl::at(vertices, gsl::at(triangles, i + 1)),
+            gsl::at(vertices, gsl::at(triangles, i + 2)), texture);
+    }
+    return true;
+}
+
+void headless_render_device::rasterize(
+    vertex const& a, vertex const& b, vertex const& c,
+    texture_image const* texture) noexcept
+{
+    // The device culls counter-clockwise triangles, so only triangles that
+    // wind clockwise on screen have a positive area here.
+    auto const area = edge(a, b, c.x, c.y);
+    if (!(area > 0.f))
+    {
+        return;
+    }
+
+    auto const clip_x0 = std::min<std::uint32_t>(m_clip.x, m_width);
+    auto const clip_y0 = std::min<std::uint32_t>(m_clip.y, m_height);
+    auto const clip_x1 =
+        std::min<std::uint32_t>(m_clip.x + m_clip.width, m_width);
+    auto const clip_y1 =
+        std::min<std::uint32_t>(m_clip.y + m_clip.height, m_height);
+
+    auto const bound = [](float value, std::uint32_t low, std::uint32_t high) {
+        return gsl::narrow_cast<std::uint32_t>(std::clamp(
+            value, static_cast<float>(low), static_cast<float>(high)));
+    };
+
+    auto const [min_x, max_x] = std::minmax({a.x, b.x, c.x});
+    auto const [min_y, max_y] = std::minmax({a.y, b.y, c.y});
+
+    auto const x0 = bound(std::floor(min_x), clip_x0, clip_x1);
+    auto const y0 = bound(std::floor(min_y), clip_y0, clip_y1);
+    auto const x1 = bound(std::ceil(max_x) + 1.f, clip_x0, clip_x1);
+    auto const y1 = bound(std::ceil(max_y) + 1.f, clip_y0, clip_y1);
+
+    for (auto y = y0; y < y1; ++y)
+    {
+        for (auto x = x0; x < x1; ++x)
+        {
+            // Pixel centres sit on integer coordinates, as in Direct3D 8;
+            // vertices are offset by half a pixel to account for it.
+            auto const px = static_cast<float>(x);
+            auto const py = static_cast<float>(y);
+            auto const w0 = edge(b, c, px, py);
+            auto const w1 = edge(c, a, px, py);
+            auto const w2 = edge(a, b, px, py);
+            if (!covers(w0, b, c) || !covers(w1, c, a) || !covers(w2, a, b))
+            {
+                continue;
+            }
+
+            auto const l0 = w0 / area;
+            auto const l1 = w1 / area;
+            auto const l2 = w2 / area;
+
+            auto const interpolate = [&](auto member) {
+                return l0 * a.color.*member + l1 * b.color.*member +
+                       l2 * c.color.*member;
+            };
+
+            auto diffuse = color{
+                channel(interpolate(&color::r)),
+                channel(interpolate(&color::g)),
+                channel(interpolate(&color::b)),
+                channel(interpolate(&color::a))};
+
+            if (texture)
+            {
+                auto const u     = l0 * a.u + l1 * b.u + l2 * c.u;
+                auto const v     = l0 * a.v + l1 * b.v + l2 * c.v;
+                auto const texel = sample(*texture, u, v, m_wrap);
+                diffuse.r        = modulate(diffuse.r, texel.r);
+                diffuse.g        = modulate(diffuse.g, texel.g);
+                diffuse.b        = modulate(diffuse.b, texel.b);
+                diffuse.a        = modulate(diffuse.a, texel.a);
+            }
+
+            write(std::size_t{y} * m_width + x, diffuse);
+        }
+    }
+}
+
+void headless_render_device::write(std::size_t pixel, color source) noexcept
+{
+    switch (m_mask)
+    {
+    case mask_state::writing:
+        // Alpha testing against 128 decides what the mask covers; nothing
+        // is drawn while the mask is being written.
+        if (source.a >= 128)
+        {
+            gsl::at(m_stencil, pixel) = 1;
+        }
+        return;
+    case mask_state::testing:
+        if (gsl::at(m_stencil, pixel) != 1)
+        {
+            return;
+        }
+        break;
+    case mask_state::disabled: break;
+    }
+
+    // Colours are premultiplied: source + destination * (1 - source alpha).
+    auto& destination    = gsl::at(m_image, pixel);
+    auto const remaining = gsl::narrow_cast<std::uint8_t>(255 - source.a);
+    destination.r = gsl::narrow_cast<std::uint8_t>(
+        std::min(source.r + modulate(destination.r, remaining), 255));
+    destination.g = gsl::narrow_cast<std::uint8_t>(
+        std::min(source.g + modulate(destination.g, remaining), 255));
+    destination.b = gsl::narrow_cast<std::uint8_t>(
+        std::min(source.b + modulate(destination.b, remaining), 255));
+    destination.a = gsl::narrow_cast<std::uint8_t>(
+        std::min(source.a + modulate(destination.a, remaining), 255));
+}
+
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_HEADLESS_RENDER_DEVICE_HPP
+#define WINDOWER_UI_HEADLESS_RENDER_DEVICE_HPP
+
+#include "ui/color.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vertex.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace windower::ui
+{
+
+// A render device that replays command buffers without Direct3D, for
+// running the UI outside the game. Every draw is logged. Triangle lists
+// whose buffers have been bound to CPU copies are also rasterized into an
+// A8R8G8B8 image, with the culling, clipping, premultiplied blending and
+// stencil masking the real device is set up for. Textures are point
+// sampled, and depth is ignored.
+//
+// Bound spans are views; the memory behind them has to outlive the draws
+// that use it.
+class headless_render_device final : public render_device
+{
+public:
+    class draw_record
+    {
+    public:
+        primitive_type type;
+        texture_handle texture;
+        vertex_buffer_handle vertex_buffer;
+        index_buffer_handle index_buffer;
+        render_viewport clip;
+        std::uint32_t first_index;
+        std::uint32_t primitive_count;
+        bool wrap;
+        bool masked;
+        bool rasterized;
+    };
+
+    class texture_image
+    {
+    public:
+        std::uint32_t width  = 0;
+        std::uint32_t height = 0;
+        std::span<color const> pixels;
+    };
+
+    headless_render_device(std::uint32_t width, std::uint32_t height) noexcept;
+
+    std::uint32_t width() const noexcept;
+    std::uint32_t height() const noexcept;
+    std::span<color const> image() const noexcept;
+    std::span<draw_record const> draws() const noexcept;
+
+    void bind(
+        vertex_buffer_handle buffer, std::span<vertex const> vertices) noexcept;
+    void bind(
+        index_buffer_handle buffer,
+        std::span<std::uint16_t const> indices) noexcept;
+    void bind(texture_handle texture, texture_image const& image) noexcept;
+
+    // Clears the image, the stencil and the draw log, and resets the
+    // device state. Bindings are kept.
+    void clear(color background = {0, 0, 0, 0}) noexcept;
+
+    texture_extent extent(texture_handle texture) const noexcept override;
+
+    void set_texture(texture_handle texture) noexcept override;
+    void set_texture_wrap(bool wrap) noexcept override;
+    void set_vertex_buffer(vertex_buffer_handle buffer) noexcept override;
+    void set_index_buffer(index_buffer_handle buffer) noexcept override;
+    void set_clip(render_viewport const& viewport) noexcept override;
+    void draw_indexed(
+        primitive_type type, std::uint32_t min_index,
+        std::uint32_t vertex_count, std::uint32_t first_index,
+        std::uint32_t primitive_count) noexcept override;
+    void begin_mask() noexcept override;
+    void apply_mask() noexcept override;
+    void end_mask() noexcept override;
+
+private:
+    enum class mask_state : std::uint8_t
+    {
+        disabled,
+        writing,
+        testing,
+    };
+
+    template<typename K, typename V>
+    using binding = std::pair<K, std::span<V const>>;
+
+    bool rasterize(
+        std::span<vertex const> vertices,
+        std::span<std::uint16_t const> indices, std::uint32_t first_index,
+        std::uint32_t primitive_count) noexcept;
+    void rasterize(
+        vertex const& a, vertex const& b, vertex const& c,
+        texture_image const* texture) noexcept;
+    void write(std::size_t pixel, color source) noexcept;
+
+    std::uint32_t m_width;
+    std::uint32_t m_height;
+    std::vector<color> m_image;
+    std::vector<std::uint8_t> m_stencil;
+    std::vector<draw_record> m_draws;
+
+    std::vector<binding<vertex_buffer_handle, vertex>> m_vertex_bindings;
+    std::vector<binding<index_buffer_handle, std::uint16_t>> m_index_bindings;
+    std::vector<std::pair<texture_handle, texture_image>> m_texture_bindings;
+
+    texture_handle m_texture             = texture_handle::none;
+    vertex_buffer_handle m_vertex_buffer = vertex_buffer_handle::none;
+    index_buffer_handle m_index_buffer   = index_buffer_handle::none;
+    render_viewport m_clip;
+    bool m_wrap       = false;
+    mask_state m_mask = mask_state::disabled;
+};
+
+}
+
+#endif
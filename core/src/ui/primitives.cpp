@@ -26,9 +26,13 @@
 
 #include "ui/color.hpp"
 #include "ui/context.hpp"
+#include "ui/dimension.hpp"
 #include "ui/ffxi_image.hpp"
+#include "ui/grid_indices.hpp"
+#include "ui/grid_vertices.hpp"
 #include "ui/patch.hpp"
 #include "ui/rectangle.hpp"
+#include "ui/retained_commands.hpp"
 #include "ui/texture_loaders.hpp"
 #include "ui/vector.hpp"
 #include "ui/vertex.hpp"
@@ -38,11 +42,96 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <numeric>
 #include <utility>
 
 namespace windower::ui::primitive
 {
+namespace
+{
+
+enum class primitive_kind : std::uint8_t
+{
+    rectangle,
+    patch,
+    nine_patch,
+    h_patch,
+    v_patch,
+    text,
+    text_layout,
+};
+
+// Lets a window replay a primitive's output from the previous frame when
+// nothing it depends on has changed. Only the outermost primitive on the
+// stack is retained; nested calls record into it.
+class primitive_scope
+{
+public:
+    primitive_scope(context& ctx, primitive_inputs const& inputs) noexcept :
+        m_ctx{ctx}, m_replayed{ctx.begin_primitive(inputs)}
+    {}
+
+    primitive_scope(primitive_scope const&) = delete;
+    primitive_scope(primitive_scope&&)      = delete;
+
+    ~primitive_scope() noexcept { m_ctx.end_primitive(); }
+
+    primitive_scope& operator=(primitive_scope const&) = delete;
+    primitive_scope& operator=(primitive_scope&&) = delete;
+
+    bool replayed() const noexcept { return m_replayed; }
+
+private:
+    context& m_ctx;
+    bool m_replayed;
+};
+
+// Turns a patch's texel coordinates into texture coordinates within the
+// region of the bound texture that holds the image, which is only part of
+// the texture when the image was packed into an atlas page.
+class texture_mapping
+{
+public:
+    texture_mapping(
+        context const& ctx, dimension const& texture_size) noexcept :
+        m_region{ctx.texture_region()}, m_texture_size{texture_size}
+    {}
+
+    float u(float x) const noexcept
+    {
+        return m_region.x0 + x / m_texture_size.width * m_region.width();
+    }
+
+    float v(float y) const noexcept
+    {
+        return m_region.y0 + y / m_texture_size.height * m_region.height();
+    }
+
+private:
+    ui::rectangle m_region;
+    dimension m_texture_size;
+};
+
+// Emits a whole grid of quads, such as the cells of a nine-patch, in one
+// draw.
+template<std::size_t Columns, std::size_t Rows>
+void draw_grid(
+    context& ctx, transform const& transform, float origin_x, float origin_y,
+    std::array<float, Columns> const& xs, std::array<float, Rows> const& ys,
+    std::array<float, Columns> const& us, std::array<float, Rows> const& vs,
+    color c) noexcept
+{
+    static constexpr auto indices = grid_indices<Columns, Rows>();
+
+    auto const [depth, rhw] = ctx.depth();
+    auto const vertices     = grid_vertices<Columns, Rows>(
+        transform, origin_x, origin_y, xs, ys, us, vs, depth, rhw, c);
+
+    ctx.draw_triangle_list(vertices, indices, determinant(transform) < 0);
+}
+
+}
 
 void set_texture(
     context& ctx, std::u8string_view name, std::size_t time_to_live) noexcept
@@ -75,10 +164,16 @@ texture_token get_texture(
 
 void rectangle(context& ctx, ui::rectangle const& bounds, color c) noexcept
 {
-    auto const origin       = ctx.origin();
-    auto const zoom         = ctx.zoom_factor();
-    auto const scale        = ctx.scale_factor();
-    auto const [depth, rhw] = ctx.depth();
+    primitive_scope const scope{
+        ctx, primitive_inputs{primitive_kind::rectangle, bounds, c}};
+    if (scope.replayed())
+    {
+        return;
+    }
+
+    auto const origin = ctx.origin();
+    auto const zoom   = ctx.zoom_factor();
+    auto const scale  = ctx.scale_factor();
 
     auto transform = ctx.current_transform();
 
@@ -112,38 +207,28 @@ void rectangle(context& ctx, ui::rectangle const& bounds, color c) noexcept
     x1 = std::round(scale_x * x1);
     y1 = std::round(scale_y * y1);
 
-    auto p0 = transform * vector{x0, y0};
-    auto p1 = transform * vector{x1, y0};
-    auto p2 = transform * vector{x0, y1};
-    auto p3 = transform * vector{x1, y1};
-
-    if (determinant(transform) < 0)
-    {
-        using std::swap;
-
-        swap(p0, p3);
-        swap(p1, p2);
-    }
-
     c = to_associated_alpha(c);
 
     set_texture(ctx, no_texture);
-    ctx.draw_triangle_list(
-        {{p0.x + origin_x, p0.y + origin_y, depth, rhw, 0, 0, c},
-         {p1.x + origin_x, p1.y + origin_y, depth, rhw, 0, 0, c},
-         {p2.x + origin_x, p2.y + origin_y, depth, rhw, 0, 0, c},
-         {p3.x + origin_x, p3.y + origin_y, depth, rhw, 0, 0, c}},
-        {0, 1, 2, 3, 2, 1});
+    draw_grid<2, 2>(
+        ctx, transform, origin_x, origin_y, {x0, x1}, {y0, y1}, {0.f, 0.f},
+        {0.f, 0.f}, c);
 }
 
 void rectangle(
     context& ctx, ui::rectangle const& bounds, patch const& patch,
     color c) noexcept
 {
-    auto const origin       = ctx.origin();
-    auto const zoom         = ctx.zoom_factor();
-    auto const scale        = ctx.scale_factor();
-    auto const [depth, rhw] = ctx.depth();
+    primitive_scope const scope{
+        ctx, primitive_inputs{primitive_kind::patch, bounds, patch, c}};
+    if (scope.replayed())
+    {
+        return;
+    }
+
+    auto const origin = ctx.origin();
+    auto const zoom   = ctx.zoom_factor();
+    auto const scale  = ctx.scale_factor();
 
     auto transform = ctx.current_transform();
 
@@ -201,35 +286,35 @@ void rectangle(
     x1 += x_ratio * overdraw_r;
     y1 += y_ratio * overdraw_b;
 
-    auto const tx0 = patch.bounds.x0 / patch.texture_size.width;
-    auto const tx1 = patch.bounds.x1 / patch.texture_size.width;
+    auto const uv = texture_mapping{ctx, patch.texture_size};
 
-    auto const ty0 = patch.bounds.y0 / patch.texture_size.height;
-    auto const ty1 = patch.bounds.y1 / patch.texture_size.height;
+    auto const tx0 = uv.u(patch.bounds.x0);
+    auto const tx1 = uv.u(patch.bounds.x1);
 
-    auto const p0 = transform * vector{x0, y0};
-    auto const p1 = transform * vector{x1, y0};
-    auto const p2 = transform * vector{x0, y1};
-    auto const p3 = transform * vector{x1, y1};
+    auto const ty0 = uv.v(patch.bounds.y0);
+    auto const ty1 = uv.v(patch.bounds.y1);
 
     c = to_associated_alpha(c);
 
-    ctx.draw_triangle_list(
-        {{p0.x + origin_x, p0.y + origin_y, depth, rhw, tx0, ty0, c},
-         {p1.x + origin_x, p1.y + origin_y, depth, rhw, tx1, ty0, c},
-         {p2.x + origin_x, p2.y + origin_y, depth, rhw, tx0, ty1, c},
-         {p3.x + origin_x, p3.y + origin_y, depth, rhw, tx1, ty1, c}},
-        {0, 1, 2, 3, 2, 1}, determinant(transform) < 0);
+    draw_grid<2, 2>(
+        ctx, transform, origin_x, origin_y, {x0, x1}, {y0, y1}, {tx0, tx1},
+        {ty0, ty1}, c);
 }
 
 void rectangle(
     context& ctx, ui::rectangle const& bounds, nine_patch const& patch,
     color c) noexcept
 {
-    auto const origin       = ctx.origin();
-    auto const zoom         = ctx.zoom_factor();
-    auto const scale        = ctx.scale_factor();
-    auto const [depth, rhw] = ctx.depth();
+    primitive_scope const scope{
+        ctx, primitive_inputs{primitive_kind::nine_patch, bounds, patch, c}};
+    if (scope.replayed())
+    {
+        return;
+    }
+
+    auto const origin = ctx.origin();
+    auto const zoom   = ctx.zoom_factor();
+    auto const scale  = ctx.scale_factor();
 
     auto transform = ctx.current_transform();
 
@@ -314,66 +399,39 @@ void rectangle(
         y3 += scale_y * overdraw_b;
     }
 
-    auto const tx0 = patch.bounds.x0 / patch.texture_size.width;
-    auto const tx3 = patch.bounds.x1 / patch.texture_size.width;
-    auto const tx1 = tx0 + patch.slice.left / patch.texture_size.width;
-    auto const tx2 = tx3 - patch.slice.right / patch.texture_size.width;
-
-    auto const ty0 = patch.bounds.y0 / patch.texture_size.height;
-    auto const ty3 = patch.bounds.y1 / patch.texture_size.height;
-    auto const ty1 = ty0 + patch.slice.top / patch.texture_size.height;
-    auto const ty2 = ty3 - patch.slice.bottom / patch.texture_size.height;
-
-    auto const p00 = transform * vector{x0, y0};
-    auto const p01 = transform * vector{x1, y0};
-    auto const p02 = transform * vector{x2, y0};
-    auto const p03 = transform * vector{x3, y0};
-    auto const p04 = transform * vector{x0, y1};
-    auto const p05 = transform * vector{x1, y1};
-    auto const p06 = transform * vector{x2, y1};
-    auto const p07 = transform * vector{x3, y1};
-    auto const p08 = transform * vector{x0, y2};
-    auto const p09 = transform * vector{x1, y2};
-    auto const p10 = transform * vector{x2, y2};
-    auto const p11 = transform * vector{x3, y2};
-    auto const p12 = transform * vector{x0, y3};
-    auto const p13 = transform * vector{x1, y3};
-    auto const p14 = transform * vector{x2, y3};
-    auto const p15 = transform * vector{x3, y3};
+    auto const uv = texture_mapping{ctx, patch.texture_size};
+
+    auto const tx0 = uv.u(patch.bounds.x0);
+    auto const tx3 = uv.u(patch.bounds.x1);
+    auto const tx1 = uv.u(patch.bounds.x0 + patch.slice.left);
+    auto const tx2 = uv.u(patch.bounds.x1 - patch.slice.right);
+
+    auto const ty0 = uv.v(patch.bounds.y0);
+    auto const ty3 = uv.v(patch.bounds.y1);
+    auto const ty1 = uv.v(patch.bounds.y0 + patch.slice.top);
+    auto const ty2 = uv.v(patch.bounds.y1 - patch.slice.bottom);
 
     c = to_associated_alpha(c);
 
-    ctx.draw_triangle_list(
-        {{p00.x + origin_x, p00.y + origin_y, depth, rhw, tx0, ty0, c},
-         {p01.x + origin_x, p01.y + origin_y, depth, rhw, tx1, ty0, c},
-         {p02.x + origin_x, p02.y + origin_y, depth, rhw, tx2, ty0, c},
-         {p03.x + origin_x, p03.y + origin_y, depth, rhw, tx3, ty0, c},
-         {p04.x + origin_x, p04.y + origin_y, depth, rhw, tx0, ty1, c},
-         {p05.x + origin_x, p05.y + origin_y, depth, rhw, tx1, ty1, c},
-         {p06.x + origin_x, p06.y + origin_y, depth, rhw, tx2, ty1, c},
-         {p07.x + origin_x, p07.y + origin_y, depth, rhw, tx3, ty1, c},
-         {p08.x + origin_x, p08.y + origin_y, depth, rhw, tx0, ty2, c},
-         {p09.x + origin_x, p09.y + origin_y, depth, rhw, tx1, ty2, c},
-         {p10.x + origin_x, p10.y + origin_y, depth, rhw, tx2, ty2, c},
-         {p11.x + origin_x, p11.y + origin_y, depth, rhw, tx3, ty2, c},
-         {p12.x + origin_x, p12.y + origin_y, depth, rhw, tx0, ty3, c},
-         {p13.x + origin_x, p13.y + origin_y, depth, rhw, tx1, ty3, c},
-         {p14.x + origin_x, p14.y + origin_y, depth, rhw, tx2, ty3, c},
-         {p15.x + origin_x, p15.y + origin_y, depth, rhw, tx3, ty3, c}},
-        {0, 1, 4,  4,  1, 5,  1, 2,  5,  5,  2,  6,  2,  3,  6,  6,  3,  7,
-         4, 5, 8,  8,  5, 9,  5, 6,  9,  9,  6,  10, 6,  7,  10, 10, 7,  11,
-         8, 9, 12, 12, 9, 13, 9, 10, 13, 13, 10, 14, 10, 11, 14, 14, 11, 15},
-        determinant(transform) < 0);
+    draw_grid<4, 4>(
+        ctx, transform, origin_x, origin_y, {x0, x1, x2, x3}, {y0, y1, y2, y3},
+        {tx0, tx1, tx2, tx3}, {ty0, ty1, ty2, ty3}, c);
 }
 
 void rectangle(
     context& ctx, ui::rectangle const& bounds, h_patch const& patch,
     color c) noexcept
 {
-    auto const origin       = ctx.origin();
-    auto const zoom         = ctx.zoom_factor();
-    auto const scale        = ctx.scale_factor();
-    auto const [depth, rhw] = ctx.depth();
+    primitive_scope const scope{
+        ctx, primitive_inputs{primitive_kind::h_patch, bounds, patch, c}};
+    if (scope.replayed())
+    {
+        return;
+    }
+
+    auto const origin = ctx.origin();
+    auto const zoom   = ctx.zoom_factor();
+    auto const scale  = ctx.scale_factor();
 
     auto transform = ctx.current_transform();
 
@@ -444,46 +502,37 @@ void rectangle(
     y0 -= y_ratio * overdraw_t;
     y1 += y_ratio * overdraw_b;
 
-    auto const tx0 = patch.bounds.x0 / patch.texture_size.width;
-    auto const tx3 = patch.bounds.x1 / patch.texture_size.width;
-    auto const tx1 = tx0 + patch.slice.left / patch.texture_size.width;
-    auto const tx2 = tx3 - patch.slice.right / patch.texture_size.width;
+    auto const uv = texture_mapping{ctx, patch.texture_size};
 
-    auto const ty0 = patch.bounds.y0 / patch.texture_size.height;
-    auto const ty1 = patch.bounds.y1 / patch.texture_size.height;
+    auto const tx0 = uv.u(patch.bounds.x0);
+    auto const tx3 = uv.u(patch.bounds.x1);
+    auto const tx1 = uv.u(patch.bounds.x0 + patch.slice.left);
+    auto const tx2 = uv.u(patch.bounds.x1 - patch.slice.right);
 
-    auto const p0 = transform * vector{x0, y0};
-    auto const p1 = transform * vector{x1, y0};
-    auto const p2 = transform * vector{x2, y0};
-    auto const p3 = transform * vector{x3, y0};
-    auto const p4 = transform * vector{x0, y1};
-    auto const p5 = transform * vector{x1, y1};
-    auto const p6 = transform * vector{x2, y1};
-    auto const p7 = transform * vector{x3, y1};
+    auto const ty0 = uv.v(patch.bounds.y0);
+    auto const ty1 = uv.v(patch.bounds.y1);
 
     c = to_associated_alpha(c);
 
-    ctx.draw_triangle_list(
-        {{p0.x + origin_x, p0.y + origin_y, depth, rhw, tx0, ty0, c},
-         {p1.x + origin_x, p1.y + origin_y, depth, rhw, tx1, ty0, c},
-         {p2.x + origin_x, p2.y + origin_y, depth, rhw, tx2, ty0, c},
-         {p3.x + origin_x, p3.y + origin_y, depth, rhw, tx3, ty0, c},
-         {p4.x + origin_x, p4.y + origin_y, depth, rhw, tx0, ty1, c},
-         {p5.x + origin_x, p5.y + origin_y, depth, rhw, tx1, ty1, c},
-         {p6.x + origin_x, p6.y + origin_y, depth, rhw, tx2, ty1, c},
-         {p7.x + origin_x, p7.y + origin_y, depth, rhw, tx3, ty1, c}},
-        {0, 1, 4, 4, 1, 5, 1, 2, 5, 5, 2, 6, 2, 3, 6, 6, 3, 7},
-        determinant(transform) < 0);
+    draw_grid<4, 2>(
+        ctx, transform, origin_x, origin_y, {x0, x1, x2, x3}, {y0, y1},
+        {tx0, tx1, tx2, tx3}, {ty0, ty1}, c);
 }
 
 void rectangle(
     context& ctx, ui::rectangle const& bounds, v_patch const& patch,
     color c) noexcept
 {
-    auto const origin       = ctx.origin();
-    auto const zoom         = ctx.zoom_factor();
-    auto const scale        = ctx.scale_factor();
-    auto const [depth, rhw] = ctx.depth();
+    primitive_scope const scope{
+        ctx, primitive_inputs{primitive_kind::v_patch, bounds, patch, c}};
+    if (scope.replayed())
+    {
+        return;
+    }
+
+    auto const origin = ctx.origin();
+    auto const zoom   = ctx.zoom_factor();
+    auto const scale  = ctx.scale_factor();
 
     auto transform = ctx.current_transform();
 
@@ -554,36 +603,21 @@ void rectangle(
         y3 += scale_y * overdraw_b;
     }
 
-    auto const tx0 = patch.bounds.x0 / patch.texture_size.width;
-    auto const tx1 = patch.bounds.x1 / patch.texture_size.width;
+    auto const uv = texture_mapping{ctx, patch.texture_size};
 
-    auto const ty0 = patch.bounds.y0 / patch.texture_size.height;
-    auto const ty3 = patch.bounds.y1 / patch.texture_size.height;
-    auto const ty1 = ty0 + patch.slice.top / patch.texture_size.height;
-    auto const ty2 = ty3 - patch.slice.bottom / patch.texture_size.height;
+    auto const tx0 = uv.u(patch.bounds.x0);
+    auto const tx1 = uv.u(patch.bounds.x1);
 
-    auto const p0 = transform * vector{x0, y0};
-    auto const p1 = transform * vector{x1, y0};
-    auto const p2 = transform * vector{x0, y1};
-    auto const p3 = transform * vector{x1, y1};
-    auto const p4 = transform * vector{x0, y2};
-    auto const p5 = transform * vector{x1, y2};
-    auto const p6 = transform * vector{x0, y3};
-    auto const p7 = transform * vector{x1, y3};
+    auto const ty0 = uv.v(patch.bounds.y0);
+    auto const ty3 = uv.v(patch.bounds.y1);
+    auto const ty1 = uv.v(patch.bounds.y0 + patch.slice.top);
+    auto const ty2 = uv.v(patch.bounds.y1 - patch.slice.bottom);
 
     c = to_associated_alpha(c);
 
-    ctx.draw_triangle_list(
-        {{p0.x + origin_x, p0.y + origin_y, depth, rhw, tx0, ty0, c},
-         {p1.x + origin_x, p1.y + origin_y, depth, rhw, tx1, ty0, c},
-         {p2.x + origin_x, p2.y + origin_y, depth, rhw, tx0, ty1, c},
-         {p3.x + origin_x, p3.y + origin_y, depth, rhw, tx1, ty1, c},
-         {p4.x + origin_x, p4.y + origin_y, depth, rhw, tx0, ty2, c},
-         {p5.x + origin_x, p5.y + origin_y, depth, rhw, tx1, ty2, c},
-         {p6.x + origin_x, p6.y + origin_y, depth, rhw, tx0, ty3, c},
-         {p7.x + origin_x, p7.y + origin_y, depth, rhw, tx1, ty3, c}},
-        {0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5, 4, 5, 6, 6, 5, 7},
-        determinant(transform) < 0);
+    draw_grid<2, 4>(
+        ctx, transform, origin_x, origin_y, {x0, x1}, {y0, y1, y2, y3},
+        {tx0, tx1}, {ty0, ty1, ty2, ty3}, c);
 }
 
 // void poly_line(
@@ -623,6 +657,15 @@ void text(
     text_rasterization_options const& rasterization_options,
     text_layout_options const& layout_options) noexcept
 {
+    primitive_scope const scope{
+        ctx, primitive_inputs{
+                 primitive_kind::text, bounds, text, rasterization_options,
+                 layout_options}};
+    if (scope.replayed())
+    {
+        return;
+    }
+
     primitive::text(
         ctx, bounds.position(),
         layout_text(ctx, bounds.size(), text, layout_options),
@@ -633,6 +676,15 @@ void text(
     context& ctx, vector const& position, text_layout const& layout,
     text_rasterization_options const& rasterization_options) noexcept
 {
+    primitive_scope const scope{
+        ctx, primitive_inputs{
+                 primitive_kind::text_layout, position, layout,
+                 rasterization_options}};
+    if (scope.replayed())
+    {
+        return;
+    }
+
     auto const scale = ctx.scale_factor();
 
     auto& rasterizer = ctx.text_rasterizer();
@@ -0,0 +1,102 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef WINDOWER_UI_RENDER_DEVICE_HPP
+#define WINDOWER_UI_RENDER_DEVICE_HPP
+
+#include <cstdint>
+
+namespace windower::ui
+{
+
+// Device resources are passed around as opaque handles. The Direct3D device
+// keeps interface pointers in them; other devices can use any value as a
+// key. Zero stands for no resource.
+enum class texture_handle : std::uintptr_t
+{
+    none,
+};
+
+enum class vertex_buffer_handle : std::uintptr_t
+{
+    none,
+};
+
+enum class index_buffer_handle : std::uintptr_t
+{
+    none,
+};
+
+// The values match D3DPRIMITIVETYPE, which frame captures store.
+enum class primitive_type : std::uint32_t
+{
+    line_strip    = 3,
+    triangle_list = 4,
+};
+
+class render_viewport
+{
+public:
+    std::uint32_t x      = 0;
+    std::uint32_t y      = 0;
+    std::uint32_t width  = 0;
+    std::uint32_t height = 0;
+    float min_z          = 0.f;
+    float max_z          = 1.f;
+};
+
+class texture_extent
+{
+public:
+    std::uint32_t width  = 0;
+    std::uint32_t height = 0;
+};
+
+// The device operations that replaying a command buffer needs. Resources
+// are passed as the handles the commands recorded, so a device that isn't
+// backed by Direct3D can treat them as opaque keys.
+class render_device
+{
+public:
+    virtual ~render_device() = default;
+
+    // The size of a texture's top level, or zero if it's unknown.
+    virtual texture_extent extent(texture_handle texture) const noexcept = 0;
+
+    virtual void set_texture(texture_handle texture) noexcept = 0;
+    virtual void set_texture_wrap(bool wrap) noexcept = 0;
+    virtual void set_vertex_buffer(vertex_buffer_handle buffer) noexcept = 0;
+    virtual void set_index_buffer(index_buffer_handle buffer) noexcept = 0;
+    virtual void set_clip(render_viewport const& viewport) noexcept = 0;
+    virtual void draw_indexed(
+        primitive_type type, std::uint32_t min_index,
+        std::uint32_t vertex_count, std::uint32_t first_index,
+        std::uint32_t primitive_count) noexcept = 0;
+    virtual void begin_mask() noexcept = 0;
+    virtual void apply_mask() noexcept = 0;
+    virtual void end_mask() noexcept = 0;
+};
+
+}
+
+#endif
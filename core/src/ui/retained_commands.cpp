@@ -0,0 +1,286 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/retained_commands.hpp"
+
+#include "ui/dimension.hpp"
+#include "ui/patch.hpp"
+#include "ui/rectangle.hpp"
+#include "ui/text_layout_engine.hpp"
+#include "ui/text_layout_options.hpp"
+#include "ui/text_rasterization_options.hpp"
+#include "ui/texture_token.hpp"
+#include "ui/thickness.hpp"
+#include "ui/transform.hpp"
+#include "ui/vector.hpp"
+#include "ui/vertex.hpp"
+
+#include <d3d8.h>
+#include <dwrite.h>
+#include <winrt/base.h>
+
+#include <gsl/gsl>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace windower::ui
+{
+
+std::uint64_t primitive_inputs::key() const noexcept { return m_key; }
+
+::IUnknown* primitive_inputs::reference() const noexcept
+{
+    return m_reference;
+}
+
+primitive_inputs&
+primitive_inputs::add(std::span<std::byte const> bytes) noexcept
+{
+    for (auto const byte : bytes)
+    {
+        m_key ^= std::to_integer<std::uint64_t>(byte);
+        m_key *= 0x100000001B3;
+    }
+    return *this;
+}
+
+primitive_inputs& primitive_inputs::add(std::u8string_view text) noexcept
+{
+    add(text.size());
+    return add(std::as_bytes(std::span{text}));
+}
+
+primitive_inputs& primitive_inputs::add(std::u8string const& text) noexcept
+{
+    return add(std::u8string_view{text});
+}
+
+primitive_inputs& primitive_inputs::add(text_layout const& layout) noexcept
+{
+    // The layout engine never modifies a layout once it is handed out, so
+    // its identity stands in for the text and options it was created from.
+    m_reference = layout.m_ptr;
+    add(layout.m_ptr);
+    add(layout.m_size);
+    return add(layout.m_offset);
+}
+
+primitive_inputs&
+primitive_inputs::add(text_layout_options const& options) noexcept
+{
+    add(options.alignment);
+    add(options.vertical_alignment);
+    add(options.word_wrapping);
+    add(options.trimming_string);
+    add(options.trimming_delimiter);
+    add(options.trimming_delimiter_count);
+    add(options.trimming_granularity);
+    add(options.padding);
+    return add(options.underline);
+}
+
+primitive_inputs&
+primitive_inputs::add(text_rasterization_options const& options) noexcept
+{
+    add(options.fill_color);
+    add(options.stroke_color);
+    add(options.stroke_width);
+    return add(options.flags);
+}
+
+primitive_inputs& primitive_inputs::add(vector const& value) noexcept
+{
+    add(value.x);
+    return add(value.y);
+}
+
+primitive_inputs& primitive_inputs::add(dimension const& value) noexcept
+{
+    add(value.width);
+    return add(value.height);
+}
+
+primitive_inputs& primitive_inputs::add(rectangle const& value) noexcept
+{
+    add(value.x0);
+    add(value.y0);
+    add(value.x1);
+    return add(value.y1);
+}
+
+primitive_inputs& primitive_inputs::add(thickness const& value) noexcept
+{
+    add(value.left);
+    add(value.top);
+    add(value.right);
+    return add(value.bottom);
+}
+
+primitive_inputs& primitive_inputs::add(h_thickness const& value) noexcept
+{
+    add(value.left);
+    return add(value.right);
+}
+
+primitive_inputs& primitive_inputs::add(v_thickness const& value) noexcept
+{
+    add(value.top);
+    return add(value.bottom);
+}
+
+primitive_inputs& primitive_inputs::add(transform const& value) noexcept
+{
+    for (auto const& row : value)
+    {
+        for (auto const element : row)
+        {
+            add(element);
+        }
+    }
+    return *this;
+}
+
+primitive_inputs& primitive_inputs::add(patch const& value) noexcept
+{
+    add(value.texture_size);
+    add(value.bounds);
+    return add(value.overdraw);
+}
+
+primitive_inputs& primitive_inputs::add(nine_patch const& value) noexcept
+{
+    add(value.texture_size);
+    add(value.bounds);
+    add(value.slice);
+    return add(value.overdraw);
+}
+
+primitive_inputs& primitive_inputs::add(h_patch const& value) noexcept
+{
+    add(value.texture_size);
+    add(value.bounds);
+    add(value.slice);
+    return add(value.overdraw);
+}
+
+primitive_inputs& primitive_inputs::add(v_patch const& value) noexcept
+{
+    add(value.texture_size);
+    add(value.bounds);
+    add(value.slice);
+    return add(value.overdraw);
+}
+
+std::size_t retained_commands::size() const noexcept { return m_calls.size(); }
+
+bool retained_commands::matches(
+    std::size_t call, std::uint64_t key) const noexcept
+{
+    return call < m_calls.size() && gsl::at(m_calls, call).key == key;
+}
+
+std::span<retained_commands::op const>
+retained_commands::ops(std::size_t call) const noexcept
+{
+    auto const& entry = gsl::at(m_calls, call);
+    return std::span{m_ops}.subspan(entry.first_op, entry.op_count);
+}
+
+std::span<vertex const>
+retained_commands::vertices(op const& op) const noexcept
+{
+    return std::span{m_vertices}.subspan(op.first_vertex, op.vertex_count);
+}
+
+std::span<std::uint16_t const>
+retained_commands::indices(op const& op) const noexcept
+{
+    return std::span{m_indices}.subspan(op.first_index, op.index_count);
+}
+
+void retained_commands::begin_call(
+    std::uint64_t key, ::IUnknown* reference) noexcept
+{
+    m_calls.push_back(
+        {.key      = key,
+         .first_op = gsl::narrow_cast<std::uint32_t>(m_ops.size()),
+         .op_count = 0});
+    retain(reference);
+}
+
+void retained_commands::set_texture(texture_token texture) noexcept
+{
+    Expects(!m_calls.empty());
+
+    m_ops.push_back({.texture = texture, .sets_texture = true});
+    ++m_calls.back().op_count;
+    retain(texture.m_value);
+}
+
+void retained_commands::draw(
+    std::span<vertex const> vertices, std::span<std::uint16_t const> indices,
+    bool reflected) noexcept
+{
+    Expects(!m_calls.empty());
+
+    m_ops.push_back(
+        {.first_vertex = gsl::narrow_cast<std::uint32_t>(m_vertices.size()),
+         .vertex_count = gsl::narrow_cast<std::uint32_t>(vertices.size()),
+         .first_index  = gsl::narrow_cast<std::uint32_t>(m_indices.size()),
+         .index_count  = gsl::narrow_cast<std::uint32_t>(indices.size())});
+    ++m_calls.back().op_count;
+
+    m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+    if (reflected)
+    {
+        m_indices.insert(m_indices.end(), indices.rbegin(), indices.rend());
+    }
+    else
+    {
+        m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+    }
+}
+
+void retained_commands::clear() noexcept
+{
+    m_calls.clear();
+    m_ops.clear();
+    m_vertices.clear();
+    m_indices.clear();
+    m_references.clear();
+}
+
+void retained_commands::retain(::IUnknown* object) noexcept
+{
+    if (object)
+    {
+        m_references.emplace_back().copy_from(object);
+    }
+}
+
+}
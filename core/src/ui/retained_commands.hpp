@@ -0,0 +1,164 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_RETAINED_COMMANDS_HPP
+#define WINDOWER_UI_RETAINED_COMMANDS_HPP
+
+#include "ui/texture_token.hpp"
+#include "ui/vertex.hpp"
+
+#include <d3d8.h>
+#include <winrt/base.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace windower::ui
+{
+
+class dimension;
+class h_patch;
+class h_thickness;
+class nine_patch;
+class patch;
+class rectangle;
+class text_layout;
+class text_layout_options;
+class text_rasterization_options;
+class thickness;
+class transform;
+class v_patch;
+class v_thickness;
+struct vector;
+
+// Identifies the output of a primitive call. The key hashes everything the
+// generated geometry depends on; the reference is a COM object whose
+// identity went into the key and that must outlive the retained output.
+class primitive_inputs
+{
+public:
+    template<typename... T>
+    explicit primitive_inputs(T const&... values) noexcept
+    {
+        (add(values), ...);
+    }
+
+    std::uint64_t key() const noexcept;
+    ::IUnknown* reference() const noexcept;
+
+    template<typename T>
+    requires std::is_trivially_copyable_v<T>
+        primitive_inputs& add(T const& value) noexcept
+    {
+        // Padding bytes are indeterminate, so only types whose every byte is
+        // part of the value can be hashed as a whole. Classes holding floats
+        // have overloads below that hash their members one by one.
+        static_assert(
+            std::has_unique_object_representations_v<T> ||
+            std::is_floating_point_v<T>);
+        return add(std::as_bytes(std::span{&value, 1}));
+    }
+
+    primitive_inputs& add(std::span<std::byte const> bytes) noexcept;
+    primitive_inputs& add(std::u8string_view text) noexcept;
+    primitive_inputs& add(std::u8string const& text) noexcept;
+    primitive_inputs& add(text_layout const& layout) noexcept;
+    primitive_inputs& add(text_layout_options const& options) noexcept;
+    primitive_inputs&
+    add(text_rasterization_options const& options) noexcept;
+    primitive_inputs& add(vector const& value) noexcept;
+    primitive_inputs& add(dimension const& value) noexcept;
+    primitive_inputs& add(rectangle const& value) noexcept;
+    primitive_inputs& add(thickness const& value) noexcept;
+    primitive_inputs& add(h_thickness const& value) noexcept;
+    primitive_inputs& add(v_thickness const& value) noexcept;
+    primitive_inputs& add(transform const& value) noexcept;
+    primitive_inputs& add(patch const& value) noexcept;
+    primitive_inputs& add(nine_patch const& value) noexcept;
+    primitive_inputs& add(h_patch const& value) noexcept;
+    primitive_inputs& add(v_patch const& value) noexcept;
+
+private:
+    std::uint64_t m_key      = 0xCBF29CE484222325;
+    ::IUnknown* m_reference = nullptr;
+};
+
+// The primitive calls a window made in one frame, along with the texture
+// changes and geometry each call produced, so that calls with unchanged
+// inputs can replay their output in the next frame.
+class retained_commands
+{
+public:
+    class op
+    {
+    public:
+        texture_token texture;
+        bool sets_texture          = false;
+        std::uint32_t first_vertex = 0;
+        std::uint32_t vertex_count = 0;
+        std::uint32_t first_index  = 0;
+        std::uint32_t index_count  = 0;
+    };
+
+    std::size_t size() const noexcept;
+    bool matches(std::size_t call, std::uint64_t key) const noexcept;
+
+    std::span<op const> ops(std::size_t call) const noexcept;
+    std::span<vertex const> vertices(op const& op) const noexcept;
+    std::span<std::uint16_t const> indices(op const& op) const noexcept;
+
+    void begin_call(std::uint64_t key, ::IUnknown* reference) noexcept;
+    void set_texture(texture_token texture) noexcept;
+    void draw(
+        std::span<vertex const> vertices,
+        std::span<std::uint16_t const> indices, bool reflected) noexcept;
+
+    void clear() noexcept;
+
+private:
+    class call
+    {
+    public:
+        std::uint64_t key;
+        std::uint32_t first_op;
+        std::uint32_t op_count;
+    };
+
+    std::vector<call> m_calls;
+    std::vector<op> m_ops;
+    std::vector<vertex> m_vertices;
+    std::vector<std::uint16_t> m_indices;
+    std::vector<winrt::com_ptr<::IUnknown>> m_references;
+
+    void retain(::IUnknown* object) noexcept;
+};
+
+}
+
+#endif
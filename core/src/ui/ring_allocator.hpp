@@ -0,0 +1,155 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_UI_RING_ALLOCATOR_HPP
+#define WINDOWER_UI_RING_ALLOCATOR_HPP
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace windower::ui
+{
+
+class ring_statistics
+{
+public:
+    std::size_t used   = 0;
+    std::size_t wraps  = 0;
+    std::size_t stalls = 0;
+    std::size_t rings  = 0;
+};
+
+// Hands out space from a pool of fixed-size rings. Allocations append to
+// the current ring across frames, so writers can lock without discarding.
+// A ring that fills up wraps back to the start, but data written in the
+// current frame must survive until the frame is rendered; a wrap that would
+// overwrite it is a stall, and the next ring in the pool takes over.
+//
+// The rings themselves are opaque to the allocator, which keeps the
+// bookkeeping independent of the device.
+template<typename Ring>
+class ring_allocator
+{
+public:
+    class allocation
+    {
+    public:
+        Ring* ring;
+        std::size_t offset;
+        std::size_t count;
+        bool discard;
+    };
+
+    explicit ring_allocator(std::size_t capacity) noexcept :
+        m_capacity{capacity}
+    {}
+
+    std::size_t capacity() const noexcept { return m_capacity; }
+
+    ring_statistics const& statistics() const noexcept { return m_statistics; }
+
+    // Starts a new frame. The current ring moves to the front so that the
+    // rings used within a frame are always the first current + 1; the pool
+    // keeps as many rings as the busiest frame needed.
+    void begin_frame() noexcept
+    {
+        std::rotate(
+            m_rings.begin(), m_rings.begin() + m_current, m_rings.end());
+        m_current     = 0;
+        m_frame_start = m_position;
+        m_statistics  = {.rings = m_rings.size()};
+    }
+
+    // Releases every ring; the next allocation starts a new pool with the
+    // given capacity.
+    void reset(std::size_t capacity) noexcept
+    {
+        m_rings.clear();
+        m_capacity    = capacity;
+        m_current     = 0;
+        m_position    = 0;
+        m_frame_start = 0;
+    }
+
+    // Reserves the rest of a ring with room for at least min_count elements.
+    // Nothing is consumed until commit is called with the number of
+    // elements actually written.
+    template<typename F>
+    allocation reserve(std::size_t min_count, F&& make_ring) noexcept
+    {
+        Expects(min_count <= m_capacity);
+
+        auto discard = false;
+        if (m_rings.empty())
+        {
+            m_rings.push_back(std::forward<F>(make_ring)(m_capacity));
+            m_position = 0;
+            discard    = true;
+        }
+        else if (m_capacity - m_position < min_count)
+        {
+            ++m_statistics.wraps;
+            if (m_position != m_frame_start)
+            {
+                ++m_statistics.stalls;
+                if (++m_current == m_rings.size())
+                {
+                    m_rings.push_back(std::forward<F>(make_ring)(m_capacity));
+                }
+            }
+            m_position    = 0;
+            m_frame_start = 0;
+            discard       = true;
+        }
+        m_statistics.rings = std::max(m_statistics.rings, m_rings.size());
+
+        return {
+            &gsl::at(m_rings, m_current), m_position, m_capacity - m_position,
+            discard};
+    }
+
+    void commit(std::size_t count) noexcept
+    {
+        Expects(count <= m_capacity - m_position);
+
+        m_position += count;
+        m_statistics.used += count;
+    }
+
+private:
+    std::size_t m_capacity;
+    std::vector<Ring> m_rings;
+    std::size_t m_current     = 0;
+    std::size_t m_position    = 0;
+    std::size_t m_frame_start = 0;
+    ring_statistics m_statistics;
+};
+
+}
+
+#endif
@@ -98,6 +98,7 @@ private:
     rectangle m_draw_bounds;
     vector m_offset;
 
+    friend class primitive_inputs;
     friend class text_layout_engine;
     friend class text_rasterizer;
 };
@@ -24,8 +24,10 @@
 
 #include "ui/texture_cache.hpp"
 
+#include "ui/atlas_packer.hpp"
 #include "ui/context.hpp"
 #include "ui/texture.hpp"
+#include "ui/texture_token.hpp"
 
 #include <d3d8.h>
 #include <wincodec.h>
@@ -34,12 +36,109 @@
 #include <gsl/gsl>
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
 #include <span>
 #include <utility>
+#include <vector>
 
 namespace windower::ui
 {
 
+namespace
+{
+
+// Each image in an atlas page is surrounded by a copy of its edge pixels so
+// that filtering at the image's edge doesn't pick up its neighbours.
+constexpr auto atlas_gutter     = 1;
+constexpr auto atlas_pixel_size = std::size_t{4};
+
+atlas_region padded_region(rectangle const& region) noexcept
+{
+    constexpr auto page_size = float{texture_cache::atlas_page_size};
+
+    auto const x = std::lround(region.x0 * page_size) - atlas_gutter;
+    auto const y = std::lround(region.y0 * page_size) - atlas_gutter;
+    auto const w = std::lround(region.width() * page_size) + 2 * atlas_gutter;
+    auto const h = std::lround(region.height() * page_size) + 2 * atlas_gutter;
+    return {
+        gsl::narrow_cast<std::uint16_t>(x), gsl::narrow_cast<std::uint16_t>(y),
+        gsl::narrow_cast<std::uint16_t>(w), gsl::narrow_cast<std::uint16_t>(h)};
+}
+
+rectangle image_region(atlas_region const& padded) noexcept
+{
+    constexpr auto page_size = float{texture_cache::atlas_page_size};
+
+    return {
+        (padded.x + atlas_gutter) / page_size,
+        (padded.y + atlas_gutter) / page_size,
+        (padded.x + padded.width - atlas_gutter) / page_size,
+        (padded.y + padded.height - atlas_gutter) / page_size};
+}
+
+std::span<std::byte>
+locked_pixels(::D3DLOCKED_RECT const& data, std::size_t height) noexcept
+{
+    auto const pitch = gsl::narrow_cast<std::size_t>(data.Pitch);
+    return {static_cast<std::byte*>(data.pBits), pitch * height};
+}
+
+// Fills the gutter of a padded region from the image inside it. The locked
+// rectangle starts at the region's corner, so the last row is only as long
+// as the region is wide.
+void extrude(::D3DLOCKED_RECT const& data, atlas_region const& padded) noexcept
+{
+    auto const pitch    = gsl::narrow_cast<std::size_t>(data.Pitch);
+    auto const row_size = padded.width * atlas_pixel_size;
+    auto const height   = std::size_t{padded.height};
+    auto const pixels   = std::span{
+        static_cast<std::byte*>(data.pBits), pitch * (height - 1) + row_size};
+
+    for (auto y = std::size_t{1}; y + 1 < height; ++y)
+    {
+        auto const row = pixels.subspan(y * pitch, row_size);
+        std::ranges::copy(
+            row.subspan(atlas_pixel_size, atlas_pixel_size), row.begin());
+        std::ranges::copy(
+            row.subspan(row_size - 2 * atlas_pixel_size, atlas_pixel_size),
+            row.subspan(row_size - atlas_pixel_size).begin());
+    }
+    std::ranges::copy(pixels.subspan(pitch, row_size), pixels.begin());
+    std::ranges::copy(
+        pixels.subspan((height - 2) * pitch, row_size),
+        pixels.subspan((height - 1) * pitch).begin());
+}
+
+void copy_region(
+    ::D3DLOCKED_RECT const& from, atlas_region const& source,
+    ::D3DLOCKED_RECT const& to, atlas_region const& destination) noexcept
+{
+    constexpr auto page_size = std::size_t{texture_cache::atlas_page_size};
+
+    auto const from_pixels = locked_pixels(from, page_size);
+    auto const to_pixels   = locked_pixels(to, page_size);
+    auto const from_pitch  = gsl::narrow_cast<std::size_t>(from.Pitch);
+    auto const to_pitch    = gsl::narrow_cast<std::size_t>(to.Pitch);
+    auto const row_size    = source.width * atlas_pixel_size;
+
+    for (auto y = std::size_t{0}; y < source.height; ++y)
+    {
+        auto const from_offset =
+            (source.y + y) * from_pitch + source.x * atlas_pixel_size;
+        auto const to_offset =
+            (destination.y + y) * to_pitch + destination.x * atlas_pixel_size;
+        std::ranges::copy(
+            from_pixels.subspan(from_offset, row_size),
+            to_pixels.subspan(to_offset, row_size).begin());
+    }
+}
+
+}
+
 texture_cache::descriptor::descriptor(
     texture_type type, std::u8string_view name) noexcept :
     m_type{type},
@@ -224,21 +323,47 @@ void texture_cache::initialize(context& ctx) noexcept
     }
 }
 
-void texture_cache::update() noexcept
+void texture_cache::update(context& ctx) noexcept
 {
+    m_retired_pages.clear();
+
     auto end = std::stable_partition(
         m_entries.begin(), m_entries.end(),
         [](auto const& e) { return e.m_time_to_live > 0; });
     winrt::com_ptr<::IDirect3DTexture8> deleter;
     for (auto it = end; it != m_entries.end(); ++it)
     {
-        deleter.attach(it->m_texture.token.m_value);
+        auto const& token = it->m_texture.token;
+        if (auto const page = find_page(token.m_value))
+        {
+            page->live_area -= padded_region(token.m_region).area();
+        }
+        deleter.attach(token.m_value);
     }
     m_entries.erase(end, m_entries.cend());
     for (auto& entry : m_entries)
     {
         --entry.m_time_to_live;
     }
+
+    // Once more than half of a page has gone to waste, whatever is left
+    // moves to a fresh page. Commands recorded this frame still refer to
+    // the old page, so it stays alive until the next update.
+    for (auto& page : m_pages)
+    {
+        if (page.live_area * 2 < page.packer.used_area())
+        {
+            if (page.live_area == 0)
+            {
+                m_retired_pages.push_back(std::move(page.texture));
+            }
+            else
+            {
+                repack(ctx, page);
+            }
+        }
+    }
+    std::erase_if(m_pages, [](auto const& page) { return !page.texture; });
 }
 
 void texture_cache::clear() noexcept
@@ -249,6 +374,163 @@ void texture_cache::clear() noexcept
         deleter.attach(entry.m_texture.token.m_value);
     }
     m_entries.clear();
+    m_pages.clear();
+    m_retired_pages.clear();
+}
+
+std::optional<texture_cache::atlas_slot>
+texture_cache::reserve(context& ctx, dimension const& size) noexcept
+{
+    auto const width  = std::ceil(size.width);
+    auto const height = std::ceil(size.height);
+    if (width < 1.f || height < 1.f || width > max_atlas_extent ||
+        height > max_atlas_extent)
+    {
+        return std::nullopt;
+    }
+
+    auto const padded_width =
+        gsl::narrow_cast<std::uint16_t>(width + 2 * atlas_gutter);
+    auto const padded_height =
+        gsl::narrow_cast<std::uint16_t>(height + 2 * atlas_gutter);
+
+    auto const place = [&](atlas_page& page) -> std::optional<atlas_slot> {
+        if (auto const region = page.packer.insert(padded_width, padded_height))
+        {
+            return atlas_slot{
+                page.texture.get(), *region,
+                {region->x + atlas_gutter, region->y + atlas_gutter,
+                 region->x + region->width - atlas_gutter,
+                 region->y + region->height - atlas_gutter}};
+        }
+        return std::nullopt;
+    };
+
+    for (auto& page : m_pages)
+    {
+        if (auto slot = place(page))
+        {
+            return slot;
+        }
+    }
+
+    constexpr auto page_size = float{atlas_page_size};
+    if (auto texture = allocate(ctx, {page_size, page_size}, D3DFMT_A8R8G8B8))
+    {
+        auto& page   = m_pages.emplace_back();
+        page.texture = std::move(texture);
+        return place(page);
+    }
+    return std::nullopt;
+}
+
+texture_token texture_cache::commit(atlas_slot const& slot) noexcept
+{
+    auto const& region = slot.region;
+    auto const bounds  = ::RECT{
+        region.x, region.y, region.x + region.width,
+        region.y + region.height};
+    auto data = ::D3DLOCKED_RECT{};
+    if (FAILED(slot.page->LockRect(0, &data, &bounds, 0)))
+    {
+        return no_texture;
+    }
+    extrude(data, region);
+    if (FAILED(slot.page->UnlockRect(0)))
+    {
+        return no_texture;
+    }
+
+    if (auto const page = find_page(slot.page))
+    {
+        page->live_area += region.area();
+    }
+
+    winrt::com_ptr<::IDirect3DTexture8> reference;
+    reference.copy_from(slot.page);
+    return {reference.detach(), image_region(region)};
+}
+
+texture_cache::atlas_page*
+texture_cache::find_page(::IDirect3DTexture8* texture) noexcept
+{
+    auto const it = std::ranges::find_if(m_pages, [&](auto const& page) {
+        return page.texture.get() == texture;
+    });
+    return it != m_pages.end() ? &*it : nullptr;
+}
+
+void texture_cache::repack(context& ctx, atlas_page& page) noexcept
+{
+    std::vector<entry*> live;
+    for (auto& entry : m_entries)
+    {
+        if (entry.m_texture.token.m_value == page.texture.get())
+        {
+            live.push_back(&entry);
+        }
+    }
+
+    // Tallest first, which keeps the skyline flat for the shorter images.
+    std::ranges::sort(live, std::greater{}, [](entry const* e) {
+        auto const region = padded_region(e->m_texture.token.m_region);
+        return std::pair{region.height, region.width};
+    });
+
+    auto packer = atlas_packer{atlas_page_size, atlas_page_size};
+    std::vector<atlas_region> destinations;
+    destinations.reserve(live.size());
+    for (auto const* entry : live)
+    {
+        auto const source = padded_region(entry->m_texture.token.m_region);
+        if (auto const region = packer.insert(source.width, source.height))
+        {
+            destinations.push_back(*region);
+        }
+        else
+        {
+            return;
+        }
+    }
+
+    constexpr auto page_size = float{atlas_page_size};
+    auto texture = allocate(ctx, {page_size, page_size}, D3DFMT_A8R8G8B8);
+    auto from    = ::D3DLOCKED_RECT{};
+    auto to      = ::D3DLOCKED_RECT{};
+    if (!texture ||
+        FAILED(page.texture->LockRect(0, &from, nullptr, D3DLOCK_READONLY)))
+    {
+        return;
+    }
+    if (FAILED(texture->LockRect(0, &to, nullptr, 0)))
+    {
+        page.texture->UnlockRect(0);
+        return;
+    }
+    for (auto i = std::size_t{0}; i < live.size(); ++i)
+    {
+        copy_region(
+            from, padded_region(gsl::at(live, i)->m_texture.token.m_region), to,
+            gsl::at(destinations, i));
+    }
+    if (FAILED(page.texture->UnlockRect(0)) || FAILED(texture->UnlockRect(0)))
+    {
+        return;
+    }
+
+    winrt::com_ptr<::IDirect3DTexture8> deleter;
+    for (auto i = std::size_t{0}; i < live.size(); ++i)
+    {
+        auto& token = gsl::at(live, i)->m_texture.token;
+        deleter.attach(token.m_value);
+        auto reference = texture;
+        token          = {
+            reference.detach(), image_region(gsl::at(destinations, i))};
+    }
+
+    m_retired_pages.push_back(std::move(page.texture));
+    page.texture = std::move(texture);
+    page.packer  = packer;
 }
 
 }
@@ -25,8 +25,10 @@
 #ifndef WINDOWER_UI_TEXTURE_CACHE_HPP
 #define WINDOWER_UI_TEXTURE_CACHE_HPP
 
+#include "ui/atlas_packer.hpp"
 #include "ui/bitmap.hpp"
 #include "ui/texture.hpp"
+#include "ui/texture_token.hpp"
 
 #include <d3d8.h>
 #include <wincodec.h>
@@ -38,6 +40,7 @@
 #include <compare>
 #include <concepts>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -53,6 +56,14 @@ enum class texture_type : std::uint32_t
     text,
 };
 
+// Whether a small image may be packed into a shared atlas page. Textures
+// that are drawn with wrapping addressing need a texture of their own.
+enum class texture_placement : std::uint8_t
+{
+    shared,
+    standalone,
+};
+
 template<typename T>
 concept texture_loader = requires(T const& loader)
 {
@@ -87,6 +98,9 @@ public:
         friend class texture_cache;
     };
 
+    static constexpr std::uint16_t atlas_page_size  = 1024;
+    static constexpr std::uint16_t max_atlas_extent = 256;
+
     static winrt::com_ptr<::IDirect3DTexture8>
     allocate(context&, dimension const&, ::D3DFORMAT);
 
@@ -122,11 +136,42 @@ public:
         return it->m_texture;
     }
 
+    // Packs an A8R8G8B8 image of the given pixel size into an atlas page.
+    // The copy function receives the page and the rectangle to fill, and
+    // the returned token (no_texture if the image didn't fit or the copy
+    // failed) holds a reference to the page, like any other loaded texture.
+    template<std::predicate<::IDirect3DTexture8*, ::RECT const&> F>
+    texture_token pack(context& ctx, dimension const& size, F&& copy) noexcept
+    {
+        if (auto const slot = reserve(ctx, size);
+            slot && copy(slot->page, slot->bounds))
+        {
+            return commit(*slot);
+        }
+        return no_texture;
+    }
+
     void initialize(context&) noexcept;
-    void update() noexcept;
+    void update(context&) noexcept;
     void clear() noexcept;
 
 private:
+    class atlas_page
+    {
+    public:
+        winrt::com_ptr<::IDirect3DTexture8> texture;
+        atlas_packer packer{atlas_page_size, atlas_page_size};
+        std::uint32_t live_area = 0;
+    };
+
+    class atlas_slot
+    {
+    public:
+        ::IDirect3DTexture8* page;
+        atlas_region region;
+        ::RECT bounds;
+    };
+
     class entry
     {
     public:
@@ -153,8 +198,15 @@ private:
         friend class texture_cache;
     };
 
+    std::optional<atlas_slot> reserve(context&, dimension const&) noexcept;
+    texture_token commit(atlas_slot const&) noexcept;
+    atlas_page* find_page(::IDirect3DTexture8*) noexcept;
+    void repack(context&, atlas_page&) noexcept;
+
     texture m_error_texture;
     std::vector<entry> m_entries;
+    std::vector<atlas_page> m_pages;
+    std::vector<winrt::com_ptr<::IDirect3DTexture8>> m_retired_pages;
 };
 
 }
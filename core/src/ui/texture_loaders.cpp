@@ -28,6 +28,7 @@
 #include "ui/context.hpp"
 #include "ui/ffxi_image.hpp"
 #include "ui/texture.hpp"
+#include "ui/texture_cache.hpp"
 #include "utility.hpp"
 
 #include <d3d8.h>
@@ -35,6 +36,7 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <string_view>
 #include <utility>
 
@@ -42,9 +44,11 @@ namespace windower::ui
 {
 
 texture const& load_texture(
-    context& ctx, std::u8string_view name, std::size_t time_to_live) noexcept
+    context& ctx, std::u8string_view name, std::size_t time_to_live,
+    texture_placement placement) noexcept
 {
     auto desc = texture_cache::descriptor{texture_type::file, name};
+    desc.set_integer(0, static_cast<std::intptr_t>(placement));
     desc.set_float(0, ctx.scale_factor_uniform());
     return ctx.texture_cache().get(desc, time_to_live, [&]() noexcept {
         auto const bitmap = bitmap::load(ctx, name);
@@ -54,6 +58,19 @@ texture const& load_texture(
                 format != D3DFMT_UNKNOWN)
             {
                 auto const size = converted.raw_size();
+                if (placement == texture_placement::shared &&
+                    format == ::D3DFMT_A8R8G8B8)
+                {
+                    if (auto const token = ctx.texture_cache().pack(
+                            ctx, size,
+                            [&](auto page, auto const& bounds) noexcept {
+                                return converted.copy_to(page, bounds);
+                            });
+                        token != no_texture)
+                    {
+                        return texture{token, converted.patch()};
+                    }
+                }
                 if (auto tex = texture_cache::allocate(ctx, size, format);
                     tex && converted.copy_to(tex.get()))
                 {
@@ -74,6 +91,17 @@ texture const& load_texture(
         if (format != ::D3DFMT_UNKNOWN)
         {
             auto const size = image.raw_size();
+            if (format == ::D3DFMT_A8R8G8B8)
+            {
+                if (auto const token = ctx.texture_cache().pack(
+                        ctx, size, [&](auto page, auto const& bounds) noexcept {
+                            return image.copy_to(page, bounds);
+                        });
+                    token != no_texture)
+                {
+                    return texture{token, image.patch()};
+                }
+            }
             if (auto tex = texture_cache::allocate(ctx, size, format);
                 tex && image.copy_to(tex.get()))
             {
@@ -28,6 +28,7 @@
 #include "ui/context.hpp"
 #include "ui/ffxi_image.hpp"
 #include "ui/texture.hpp"
+#include "ui/texture_cache.hpp"
 
 #include <cstddef>
 #include <string_view>
@@ -36,7 +37,8 @@ namespace windower::ui
 {
 
 texture const& load_texture(
-    context& ctx, std::u8string_view name, std::size_t time_to_live) noexcept;
+    context& ctx, std::u8string_view name, std::size_t time_to_live,
+    texture_placement placement = texture_placement::shared) noexcept;
 
 texture const& load_texture(
     context& ctx, ffxi_image const& image, std::size_t time_to_live) noexcept;
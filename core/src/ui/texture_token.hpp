@@ -26,24 +26,37 @@
 #define WINDOWER_UI_TEXTURE_TOKEN_HPP
 
 #include "ui/patch.hpp"
+#include "ui/rectangle.hpp"
 
 #include <d3d8.h>
 
 namespace windower::ui
 {
 
+// A texture to draw with, and the part of it that holds the image. Images
+// packed into an atlas page share the page's texture; texture coordinates
+// are relative to the image and get mapped into the region when drawn.
 class texture_token
 {
 public:
     constexpr texture_token() = default;
     constexpr texture_token(::IDirect3DTexture8* value) : m_value{value} {}
+    constexpr texture_token(
+        ::IDirect3DTexture8* value, rectangle const& region) :
+        m_value{value},
+        m_region{region}
+    {}
+
+    constexpr rectangle const& region() const noexcept { return m_region; }
 
     constexpr bool operator==(texture_token const& other) const = default;
 
 private:
     ::IDirect3DTexture8* m_value = nullptr;
+    rectangle m_region           = {0.f, 0.f, 1.f, 1.f};
 
     friend class context;
+    friend class retained_commands;
     friend class texture_cache;
 };
 
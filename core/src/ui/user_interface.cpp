@@ -31,7 +31,9 @@
 
 #include <gsl/gsl>
 
+#include <filesystem>
 #include <memory>
+#include <utility>
 
 namespace windower
 {
@@ -65,6 +67,15 @@ void user_interface::activate_previous_window() noexcept
     }
 }
 
+bool user_interface::capture_frame(std::filesystem::path path) noexcept
+{
+    if (m_context)
+    {
+        m_context->capture_frame(std::move(path));
+    }
+    return m_context != nullptr;
+}
+
 std::optional<::LRESULT>
 user_interface::process_message(::MSG const& message) const noexcept
 {
@@ -35,6 +35,7 @@
 
 #include <gsl/gsl>
 
+#include <filesystem>
 #include <memory>
 #include <optional>
 
@@ -57,6 +58,8 @@ public:
     void activate_next_window() noexcept;
     void activate_previous_window() noexcept;
 
+    bool capture_frame(std::filesystem::path path) noexcept;
+
     std::optional<::LRESULT>
     process_message(::MSG const& message) const noexcept;
     void begin_frame() noexcept;
@@ -106,6 +106,10 @@ bool window::valid(std::size_t layer_index) const noexcept
     return gsl::narrow_cast<std::size_t>(m_layer) == layer_index;
 }
 
+void window::invalidate() noexcept { m_invalidated = true; }
+
+bool window::rerecorded() const noexcept { return m_rerecorded; }
+
 bool window::is_descendent_of(window const& ancestor) const noexcept
 {
     auto current_ptr        = this;
@@ -29,6 +29,7 @@
 #include "ui/id.hpp"
 #include "ui/layer.hpp"
 #include "ui/rectangle.hpp"
+#include "ui/retained_commands.hpp"
 #include "ui/static_any.hpp"
 #include "ui/vector.hpp"
 
@@ -79,6 +80,9 @@ public:
 
     bool valid(std::size_t) const noexcept;
 
+    void invalidate() noexcept;
+    bool rerecorded() const noexcept;
+
     bool is_descendent_of(window const& ancestor) const noexcept;
 
     id focused_id() const noexcept;
@@ -145,6 +149,11 @@ private:
     ui::command_buffer m_commands;
     ui::layer m_layer = ui::layer::screen;
 
+    retained_commands m_retained;
+    retained_commands m_recording;
+    bool m_invalidated = false;
+    bool m_rerecorded  = false;
+
     rectangle m_bounds;
     vector m_origin;
     float m_zoom_factor = 1.f;
@@ -106,6 +106,14 @@ window const* window_manager::active_window() const noexcept
     return m_active_window;
 }
 
+void window_manager::invalidate() noexcept
+{
+    for (auto& entry : m_windows)
+    {
+        entry.first.invalidate();
+    }
+}
+
 void window_manager::update(context& ctx) noexcept
 {
     for (std::size_t i = 0; i < m_windows.size(); ++i)
@@ -117,6 +125,7 @@ void window_manager::update(context& ctx) noexcept
             auto const layer_index = to_underlying(entry.first.m_layer);
             std::erase(gsl::at(m_z_order, layer_index), &entry.first);
             entry.first.m_id = 0;
+            entry.first.m_retained.clear();
             m_free_list.push_back(i);
         }
         entry.second = false;
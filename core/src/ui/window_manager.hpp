@@ -56,6 +56,7 @@ public:
     window const* hot_window() const noexcept;
     window const* active_window() const noexcept;
 
+    void invalidate() noexcept;
     void update(context& ctx) noexcept;
     window const* update_hot_window(context& ctx) noexcept;
 
@@ -26,13 +26,27 @@
 
 #include "utility.hpp"
 
-#include <icu.h>
+#if defined(_WIN32)
+#    include <icu.h>
+#else
+#    include <unicode/ucasemap.h>
+#    include <unicode/uchar.h>
+#    include <unicode/ustring.h>
+#    include <unicode/utf16.h>
+#endif
 
 #include <gsl/gsl>
 
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
 #include <span>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 namespace windower
 {
@@ -112,6 +126,14 @@ char32_t decode_single(sjis_char byte) noexcept
 
 char32_t decode_double(sjis_char byte0, sjis_char byte1) noexcept
 {
+    // Each row of the table starts at trail byte 0x1F. Lower trail bytes
+    // would wrap into the next row, or past the end of the table for the last
+    // lead byte.
+    if (byte1 < 0x1F)
+    {
+        return U'\uFFFD';
+    }
+
     byte0 = byte0 < 0xE0 ? byte0 - 0x81
           : byte0 < 0xFA ? byte0 - 0xC1
                          : byte0 - 0xCB;
@@ -120,6 +142,264 @@ char32_t decode_double(sjis_char byte0, sjis_char byte1) noexcept
     return gsl::at(sjis_tables::decode_double_byte, byte0 * 0xE0 + byte1);
 }
 
+// Returns the length of the leading run of ASCII code units.
+std::size_t ascii_prefix(std::u8string_view str) noexcept
+{
+    auto const data = str.data();
+    auto const size = str.size();
+    auto i          = std::size_t{};
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
+    {
+        for (; i + 16 <= size; i += 16)
+        {
+            auto const chunk =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+            if (auto const mask = _mm_movemask_epi8(chunk))
+            {
+                return i + std::countr_zero(static_cast<unsigned>(mask));
+            }
+        }
+        while (i < size && data[i] < 0x80)
+        {
+            ++i;
+        }
+    }
+    return i;
+}
+
+std::size_t ascii_prefix(utf16_string_view str) noexcept
+{
+    auto const data = str.data();
+    auto const size = str.size();
+    auto i          = std::size_t{};
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
+    {
+        auto const high = _mm_set1_epi16(static_cast<short>(0xFF80));
+        auto const zero = _mm_setzero_si128();
+        for (; i + 8 <= size; i += 8)
+        {
+            auto const chunk =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+            auto const ascii =
+                _mm_cmpeq_epi16(_mm_and_si128(chunk, high), zero);
+            if (auto const mask = _mm_movemask_epi8(ascii) ^ 0xFFFF)
+            {
+                return i + std::countr_zero(static_cast<unsigned>(mask)) / 2;
+            }
+        }
+        while (i < size && data[i] < 0x80)
+        {
+            ++i;
+        }
+    }
+    return i;
+}
+
+void widen_ascii(
+    char8_t const* source, std::size_t size, utf16_char* target) noexcept
+{
+    auto i = std::size_t{};
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
+    {
+        auto const zero = _mm_setzero_si128();
+        for (; i + 16 <= size; i += 16)
+        {
+            auto const chunk =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(target + i),
+                _mm_unpacklo_epi8(chunk, zero));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(target + i + 8),
+                _mm_unpackhi_epi8(chunk, zero));
+        }
+        for (; i < size; ++i)
+        {
+            target[i] = source[i];
+        }
+    }
+}
+
+void narrow_ascii(
+    utf16_char const* source, std::size_t size, char8_t* target) noexcept
+{
+    auto i = std::size_t{};
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
+    {
+        for (; i + 16 <= size; i += 16)
+        {
+            auto const low =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i));
+            auto const high = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(source + i + 8));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(target + i),
+                _mm_packus_epi16(low, high));
+        }
+        for (; i < size; ++i)
+        {
+            target[i] = static_cast<char8_t>(source[i]);
+        }
+    }
+}
+
+// Returns the UTF-8 length of the code point at the given offset and
+// advances past it. Unpaired surrogates count as U+FFFD.
+std::size_t utf8_length(utf16_string_view str, std::size_t& offset) noexcept
+{
+    auto const unit = str[offset++];
+    if (unit < 0x80)
+    {
+        return 1;
+    }
+    if (unit < 0x800)
+    {
+        return 2;
+    }
+    if (U16_IS_LEAD(unit) && offset < str.size() && U16_IS_TRAIL(str[offset]))
+    {
+        ++offset;
+        return 4;
+    }
+    return 3;
+}
+
+// Returns the exact length of a UTF-16 string converted to UTF-8. Blocks of
+// eight code units without surrogates are measured in one step.
+std::size_t utf8_length(utf16_string_view str) noexcept
+{
+    auto const data = str.data();
+    auto const size = str.size();
+    auto result     = std::size_t{};
+    auto offset     = std::size_t{};
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
+    {
+        auto const zero           = _mm_setzero_si128();
+        auto const ones           = _mm_set1_epi16(1);
+        auto const one_byte       = _mm_set1_epi16(0x007F);
+        auto const two_bytes      = _mm_set1_epi16(0x07FF);
+        auto const surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+        auto const surrogate      = _mm_set1_epi16(static_cast<short>(0xD800));
+
+        // Every unit counts as three bytes; the comparisons below yield -1
+        // for each byte a unit does not need.
+        auto savings = _mm_setzero_si128();
+        auto blocks  = std::size_t{};
+        while (offset + 8 <= size)
+        {
+            auto const chunk = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(data + offset));
+            auto const surrogates = _mm_cmpeq_epi16(
+                _mm_and_si128(chunk, surrogate_mask), surrogate);
+            if (_mm_movemask_epi8(surrogates) != 0)
+            {
+                auto const end = offset + 8;
+                while (offset < end)
+                {
+                    result += utf8_length(str, offset);
+                }
+                continue;
+            }
+            auto const short_one =
+                _mm_cmpeq_epi16(_mm_subs_epu16(chunk, one_byte), zero);
+            auto const short_two =
+                _mm_cmpeq_epi16(_mm_subs_epu16(chunk, two_bytes), zero);
+            savings = _mm_add_epi32(
+                savings,
+                _mm_madd_epi16(_mm_add_epi16(short_one, short_two), ones));
+            ++blocks;
+            offset += 8;
+        }
+        savings = _mm_add_epi32(savings, _mm_srli_si128(savings, 8));
+        savings = _mm_add_epi32(savings, _mm_srli_si128(savings, 4));
+        result += blocks * 24 -
+                  static_cast<std::size_t>(-_mm_cvtsi128_si32(savings));
+    }
+    while (offset < size)
+    {
+        result += utf8_length(str, offset);
+    }
+    return result;
+}
+
+// Encodes a UTF-16 string as UTF-8 into a buffer of exactly utf8_length
+// bytes, replacing unpaired surrogates with U+FFFD. An ASCII unit narrows the
+// next eight units in one store and keeps their ASCII prefix, so the short
+// runs between accented letters skip the run scan. The store is safe because
+// every remaining unit produces at least one byte.
+void encode_utf8(utf16_string_view str, char8_t* target) noexcept
+{
+    auto const data = str.data();
+    auto const size = str.size();
+    auto offset     = std::size_t{};
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
+    {
+        auto const high = _mm_set1_epi16(static_cast<short>(0xFF80));
+        auto const zero = _mm_setzero_si128();
+        while (offset < size)
+        {
+            char32_t unit = data[offset];
+            if (unit < 0x80)
+            {
+                if (offset + 8 <= size)
+                {
+                    auto const chunk = _mm_loadu_si128(
+                        reinterpret_cast<__m128i const*>(data + offset));
+                    auto const ascii = _mm_movemask_epi8(
+                        _mm_cmpeq_epi16(_mm_and_si128(chunk, high), zero));
+                    _mm_storel_epi64(
+                        reinterpret_cast<__m128i*>(target),
+                        _mm_packus_epi16(chunk, chunk));
+                    auto const run =
+                        std::countr_one(static_cast<unsigned>(ascii)) / 2;
+                    target += run;
+                    offset += run;
+                    if (run < 8)
+                    {
+                        continue;
+                    }
+                }
+                auto const run = ascii_prefix(str.substr(offset));
+                narrow_ascii(data + offset, run, target);
+                target += run;
+                offset += run;
+                continue;
+            }
+            ++offset;
+            if (unit < 0x800)
+            {
+                *target++ = static_cast<char8_t>(0xC0 | unit >> 6);
+                *target++ = static_cast<char8_t>(0x80 | (unit & 0x3F));
+                continue;
+            }
+            if (U16_IS_SURROGATE(unit))
+            {
+                if (U16_IS_SURROGATE_LEAD(unit) && offset < size &&
+                    U16_IS_TRAIL(data[offset]))
+                {
+                    unit = U16_GET_SUPPLEMENTARY(unit, data[offset++]);
+                    *target++ = static_cast<char8_t>(0xF0 | unit >> 18);
+                    *target++ =
+                        static_cast<char8_t>(0x80 | (unit >> 12 & 0x3F));
+                    *target++ = static_cast<char8_t>(0x80 | (unit >> 6 & 0x3F));
+                    *target++ = static_cast<char8_t>(0x80 | (unit & 0x3F));
+                    continue;
+                }
+                unit = U'\uFFFD';
+            }
+            *target++ = static_cast<char8_t>(0xE0 | unit >> 12);
+            *target++ = static_cast<char8_t>(0x80 | (unit >> 6 & 0x3F));
+            *target++ = static_cast<char8_t>(0x80 | (unit & 0x3F));
+        }
+    }
+}
+
 char32_t decode_autotranslate(
     sjis_char byte0, [[maybe_unused]] sjis_char byte1, sjis_char byte2,
     sjis_char byte3) noexcept
@@ -135,69 +415,414 @@ char32_t decode_autotranslate(
                          : U'\U000F0000' | ~id;
 }
 
-}
-
-std::u8string to_u8string(std::wstring_view str) noexcept
+std::u8string fold_case(std::u8string_view str) noexcept
 {
+    thread_local auto const case_map = case_map_ptr{};
+
     auto result     = std::u8string{};
-    auto size       = str.size();
     auto error_code = U_ZERO_ERROR;
-    do
+    result.resize(str.size());
+    auto size = ::ucasemap_utf8FoldCase(
+        case_map.get(), reinterpret_cast<char*>(result.data()), result.size(),
+        reinterpret_cast<char const*>(str.data()), str.size(), &error_code);
+    if (error_code == U_BUFFER_OVERFLOW_ERROR)
     {
+        error_code = U_ZERO_ERROR;
         result.resize(size);
-        auto result_size = std::int32_t{};
-        ::u_strToUTF8WithSub(
-            reinterpret_cast<char*>(result.data()), size, &result_size,
-            reinterpret_cast<::UChar const*>(str.data()), str.size(), U'\uFFFD',
-            nullptr, &error_code);
-        size = result_size;
+        size = ::ucasemap_utf8FoldCase(
+            case_map.get(), reinterpret_cast<char*>(result.data()),
+            result.size(), reinterpret_cast<char const*>(str.data()),
+            str.size(), &error_code);
+    }
+    if (U_FAILURE(error_code))
+    {
+        fail_fast();
     }
-    while (size > result.size());
     result.resize(size);
     return result;
 }
 
-std::u8string to_u8string(sjis_string_view str) noexcept
+// Remembers the most recently folded short strings, such as the key and
+// device names that come up over and over while parsing binds.
+class fold_case_cache
+{
+public:
+    static constexpr std::size_t max_size = 64;
+
+    std::u8string const* find(std::u8string_view key) noexcept
+    {
+        auto const end = m_entries.begin() + m_size;
+        auto const it  = std::find_if(
+            m_entries.begin(), end,
+            [&](auto const& entry) noexcept { return entry.first == key; });
+        if (it == end)
+        {
+            return nullptr;
+        }
+        std::rotate(m_entries.begin(), it, it + 1);
+        return &m_entries.front().second;
+    }
+
+    std::u8string const&
+    insert(std::u8string_view key, std::u8string value) noexcept
+    {
+        if (m_size < m_entries.size())
+        {
+            ++m_size;
+        }
+        std::rotate(
+            m_entries.begin(), m_entries.begin() + m_size - 1,
+            m_entries.begin() + m_size);
+        auto& entry  = m_entries.front();
+        entry.first  = key;
+        entry.second = std::move(value);
+        return entry.second;
+    }
+
+private:
+    std::array<std::pair<std::u8string, std::u8string>, 16> m_entries;
+    std::size_t m_size = 0;
+};
+
+// Returns the length of the leading run of printable ASCII characters, which
+// are encoded identically in UTF-8, UTF-16 and Shift-JIS.
+std::size_t
+printable_prefix(unsigned char const* data, std::size_t size) noexcept
+{
+    auto i = std::size_t{};
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
+    {
+        auto const low  = _mm_set1_epi8(0x1F);
+        auto const high = _mm_set1_epi8(0x7F);
+        for (; i + 16 <= size; i += 16)
+        {
+            auto const chunk =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+            auto const printable = _mm_and_si128(
+                _mm_cmpgt_epi8(chunk, low), _mm_cmplt_epi8(chunk, high));
+            if (auto const mask = _mm_movemask_epi8(printable) ^ 0xFFFF)
+            {
+                return i + std::countr_zero(static_cast<unsigned>(mask));
+            }
+        }
+        while (i < size && data[i] >= 0x20 && data[i] <= 0x7E)
+        {
+            ++i;
+        }
+    }
+    return i;
+}
+
+std::size_t printable_prefix(utf16_char const* data, std::size_t size) noexcept
+{
+    auto i = std::size_t{};
+    GSL_SUPPRESS(type.1)
+    GSL_SUPPRESS(bounds.1)
+    {
+        auto const low  = _mm_set1_epi16(0x1F);
+        auto const high = _mm_set1_epi16(0x7F);
+        for (; i + 8 <= size; i += 8)
+        {
+            auto const chunk =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+            auto const printable = _mm_and_si128(
+                _mm_cmpgt_epi16(chunk, low), _mm_cmplt_epi16(chunk, high));
+            if (auto const mask = _mm_movemask_epi8(printable) ^ 0xFFFF)
+            {
+                return i + std::countr_zero(static_cast<unsigned>(mask)) / 2;
+            }
+        }
+        while (i < size && data[i] >= 0x20 && data[i] <= 0x7E)
+        {
+            ++i;
+        }
+    }
+    return i;
+}
+
+std::size_t printable_prefix(std::u8string_view str) noexcept
+{
+    GSL_SUPPRESS(type.1)
+    {
+        return printable_prefix(
+            reinterpret_cast<unsigned char const*>(str.data()), str.size());
+    }
+}
+
+std::size_t printable_prefix(utf16_string_view str) noexcept
+{
+    return printable_prefix(str.data(), str.size());
+}
+
+std::size_t printable_prefix(sjis_string_view str) noexcept
+{
+    return printable_prefix(str.data(), str.size());
+}
+
+// Splits a string into runs of printable ASCII and individual code points.
+template<typename String, typename Run, typename CodePoint>
+void for_each_segment(String str, Run&& run, CodePoint&& code_point) noexcept
 {
-    auto result = std::u8string{};
     auto offset = std::size_t{};
-    result.reserve(str.size());
     while (offset < str.size())
     {
-        append(result, next_code_point(str, offset));
+        if (auto const size = printable_prefix(str.substr(offset)))
+        {
+            GSL_SUPPRESS(bounds.1) { run(str.data() + offset, size); }
+            offset += size;
+            continue;
+        }
+        code_point(next_code_point(str, offset));
     }
-    return result;
 }
 
-std::wstring to_wstring(std::u8string_view str) noexcept
+// Two-level view of sjis_tables::encode. The BMP is split into 256 blocks of
+// 256 code points and identical blocks are stored once, which shrinks the
+// table to a fraction of its flat size.
+class sjis_encode_table
 {
-    auto result     = std::wstring{};
-    auto size       = str.size();
-    auto error_code = U_ZERO_ERROR;
-    do
+public:
+    sjis_encode_table() noexcept
     {
-        result.resize(size);
-        auto result_size = std::int32_t{};
-        ::u_strFromUTF8WithSub(
-            reinterpret_cast<::UChar*>(result.data()), size, &result_size,
-            reinterpret_cast<char const*>(str.data()), str.size(), U'\uFFFD',
-            nullptr, &error_code);
-        size = result_size;
+        auto const& flat = sjis_tables::encode;
+        auto block       = std::array<std::uint16_t, 256>{};
+        for (auto i = std::size_t{}; i < m_index.size(); ++i)
+        {
+            for (auto j = std::size_t{}; j < block.size(); ++j)
+            {
+                auto const offset = (i << 8 | j) * 2;
+                auto const lead =
+                    gsl::narrow_cast<unsigned char>(gsl::at(flat, offset));
+                auto const trail =
+                    gsl::narrow_cast<unsigned char>(gsl::at(flat, offset + 1));
+                gsl::at(block, j) =
+                    gsl::narrow_cast<std::uint16_t>(lead << 8 | trail);
+            }
+
+            auto found = m_blocks.size();
+            for (auto k = std::size_t{}; k < m_blocks.size(); k += 256)
+            {
+                if (std::equal(block.begin(), block.end(), &m_blocks[k]))
+                {
+                    found = k;
+                    break;
+                }
+            }
+            if (found == m_blocks.size())
+            {
+                m_blocks.insert(m_blocks.end(), block.begin(), block.end());
+            }
+            gsl::at(m_index, i) = gsl::narrow_cast<std::uint8_t>(found >> 8);
+        }
+        m_blocks.shrink_to_fit();
+    }
+
+    // Returns the lead byte (zero for single-byte characters) in the high
+    // byte and the trail byte in the low byte.
+    std::uint16_t operator[](char32_t code_point) const noexcept
+    {
+        GSL_SUPPRESS(bounds.2)
+        GSL_SUPPRESS(bounds.4)
+        {
+            return m_blocks[m_index[code_point >> 8 & 0xFF] << 8 |
+                            (code_point & 0xFF)];
+        }
+    }
+
+private:
+    std::array<std::uint8_t, 256> m_index = {};
+    std::vector<std::uint16_t> m_blocks;
+};
+
+sjis_encode_table const& sjis_encoder() noexcept
+{
+    static auto const table = sjis_encode_table{};
+    return table;
+}
+
+std::size_t sjis_length(
+    char32_t code_point, client_language client_language) noexcept
+{
+    if (code_point <= 0xFFFF)
+    {
+        return sjis_encoder()[code_point] > 0xFF ? 2 : 1;
+    }
+    return to_autotranslate_id(code_point, client_language) ? 6 : 2;
+}
+
+// Writes the Shift-JIS encoding of a code point and returns the number of
+// bytes written, which always matches sjis_length.
+std::size_t encode_sjis(
+    sjis_char* target, char32_t code_point,
+    client_language client_language) noexcept
+{
+    GSL_SUPPRESS(bounds.1)
+    {
+        if (code_point <= 0xFFFF)
+        {
+            auto const bytes = sjis_encoder()[code_point];
+            if (bytes > 0xFF)
+            {
+                target[0] = gsl::narrow_cast<sjis_char>(bytes >> 8);
+                target[1] = gsl::narrow_cast<sjis_char>(bytes & 0xFF);
+                return 2;
+            }
+            target[0] = gsl::narrow_cast<sjis_char>(bytes);
+            return 1;
+        }
+        if (auto const id = to_autotranslate_id(code_point, client_language))
+        {
+            target[0] = 0xFD;
+            target[1] = id >> 0x00 & 0xFF;
+            target[2] = id >> 0x08 & 0xFF;
+            target[3] = id >> 0x10 & 0xFF;
+            target[4] = id >> 0x18 & 0xFF;
+            target[5] = 0xFD;
+            return 6;
+        }
+        target[0] = 0x85;
+        target[1] = 0x41;
+        return 2;
     }
-    while (size > result.size());
-    result.resize(size);
-    return result;
 }
 
-std::wstring to_wstring(sjis_string_view str) noexcept
+// Returns the exact length of a UTF-8 or UTF-16 string converted to
+// Shift-JIS.
+template<typename String>
+std::size_t sjis_length(String str, client_language client_language) noexcept
+{
+    auto size = std::size_t{};
+    for_each_segment(
+        str, [&](auto, std::size_t run) noexcept { size += run; },
+        [&](char32_t code_point) noexcept {
+            size += sjis_length(code_point, client_language);
+        });
+    return size;
+}
+
+// Converts UTF-8 or UTF-16 to Shift-JIS into a buffer of exactly sjis_length
+// bytes.
+template<typename String>
+void encode_sjis(
+    String str, sjis_char* target, client_language client_language) noexcept
+{
+    GSL_SUPPRESS(bounds.1)
+    {
+        for_each_segment(
+            str,
+            [&](auto source, std::size_t run) noexcept {
+                if constexpr (sizeof *source == 1)
+                {
+                    std::memcpy(target, source, run);
+                }
+                else
+                {
+                    narrow_ascii(
+                        source, run, reinterpret_cast<char8_t*>(target));
+                }
+                target += run;
+            },
+            [&](char32_t code_point) noexcept {
+                target += encode_sjis(target, code_point, client_language);
+            });
+    }
+}
+
+std::size_t utf8_length(sjis_string_view str) noexcept
+{
+    auto size = std::size_t{};
+    for_each_segment(
+        str, [&](auto, std::size_t run) noexcept { size += run; },
+        [&](char32_t code_point) noexcept { size += U8_LENGTH(code_point); });
+    return size;
+}
+
+void decode_sjis(sjis_string_view str, char8_t* target) noexcept
 {
-    auto result = std::wstring{};
     auto offset = std::size_t{};
-    result.reserve(str.size());
-    while (offset < str.size())
+    GSL_SUPPRESS(bounds.1)
+    GSL_SUPPRESS(con.4)
+    {
+        for_each_segment(
+            str,
+            [&](sjis_char const* source, std::size_t run) noexcept {
+                std::memcpy(target + offset, source, run);
+                offset += run;
+            },
+            [&](char32_t code_point) noexcept {
+                // Malformed autotranslate sequences can decode past U+10FFFF,
+                // which has no UTF-8 form and was measured as zero bytes.
+                if (U8_LENGTH(code_point) != 0)
+                {
+                    U8_APPEND_UNSAFE(target, offset, code_point);
+                }
+            });
+    }
+}
+
+std::size_t utf16_length(sjis_string_view str) noexcept
+{
+    auto size = std::size_t{};
+    for_each_segment(
+        str, [&](auto, std::size_t run) noexcept { size += run; },
+        [&](char32_t code_point) noexcept { size += U16_LENGTH(code_point); });
+    return size;
+}
+
+void decode_sjis(sjis_string_view str, utf16_char* target) noexcept
+{
+    auto offset = std::size_t{};
+    GSL_SUPPRESS(bounds.1)
+    GSL_SUPPRESS(con.4)
     {
-        append(result, next_code_point(str, offset));
+        for_each_segment(
+            str,
+            [&](sjis_char const* source, std::size_t run) noexcept {
+                widen_ascii(
+                    reinterpret_cast<char8_t const*>(source), run,
+                    target + offset);
+                offset += run;
+            },
+            [&](char32_t code_point) noexcept {
+                U16_APPEND_UNSAFE(target, offset, code_point);
+            });
     }
+}
+
+}
+
+std::u8string to_u8string(utf16_string_view str) noexcept
+{
+    auto result = std::u8string{};
+    result.resize(utf8_length(str));
+    encode_utf8(str, result.data());
+    return result;
+}
+
+std::u8string to_u8string(sjis_string_view str) noexcept
+{
+    auto result = std::u8string{};
+    result.resize(utf8_length(str));
+    decode_sjis(str, result.data());
+    return result;
+}
+
+utf16_string to_wstring(std::u8string_view str) noexcept
+{
+    // Every UTF-16 code unit consumes at least one byte of input, so the
+    // input length is enough room for the result.
+    auto result = utf16_string{};
+    result.resize(str.size());
+    result.resize(to_wstring(str, result));
+    return result;
+}
+
+utf16_string to_wstring(sjis_string_view str) noexcept
+{
+    auto result = utf16_string{};
+    result.resize(utf16_length(str));
+    decode_sjis(str, result.data());
     return result;
 }
 
@@ -205,26 +830,108 @@ sjis_string
 to_sjis_string(std::u8string_view str, client_language client_language) noexcept
 {
     auto result = sjis_string{};
-    auto offset = std::size_t{};
-    result.reserve(str.size());
-    while (offset < str.size())
-    {
-        append(result, next_code_point(str, offset), client_language);
-    }
+    result.resize(sjis_length(str, client_language));
+    encode_sjis(str, result.data(), client_language);
     return result;
 }
 
 sjis_string
-to_sjis_string(std::wstring_view str, client_language client_language) noexcept
+to_sjis_string(utf16_string_view str, client_language client_language) noexcept
 {
     auto result = sjis_string{};
-    auto offset = std::size_t{};
-    result.reserve(str.size());
-    while (offset < str.size())
+    result.resize(sjis_length(str, client_language));
+    encode_sjis(str, result.data(), client_language);
+    return result;
+}
+
+std::size_t
+to_u8string(utf16_string_view str, std::span<char8_t> buffer) noexcept
+{
+    auto const size = utf8_length(str);
+    if (size <= buffer.size())
     {
-        append(result, next_code_point(str, offset), client_language);
+        encode_utf8(str, buffer.data());
     }
-    return result;
+    return size;
+}
+
+std::size_t
+to_u8string(sjis_string_view str, std::span<char8_t> buffer) noexcept
+{
+    auto const size = utf8_length(str);
+    if (size <= buffer.size())
+    {
+        decode_sjis(str, buffer.data());
+    }
+    return size;
+}
+
+std::size_t
+to_wstring(std::u8string_view str, std::span<utf16_char> buffer) noexcept
+{
+    auto const prefix = ascii_prefix(str);
+    auto const rest   = str.substr(prefix);
+    if (prefix > buffer.size())
+    {
+        // Measure only; ICU reports the full length when given no room.
+        auto result_size = std::int32_t{};
+        auto error_code  = U_ZERO_ERROR;
+        ::u_strFromUTF8WithSub(
+            nullptr, 0, &result_size,
+            reinterpret_cast<char const*>(rest.data()), rest.size(),
+            U'\uFFFD', nullptr, &error_code);
+        return prefix + result_size;
+    }
+
+    widen_ascii(str.data(), prefix, buffer.data());
+    if (rest.empty())
+    {
+        return prefix;
+    }
+
+    auto const target = buffer.subspan(prefix);
+    auto result_size  = std::int32_t{};
+    auto error_code   = U_ZERO_ERROR;
+    ::u_strFromUTF8WithSub(
+        reinterpret_cast<::UChar*>(target.data()), target.size(), &result_size,
+        reinterpret_cast<char const*>(rest.data()), rest.size(), U'\uFFFD',
+        nullptr, &error_code);
+    return prefix + result_size;
+}
+
+std::size_t
+to_wstring(sjis_string_view str, std::span<utf16_char> buffer) noexcept
+{
+    auto const size = utf16_length(str);
+    if (size <= buffer.size())
+    {
+        decode_sjis(str, buffer.data());
+    }
+    return size;
+}
+
+std::size_t to_sjis_string(
+    std::u8string_view str, std::span<sjis_char> buffer,
+    client_language client_language) noexcept
+{
+    auto const size = sjis_length(str, client_language);
+    if (size <= buffer.size())
+    {
+        encode_sjis(str, buffer.data(), client_language);
+    }
+    return size;
+}
+
+std::size_t to_sjis_string(
+    utf16_string_view str, std::span<sjis_char> buffer,
+    client_language client_language) noexcept
+{
+    auto const size = sjis_length(str, client_language);
+    if (size <= buffer.size())
+    {
+        encode_sjis(str, buffer.data(), client_language);
+    }
+    return size;
 }
 
 char32_t next_code_point(std::u8string_view str, std::size_t& offset) noexcept
@@ -240,7 +947,7 @@ char32_t next_code_point(std::u8string_view str, std::size_t& offset) noexcept
     return result;
 }
 
-char32_t next_code_point(std::wstring_view str, std::size_t& offset) noexcept
+char32_t next_code_point(utf16_string_view str, std::size_t& offset) noexcept
 {
     auto result = U'\uFFFD';
     GSL_SUPPRESS(bounds.1)
@@ -294,7 +1001,7 @@ void append(std::u8string& str, char32_t code_point) noexcept
     GSL_SUPPRESS(con.4) { U8_APPEND_UNSAFE(str.data(), offset, code_point); }
 }
 
-void append(std::wstring& str, char32_t code_point) noexcept
+void append(utf16_string& str, char32_t code_point) noexcept
 {
     auto offset = str.size();
     str.resize(offset + U16_LENGTH(code_point));
@@ -306,51 +1013,37 @@ void append(
     sjis_string& str, char32_t code_point,
     client_language client_language) noexcept
 {
-    if (code_point <= 0xFFFF)
+    auto buffer     = std::array<sjis_char, 6>{};
+    auto const size = encode_sjis(buffer.data(), code_point, client_language);
+    str.append(buffer.data(), size);
+}
+
+std::u8string nfkc_fold_case(std::u8string_view str) noexcept
+{
+    if (ascii_prefix(str) == str.size())
     {
-        if (auto const byte = gsl::at(sjis_tables::encode, code_point * 2))
+        auto result = std::u8string{str};
+        for (auto& c : result)
         {
-            str.push_back(byte);
+            if (c >= u8'A' && c <= u8'Z')
+            {
+                c += u8'a' - u8'A';
+            }
         }
-        str.push_back(gsl::at(sjis_tables::encode, code_point * 2 + 1));
+        return result;
     }
-    else if (auto const id = to_autotranslate_id(code_point, client_language))
-    {
-        str.push_back(0xFD);
-        str.push_back(id >> 0x00 & 0xFF);
-        str.push_back(id >> 0x08 & 0xFF);
-        str.push_back(id >> 0x10 & 0xFF);
-        str.push_back(id >> 0x18 & 0xFF);
-        str.push_back(0xFD);
-    }
-    else
-    {
-        str.push_back(0x85);
-        str.push_back(0x41);
-    }
-}
 
-std::u8string nfkc_fold_case(std::u8string_view str) noexcept
-{
-    auto const case_map = case_map_ptr{};
-    auto result         = std::u8string{};
-    auto size           = str.size();
-    auto error_code     = U_ZERO_ERROR;
-    do
+    if (str.size() <= fold_case_cache::max_size)
     {
-        result.resize(size);
-        size = ::ucasemap_utf8FoldCase(
-            case_map.get(), reinterpret_cast<char*>(result.data()),
-            result.size(), reinterpret_cast<char const*>(str.data()),
-            str.size(), &error_code);
-        if (U_FAILURE(error_code))
+        thread_local auto cache = fold_case_cache{};
+        if (auto const cached = cache.find(str))
         {
-            fail_fast();
+            return *cached;
         }
+        return cache.insert(str, fold_case(str));
     }
-    while (size > result.size());
-    result.resize(size);
-    return result;
+
+    return fold_case(str);
 }
 
 std::uint32_t to_autotranslate_id(
@@ -10632,6 +11325,7 @@ std::span<char const> const sjis_tables::encode = {
     "\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41"
     "\x81\x91\x81\x92\x81\xCA\x81\x50\x85\x41\x85\x41\x85\x41\x85\x41"
     "\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41"
+    "\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41"
     "\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41\x85\x41"};
 
 }
@@ -27,6 +27,9 @@
 
 #include <gsl/gsl>
 
+#include <cstdint>
+#include <cwchar>
+#include <span>
 #include <string>
 #include <string_view>
 
@@ -44,23 +47,52 @@ using sjis_char = unsigned char;
 using sjis_string      = std::basic_string<sjis_char>;
 using sjis_string_view = std::basic_string_view<sjis_char>;
 
-std::u8string to_u8string(std::wstring_view str) noexcept;
+// UTF-16 strings are wstrings wherever wchar_t is 16 bits wide, so on Windows
+// these are exactly std::wstring and std::wstring_view.
+#if WCHAR_MAX <= 0xFFFF
+using utf16_char = wchar_t;
+#else
+using utf16_char = char16_t;
+#endif
+
+using utf16_string      = std::basic_string<utf16_char>;
+using utf16_string_view = std::basic_string_view<utf16_char>;
+
+std::u8string to_u8string(utf16_string_view str) noexcept;
 std::u8string to_u8string(sjis_string_view str) noexcept;
-std::wstring to_wstring(std::u8string_view str) noexcept;
-std::wstring to_wstring(sjis_string_view str) noexcept;
+utf16_string to_wstring(std::u8string_view str) noexcept;
+utf16_string to_wstring(sjis_string_view str) noexcept;
 sjis_string to_sjis_string(
     std::u8string_view str,
     client_language client_language = client_language::english) noexcept;
 sjis_string to_sjis_string(
-    std::wstring_view str,
+    utf16_string_view str,
+    client_language client_language = client_language::english) noexcept;
+
+// These overloads convert into a caller-supplied buffer and return the length
+// of the result. If the buffer is too small its contents are unspecified, so
+// an empty buffer can be used to query the required length.
+std::size_t
+to_u8string(utf16_string_view str, std::span<char8_t> buffer) noexcept;
+std::size_t
+to_u8string(sjis_string_view str, std::span<char8_t> buffer) noexcept;
+std::size_t
+to_wstring(std::u8string_view str, std::span<utf16_char> buffer) noexcept;
+std::size_t
+to_wstring(sjis_string_view str, std::span<utf16_char> buffer) noexcept;
+std::size_t to_sjis_string(
+    std::u8string_view str, std::span<sjis_char> buffer,
+    client_language client_language = client_language::english) noexcept;
+std::size_t to_sjis_string(
+    utf16_string_view str, std::span<sjis_char> buffer,
     client_language client_language = client_language::english) noexcept;
 
 char32_t next_code_point(std::u8string_view str, std::size_t& offset) noexcept;
-char32_t next_code_point(std::wstring_view str, std::size_t& offset) noexcept;
+char32_t next_code_point(utf16_string_view str, std::size_t& offset) noexcept;
 char32_t next_code_point(sjis_string_view str, std::size_t& offset) noexcept;
 
 void append(std::u8string& str, char32_t code_point) noexcept;
-void append(std::wstring& str, char32_t code_point) noexcept;
+void append(utf16_string& str, char32_t code_point) noexcept;
 void append(
     sjis_string& str, char32_t code_point,
     client_language client_language = client_language::english) noexcept;
@@ -0,0 +1,133 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "ui/atlas_packer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+using windower::ui::atlas_packer;
+using windower::ui::atlas_region;
+
+// Tracks which texels of a page are taken, to catch overlapping regions.
+class occupancy
+{
+public:
+    occupancy(std::uint16_t width, std::uint16_t height) :
+        m_width{width}, m_texels(std::size_t{width} * height)
+    {}
+
+    bool claim(atlas_region const& region)
+    {
+        for (auto y = region.y; y < region.y + region.height; ++y)
+        {
+            for (auto x = region.x; x < region.x + region.width; ++x)
+            {
+                auto&& texel = m_texels[std::size_t{y} * m_width + x];
+                if (texel)
+                {
+                    return false;
+                }
+                texel = true;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::size_t m_width;
+    std::vector<bool> m_texels;
+};
+
+}
+
+TEST(atlas_packer, equal_tiles_fill_the_page)
+{
+    atlas_packer packer{256, 128};
+    for (auto i = 0; i < 8 * 16; ++i)
+    {
+        ASSERT_TRUE(packer.insert(16, 16)) << i;
+    }
+    EXPECT_EQ(packer.used_area(), 256u * 128);
+    EXPECT_FALSE(packer.insert(1, 1));
+
+    packer.clear();
+    EXPECT_EQ(packer.used_area(), 0);
+    EXPECT_EQ(packer.insert(256, 128), (atlas_region{0, 0, 256, 128}));
+}
+
+TEST(atlas_packer, rejects_regions_larger_than_the_page)
+{
+    atlas_packer packer{64, 32};
+    EXPECT_FALSE(packer.insert(65, 1));
+    EXPECT_FALSE(packer.insert(1, 33));
+    EXPECT_EQ(packer.used_area(), 0);
+}
+
+TEST(atlas_packer, random_regions_never_overlap)
+{
+    std::mt19937 engine{1};
+    for (auto round = 0; round < 200; ++round)
+    {
+        auto const page_width =
+            static_cast<std::uint16_t>(16 << (engine() % 6));
+        auto const page_height =
+            static_cast<std::uint16_t>(16 << (engine() % 6));
+        auto const largest = static_cast<std::uint32_t>(
+            std::max(page_width, page_height) / (1 + engine() % 8));
+        std::uniform_int_distribution<std::uint32_t> size{1, largest};
+
+        atlas_packer packer{page_width, page_height};
+        occupancy texels{page_width, page_height};
+        auto area     = std::uint32_t{};
+        auto failures = 0;
+        while (failures < 20)
+        {
+            auto const width  = static_cast<std::uint16_t>(size(engine));
+            auto const height = static_cast<std::uint16_t>(size(engine));
+            auto const region = packer.insert(width, height);
+            if (!region)
+            {
+                ++failures;
+                continue;
+            }
+
+            ASSERT_EQ(region->width, width);
+            ASSERT_EQ(region->height, height);
+            ASSERT_LE(region->x + region->width, page_width);
+            ASSERT_LE(region->y + region->height, page_height);
+            ASSERT_TRUE(texels.claim(*region))
+                << "overlap at " << region->x << ", " << region->y;
+            area += region->area();
+            ASSERT_EQ(packer.used_area(), area);
+        }
+    }
+}
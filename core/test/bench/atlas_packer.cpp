@@ -0,0 +1,299 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/atlas_packer.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using windower::ui::atlas_packer;
+using windower::ui::atlas_region;
+
+// The texture cache's page size, and the one texel gutter it adds around
+// every image.
+constexpr std::uint16_t page_size = 1024;
+constexpr std::uint16_t gutter    = 1;
+constexpr double page_area        = double{page_size} * page_size;
+
+struct size
+{
+    std::uint16_t width;
+    std::uint16_t height;
+};
+
+using distribution = size (*)(std::mt19937&);
+
+std::uint16_t between(std::mt19937& engine, int low, int high)
+{
+    return static_cast<std::uint16_t>(
+        std::uniform_int_distribution<int>{low, high}(engine));
+}
+
+// Item and status icons: mostly the client's 32x32 icons, with some smaller
+// status icons and larger portraits.
+size icon(std::mt19937& engine)
+{
+    auto const roll = engine() % 10;
+    auto const side = roll < 7 ? 32 : roll < 9 ? 16 : 64;
+    return {static_cast<std::uint16_t>(side), static_cast<std::uint16_t>(side)};
+}
+
+// Window skins cut into nine slices: small corners, long thin edges and the
+// occasional large centre or button sheet.
+size skin(std::mt19937& engine)
+{
+    switch (engine() % 8)
+    {
+    case 0:
+    case 1:
+    case 2: return {between(engine, 4, 16), between(engine, 4, 16)};
+    case 3:
+    case 4: return {between(engine, 32, 256), between(engine, 4, 16)};
+    case 5: return {between(engine, 4, 16), between(engine, 32, 256)};
+    case 6: return {between(engine, 64, 256), between(engine, 64, 256)};
+    default: return {between(engine, 16, 96), between(engine, 16, 48)};
+    }
+}
+
+size mixed(std::mt19937& engine)
+{
+    return engine() % 2 == 0 ? icon(engine) : skin(engine);
+}
+
+// Inserts images into one page until the first one doesn't fit, and reports
+// how much of the page they cover.
+void atlas_fill(benchmark::State& state, distribution next)
+{
+    auto placed = std::size_t{};
+    auto used   = std::uint32_t{};
+    for (auto _ : state)
+    {
+        std::mt19937 engine{1};
+        atlas_packer packer{page_size, page_size};
+        placed = 0;
+        for (;;)
+        {
+            auto const [width, height] = next(engine);
+            if (!packer.insert(width + 2 * gutter, height + 2 * gutter))
+            {
+                break;
+            }
+            ++placed;
+        }
+        used = packer.used_area();
+        benchmark::DoNotOptimize(used);
+    }
+    state.counters["images"]    = static_cast<double>(placed);
+    state.counters["occupancy"] = used / page_area;
+    state.counters["waste"]     = 1 - used / page_area;
+}
+
+// Replays the texture cache's policy: each frame some images are requested
+// with a time to live, expired ones are dropped, and a page where more than
+// half of the packed area is dead is repacked tallest first, or dropped when
+// nothing on it is alive.
+class churn
+{
+public:
+    explicit churn(distribution next) noexcept : m_next{next} {}
+
+    void frame()
+    {
+        std::erase_if(m_images, [](image& i) {
+            if (i.time_to_live == 0)
+            {
+                i.page->live_area -= i.region.area();
+                return true;
+            }
+            --i.time_to_live;
+            return false;
+        });
+
+        for (auto n = m_engine() % 6; n > 0; --n)
+        {
+            auto const [width, height] = m_next(m_engine);
+            auto const time_to_live =
+                m_engine() % 4 == 0 ? between(m_engine, 600, 3000)
+                                    : between(m_engine, 10, 300);
+            insert(
+                static_cast<std::uint16_t>(width + 2 * gutter),
+                static_cast<std::uint16_t>(height + 2 * gutter),
+                time_to_live);
+        }
+
+        for (auto& page : m_pages)
+        {
+            if (page->live_area * 2 < page->packer.used_area())
+            {
+                ++repacks;
+                repack(*page);
+            }
+        }
+        std::erase_if(m_pages, [](auto const& page) {
+            return page->live_area == 0;
+        });
+
+        auto live = std::uint32_t{};
+        auto used = std::uint32_t{};
+        for (auto const& page : m_pages)
+        {
+            live += page->live_area;
+            used += page->packer.used_area();
+        }
+        auto const capacity = page_area * static_cast<double>(m_pages.size());
+        if (capacity > 0)
+        {
+            occupancy += live / capacity;
+            dead += (used - live) / capacity;
+        }
+        pages += static_cast<double>(m_pages.size());
+    }
+
+    double occupancy = 0;
+    double dead      = 0;
+    double pages     = 0;
+    std::size_t repacks = 0;
+
+private:
+    struct atlas_page
+    {
+        atlas_packer packer{page_size, page_size};
+        std::uint32_t live_area = 0;
+    };
+
+    struct image
+    {
+        atlas_page* page;
+        atlas_region region;
+        std::uint16_t time_to_live;
+    };
+
+    void
+    insert(std::uint16_t width, std::uint16_t height, std::uint16_t ttl)
+    {
+        for (auto& page : m_pages)
+        {
+            if (auto const region = page->packer.insert(width, height))
+            {
+                place(*page, *region, ttl);
+                return;
+            }
+        }
+        auto& page = *m_pages.emplace_back(std::make_unique<atlas_page>());
+        if (auto const region = page.packer.insert(width, height))
+        {
+            place(page, *region, ttl);
+        }
+    }
+
+    void place(atlas_page& page, atlas_region const& region, std::uint16_t ttl)
+    {
+        page.live_area += region.area();
+        m_images.push_back({&page, region, ttl});
+    }
+
+    void repack(atlas_page& page)
+    {
+        std::vector<image*> live;
+        for (auto& i : m_images)
+        {
+            if (i.page == &page)
+            {
+                live.push_back(&i);
+            }
+        }
+        std::ranges::sort(live, std::greater{}, [](image const* i) {
+            return std::pair{i->region.height, i->region.width};
+        });
+
+        atlas_packer packer{page_size, page_size};
+        std::vector<atlas_region> destinations;
+        for (auto const* i : live)
+        {
+            auto const region =
+                packer.insert(i->region.width, i->region.height);
+            if (!region)
+            {
+                return;
+            }
+            destinations.push_back(*region);
+        }
+        for (auto n = std::size_t{}; n < live.size(); ++n)
+        {
+            live[n]->region = destinations[n];
+        }
+        page.packer = packer;
+    }
+
+    distribution m_next;
+    std::mt19937 m_engine{1};
+    std::vector<std::unique_ptr<atlas_page>> m_pages;
+    std::vector<image> m_images;
+};
+
+void atlas_churn(benchmark::State& state, distribution next)
+{
+    auto const frames = state.range(0);
+    auto occupancy    = 0.;
+    auto dead         = 0.;
+    auto pages        = 0.;
+    auto repacks      = std::size_t{};
+    for (auto _ : state)
+    {
+        churn run{next};
+        for (auto i = std::int64_t{}; i < frames; ++i)
+        {
+            run.frame();
+        }
+        occupancy = run.occupancy / static_cast<double>(frames);
+        dead      = run.dead / static_cast<double>(frames);
+        pages     = run.pages / static_cast<double>(frames);
+        repacks   = run.repacks;
+    }
+    state.counters["occupancy"] = occupancy;
+    state.counters["dead"]      = dead;
+    state.counters["waste"]     = 1 - occupancy;
+    state.counters["pages"]     = pages;
+    state.counters["repacks"]   = static_cast<double>(repacks);
+}
+
+}
+
+BENCHMARK_CAPTURE(atlas_fill, icons, icon);
+BENCHMARK_CAPTURE(atlas_fill, skins, skin);
+BENCHMARK_CAPTURE(atlas_fill, mixed, mixed);
+BENCHMARK_CAPTURE(atlas_churn, icons, icon)->Arg(5000);
+BENCHMARK_CAPTURE(atlas_churn, skins, skin)->Arg(5000);
+BENCHMARK_CAPTURE(atlas_churn, mixed, mixed)->Arg(5000);
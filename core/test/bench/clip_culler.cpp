@@ -0,0 +1,119 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/clip_culler.hpp"
+
+#include "ui/grid_indices.hpp"
+#include "ui/rectangle.hpp"
+#include "ui/vertex.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+using namespace windower::ui;
+
+// A block of text as the primitives emit it: one quad per glyph, 9 by 14
+// pixels apart, 40 glyphs to a line.
+class text_block
+{
+public:
+    explicit text_block(std::size_t glyphs)
+    {
+        for (auto glyph = std::size_t{}; glyph < glyphs; ++glyph)
+        {
+            auto const x = static_cast<float>(glyph % 40 * 9) - .5f;
+            auto const y = static_cast<float>(glyph / 40 * 14) - .5f;
+            auto const base = static_cast<std::uint16_t>(vertices.size());
+            vertices.insert(
+                vertices.end(),
+                {{x, y}, {x + 7, y}, {x, y + 12}, {x + 7, y + 12}});
+            for (auto const corner : grid_indices<2, 2>())
+            {
+                indices.push_back(
+                    static_cast<std::uint16_t>(base + corner));
+            }
+        }
+    }
+
+    float height() const noexcept
+    {
+        return vertices.empty() ? 0.f : vertices.back().y + .5f;
+    }
+
+    std::vector<vertex> vertices;
+    std::vector<std::uint16_t> indices;
+};
+
+enum class placement
+{
+    inside,
+    straddling,
+    outside,
+};
+
+rectangle clip_rectangle(placement where, float height) noexcept
+{
+    switch (where)
+    {
+    case placement::inside: return {0, 0, 360, height};
+    case placement::straddling: return {0, height / 2, 360, height};
+    case placement::outside: break;
+    }
+    return {0, height, 360, height * 2};
+}
+
+// Culls the block and copies what is kept, as primitive_command does. A
+// straddling block is scrolled halfway out of its clip rectangle, which
+// is the case that tests every triangle.
+void clip_culling(benchmark::State& state, placement where)
+{
+    text_block const block{static_cast<std::size_t>(state.range(0))};
+    auto const clip = clip_rectangle(where, block.height());
+
+    std::vector<std::uint16_t> target(block.indices.size());
+    for (auto _ : state)
+    {
+        clip_culler const culler{block.vertices, block.indices, clip};
+        culler.copy(std::span{target}.first(culler.kept() * 3), 0, false);
+        benchmark::DoNotOptimize(target.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(
+        state.iterations() * block.indices.size() / 3));
+}
+
+}
+
+BENCHMARK_CAPTURE(clip_culling, inside, placement::inside)->Arg(1)->Arg(1024);
+BENCHMARK_CAPTURE(clip_culling, straddling, placement::straddling)
+    ->Arg(64)
+    ->Arg(1024);
+BENCHMARK_CAPTURE(clip_culling, outside, placement::outside)->Arg(1024);
@@ -0,0 +1,164 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/color.hpp"
+#include "ui/dimension.hpp"
+#include "ui/frame_capture.hpp"
+#include "ui/frame_replay.hpp"
+#include "ui/headless_render_device.hpp"
+#include "ui/layer.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vertex.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+using namespace windower::ui;
+
+constexpr auto vertices = vertex_buffer_handle{0x1000};
+constexpr auto indices  = index_buffer_handle{0x2000};
+
+constexpr std::uint32_t screen_width  = 1280;
+constexpr std::uint32_t screen_height = 720;
+constexpr std::uint32_t window_width  = 240;
+constexpr std::uint32_t window_height = 160;
+
+// A background and this many glyph sized quads per window.
+constexpr std::uint32_t glyphs = 96;
+
+void quad(
+    std::vector<vertex>& out, float x0, float y0, float x1, float y1,
+    color c)
+{
+    out.push_back({x0 - .5f, y0 - .5f, 0.f, 1.f, 0.f, 0.f, c});
+    out.push_back({x1 - .5f, y0 - .5f, 0.f, 1.f, 1.f, 0.f, c});
+    out.push_back({x0 - .5f, y1 - .5f, 0.f, 1.f, 0.f, 1.f, c});
+    out.push_back({x1 - .5f, y1 - .5f, 0.f, 1.f, 1.f, 1.f, c});
+}
+
+// Records a frame of text windows spread over the screen, overlapping once
+// there are more than fit, through a capture device the way the context
+// records one.
+class recorded_frame
+{
+public:
+    explicit recorded_frame(std::uint32_t windows) :
+        device{screen_width, screen_height}
+    {
+        for (auto i = std::uint32_t{}; i < windows; ++i)
+        {
+            auto const x = static_cast<float>(i % 5 * 250);
+            auto const y = static_cast<float>(i / 5 % 4 * 170);
+            quad(
+                vertex_data, x, y, x + window_width, y + window_height,
+                {32, 32, 48, 224});
+            for (auto g = std::uint32_t{}; g < glyphs; ++g)
+            {
+                auto const gx = x + 8 + static_cast<float>(g % 24 * 9);
+                auto const gy = y + 8 + static_cast<float>(g / 24 * 14);
+                quad(vertex_data, gx, gy, gx + 7, gy + 12, {255, 255, 255});
+            }
+        }
+        for (auto v = std::uint16_t{}; v < vertex_data.size(); v += 4)
+        {
+            index_data.insert(
+                index_data.end(),
+                {v, std::uint16_t(v + 1), std::uint16_t(v + 2),
+                 std::uint16_t(v + 2), std::uint16_t(v + 1),
+                 std::uint16_t(v + 3)});
+        }
+
+        device.bind(vertices, vertex_data);
+        device.bind(indices, index_data);
+        capture.record(vertices, 0, vertex_data);
+        capture.record(indices, 0, index_data);
+
+        constexpr auto quads = glyphs + 1;
+        capture_render_device recorder{capture, device};
+        for (auto i = std::uint32_t{}; i < windows; ++i)
+        {
+            auto const x = i % 5 * 250;
+            auto const y = i / 5 % 4 * 170;
+            capture.begin_window(
+                i + 1, layer::screen, 0.f,
+                {static_cast<float>(x), static_cast<float>(y),
+                 static_cast<float>(x + window_width),
+                 static_cast<float>(y + window_height)});
+            recorder.set_clip({x, y, window_width, window_height});
+            recorder.set_vertex_buffer(vertices);
+            recorder.set_index_buffer(indices);
+            recorder.draw_indexed(
+                primitive_type::triangle_list, i * quads * 4, quads * 4,
+                i * quads * 6, quads * 2);
+        }
+    }
+
+    frame_capture capture{
+        dimension{screen_width, screen_height}, frame_capture::input_record{}};
+    headless_render_device device;
+    std::vector<vertex> vertex_data;
+    std::vector<std::uint16_t> index_data;
+};
+
+// Replays the whole frame into a headless device, which rasterizes it,
+// and reports the primitives and pixels drawn per second.
+void frame_replay_headless(benchmark::State& state)
+{
+    recorded_frame const frame{static_cast<std::uint32_t>(state.range(0))};
+    frame_replay const replay{frame.capture};
+    headless_render_device device{screen_width, screen_height};
+    replay.bind(device);
+
+    auto primitives = std::size_t{};
+    for (auto _ : state)
+    {
+        device.clear();
+        auto const reports = replay.run(device);
+        benchmark::DoNotOptimize(device.image().data());
+        primitives = 0;
+        for (auto const& report : reports)
+        {
+            primitives += report.primitives;
+        }
+    }
+    auto const pixels =
+        static_cast<double>(window_width * window_height + glyphs * 7 * 12) *
+        static_cast<double>(state.range(0));
+    state.counters["primitives"] = benchmark::Counter(
+        static_cast<double>(primitives),
+        benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["pixels"] = benchmark::Counter(
+        pixels, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+}
+
+BENCHMARK(frame_replay_headless)->Arg(1)->Arg(8)->Arg(32);
@@ -0,0 +1,104 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/grid_indices.hpp"
+#include "ui/grid_vertices.hpp"
+
+#include "ui/color.hpp"
+#include "ui/transform.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+
+using namespace windower::ui;
+
+template<std::size_t N>
+constexpr std::array<float, N> steps(float first, float last) noexcept
+{
+    std::array<float, N> result{};
+    for (auto i = std::size_t{}; i < N; ++i)
+    {
+        result[i] = first + (last - first) * static_cast<float>(i) / (N - 1);
+    }
+    return result;
+}
+
+// The corners draw_grid computes for a rectangle (2x2), the horizontal and
+// vertical three-patches (4x2, 2x4) and a nine-patch (4x4), under a rotated
+// and scaled transform so that no term of it is trivial.
+template<std::size_t Columns, std::size_t Rows>
+void grid_vertices_build(benchmark::State& state)
+{
+    constexpr auto xs = steps<Columns>(0.f, 200.f);
+    constexpr auto ys = steps<Rows>(0.f, 120.f);
+    constexpr auto us = steps<Columns>(0.f, 1.f);
+    constexpr auto vs = steps<Rows>(0.f, 1.f);
+
+    auto t =
+        transform::rotation(.1f, 100.f, 60.f) * transform::scale(1.25f, 1.25f);
+    auto origin = 16.f;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(t);
+        benchmark::DoNotOptimize(origin);
+        auto const vertices = grid_vertices<Columns, Rows>(
+            t, origin, origin, xs, ys, us, vs, .5f, 5.f,
+            colors::white);
+        benchmark::DoNotOptimize(vertices.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(
+        static_cast<std::int64_t>(state.iterations() * Columns * Rows));
+}
+
+// grid_indices is constexpr and draw_grid keeps its result in a static
+// table. Called at run time, the compiler should still fold it into a copy
+// of a constant, which this checks.
+template<std::size_t Columns, std::size_t Rows>
+void grid_indices_build(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        auto const indices = grid_indices<Columns, Rows>();
+        benchmark::DoNotOptimize(indices.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(
+        state.iterations() * (Columns - 1) * (Rows - 1) * 6));
+}
+
+}
+
+BENCHMARK_TEMPLATE(grid_vertices_build, 2, 2);
+BENCHMARK_TEMPLATE(grid_vertices_build, 4, 2);
+BENCHMARK_TEMPLATE(grid_vertices_build, 2, 4);
+BENCHMARK_TEMPLATE(grid_vertices_build, 4, 4);
+BENCHMARK_TEMPLATE(grid_indices_build, 2, 2);
+BENCHMARK_TEMPLATE(grid_indices_build, 4, 4);
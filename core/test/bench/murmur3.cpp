@@ -0,0 +1,83 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "murmur3.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+std::vector<std::byte> make_data(std::size_t size)
+{
+    std::vector<std::byte> data(size);
+    std::uint32_t state = 1;
+    std::ranges::generate(data, [&state] {
+        state = state * 1664525 + 1013904223;
+        return std::byte(state >> 24);
+    });
+    return data;
+}
+
+void murmur3_hash(benchmark::State& state)
+{
+    auto const data = make_data(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(windower::murmur3::hash(data, 0));
+    }
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+
+void murmur3_stream(benchmark::State& state)
+{
+    auto const data  = make_data(static_cast<std::size_t>(state.range(0)));
+    auto const chunk = std::size_t{7};
+    for (auto _ : state)
+    {
+        windower::murmur3 hasher;
+        hasher.reset(0);
+        for (std::size_t i = 0; i < data.size(); i += chunk)
+        {
+            hasher.update(std::span{data}.subspan(
+                i, std::min(chunk, data.size() - i)));
+        }
+        benchmark::DoNotOptimize(hasher.digest());
+    }
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+
+}
+
+BENCHMARK(murmur3_hash)->Range(8, 64 << 10);
+BENCHMARK(murmur3_stream)->Range(8, 64 << 10);
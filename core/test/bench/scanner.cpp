@@ -0,0 +1,158 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mapped_image.hpp"
+
+#include "pe_image.hpp"
+#include "scanner.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using windower::signature;
+using windower::test::mapped_image;
+
+// Signatures planted near the end of the code, so that finding them covers
+// the whole image. The anchored ones contain bytes the generated code never
+// has; the common ones are made only of its most frequent bytes.
+constexpr std::array<std::u8string_view, 4> anchored{
+    u8"C745FCF3A5", u8"A1????????C3", u8"B9??D7", u8"F3AB5FC9"};
+constexpr std::array<std::u8string_view, 4> common{
+    u8"8B55FF89E8008B55??89E800", u8"00008B8B55555555FFFF0000",
+    u8"E8????FF89558B0000E8FF89", u8"89550000FF8BE8E8??5589FF"};
+
+// Images up to 4 MiB of code are searched on the calling thread, larger ones
+// in parallel chunks.
+constexpr auto parallel_size = std::int64_t{0x400000};
+
+mapped_image make_image(std::uint32_t code_size)
+{
+    std::mt19937 engine{1};
+    mapped_image result{{{0x1000, code_size, true}}, engine};
+    auto const bytes = result.bytes();
+    auto offset      = std::size_t{0x1000} + code_size;
+    for (auto const& strings : {anchored, common})
+    {
+        for (auto const string : strings)
+        {
+            signature const sig{string};
+            offset -= windower::signature::max_size;
+            for (auto i = std::size_t{}; i < sig.size(); ++i)
+            {
+                bytes[offset + i] = sig.data()[i];
+            }
+        }
+    }
+    return result;
+}
+
+mapped_image const& image(std::int64_t code_size)
+{
+    static std::map<std::int64_t, std::unique_ptr<mapped_image>> cache;
+    auto& entry = cache[code_size];
+    if (!entry)
+    {
+        entry = std::make_unique<mapped_image>(
+            make_image(static_cast<std::uint32_t>(code_size)));
+    }
+    return *entry;
+}
+
+void set_counters(benchmark::State& state)
+{
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(state.iterations()) * state.range(0));
+    state.SetLabel(
+        state.range(0) >= parallel_size &&
+                std::thread::hardware_concurrency() > 1
+            ? "parallel"
+            : "single-threaded");
+}
+
+void scanner_locate(
+    benchmark::State& state, std::array<std::u8string_view, 4> strings)
+{
+    auto const& target = image(state.range(0));
+    signature const sig{strings[0]};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(windower::locate(target.image(), sig));
+    }
+    set_counters(state);
+}
+
+void scanner_locate_all(
+    benchmark::State& state, std::array<std::u8string_view, 4> strings)
+{
+    auto const& target = image(state.range(0));
+    std::vector<signature> signatures;
+    for (auto const string : strings)
+    {
+        signatures.emplace_back(string);
+    }
+    std::vector<signature const*> pointers;
+    for (auto const& sig : signatures)
+    {
+        pointers.push_back(&sig);
+    }
+    std::vector<std::optional<std::uint32_t>> rvas(pointers.size());
+    for (auto _ : state)
+    {
+        windower::locate_all(target.image(), pointers, rvas);
+        benchmark::DoNotOptimize(rvas.data());
+    }
+    set_counters(state);
+}
+
+}
+
+BENCHMARK_CAPTURE(scanner_locate, anchored, anchored)
+    ->Arg(64 << 10)
+    ->Arg(3 << 20)
+    ->Arg(8 << 20);
+BENCHMARK_CAPTURE(scanner_locate, common, common)
+    ->Arg(64 << 10)
+    ->Arg(3 << 20)
+    ->Arg(8 << 20);
+BENCHMARK_CAPTURE(scanner_locate_all, anchored, anchored)
+    ->Arg(64 << 10)
+    ->Arg(3 << 20)
+    ->Arg(8 << 20);
+BENCHMARK_CAPTURE(scanner_locate_all, common, common)
+    ->Arg(64 << 10)
+    ->Arg(3 << 20)
+    ->Arg(8 << 20);
@@ -0,0 +1,99 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "lua_environment.hpp"
+
+#include "addon/lua.hpp"
+#include "addon/lua_internal.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string_view>
+
+namespace
+{
+
+// Builds a settings-like table of records and returns an encoder, a decoder
+// and the encoded size for the serializer module named by the argument.
+constexpr std::u8string_view corpus = u8R"(
+local serializer = require(...)
+local records = {}
+for i = 1, 200 do
+    records[i] = {
+        id = i,
+        name = 'record ' .. i,
+        position = {x = i * 0.5, y = -i, z = 1e6 + i},
+        flags = {true, false, i % 3 == 0},
+        tags = {'alpha', 'beta', 'gamma'},
+    }
+end
+local value = {records = records, version = 3, owner = records[1]}
+local encoded = serializer.serialize(value)
+return function()
+    return serializer.serialize(value)
+end, function()
+    return serializer.deserialize(encoded)
+end, #encoded
+)";
+
+void serializer_run(benchmark::State& state, char8_t const* module, int which)
+{
+    using namespace windower;
+
+    auto const interpreter = test::create_serializer_interpreter();
+    lua::stack_guard guard{interpreter};
+
+    lua::load(guard, corpus, u8"corpus");
+    lua::push(guard, module);
+    lua::call(guard, 1, 3);
+    auto const size = lua::get<std::int64_t>(guard, -1);
+    auto const function = lua::absolute(guard, which - 3);
+
+    for (auto _ : state)
+    {
+        lua::copy(guard, function);
+        lua::call(guard, 0, 1);
+        lua::pop(guard);
+    }
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(state.iterations()) * size);
+}
+
+void serializer_encode(benchmark::State& state, char8_t const* module)
+{
+    serializer_run(state, module, 0);
+}
+
+void serializer_decode(benchmark::State& state, char8_t const* module)
+{
+    serializer_run(state, module, 1);
+}
+
+}
+
+BENCHMARK_CAPTURE(serializer_encode, native, u8"core.serializer");
+BENCHMARK_CAPTURE(serializer_encode, reference, u8"core.serializer.reference");
+BENCHMARK_CAPTURE(serializer_decode, native, u8"core.serializer");
+BENCHMARK_CAPTURE(serializer_decode, reference, u8"core.serializer.reference");
@@ -0,0 +1,147 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "unicode.hpp"
+
+#if defined(_WIN32)
+#    include <icu.h>
+#else
+#    include <unicode/ustring.h>
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+// Repeats a sample up to the benchmark size: plain ASCII, mostly ASCII text
+// with the occasional accented letter, and Japanese text.
+std::u8string make_text(std::int64_t kind, std::int64_t size)
+{
+    constexpr std::u8string_view samples[] = {
+        u8"The quick brown fox jumps over the lazy dog. ",
+        u8"Résumé of the café's menu: crème brûlée, déjà vu. ",
+        u8"いろはにほへとちりぬるを わかよたれそつねならむ ",
+    };
+
+    auto const sample = samples[kind];
+    auto result       = std::u8string{};
+    while (result.size() < static_cast<std::size_t>(size))
+    {
+        result += sample;
+    }
+    return result;
+}
+
+void to_wstring(benchmark::State& state)
+{
+    auto const text = make_text(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(windower::to_wstring(text));
+    }
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+
+void to_u8string(benchmark::State& state)
+{
+    auto const text = windower::to_wstring(
+        make_text(state.range(0), state.range(1)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(windower::to_u8string(text));
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(
+        state.iterations() * text.size() * sizeof(windower::utf16_char)));
+}
+
+// The previous implementation: ICU with a buffer sized to the input.
+void icu_to_wstring(benchmark::State& state)
+{
+    auto const text = make_text(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        auto result     = windower::utf16_string(text.size(), u'\0');
+        auto length     = std::int32_t{};
+        auto error_code = U_ZERO_ERROR;
+        ::u_strFromUTF8WithSub(
+            reinterpret_cast<::UChar*>(result.data()),
+            static_cast<std::int32_t>(result.size()), &length,
+            reinterpret_cast<char const*>(text.data()),
+            static_cast<std::int32_t>(text.size()), 0xFFFD, nullptr,
+            &error_code);
+        result.resize(static_cast<std::size_t>(length));
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+
+void icu_to_u8string(benchmark::State& state)
+{
+    auto const text = windower::to_wstring(
+        make_text(state.range(0), state.range(1)));
+    for (auto _ : state)
+    {
+        auto result     = std::u8string(text.size() * 3, u8'\0');
+        auto length     = std::int32_t{};
+        auto error_code = U_ZERO_ERROR;
+        ::u_strToUTF8WithSub(
+            reinterpret_cast<char*>(result.data()),
+            static_cast<std::int32_t>(result.size()), &length,
+            reinterpret_cast<::UChar const*>(text.data()),
+            static_cast<std::int32_t>(text.size()), 0xFFFD, nullptr,
+            &error_code);
+        result.resize(static_cast<std::size_t>(length));
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(
+        state.iterations() * text.size() * sizeof(windower::utf16_char)));
+}
+
+void text_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"text", "size"});
+    for (auto kind = 0; kind < 3; ++kind)
+    {
+        for (auto size : {16, 256, 4096})
+        {
+            benchmark->Args({kind, size});
+        }
+    }
+}
+
+}
+
+BENCHMARK(to_wstring)->Apply(text_sizes);
+BENCHMARK(icu_to_wstring)->Apply(text_sizes);
+BENCHMARK(to_u8string)->Apply(text_sizes);
+BENCHMARK(icu_to_u8string)->Apply(text_sizes);
@@ -0,0 +1,103 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "hooklib/x86.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+using windower::hooklib::x86;
+
+// A function prologue and body of the kind the hooks patch over.
+constexpr std::array<std::uint8_t, 45> sample = {
+    0x55,                                     // push ebp
+    0x8B, 0xEC,                               // mov ebp, esp
+    0x83, 0xEC, 0x10,                         // sub esp, 16
+    0x53,                                     // push ebx
+    0x8B, 0x5D, 0x08,                         // mov ebx, [ebp+8]
+    0x8B, 0x04, 0x9D, 0x00, 0x10, 0x40, 0x00, // mov eax, [ebx*4+0x401000]
+    0x0F, 0xB6, 0x4B, 0x04,                   // movzx ecx, byte [ebx+4]
+    0x66, 0x89, 0x45, 0xFC,                   // mov [ebp-4], ax
+    0x85, 0xC0,                               // test eax, eax
+    0x74, 0x10,                               // je +16
+    0xE8, 0x00, 0x01, 0x00, 0x00,             // call +256
+    0x0F, 0x85, 0x20, 0x00, 0x00, 0x00,       // jne +32
+    0x5B,                                     // pop ebx
+    0x8B, 0xE5,                               // mov esp, ebp
+    0x5D,                                     // pop ebp
+    0xC3,                                     // ret
+};
+
+std::vector<std::uint8_t> make_code()
+{
+    std::vector<std::uint8_t> code;
+    for (auto i = 0; i < 64; ++i)
+    {
+        code.insert(code.end(), sample.begin(), sample.end());
+    }
+    code.resize(code.size() + x86::max_instruction_size);
+    return code;
+}
+
+void x86_decode(benchmark::State& state)
+{
+    auto const code = make_code();
+    auto const end  = code.size() - x86::max_instruction_size;
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < end;)
+        {
+            i += x86::decode(code.data() + i).size;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(state.iterations()) *
+        static_cast<std::int64_t>(end));
+}
+
+void x86_relocate(benchmark::State& state)
+{
+    std::vector<std::uint8_t> buffer(0x200, x86::nop_instruction);
+    std::copy(sample.begin(), sample.end(), buffer.begin());
+    auto const destination = std::span{buffer}.subspan(0x100, 0x80);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            x86::relocate(buffer.data(), sample.size(), destination));
+    }
+}
+
+}
+
+BENCHMARK(x86_decode);
+BENCHMARK(x86_relocate);
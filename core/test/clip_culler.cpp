@@ -0,0 +1,102 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/clip_culler.hpp"
+
+#include "ui/rectangle.hpp"
+#include "ui/vertex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+
+using namespace windower::ui;
+
+// Three quads in a row, each ten pixels wide, offset half a pixel as the
+// primitives place them.
+std::vector<vertex> row_of_quads()
+{
+    std::vector<vertex> vertices;
+    for (auto quad = 0; quad < 3; ++quad)
+    {
+        auto const x0 = static_cast<float>(quad * 10) - .5f;
+        auto const x1 = x0 + 10.f;
+        vertices.insert(
+            vertices.end(), {{x0, -.5f}, {x1, -.5f}, {x0, 9.5f}, {x1, 9.5f}});
+    }
+    return vertices;
+}
+
+constexpr std::array<std::uint16_t, 18> row_indices{
+    0, 1, 2, 2, 1, 3, 4, 5, 6, 6, 5, 7, 8, 9, 10, 10, 9, 11};
+
+std::vector<std::uint16_t> copy(
+    clip_culler const& culler, std::size_t base, bool reflected = false)
+{
+    std::vector<std::uint16_t> indices(culler.kept() * 3);
+    culler.copy(indices, base, reflected);
+    return indices;
+}
+
+}
+
+TEST(clip_culler, keeps_a_list_inside_the_clip_rectangle_whole)
+{
+    auto const vertices = row_of_quads();
+    clip_culler const culler{vertices, row_indices, {-1, -1, 30, 10}};
+
+    EXPECT_EQ(culler.kept(), 6);
+    EXPECT_EQ(culler.extent(), (rectangle{-.5f, -.5f, 29.5f, 9.5f}));
+    EXPECT_EQ(copy(culler, 100)[0], 100);
+    EXPECT_EQ(copy(culler, 100)[17], 111);
+}
+
+TEST(clip_culler, drops_a_list_outside_the_clip_rectangle)
+{
+    auto const vertices = row_of_quads();
+    EXPECT_EQ((clip_culler{vertices, row_indices, {0, 10, 30, 20}}.kept()), 0);
+    EXPECT_EQ((clip_culler{vertices, row_indices, {30, 0, 40, 10}}.kept()), 0);
+}
+
+TEST(clip_culler, culls_a_straddling_list_triangle_by_triangle)
+{
+    auto const vertices = row_of_quads();
+
+    // Only the middle quad reaches into the clip rectangle.
+    clip_culler const culler{vertices, row_indices, {10, 0, 20, 10}};
+    ASSERT_EQ(culler.kept(), 2);
+    EXPECT_EQ(
+        copy(culler, 0), (std::vector<std::uint16_t>{4, 5, 6, 6, 5, 7}));
+
+    // Reflected lists are written back to front with the winding reversed.
+    EXPECT_EQ(
+        copy(culler, 1, true),
+        (std::vector<std::uint16_t>{8, 6, 7, 7, 6, 5}));
+}
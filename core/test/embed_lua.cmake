@@ -0,0 +1,45 @@
+# Writes a Lua module into a header in the format of core.vcxproj's
+# CompileLua task, so that the module loaders build unchanged. The source is
+# embedded as text rather than bytecode; lua::load accepts either.
+#
+#   cmake -DSOURCE=<module>.lua -DOUTPUT=<module>.lua.hpp -P embed_lua.cmake
+
+get_filename_component(module "${SOURCE}" NAME_WE)
+file(READ "${SOURCE}" hex HEX)
+string(LENGTH "${hex}" length)
+math(EXPR length "${length} / 2")
+
+# Four bytes per line, as CompileLua writes them.
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" " std::byte{0x\\1}," bytes "${hex}")
+set(byte "std::byte{0x..},")
+string(REGEX REPLACE "(${byte} ${byte} ${byte} ${byte})" "\\1\n   "
+    bytes "${bytes}")
+string(REGEX REPLACE "\n   $" "" bytes "${bytes}")
+string(TOUPPER "${module}" guard)
+
+file(WRITE "${OUTPUT}"
+"#ifndef PRECOMPILED_LUA_${guard}\n"
+"#define PRECOMPILED_LUA_${guard}\n"
+"\n"
+"#if defined(_MSC_VER)\n"
+"#    pragma warning(push, 0)\n"
+"#    pragma warning(disable : 26493)\n"
+"#endif\n"
+"\n"
+"#include <array>\n"
+"#include <cstddef>\n"
+"\n"
+"namespace windower\n"
+"{\n"
+"\n"
+"constexpr std::array<std::byte, ${length}> lua_${module}_source{\n"
+"   ${bytes}\n"
+"};\n"
+"\n"
+"}\n"
+"\n"
+"#if defined(_MSC_VER)\n"
+"#    pragma warning(pop)\n"
+"#endif\n"
+"\n"
+"#endif\n")
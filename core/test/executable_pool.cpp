@@ -0,0 +1,285 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "hooklib/executable_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#if !defined(_WIN32)
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+namespace
+{
+
+using windower::hooklib::executable_pool;
+using windower::hooklib::page_provider;
+
+// Hands out ordinary heap memory and records the protection changes the pool
+// asks for.
+class fake_page_provider final : public page_provider
+{
+public:
+    static constexpr std::size_t size = 4096;
+
+    std::size_t region_size() const noexcept override { return size; }
+
+    std::byte* allocate(void const*) override
+    {
+        auto& region = m_regions.emplace_back(new std::byte[size]);
+        return region.get();
+    }
+
+    void deallocate(std::byte* region) noexcept override
+    {
+        std::erase_if(m_regions, [&](auto const& entry) {
+            return entry.get() == region;
+        });
+    }
+
+    void make_writable(std::byte*) override { ++writable_calls; }
+
+    void make_executable(std::byte*) noexcept override
+    {
+        ++executable_calls;
+    }
+
+    std::size_t live_regions() const noexcept { return m_regions.size(); }
+
+    std::size_t writable_calls   = 0;
+    std::size_t executable_calls = 0;
+
+private:
+    std::vector<std::unique_ptr<std::byte[]>> m_regions;
+};
+
+#if !defined(_WIN32)
+
+// The POSIX counterpart of the VirtualAlloc provider the trampolines use.
+class mapped_page_provider final : public page_provider
+{
+public:
+    std::size_t region_size() const noexcept override
+    {
+        return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    std::byte* allocate(void const* hint) override
+    {
+        // The hint is only advisory; the pool checks the result is in reach.
+        auto const ptr = ::mmap(
+            const_cast<void*>(hint), region_size(), PROT_READ | PROT_EXEC,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+        {
+            throw std::system_error{errno, std::generic_category()};
+        }
+        return static_cast<std::byte*>(ptr);
+    }
+
+    void deallocate(std::byte* region) noexcept override
+    {
+        ::munmap(region, region_size());
+    }
+
+    void make_writable(std::byte* region) override
+    {
+        if (::mprotect(
+                region, region_size(), PROT_READ | PROT_WRITE | PROT_EXEC) !=
+            0)
+        {
+            throw std::system_error{errno, std::generic_category()};
+        }
+    }
+
+    void make_executable(std::byte* region) noexcept override
+    {
+        ::mprotect(region, region_size(), PROT_READ | PROT_EXEC);
+        __builtin___clear_cache(
+            reinterpret_cast<char*>(region),
+            reinterpret_cast<char*>(region + region_size()));
+    }
+};
+
+#endif
+
+}
+
+TEST(executable_pool, rejects_slots_larger_than_a_region)
+{
+    fake_page_provider provider;
+    EXPECT_THROW(
+        (executable_pool{provider, fake_page_provider::size + 1}),
+        std::invalid_argument);
+}
+
+TEST(executable_pool, allocation_requires_a_batch)
+{
+    fake_page_provider provider;
+    executable_pool pool{provider, 64};
+    EXPECT_THROW(pool.allocate(), std::logic_error);
+    EXPECT_EQ(provider.live_regions(), 0);
+}
+
+TEST(executable_pool, slots_fill_regions_in_order)
+{
+    fake_page_provider provider;
+    executable_pool pool{provider, 60};
+    auto constexpr slot_size  = std::size_t{64};
+    auto constexpr slot_count = fake_page_provider::size / slot_size;
+
+    executable_pool::write_batch const batch{pool};
+    std::vector<std::byte*> slots;
+    for (std::size_t i = 0; i < slot_count; ++i)
+    {
+        slots.push_back(static_cast<std::byte*>(pool.allocate()));
+    }
+    EXPECT_EQ(provider.live_regions(), 1);
+    for (std::size_t i = 1; i < slots.size(); ++i)
+    {
+        EXPECT_EQ(slots[i] - slots[i - 1], slot_size);
+    }
+
+    auto const next = static_cast<std::byte*>(pool.allocate());
+    EXPECT_EQ(provider.live_regions(), 2);
+    EXPECT_TRUE(next < slots.front() || next >= slots.back() + slot_size);
+
+    // A freed slot is handed out again before the region grows.
+    pool.deallocate(slots[5]);
+    EXPECT_EQ(pool.allocate(), slots[5]);
+}
+
+TEST(executable_pool, empty_regions_are_released)
+{
+    fake_page_provider provider;
+    executable_pool pool{provider, 1024};
+
+    std::vector<void*> slots;
+    {
+        executable_pool::write_batch const batch{pool};
+        for (auto i = 0; i < 10; ++i)
+        {
+            slots.push_back(pool.allocate());
+        }
+    }
+    EXPECT_EQ(provider.live_regions(), 3);
+
+    std::ranges::reverse(slots);
+    for (auto const slot : slots)
+    {
+        pool.deallocate(slot);
+    }
+    EXPECT_EQ(provider.live_regions(), 0);
+    pool.deallocate(nullptr);
+}
+
+TEST(executable_pool, batches_change_protection_once)
+{
+    fake_page_provider provider;
+    executable_pool pool{provider, 64};
+    {
+        executable_pool::write_batch const outer{pool};
+        pool.allocate();
+        {
+            executable_pool::write_batch const inner{pool};
+            pool.allocate();
+            pool.allocate();
+        }
+        EXPECT_EQ(provider.executable_calls, 0);
+        pool.allocate();
+    }
+    EXPECT_EQ(provider.writable_calls, 1);
+    EXPECT_EQ(provider.executable_calls, 1);
+
+    {
+        executable_pool::write_batch const batch{pool};
+        pool.allocate();
+    }
+    EXPECT_EQ(provider.writable_calls, 2);
+    EXPECT_EQ(provider.executable_calls, 2);
+}
+
+TEST(executable_pool, regions_out_of_reach_are_returned)
+{
+    if constexpr (sizeof(void*) <= sizeof(std::int32_t))
+    {
+        GTEST_SKIP() << "rel32 reaches the whole address space";
+    }
+    else
+    {
+        fake_page_provider provider;
+        executable_pool pool{provider, 64};
+        executable_pool::write_batch const batch{pool};
+
+        auto const near = pool.allocate();
+        auto const far  = std::bit_cast<void const*>(
+            std::bit_cast<std::uintptr_t>(near) + (std::uintptr_t{1} << 33));
+        EXPECT_THROW(pool.allocate(far), std::runtime_error);
+        EXPECT_EQ(provider.live_regions(), 1);
+    }
+}
+
+#if !defined(_WIN32) && (defined(__i386__) || defined(__x86_64__))
+
+TEST(executable_pool, slots_run_after_the_batch)
+{
+    mapped_page_provider provider;
+    executable_pool pool{provider, 16};
+    auto const anchor = reinterpret_cast<void const*>(&::sysconf);
+
+    std::set<void*> slots;
+    for (std::uint8_t value = 0; value < 64; ++value)
+    {
+        void* slot = nullptr;
+        {
+            executable_pool::write_batch const batch{pool};
+            slot = pool.allocate(anchor);
+            // mov eax, value; ret
+            std::uint8_t const code[] = {0xB8, value, 0, 0, 0, 0xC3};
+            std::memcpy(slot, code, sizeof code);
+        }
+        EXPECT_EQ(reinterpret_cast<int (*)()>(slot)(), value);
+        slots.insert(slot);
+    }
+    EXPECT_EQ(slots.size(), 64);
+
+    for (auto const slot : slots)
+    {
+        pool.deallocate(slot);
+    }
+}
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/frame_capture.hpp"
+
+#include "ui/color.hpp"
+#include "ui/dimension.hpp"
+#include "ui/frame_replay.hpp"
+#include "ui/headless_render_device.hpp"
+#include "ui/layer.hpp"
+#include "ui/rectangle.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vector.hpp"
+#include "ui/vertex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace windower::ui;
+
+// Arbitrary values, as a real device's pointers would be.
+constexpr auto vertices = vertex_buffer_handle{0x1000};
+constexpr auto indices  = index_buffer_handle{0x2000};
+
+constexpr auto red  = color{255, 0, 0};
+constexpr auto blue = color{0, 0, 255};
+
+void quad(
+    std::vector<vertex>& out, float x0, float y0, float x1, float y1,
+    color c)
+{
+    out.push_back({x0 - .5f, y0 - .5f, 0.f, 1.f, 0.f, 0.f, c});
+    out.push_back({x1 - .5f, y0 - .5f, 0.f, 1.f, 1.f, 0.f, c});
+    out.push_back({x0 - .5f, y1 - .5f, 0.f, 1.f, 0.f, 1.f, c});
+    out.push_back({x1 - .5f, y1 - .5f, 0.f, 1.f, 1.f, 1.f, c});
+}
+
+std::filesystem::path temporary(std::string const& name)
+{
+    return std::filesystem::path{::testing::TempDir()} / name;
+}
+
+// Records two windows the way the context does: the data buffers report
+// what was written to them, and a capture device sits in front of the
+// device that renders the frame.
+class recorded_frame
+{
+public:
+    recorded_frame() : device{8, 8}
+    {
+        quad(vertex_data, 0, 0, 6, 6, red);
+        quad(vertex_data, 2, 2, 8, 8, blue);
+        index_data = {0, 1, 2, 2, 1, 3, 4, 5, 6, 6, 5, 7};
+
+        device.bind(vertices, vertex_data);
+        device.bind(indices, index_data);
+
+        // The second quad is written after a lock, as a separate segment.
+        auto const span = std::span<vertex const>{vertex_data};
+        capture.record(vertices, 0, span.first(4));
+        capture.record(vertices, 4, span.subspan(4));
+        capture.record(indices, 0, index_data);
+
+        capture_render_device recorder{capture, device};
+        capture.begin_window(1, layer::screen, 0.f, {0, 0, 6, 6});
+        recorder.set_clip({0, 0, 8, 8});
+        recorder.set_vertex_buffer(vertices);
+        recorder.set_index_buffer(indices);
+        recorder.draw_indexed(primitive_type::triangle_list, 0, 4, 0, 2);
+
+        capture.begin_window(2, layer::world, .5f, {2, 2, 8, 8});
+        recorder.set_clip({4, 4, 4, 4});
+        recorder.draw_indexed(primitive_type::triangle_list, 4, 4, 6, 2);
+    }
+
+    frame_capture capture{
+        dimension{8, 8},
+        {.mouse_position = {3, 4},
+         .scroll_offset  = {0, -1},
+         .held_buttons   = 0b101,
+         .layout_mode    = true}};
+    headless_render_device device;
+    std::vector<vertex> vertex_data;
+    std::vector<std::uint16_t> index_data;
+};
+
+}
+
+TEST(frame_capture, records_windows_and_calls)
+{
+    recorded_frame const frame;
+    auto const& capture = frame.capture;
+
+    ASSERT_EQ(capture.windows().size(), 2);
+    EXPECT_EQ(capture.windows()[0].first_call, 0);
+    EXPECT_EQ(capture.windows()[0].call_count, 4);
+    EXPECT_EQ(capture.windows()[1].first_call, 4);
+    EXPECT_EQ(capture.windows()[1].call_count, 2);
+
+    // Handles are replaced by identifiers starting at one.
+    auto const calls = capture.calls();
+    ASSERT_EQ(calls.size(), 6);
+    EXPECT_EQ(calls[1].type, frame_capture::call_type::set_vertex_buffer);
+    EXPECT_EQ(calls[1].arguments[0], 1);
+    EXPECT_EQ(calls[2].type, frame_capture::call_type::set_index_buffer);
+    EXPECT_EQ(calls[2].arguments[0], 1);
+
+    ASSERT_EQ(capture.vertex_segments().size(), 2);
+    EXPECT_EQ(capture.vertex_segments()[1].buffer, 1);
+    EXPECT_EQ(capture.vertex_segments()[1].offset, 4);
+    ASSERT_EQ(capture.index_segments().size(), 1);
+    EXPECT_EQ(capture.index_segments()[0].data, frame.index_data);
+
+    // The capture device forwards everything it records.
+    EXPECT_EQ(frame.device.draws().size(), 2);
+}
+
+TEST(frame_capture, round_trips_through_a_file)
+{
+    recorded_frame const frame;
+    auto const path = temporary("frame_capture_round_trip.uic");
+    ASSERT_TRUE(frame.capture.save(path));
+
+    auto const loaded = frame_capture::load(path);
+    std::filesystem::remove(path);
+    ASSERT_TRUE(loaded);
+
+    EXPECT_EQ(loaded->screen_size().width, 8);
+    EXPECT_EQ(loaded->screen_size().height, 8);
+    EXPECT_EQ(loaded->input().mouse_position, (vector{3, 4}));
+    EXPECT_EQ(loaded->input().scroll_offset, (vector{0, -1}));
+    EXPECT_EQ(loaded->input().held_buttons, 0b101);
+    EXPECT_TRUE(loaded->input().layout_mode);
+
+    ASSERT_EQ(loaded->windows().size(), frame.capture.windows().size());
+    for (auto i = std::size_t{}; i < loaded->windows().size(); ++i)
+    {
+        auto const& expected = frame.capture.windows()[i];
+        auto const& actual   = loaded->windows()[i];
+        EXPECT_EQ(actual.id, expected.id);
+        EXPECT_EQ(actual.layer, expected.layer);
+        EXPECT_EQ(actual.depth, expected.depth);
+        EXPECT_EQ(actual.bounds, expected.bounds);
+        EXPECT_EQ(actual.first_call, expected.first_call);
+        EXPECT_EQ(actual.call_count, expected.call_count);
+    }
+
+    ASSERT_EQ(loaded->calls().size(), frame.capture.calls().size());
+    for (auto i = std::size_t{}; i < loaded->calls().size(); ++i)
+    {
+        EXPECT_EQ(loaded->calls()[i].type, frame.capture.calls()[i].type);
+        EXPECT_EQ(
+            loaded->calls()[i].arguments, frame.capture.calls()[i].arguments);
+    }
+
+    ASSERT_EQ(loaded->vertex_segments().size(), 2);
+    auto const& segment = loaded->vertex_segments()[1];
+    EXPECT_EQ(segment.offset, 4);
+    ASSERT_EQ(segment.data.size(), 4);
+    EXPECT_EQ(segment.data[3].x, frame.vertex_data[7].x);
+    EXPECT_EQ(
+        std::uint32_t{segment.data[3].color},
+        std::uint32_t{frame.vertex_data[7].color});
+    EXPECT_EQ(loaded->index_segments()[0].data, frame.index_data);
+}
+
+TEST(frame_capture, replays_the_recorded_image)
+{
+    recorded_frame const frame;
+    auto const path = temporary("frame_capture_replay.uic");
+    ASSERT_TRUE(frame.capture.save(path));
+    auto const loaded = frame_capture::load(path);
+    std::filesystem::remove(path);
+    ASSERT_TRUE(loaded);
+
+    frame_replay const replay{*loaded};
+    auto const& size = loaded->screen_size();
+    headless_render_device device{
+        static_cast<std::uint32_t>(size.width),
+        static_cast<std::uint32_t>(size.height)};
+    replay.bind(device);
+    auto const reports = replay.run(device);
+
+    ASSERT_EQ(reports.size(), 2);
+    EXPECT_EQ(reports[0].id, 1);
+    EXPECT_EQ(reports[0].layer, layer::screen);
+    EXPECT_EQ(reports[0].calls, 4);
+    EXPECT_EQ(reports[0].draw_calls, 1);
+    EXPECT_EQ(reports[0].primitives, 2);
+    EXPECT_EQ(reports[1].id, 2);
+    EXPECT_EQ(reports[1].calls, 2);
+    EXPECT_EQ(reports[1].draw_calls, 1);
+
+    ASSERT_EQ(device.draws().size(), 2);
+    EXPECT_TRUE(device.draws()[0].rasterized);
+    EXPECT_TRUE(device.draws()[1].rasterized);
+
+    auto const expected = frame.device.image();
+    auto const actual   = device.image();
+    ASSERT_EQ(actual.size(), expected.size());
+    for (auto i = std::size_t{}; i < actual.size(); ++i)
+    {
+        EXPECT_EQ(std::uint32_t{actual[i]}, std::uint32_t{expected[i]})
+            << "pixel " << i;
+    }
+
+    // The second window is clipped to the bottom right quarter.
+    EXPECT_EQ(std::uint32_t{actual[3 * 8 + 3]}, std::uint32_t{red});
+    EXPECT_EQ(std::uint32_t{actual[5 * 8 + 5]}, std::uint32_t{blue});
+}
+
+TEST(frame_capture, rejects_damaged_files)
+{
+    EXPECT_FALSE(frame_capture::load(temporary("frame_capture_missing.uic")));
+
+    recorded_frame const frame;
+    auto const path = temporary("frame_capture_damaged.uic");
+    ASSERT_TRUE(frame.capture.save(path));
+    auto const size = std::filesystem::file_size(path);
+
+    // Every truncation loses a field the loader needs.
+    for (auto length = std::uintmax_t{}; length < size; length += 7)
+    {
+        std::filesystem::resize_file(path, length);
+        EXPECT_FALSE(frame_capture::load(path)) << "length " << length;
+        ASSERT_TRUE(frame.capture.save(path));
+    }
+
+    std::ofstream{path, std::ios::binary | std::ios::trunc} << "not a capture";
+    EXPECT_FALSE(frame_capture::load(path));
+    std::filesystem::remove(path);
+}
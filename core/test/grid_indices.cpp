@@ -0,0 +1,228 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ui/grid_indices.hpp"
+
+#include "ui/color.hpp"
+#include "ui/grid_vertices.hpp"
+#include "ui/headless_render_device.hpp"
+#include "ui/render_device.hpp"
+#include "ui/transform.hpp"
+#include "ui/vector.hpp"
+#include "ui/vertex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+using namespace windower::ui;
+
+using triangle = std::array<std::uint16_t, 3>;
+
+// The triangles of a list, each rotated to start at its lowest index so
+// that the winding is kept, in sorted order.
+std::vector<triangle> triangles(std::span<std::uint16_t const> indices)
+{
+    std::vector<triangle> result;
+    for (auto i = std::size_t{}; i + 2 < indices.size(); i += 3)
+    {
+        triangle t{indices[i], indices[i + 1], indices[i + 2]};
+        std::ranges::rotate(t, std::ranges::min_element(t));
+        result.push_back(t);
+    }
+    std::ranges::sort(result);
+    return result;
+}
+
+// The lists the primitives were written with before they shared a grid.
+constexpr std::array<std::uint16_t, 6> rectangle_indices{0, 1, 2, 3, 2, 1};
+
+constexpr std::array<std::uint16_t, 18> h_patch_indices{
+    0, 1, 4, 4, 1, 5, 1, 2, 5, 5, 2, 6, 2, 3, 6, 6, 3, 7};
+
+constexpr std::array<std::uint16_t, 18> v_patch_indices{
+    0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5, 4, 5, 6, 6, 5, 7};
+
+constexpr std::array<std::uint16_t, 54> nine_patch_indices{
+    0, 1, 4,  4,  1, 5,  1, 2,  5,  5,  2,  6,  2,  3,  6,  6,  3,  7,
+    4, 5, 8,  8,  5, 9,  5, 6,  9,  9,  6,  10, 6,  7,  10, 10, 7,  11,
+    8, 9, 12, 12, 9, 13, 9, 10, 13, 13, 10, 14, 10, 11, 14, 14, 11, 15};
+
+// Vertices on an uneven grid, laid out row by row.
+template<std::size_t Columns, std::size_t Rows>
+std::array<vertex, Columns * Rows> grid(
+    std::array<float, Columns> const& xs, std::array<float, Rows> const& ys)
+{
+    std::array<vertex, Columns * Rows> result{};
+    for (auto row = std::size_t{}; row < Rows; ++row)
+    {
+        for (auto column = std::size_t{}; column < Columns; ++column)
+        {
+            auto const c = color{
+                std::uint8_t(column * 60), std::uint8_t(row * 60), 255};
+            result[row * Columns + column] = {
+                xs[column], ys[row], 0.f, 1.f, 0.f, 0.f, c};
+        }
+    }
+    return result;
+}
+
+std::vector<std::uint32_t> render(
+    std::span<vertex const> vertices, std::span<std::uint16_t const> indices)
+{
+    constexpr auto vertex_buffer = vertex_buffer_handle{1};
+    constexpr auto index_buffer  = index_buffer_handle{1};
+
+    headless_render_device device{32, 32};
+    device.bind(vertex_buffer, vertices);
+    device.bind(index_buffer, indices);
+    device.set_vertex_buffer(vertex_buffer);
+    device.set_index_buffer(index_buffer);
+    device.draw_indexed(
+        primitive_type::triangle_list, 0,
+        static_cast<std::uint32_t>(vertices.size()), 0,
+        static_cast<std::uint32_t>(indices.size() / 3));
+
+    std::vector<std::uint32_t> image;
+    for (auto const& pixel : device.image())
+    {
+        image.push_back(std::uint32_t{pixel});
+    }
+    return image;
+}
+
+// Both lists are drawn with culling on, so a triangle wound the wrong way
+// would leave a hole in one of the images.
+template<std::size_t Columns, std::size_t Rows, std::size_t Count>
+void expect_same_image(
+    std::array<float, Columns> const& xs, std::array<float, Rows> const& ys,
+    std::array<std::uint16_t, Count> const& hand_written)
+{
+    constexpr auto indices = grid_indices<Columns, Rows>();
+    static_assert(indices.size() == Count);
+
+    auto const vertices = grid(xs, ys);
+    auto const expected = render(vertices, hand_written);
+    EXPECT_LT(std::ranges::count(expected, 0u), expected.size());
+    EXPECT_EQ(render(vertices, indices), expected);
+}
+
+}
+
+TEST(grid_indices, matches_the_hand_written_lists)
+{
+    constexpr auto rectangle = grid_indices<2, 2>();
+    constexpr auto h_patch   = grid_indices<4, 2>();
+    constexpr auto v_patch   = grid_indices<2, 4>();
+    constexpr auto nine      = grid_indices<4, 4>();
+
+    EXPECT_EQ(triangles(rectangle), triangles(rectangle_indices));
+    EXPECT_EQ(triangles(h_patch), triangles(h_patch_indices));
+    EXPECT_EQ(triangles(v_patch), triangles(v_patch_indices));
+    EXPECT_EQ(triangles(nine), triangles(nine_patch_indices));
+}
+
+TEST(grid_indices, covers_every_cell_clockwise)
+{
+    constexpr auto columns = std::size_t{5};
+    constexpr auto rows    = std::size_t{3};
+    constexpr auto indices = grid_indices<columns, rows>();
+    auto const vertices = grid<columns, rows>({0, 1, 3, 6, 10}, {0, 2, 5});
+
+    auto area = 0.f;
+    for (auto const& t : triangles(indices))
+    {
+        for (auto const index : t)
+        {
+            ASSERT_LT(index, columns * rows);
+        }
+
+        // Positive with y pointing down means clockwise on screen.
+        auto const& a = vertices[t[0]];
+        auto const& b = vertices[t[1]];
+        auto const& c = vertices[t[2]];
+        auto const twice_area =
+            (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        EXPECT_GT(twice_area, 0.f);
+        area += twice_area / 2;
+    }
+    EXPECT_EQ(area, 10.f * 5.f);
+
+    auto const unique = triangles(indices);
+    EXPECT_EQ(std::ranges::adjacent_find(unique), unique.end());
+    EXPECT_EQ(unique.size(), (columns - 1) * (rows - 1) * 2);
+}
+
+TEST(grid_indices, renders_like_the_hand_written_lists)
+{
+    expect_same_image(
+        std::array{3.5f, 17.5f}, std::array{4.5f, 25.5f}, rectangle_indices);
+    expect_same_image(
+        std::array{.5f, 3.5f, 26.5f, 31.5f}, std::array{2.5f, 29.5f},
+        h_patch_indices);
+    expect_same_image(
+        std::array{6.5f, 21.5f}, std::array{.5f, 8.5f, 12.5f, 30.5f},
+        v_patch_indices);
+    expect_same_image(
+        std::array{1.5f, 4.5f, 20.5f, 30.5f},
+        std::array{.5f, 7.5f, 9.5f, 31.5f}, nine_patch_indices);
+}
+
+TEST(grid_vertices, transforms_every_corner)
+{
+    constexpr auto xs = std::array{0.f, 3.f, 17.f, 20.f};
+    constexpr auto ys = std::array{0.f, 4.f, 8.f, 12.f};
+    constexpr auto us = std::array{0.f, .25f, .75f, 1.f};
+    constexpr auto vs = std::array{0.f, .5f, .5f, 1.f};
+    constexpr auto c  = color{10, 20, 30, 40};
+
+    auto const t = transform::rotation(.3f, 5.f, 2.f) *
+                   transform::shear(.2f, 0.f) * transform::scale(1.5f, 2.f);
+    auto const vertices =
+        grid_vertices<4, 4>(t, 7.f, -3.f, xs, ys, us, vs, .25f, 7.5f, c);
+
+    for (auto row = std::size_t{}; row < 4; ++row)
+    {
+        for (auto column = std::size_t{}; column < 4; ++column)
+        {
+            auto const& v = vertices[row * 4 + column];
+            auto const p  = t * vector{xs[column], ys[row]};
+            EXPECT_FLOAT_EQ(v.x, p.x + 7.f);
+            EXPECT_FLOAT_EQ(v.y, p.y - 3.f);
+            EXPECT_EQ(v.z, .25f);
+            EXPECT_EQ(v.rhw, 7.5f);
+            EXPECT_EQ(v.u, us[column]);
+            EXPECT_EQ(v.v, vs[row]);
+            EXPECT_EQ(std::uint32_t{v.color}, std::uint32_t{c});
+        }
+    }
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "ui/headless_render_device.hpp"
+
+#include "ui/color.hpp"
+#include "ui/render_device.hpp"
+#include "ui/vertex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+
+using namespace windower::ui;
+
+constexpr auto vertices = vertex_buffer_handle{1};
+constexpr auto indices  = index_buffer_handle{1};
+
+// Two clockwise triangles covering the pixels from (x0, y0) up to, but not
+// including, (x1, y1). Pixel centres lie on integer coordinates, so the
+// corners sit half a pixel outside them.
+std::array<vertex, 4> quad(
+    float x0, float y0, float x1, float y1, color c, float u0 = 0.f,
+    float v0 = 0.f, float u1 = 1.f, float v1 = 1.f)
+{
+    return {
+        vertex{x0 - .5f, y0 - .5f, 0.f, 1.f, u0, v0, c},
+        vertex{x1 - .5f, y0 - .5f, 0.f, 1.f, u1, v0, c},
+        vertex{x0 - .5f, y1 - .5f, 0.f, 1.f, u0, v1, c},
+        vertex{x1 - .5f, y1 - .5f, 0.f, 1.f, u1, v1, c}};
+}
+
+constexpr std::array<std::uint16_t, 6> clockwise         = {0, 1, 2, 2, 1, 3};
+constexpr std::array<std::uint16_t, 6> counter_clockwise = {0, 2, 1, 2, 3, 1};
+
+std::uint32_t pixel(headless_render_device const& device, int x, int y)
+{
+    auto const image = device.image();
+    return std::uint32_t{image[std::size_t(y) * device.width() + x]};
+}
+
+std::size_t count(headless_render_device const& device, color c)
+{
+    auto result = std::size_t{};
+    for (auto const& p : device.image())
+    {
+        result += std::uint32_t{p} == std::uint32_t{c};
+    }
+    return result;
+}
+
+void draw(
+    headless_render_device& device, std::array<vertex, 4> const& corners,
+    std::array<std::uint16_t, 6> const& order = clockwise)
+{
+    device.bind(vertices, corners);
+    device.bind(indices, order);
+    device.set_vertex_buffer(vertices);
+    device.set_index_buffer(indices);
+    device.draw_indexed(primitive_type::triangle_list, 0, 4, 0, 2);
+}
+
+}
+
+TEST(headless_render_device, fills_covered_pixels)
+{
+    headless_render_device device{8, 8};
+    auto const red = color{255, 0, 0};
+    draw(device, quad(2, 3, 6, 5, red));
+
+    EXPECT_EQ(count(device, red), 4 * 2);
+    EXPECT_EQ(pixel(device, 2, 3), std::uint32_t{red});
+    EXPECT_EQ(pixel(device, 5, 4), std::uint32_t{red});
+    EXPECT_EQ(pixel(device, 6, 4), 0);
+    EXPECT_EQ(pixel(device, 2, 5), 0);
+
+    ASSERT_EQ(device.draws().size(), 1);
+    auto const& draw = device.draws()[0];
+    EXPECT_EQ(draw.type, primitive_type::triangle_list);
+    EXPECT_EQ(draw.vertex_buffer, vertices);
+    EXPECT_EQ(draw.index_buffer, indices);
+    EXPECT_EQ(draw.primitive_count, 2);
+    EXPECT_TRUE(draw.rasterized);
+}
+
+TEST(headless_render_device, culls_counter_clockwise_triangles)
+{
+    headless_render_device device{8, 8};
+    draw(device, quad(0, 0, 8, 8, colors::white), counter_clockwise);
+    EXPECT_EQ(count(device, colors::transparent), 64);
+}
+
+TEST(headless_render_device, clips_to_the_viewport)
+{
+    headless_render_device device{8, 8};
+    device.set_clip({1, 2, 3, 4});
+    draw(device, quad(0, 0, 8, 8, colors::white));
+
+    EXPECT_EQ(count(device, colors::white), 3 * 4);
+    EXPECT_EQ(pixel(device, 1, 2), std::uint32_t{colors::white});
+    EXPECT_EQ(pixel(device, 3, 5), std::uint32_t{colors::white});
+    EXPECT_EQ(pixel(device, 4, 5), 0);
+    EXPECT_EQ(device.draws()[0].clip.width, 3);
+}
+
+TEST(headless_render_device, blends_premultiplied_colours)
+{
+    headless_render_device device{4, 4};
+    device.clear({0, 0, 200, 255});
+    draw(device, quad(0, 0, 4, 4, {100, 0, 0, 128}));
+
+    // 100 + 0 * 127 / 255, 0, 200 * 127 / 255, 128 + 255 * 127 / 255
+    EXPECT_EQ(pixel(device, 1, 1), std::uint32_t(color{100, 0, 100, 255}));
+}
+
+TEST(headless_render_device, masks_limit_later_draws)
+{
+    headless_render_device device{8, 8};
+    device.begin_mask();
+    draw(device, quad(0, 0, 4, 8, colors::white));
+    draw(device, quad(0, 0, 8, 8, {255, 255, 255, 100}));
+    EXPECT_EQ(count(device, colors::transparent), 64);
+
+    device.apply_mask();
+    draw(device, quad(0, 0, 8, 8, colors::white));
+    device.end_mask();
+
+    EXPECT_EQ(count(device, colors::white), 4 * 8);
+    EXPECT_EQ(pixel(device, 4, 0), 0);
+    EXPECT_TRUE(device.draws()[2].masked);
+    EXPECT_TRUE(device.draws()[2].rasterized);
+}
+
+TEST(headless_render_device, samples_bound_textures)
+{
+    headless_render_device device{4, 4};
+    std::vector<color> const texels = {
+        colors::white, {255, 0, 0}, {0, 255, 0}, {0, 0, 255}};
+    auto const texture = texture_handle{7};
+    device.bind(texture, {2, 2, texels});
+    EXPECT_EQ(device.extent(texture).width, 2);
+    EXPECT_EQ(device.extent(texture_handle{8}).width, 0);
+
+    device.set_texture(texture);
+    draw(device, quad(0, 0, 4, 4, colors::white));
+
+    EXPECT_EQ(pixel(device, 0, 0), std::uint32_t{colors::white});
+    EXPECT_EQ(pixel(device, 3, 0), std::uint32_t(color{255, 0, 0}));
+    EXPECT_EQ(pixel(device, 0, 3), std::uint32_t(color{0, 255, 0}));
+    EXPECT_EQ(pixel(device, 3, 3), std::uint32_t(color{0, 0, 255}));
+}
+
+TEST(headless_render_device, logs_draws_it_cannot_rasterize)
+{
+    headless_render_device device{4, 4};
+    device.set_vertex_buffer(vertex_buffer_handle{9});
+    device.set_index_buffer(indices);
+    device.draw_indexed(primitive_type::triangle_list, 0, 4, 0, 2);
+    device.draw_indexed(primitive_type::line_strip, 0, 4, 0, 3);
+
+    ASSERT_EQ(device.draws().size(), 2);
+    EXPECT_FALSE(device.draws()[0].rasterized);
+    EXPECT_EQ(device.draws()[1].type, primitive_type::line_strip);
+    EXPECT_EQ(count(device, colors::transparent), 16);
+
+    device.clear();
+    EXPECT_TRUE(device.draws().empty());
+}
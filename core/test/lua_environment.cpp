@@ -0,0 +1,124 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "lua_environment.hpp"
+
+#include "addon/error.hpp"
+#include "addon/lua.hpp"
+#include "addon/lua_internal.hpp"
+#include "addon/modules/class.hpp"
+#include "addon/modules/serializer.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+// Both serializers register these as resources. LuaJIT only provides some of
+// them when built with Lua 5.2 compatibility, and the coroutine functions
+// come from the script scheduler, so missing ones get distinct stand-ins.
+constexpr std::u8string_view placeholders = u8R"(
+for _, path in ipairs({
+    'rawlen', 'coroutine.isyieldable', 'coroutine.sleep',
+    'coroutine.sleep_frame', 'coroutine.schedule', 'debug.getuservalue',
+    'debug.setuservalue', 'debug.upvalueid', 'debug.upvaluejoin', 'jit.util',
+    'package.searchers', 'package.searchpath', 'table.clear', 'table.move',
+    'table.new', 'table.pack', 'table.unpack',
+}) do
+    local parent, key = _G, nil
+    for name in path:gmatch('[^.]+') do
+        if key ~= nil then parent = parent[key] end
+        key = name
+    end
+    if parent[key] == nil then
+        parent[key] = function() error(path .. ' is not available') end
+    end
+end
+)";
+
+std::filesystem::path script_path(std::u8string_view name)
+{
+    return std::filesystem::path{WINDOWER_TEST_SCRIPTS} / name;
+}
+
+int load_reference_serializer_module(windower::lua::state s)
+{
+    using namespace windower;
+
+    lua::stack_guard guard{s};
+
+    std::ifstream stream{
+        script_path(u8"serializer_reference.lua"), std::ios::binary};
+    lua::load(guard, stream, u8"core.serializer.reference");
+    lua::call(guard, 0);
+
+    return guard.release();
+}
+
+}
+
+windower::lua::interpreter windower::test::create_serializer_interpreter()
+{
+    lua::interpreter interpreter;
+
+    lua::load(interpreter, lua::lib::package);
+    lua::load(interpreter, lua::lib::math);
+    lua::load(interpreter, lua::lib::string);
+    lua::load(interpreter, lua::lib::table);
+    lua::load(interpreter, lua::lib::io);
+    lua::load(interpreter, lua::lib::os);
+    lua::load(interpreter, lua::lib::debug);
+    lua::load(interpreter, lua::lib::bit);
+    lua::load(interpreter, lua::lib::jit);
+    lua::load(interpreter, lua::lib::ffi);
+
+    lua::preload(interpreter, u8"core.class", load_class_module);
+    lua::preload(interpreter, u8"core.serializer", load_serializer_module);
+    lua::preload(
+        interpreter, u8"core.serializer.reference",
+        ::load_reference_serializer_module);
+
+    lua::stack_guard guard{interpreter};
+    lua::load(guard, placeholders, u8"placeholders");
+    lua::call(guard, 0);
+
+    return interpreter;
+}
+
+void windower::test::run_script(
+    lua::interpreter const& interpreter, std::u8string_view name)
+{
+    lua::stack_guard guard{interpreter};
+
+    std::ifstream stream{::script_path(name), std::ios::binary};
+    if (!stream)
+    {
+        throw lua::error{"cannot open " + script_path(name).string()};
+    }
+    lua::load(guard, stream, std::u8string{name}.c_str());
+    lua::call(guard, 0);
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_TEST_LUA_ENVIRONMENT_HPP
+#define WINDOWER_TEST_LUA_ENVIRONMENT_HPP
+#pragma once
+
+#include "addon/lua_internal.hpp"
+
+#include <string_view>
+
+namespace windower::test
+{
+
+// Creates an interpreter with what core.serializer needs from a script's
+// environment: the standard libraries, placeholders for the functions the
+// script host adds, and core.class and core.serializer preloaded. The pure
+// Lua implementation the native serializer replaced is preloaded as
+// core.serializer.reference.
+lua::interpreter create_serializer_interpreter();
+
+// Runs a file from core/test/scripts. Errors are thrown as lua::error.
+void run_script(lua::interpreter const&, std::u8string_view name);
+
+}
+
+#endif
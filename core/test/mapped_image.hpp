@@ -0,0 +1,153 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WINDOWER_TEST_MAPPED_IMAGE_HPP
+#define WINDOWER_TEST_MAPPED_IMAGE_HPP
+#pragma once
+
+#include "pe_image.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace windower::test
+{
+
+struct section_spec
+{
+    std::uint32_t virtual_address;
+    std::uint32_t virtual_size;
+    bool executable;
+};
+
+constexpr std::uint32_t headers_size = 0x400;
+
+template<typename T>
+void put(std::vector<std::byte>& bytes, std::size_t offset, T value)
+{
+    std::memcpy(bytes.data() + offset, &value, sizeof value);
+}
+
+// Writes the DOS, NT and section headers of a 32-bit image. Raw data of each
+// section is placed at raw_offsets[i].
+inline void write_headers(
+    std::vector<std::byte>& bytes, std::uint32_t image_size,
+    std::span<section_spec const> sections,
+    std::span<std::uint32_t const> raw_offsets,
+    std::span<std::uint32_t const> raw_sizes)
+{
+    constexpr auto nt       = std::size_t{0x80};
+    constexpr auto optional = nt + 4 + 20;
+    constexpr auto table    = optional + 0xE0;
+
+    put<std::uint16_t>(bytes, 0, 0x5A4D);
+    put<std::uint32_t>(bytes, 0x3C, nt);
+    put<std::uint32_t>(bytes, nt, 0x00004550);
+    put<std::uint16_t>(bytes, nt + 4, 0x014C);
+    put<std::uint16_t>(bytes, nt + 6, sections.size());
+    put<std::uint32_t>(bytes, nt + 8, 0x5EED1234);
+    put<std::uint16_t>(bytes, nt + 20, 0xE0);
+    put<std::uint16_t>(bytes, optional, 0x010B);
+    put<std::uint32_t>(bytes, optional + 56, image_size);
+    put<std::uint32_t>(bytes, optional + 60, headers_size);
+    for (auto i = std::size_t{}; i < sections.size(); ++i)
+    {
+        auto const entry = table + i * 40;
+        put<std::uint32_t>(bytes, entry + 8, sections[i].virtual_size);
+        put<std::uint32_t>(bytes, entry + 12, sections[i].virtual_address);
+        put<std::uint32_t>(bytes, entry + 16, raw_sizes[i]);
+        put<std::uint32_t>(bytes, entry + 20, raw_offsets[i]);
+        put<std::uint32_t>(
+            bytes, entry + 36,
+            sections[i].executable ? 0x60000020 : 0xC0000040);
+    }
+}
+
+// An image laid out at its virtual addresses, as the loader would map it.
+class mapped_image
+{
+public:
+    mapped_image(std::vector<section_spec> sections, std::mt19937& engine) :
+        m_sections{std::move(sections)}
+    {
+        auto image_size = headers_size;
+        for (auto const& section : m_sections)
+        {
+            image_size = std::max(
+                image_size, section.virtual_address + section.virtual_size);
+        }
+        m_bytes.resize(image_size);
+
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> sizes;
+        for (auto const& section : m_sections)
+        {
+            offsets.push_back(section.virtual_address);
+            sizes.push_back(section.virtual_size);
+            fill_code(engine, section);
+        }
+        write_headers(m_bytes, image_size, m_sections, offsets, sizes);
+        m_image = pe_image{m_bytes.data()};
+    }
+
+    pe_image const& image() const noexcept { return m_image; }
+
+    std::span<section_spec const> sections() const noexcept
+    {
+        return m_sections;
+    }
+
+    std::span<std::byte> bytes() noexcept { return m_bytes; }
+
+private:
+    std::vector<section_spec> m_sections;
+    std::vector<std::byte> m_bytes;
+    pe_image m_image;
+
+    // Skews the bytes towards common x86 opcodes, which is where a matcher
+    // that anchors on rare bytes has to work hardest.
+    void fill_code(std::mt19937& engine, section_spec const& section)
+    {
+        static constexpr std::byte common[] = {
+            std::byte{0x00}, std::byte{0x8B}, std::byte{0x55},
+            std::byte{0xFF}, std::byte{0x89}, std::byte{0xE8}};
+        for (auto i = std::size_t{}; i < section.virtual_size; ++i)
+        {
+            m_bytes[section.virtual_address + i] =
+                engine() % 2 == 0 ? common[engine() % std::size(common)]
+                                  : std::byte(engine() % 8);
+        }
+    }
+};
+
+}
+
+#endif
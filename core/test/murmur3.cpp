@@ -0,0 +1,110 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "murmur3.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+std::span<std::byte const> bytes(std::string_view str) noexcept
+{
+    return std::as_bytes(std::span{str});
+}
+
+std::uint32_t hash(std::string_view str, std::uint32_t seed) noexcept
+{
+    return windower::murmur3::hash(bytes(str), seed);
+}
+
+}
+
+TEST(murmur3, reference_vectors)
+{
+    using namespace std::string_view_literals;
+
+    EXPECT_EQ(hash(""sv, 0), 0x00000000);
+    EXPECT_EQ(hash(""sv, 1), 0x514E28B7);
+    EXPECT_EQ(hash(""sv, 0xFFFFFFFF), 0x81F16F39);
+    EXPECT_EQ(hash("\0\0\0\0"sv, 0), 0x2362F9DE);
+    EXPECT_EQ(hash("aaaa"sv, 0x9747B28C), 0x5A97808A);
+    EXPECT_EQ(hash("aaa"sv, 0x9747B28C), 0x283E0130);
+    EXPECT_EQ(hash("aa"sv, 0x9747B28C), 0x5D211726);
+    EXPECT_EQ(hash("a"sv, 0x9747B28C), 0x7FA09EA6);
+    EXPECT_EQ(hash("Hello, world!"sv, 0x9747B28C), 0x24884CBA);
+    EXPECT_EQ(
+        hash("The quick brown fox jumps over the lazy dog"sv, 0x9747B28C),
+        0x2FA826CD);
+}
+
+TEST(murmur3, stream_matches_one_shot_for_every_split)
+{
+    std::mt19937 engine{1};
+    std::uniform_int_distribution<int> distribution{0, 255};
+
+    for (std::size_t size = 0; size <= 67; ++size)
+    {
+        std::vector<std::byte> data(size);
+        for (auto& b : data)
+        {
+            b = std::byte(distribution(engine));
+        }
+        auto const seed     = static_cast<std::uint32_t>(engine());
+        auto const expected = windower::murmur3::hash(data, seed);
+
+        for (std::size_t first = 0; first <= size; ++first)
+        {
+            for (std::size_t second = first; second <= size; ++second)
+            {
+                windower::murmur3 state;
+                state.reset(seed);
+                state.update(std::span{data}.first(first));
+                state.update(std::span{data}.subspan(first, second - first));
+                state.update(std::span{data}.subspan(second));
+                ASSERT_EQ(state.digest(), expected)
+                    << "size " << size << ", split " << first << '/'
+                    << second;
+            }
+        }
+    }
+}
+
+TEST(murmur3, reset_discards_previous_input)
+{
+    windower::murmur3 state;
+    state.reset(7);
+    state.update(bytes("discarded"));
+    state.reset(7);
+    state.update(bytes("kept"));
+    EXPECT_EQ(state.digest(), hash("kept", 7));
+}
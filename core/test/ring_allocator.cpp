@@ -0,0 +1,227 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "ui/ring_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+using windower::ui::ring_allocator;
+
+// Stands in for a dynamic buffer. Each element remembers which write put it
+// there, so a test can tell whether data was lost before it was drawn.
+using fake_ring = std::shared_ptr<std::vector<std::uint32_t>>;
+
+// Mimics the device side of data_buffer: every write locks a reservation,
+// and the frame's draws only read the rings once the frame is rendered.
+// Discarding a ring hands back fresh memory, which loses whatever the
+// frame's pending draws wrote there.
+class fake_device
+{
+public:
+    explicit fake_device(std::size_t capacity) : allocator{capacity} {}
+
+    ring_allocator<fake_ring> allocator;
+    std::size_t rings_created = 0;
+    std::size_t discards      = 0;
+
+    void begin_frame()
+    {
+        allocator.begin_frame();
+        m_draws.clear();
+    }
+
+    void write(std::size_t count)
+    {
+        auto const next =
+            allocator.reserve(count, [this](std::size_t capacity) {
+                ++rings_created;
+                return std::make_shared<std::vector<std::uint32_t>>(capacity);
+            });
+        ASSERT_GE(next.count, count);
+        ASSERT_EQ(next.offset + next.count, allocator.capacity());
+
+        auto& contents = **next.ring;
+        if (next.discard)
+        {
+            ++discards;
+            std::ranges::fill(contents, 0);
+        }
+        for (auto i = std::size_t{}; i < count; ++i)
+        {
+            contents[next.offset + i] = m_serial + i;
+        }
+        m_draws.push_back({*next.ring, next.offset, count, m_serial});
+        m_serial += static_cast<std::uint32_t>(count);
+        allocator.commit(count);
+    }
+
+    // Checks that every write of the frame is still intact when drawn.
+    void render() const
+    {
+        for (auto const& draw : m_draws)
+        {
+            for (auto i = std::size_t{}; i < draw.count; ++i)
+            {
+                ASSERT_EQ((*draw.ring)[draw.offset + i], draw.first + i)
+                    << "offset " << draw.offset + i;
+            }
+        }
+    }
+
+private:
+    class draw
+    {
+    public:
+        fake_ring ring;
+        std::size_t offset;
+        std::size_t count;
+        std::uint32_t first;
+    };
+
+    std::vector<draw> m_draws;
+    std::uint32_t m_serial = 1;
+};
+
+}
+
+TEST(ring_allocator, appends_across_frames)
+{
+    fake_device device{100};
+    for (auto frame = 0; frame < 3; ++frame)
+    {
+        device.begin_frame();
+        device.write(10);
+        device.write(20);
+        device.render();
+    }
+
+    EXPECT_EQ(device.rings_created, 1);
+    EXPECT_EQ(device.discards, 1);
+    EXPECT_EQ(device.allocator.statistics().used, 30);
+    EXPECT_EQ(device.allocator.statistics().wraps, 0);
+}
+
+TEST(ring_allocator, wrap_discards_a_ring_the_frame_has_not_used)
+{
+    fake_device device{100};
+    device.begin_frame();
+    device.write(90);
+    device.render();
+
+    device.begin_frame();
+    device.write(20);
+    device.render();
+
+    EXPECT_EQ(device.rings_created, 1);
+    EXPECT_EQ(device.discards, 2);
+    EXPECT_EQ(device.allocator.statistics().wraps, 1);
+    EXPECT_EQ(device.allocator.statistics().stalls, 0);
+}
+
+TEST(ring_allocator, wrap_within_a_frame_stalls_to_the_next_ring)
+{
+    fake_device device{100};
+    device.begin_frame();
+    device.write(60);
+    device.write(60);
+    device.write(60);
+    device.render();
+
+    EXPECT_EQ(device.rings_created, 3);
+    EXPECT_EQ(device.allocator.statistics().wraps, 2);
+    EXPECT_EQ(device.allocator.statistics().stalls, 2);
+    EXPECT_EQ(device.allocator.statistics().rings, 3);
+
+    // The pool now covers a frame of that size without growing.
+    device.begin_frame();
+    device.write(60);
+    device.write(60);
+    device.write(60);
+    device.render();
+
+    EXPECT_EQ(device.rings_created, 3);
+    EXPECT_EQ(device.allocator.statistics().rings, 3);
+}
+
+TEST(ring_allocator, reset_starts_a_new_pool)
+{
+    fake_device device{100};
+    device.begin_frame();
+    device.write(60);
+    device.write(60);
+    device.render();
+
+    device.allocator.reset(200);
+    device.begin_frame();
+    device.write(150);
+    device.render();
+
+    EXPECT_EQ(device.allocator.capacity(), 200);
+    EXPECT_EQ(device.rings_created, 3);
+    EXPECT_EQ(device.allocator.statistics().rings, 1);
+}
+
+TEST(ring_allocator, random_frames_never_lose_pending_data)
+{
+    std::mt19937 engine{1};
+    for (auto const capacity : {16, 100, 1024})
+    {
+        fake_device device{static_cast<std::size_t>(capacity)};
+        std::uniform_int_distribution<std::size_t> size{
+            1, device.allocator.capacity()};
+        std::uniform_int_distribution<std::size_t> writes{0, 12};
+        auto most_writes = std::size_t{};
+        for (auto frame = 0; frame < 2000; ++frame)
+        {
+            device.begin_frame();
+            auto const count = writes(engine);
+            for (auto write = std::size_t{}; write < count; ++write)
+            {
+                device.write(size(engine));
+            }
+            device.render();
+            if (HasFatalFailure())
+            {
+                return;
+            }
+
+            // Every write opens at most one more ring, and the pool keeps
+            // every ring it created.
+            auto const& statistics = device.allocator.statistics();
+            most_writes = std::max(most_writes, count);
+            EXPECT_LE(statistics.stalls, statistics.wraps);
+            EXPECT_LE(device.rings_created, most_writes + 1);
+            EXPECT_EQ(statistics.rings, device.rings_created);
+        }
+    }
+}
@@ -0,0 +1,315 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mapped_image.hpp"
+
+#include "errors/syntax_error.hpp"
+#include "pe_image.hpp"
+#include "scanner.hpp"
+#include "utility.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+using windower::pe_image;
+using windower::signature;
+using windower::test::headers_size;
+using windower::test::mapped_image;
+using windower::test::section_spec;
+using windower::test::write_headers;
+
+std::uint32_t random_size(std::mt19937& engine, std::uint32_t max)
+{
+    return 1 + static_cast<std::uint32_t>(engine() % max);
+}
+
+// Every match in the executable sections, in address order.
+std::vector<std::uint32_t>
+brute_force(pe_image const& image, signature const& sig)
+{
+    std::vector<std::uint32_t> result;
+    for (auto const& section : image.sections())
+    {
+        auto const data = image.section_data(section);
+        if (!section.executable() || data.size() < sig.size())
+        {
+            continue;
+        }
+        for (auto i = std::size_t{}; i + sig.size() <= data.size(); ++i)
+        {
+            auto match = true;
+            for (auto j = std::size_t{}; match && j < sig.size(); ++j)
+            {
+                match = (data[i + j] & sig.mask()[j]) == sig.data()[j];
+            }
+            if (match)
+            {
+                result.push_back(
+                    section.virtual_address + static_cast<std::uint32_t>(i));
+            }
+        }
+    }
+    return result;
+}
+
+// Builds a signature from bytes of the image, or random bytes, with random
+// wildcards anywhere but the last byte.
+signature random_signature(std::mt19937& engine, std::span<std::byte> bytes)
+{
+    auto const size = 1 + engine() % (signature::max_size - 1);
+    auto const from = engine() % 2 == 0 && bytes.size() > headers_size + size
+                        ? headers_size +
+                              engine() % (bytes.size() - headers_size - size)
+                        : bytes.size();
+
+    std::u8string string;
+    for (auto i = std::size_t{}; i < size; ++i)
+    {
+        if (i + 1 < size && engine() % 5 == 0)
+        {
+            string += u8"??";
+            continue;
+        }
+        auto const value = from < bytes.size()
+                             ? std::to_integer<unsigned>(bytes[from + i])
+                             : engine() % 8;
+        constexpr char8_t digits[] = u8"0123456789ABCDEF";
+        string += digits[value >> 4];
+        string += digits[value & 0xF];
+    }
+    return signature{string};
+}
+
+}
+
+TEST(scanner, locate_matches_brute_force)
+{
+    std::mt19937 engine{1};
+    for (auto i = 0; i < 300; ++i)
+    {
+        mapped_image image{
+            {{0x1000, random_size(engine, 0x3000), true},
+             {0x5000, random_size(engine, 0x1000), false},
+             {0x7000, random_size(engine, 0x800), true}},
+            engine};
+        for (auto j = 0; j < 20; ++j)
+        {
+            auto const sig      = random_signature(engine, image.bytes());
+            auto const expected = brute_force(image.image(), sig);
+
+            std::vector<std::uint32_t> rvas(1 + engine() % 8);
+            auto const count = windower::locate(image.image(), sig, rvas);
+            ASSERT_EQ(count, std::min(rvas.size(), expected.size()))
+                << "image " << i << " signature " << j;
+            ASSERT_TRUE(std::equal(
+                rvas.begin(), rvas.begin() + count, expected.begin()))
+                << "image " << i << " signature " << j;
+
+            for (auto const rva : expected)
+            {
+                ASSERT_TRUE(windower::matches(image.image(), rva, sig));
+            }
+        }
+    }
+}
+
+TEST(scanner, locate_all_finds_each_first_match)
+{
+    std::mt19937 engine{2};
+    for (auto i = 0; i < 100; ++i)
+    {
+        mapped_image image{
+            {{0x1000, random_size(engine, 0x4000), true},
+             {0x6000, random_size(engine, 0x1000), true}},
+            engine};
+
+        std::vector<signature> signatures;
+        for (auto j = 0; j < 24; ++j)
+        {
+            signatures.push_back(random_signature(engine, image.bytes()));
+        }
+        std::vector<signature const*> pointers;
+        for (auto const& sig : signatures)
+        {
+            pointers.push_back(&sig);
+        }
+        std::vector<std::optional<std::uint32_t>> rvas(signatures.size());
+        windower::locate_all(image.image(), pointers, rvas);
+
+        for (auto j = std::size_t{}; j < signatures.size(); ++j)
+        {
+            auto const expected = brute_force(image.image(), signatures[j]);
+            if (expected.empty())
+            {
+                ASSERT_FALSE(rvas[j]) << "image " << i << " signature " << j;
+            }
+            else
+            {
+                ASSERT_EQ(rvas[j], expected.front())
+                    << "image " << i << " signature " << j;
+            }
+        }
+    }
+}
+
+// Images with more than 4 MiB of code are searched in parallel chunks, so
+// matches must come back in address order across chunk boundaries.
+TEST(scanner, large_images_match_brute_force)
+{
+    std::mt19937 engine{3};
+    mapped_image image{
+        {{0x1000, 0x380000, true}, {0x400000, 0x180000, true}}, engine};
+    auto const bytes = image.bytes();
+    for (auto const boundary : {0x101000u - 3, 0x201000u - 1, 0x3FFFF0u})
+    {
+        constexpr unsigned char marker[] = {0xC7, 0x45, 0xFC, 0xF3, 0xA5};
+        std::memcpy(&bytes[boundary], marker, sizeof marker);
+    }
+
+    for (auto const& sig :
+         {signature{u8"C745FCF3A5"}, signature{u8"C7??FC"},
+          signature{u8"??????8B558B"}, signature{u8"FF8B8B"}})
+    {
+        auto const expected = brute_force(image.image(), sig);
+        std::vector<std::uint32_t> rvas(expected.size() + 1);
+        auto const count = windower::locate(image.image(), sig, rvas);
+        ASSERT_EQ(count, expected.size());
+        rvas.resize(count);
+        ASSERT_EQ(rvas, expected);
+
+        rvas.resize(std::min<std::size_t>(count, 3));
+        ASSERT_EQ(windower::locate(image.image(), sig, rvas), rvas.size());
+        ASSERT_TRUE(std::equal(rvas.begin(), rvas.end(), expected.begin()));
+    }
+}
+
+// A signature of wildcards alone has no byte to search for, so the grammar
+// requires at least one fixed byte. The search functions also treat such a
+// signature as never matching, but it cannot be constructed.
+TEST(scanner, wildcard_only_signatures_are_rejected)
+{
+    std::u8string longest;
+    for (auto i = std::size_t{}; i < signature::max_size; ++i)
+    {
+        longest += u8"??";
+    }
+
+    for (std::u8string_view const string :
+         {std::u8string_view{u8"??"}, std::u8string_view{u8"????????"},
+          std::u8string_view{u8"&??"}, std::u8string_view{u8"??*??"},
+          std::u8string_view{longest}})
+    {
+        EXPECT_THROW(signature{string}, windower::syntax_error)
+            << windower::to_string_view(string);
+    }
+    EXPECT_EQ(signature{u8"8B????55"}.size(), 4u);
+}
+
+// Writes the image in file layout, keeping only part of each section's data
+// so the loader has to zero-fill the rest, and loads it back.
+TEST(scanner, loaded_images_match_mapped_images)
+{
+    std::mt19937 engine{4};
+    mapped_image mapped{
+        {{0x1000, 0x2345, true},
+         {0x4000, 0x0800, false},
+         {0x5000, 0x1F00, true}},
+        engine};
+    auto const sections = mapped.sections();
+    auto const bytes    = mapped.bytes();
+
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> sizes;
+    auto file = std::vector<std::byte>(headers_size);
+    for (auto const& section : sections)
+    {
+        auto const size = section.virtual_size / 4 * 3;
+        offsets.push_back(static_cast<std::uint32_t>(file.size()));
+        sizes.push_back(size);
+        file.insert(
+            file.end(), bytes.begin() + section.virtual_address,
+            bytes.begin() + section.virtual_address + size);
+        file.resize((file.size() + 0x1FF) & ~std::size_t{0x1FF});
+    }
+    write_headers(
+        file, static_cast<std::uint32_t>(bytes.size()), sections, offsets,
+        sizes);
+
+    auto const path = std::filesystem::temp_directory_path() /
+                      "windower_scanner_test.dll";
+    {
+        std::ofstream stream{path, std::ios::binary};
+        stream.write(
+            reinterpret_cast<char const*>(file.data()),
+            static_cast<std::streamsize>(file.size()));
+    }
+    auto const loaded = pe_image::load(path);
+    std::ofstream{path, std::ios::binary}.write(
+        reinterpret_cast<char const*>(file.data()), 0x100);
+    auto const truncated = pe_image::load(path);
+    std::filesystem::remove(path);
+
+    ASSERT_TRUE(loaded);
+    EXPECT_FALSE(truncated);
+    EXPECT_EQ(loaded.timestamp(), 0x5EED1234u);
+    EXPECT_EQ(loaded.image_size(), bytes.size());
+    ASSERT_EQ(loaded.sections().size(), sections.size());
+    for (auto i = std::size_t{}; i < sections.size(); ++i)
+    {
+        auto const data = loaded.section_data(loaded.sections()[i]);
+        ASSERT_EQ(data.size(), sections[i].virtual_size);
+        auto const kept = data.begin() + sizes[i];
+        EXPECT_TRUE(std::equal(
+            data.begin(), kept, bytes.begin() + sections[i].virtual_address));
+        EXPECT_TRUE(std::all_of(kept, data.end(), [](std::byte value) {
+            return value == std::byte{};
+        }));
+    }
+
+    for (auto i = 0; i < 200; ++i)
+    {
+        auto const sig = random_signature(engine, bytes);
+        std::vector<std::uint32_t> rvas(4);
+        rvas.resize(windower::locate(loaded, sig, rvas));
+        auto expected = brute_force(loaded, sig);
+        expected.resize(std::min<std::size_t>(expected.size(), 4));
+        ASSERT_EQ(rvas, expected) << "signature " << i;
+    }
+}
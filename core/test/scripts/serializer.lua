@@ -0,0 +1,223 @@
+--[[
+Copyright © Windower Dev Team
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"),to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+]]
+
+-- Round-trip and wire-format checks for core.serializer. core_tests runs
+-- this file when LuaJIT is available. It also runs in game: copy it into
+-- the user scripts directory and run it with "/exec serializer". Failures are
+-- raised as errors; a summary is printed on success.
+
+local ffi = require('ffi')
+local math = require('math')
+local string = require('string')
+local table = require('table')
+
+local serializer = require('core.serializer')
+
+-- Encodings produced by the original Lua implementation of the wire format.
+local golden = {
+    {'F7', nil},
+    {'F9', true},
+    {'F8', false},
+    {'1B', 0},
+    {'1A', -1},
+    {'00', -27},
+    {'FAE4FF', -28},
+    {'7F', 100},
+    {'FA6500', 101},
+    {'FAFF7F', 32767},
+    {'F5FF7FFFFF', -32769},
+    {'F6000000000000E041', 2147483648},
+    {'F6000000000000E03F', 0.5},
+    {'F69C7500883CE4377E', 1e300},
+    {'F6000000000000F07F', 1 / 0},
+    {'C0', ''},
+    {'C3616263', 'abc'},
+    {'F409' .. string.rep('78', 40), string.rep('x', 40)},
+    {'F01E1C1D1EF7', {1, 2, 3}},
+    {'F01EC16181F9F7', {'a', 'a', true}},
+    {'F01BC1781CF7', {x = 1}},
+    {'F01DF01BF7F01CF01BF7F7F7', {{}, {{}}}},
+}
+
+local to_hex = function(str)
+    return (str:gsub('.', function(c)
+        return string.format('%02X', c:byte())
+    end))
+end
+
+local from_hex = function(str)
+    return (str:gsub('..', function(c)
+        return string.char(tonumber(c, 16))
+    end))
+end
+
+local equal
+equal = function(a, b, seen)
+    if type(a) ~= type(b) then return false end
+    if type(a) ~= 'table' then
+        if a ~= a then return b ~= b end
+        return a == b
+    end
+    if seen[a] ~= nil then return seen[a] == b end
+    seen[a] = b
+    for k, v in pairs(a) do
+        if not equal(v, b[k], seen) then return false end
+    end
+    for k in pairs(b) do
+        if a[k] == nil then return false end
+    end
+    return true
+end
+
+local random_number = function()
+    local kind = math.random(1, 8)
+    if kind == 1 then return math.random(-28, 100) end
+    if kind == 2 then return math.random(-0x8000, 0x7FFF) end
+    if kind == 3 then return math.random(-0x7FFFFFFF, 0x7FFFFFFF) end
+    if kind == 4 then
+        return (math.random() - 0.5) * 2 ^ math.random(-60, 60)
+    end
+    if kind == 5 then
+        return ({0 / 0, 1 / 0, -1 / 0, 2 ^ 53})[math.random(4)]
+    end
+    if kind == 6 then return math.random(0, 2 ^ 20) * 2 ^ 32 end
+    return math.random(0, 255)
+end
+
+local random_string = function()
+    local length = ({0, 1, 31, 32, 33, 58, 59, 300})[math.random(8)]
+    local chars = {}
+    for i = 1, math.random(0, length) do
+        chars[i] = string.char(math.random(0, 255))
+    end
+    return table.concat(chars)
+end
+
+local random_value
+random_value = function(depth, pool)
+    local kind = math.random(1, depth > 0 and 6 or 4)
+    if kind == 1 then return random_number() end
+    if kind == 2 then return random_string() end
+    if kind == 3 then return math.random(2) == 1 end
+    if kind == 4 then
+        if #pool > 0 then return pool[math.random(#pool)] end
+        return random_string()
+    end
+    local t = {}
+    pool[#pool + 1] = t
+    for i = 1, math.random(0, 8) do
+        t[i] = random_value(depth - 1, pool)
+    end
+    for _ = 1, math.random(0, 4) do
+        local key = random_value(0, {})
+        if key == key then t[key] = random_value(depth - 1, pool) end
+    end
+    return t
+end
+
+local check_round_trip = function(value, label)
+    local str = serializer.serialize(value)
+    if not equal(value, serializer.deserialize(str), {}) then
+        error(label .. ': round trip changed the value')
+    end
+
+    local data, size = serializer.serialize_buffer(value)
+    if size ~= #str or ffi.string(data, size) ~= str then
+        error(label .. ': serialize_buffer differs from serialize')
+    end
+    if not equal(value, serializer.deserialize_buffer(data, size), {}) then
+        error(label .. ': buffer round trip changed the value')
+    end
+
+    return str
+end
+
+for i, case in ipairs(golden) do
+    local bytes, value = from_hex(case[1]), case[2]
+    local str = check_round_trip(value, 'golden ' .. i)
+    if str ~= bytes then
+        error('golden ' .. i .. ': expected ' .. case[1] .. ', got ' ..
+                  to_hex(str))
+    end
+    if not equal(value, serializer.deserialize(bytes), {}) then
+        error('golden ' .. i .. ': decoding changed the value')
+    end
+end
+
+math.randomseed(1)
+
+local samples = {}
+for i = 1, 2000 do
+    local pool = {}
+    local value = random_value(4, pool)
+    if #pool > 0 and math.random(4) == 1 then
+        local t = pool[math.random(#pool)]
+        t[#t + 1] = pool[math.random(#pool)]
+    end
+    samples[#samples + 1] = check_round_trip(value, 'random ' .. i)
+end
+
+local mt = {__class = 'test_point'}
+serializer.register_class('test_point', function(p)
+    return {p.x, p.y}
+end, function(t)
+    return setmetatable({x = t[1], y = t[2]}, mt)
+end)
+local point = setmetatable({x = 3, y = 4}, mt)
+local points = serializer.deserialize(serializer.serialize({point, point}))
+if getmetatable(points[1]) ~= mt or points[1].x ~= 3 or points[2] ~=
+    points[1] then error('class instance did not round trip') end
+serializer.unregister_class('test_point')
+
+local resources = serializer.deserialize(serializer.serialize({print, string}))
+if resources[1] ~= print or resources[2] ~= string then
+    error('registered resources did not round trip')
+end
+
+local add = function(a) return a + 1 end
+if serializer.deserialize(serializer.serialize(add))(1) ~= 2 then
+    error('function did not round trip')
+end
+
+if pcall(serializer.serialize, coroutine.create(add)) then
+    error('serializing a thread did not fail')
+end
+
+local truncated = 0
+for i = 1, #samples, 50 do
+    local str = samples[i]
+    for length = 0, #str - 1 do
+        if pcall(serializer.deserialize, str:sub(1, length)) then
+            error('truncated input ' .. i .. ':' .. length .. ' decoded')
+        end
+        truncated = truncated + 1
+    end
+end
+
+for _ = 1, 20000 do
+    pcall(serializer.deserialize, random_string())
+end
+
+print(string.format('serializer: %d golden, %d random, %d truncated: ok',
+                    #golden, #samples, truncated))
@@ -0,0 +1,217 @@
+--[[
+Copyright © Windower Dev Team
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"),to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+]]
+
+-- Compares core.serializer with the pure Lua reference implementation it
+-- replaced. Every value of a random corpus has to encode to the same bytes
+-- with both, and each side has to decode what the other one wrote. Run by
+-- core_tests with both modules preloaded; failures are raised as errors.
+
+local math = require('math')
+local string = require('string')
+local table = require('table')
+
+local native = require('core.serializer')
+local reference = require('core.serializer.reference')
+
+local to_hex = function(str)
+    return (str:gsub('.', function(c)
+        return string.format('%02X', c:byte())
+    end))
+end
+
+local equal
+equal = function(a, b, seen)
+    if type(a) ~= type(b) then return false end
+    if type(a) ~= 'table' then
+        if a ~= a then return b ~= b end
+        return a == b
+    end
+    if seen[a] ~= nil then return seen[a] == b end
+    seen[a] = b
+    if getmetatable(a) ~= getmetatable(b) then return false end
+    for k, v in pairs(a) do
+        if not equal(v, b[k], seen) then return false end
+    end
+    for k in pairs(b) do
+        if a[k] == nil then return false end
+    end
+    return true
+end
+
+-- Registrations have to be mirrored, since the two modules keep separate
+-- registries.
+local register = function(name, resource, safe)
+    native.register(name, resource, safe)
+    reference.register(name, resource, safe)
+end
+
+local point_mt = {__class = 'conformance_point'}
+local point_serializer = function(p) return {p.x, p.y} end
+local point_deserializer = function(t)
+    return setmetatable({x = t[1], y = t[2]}, point_mt)
+end
+native.register_class('conformance_point', point_serializer,
+                      point_deserializer)
+reference.register_class('conformance_point', point_serializer,
+                         point_deserializer)
+
+local shared = {}
+register('conformance.shared.resource.table', shared)
+local secret = {}
+register('conformance.secret', secret, false)
+
+if pcall(native.register, 'conformance.number', 1) or
+    pcall(native.register, 'conformance.boolean', true) then
+    error('registering a number or boolean resource did not fail')
+end
+
+local resources = {print, string, math.floor, table.concat, shared}
+
+local random_number = function()
+    local kind = math.random(1, 8)
+    if kind == 1 then return math.random(-28, 100) end
+    if kind == 2 then return math.random(-0x8000, 0x7FFF) end
+    if kind == 3 then return math.random(-0x7FFFFFFF, 0x7FFFFFFF) end
+    if kind == 4 then
+        return (math.random() - 0.5) * 2 ^ math.random(-60, 60)
+    end
+    if kind == 5 then
+        return ({0 / 0, 1 / 0, -1 / 0, 2 ^ 53, -0.0})[math.random(5)]
+    end
+    if kind == 6 then return math.random(0, 2 ^ 20) * 2 ^ 32 end
+    return math.random(0, 255)
+end
+
+local random_string = function()
+    local length = ({0, 1, 15, 16, 31, 32, 33, 58, 59, 300})[math.random(10)]
+    local chars = {}
+    for i = 1, math.random(0, length) do
+        chars[i] = string.char(math.random(0, 255))
+    end
+    return table.concat(chars)
+end
+
+local random_function = function()
+    local a, b = math.random(100), random_string()
+    local kind = math.random(3)
+    if kind == 1 then return function(x) return x + 1 end end
+    if kind == 2 then return function(x) return x * a end end
+    return function() return a, b, shared end
+end
+
+local random_value
+random_value = function(depth, pool)
+    local kind = math.random(1, depth > 0 and 9 or 6)
+    if kind == 1 then return random_number() end
+    if kind == 2 then return random_string() end
+    if kind == 3 then return math.random(2) == 1 end
+    if kind == 4 then
+        if #pool > 0 then return pool[math.random(#pool)] end
+        return random_string()
+    end
+    if kind == 5 then return resources[math.random(#resources)] end
+    if kind == 6 then return random_function() end
+    if kind == 7 then
+        local p = setmetatable({x = random_number(), y = random_string()},
+                               point_mt)
+        pool[#pool + 1] = p
+        return p
+    end
+    local t = {}
+    pool[#pool + 1] = t
+    for i = 1, math.random(0, 8) do
+        t[i] = random_value(depth - 1, pool)
+    end
+    for _ = 1, math.random(0, 4) do
+        local key = random_value(0, {})
+        if key == key then t[key] = random_value(depth - 1, pool) end
+    end
+    return t
+end
+
+local contains_function
+contains_function = function(value, seen)
+    if type(value) == 'function' then return true end
+    if type(value) ~= 'table' or seen[value] then return false end
+    seen[value] = true
+    for k, v in pairs(value) do
+        if contains_function(k, seen) or contains_function(v, seen) then
+            return true
+        end
+    end
+    return false
+end
+
+local compare = function(value, preserve_upvalues, label)
+    local expected = reference.serialize(value, preserve_upvalues)
+    local actual = native.serialize(value, preserve_upvalues)
+    if actual ~= expected then
+        error(label .. ': expected ' .. to_hex(expected) .. ', got ' ..
+                  to_hex(actual))
+    end
+
+    -- Functions only compare by identity, so decoding is checked on the
+    -- rest of the corpus.
+    if contains_function(value, {}) then return false end
+    if not equal(value, native.deserialize(expected), {}) then
+        error(label .. ': native decoding of the reference changed the value')
+    end
+    if not equal(value, reference.deserialize(actual), {}) then
+        error(label .. ': reference decoding of native changed the value')
+    end
+    return true
+end
+
+math.randomseed(2)
+
+local count, decoded = 0, 0
+for i = 1, 4000 do
+    local pool = {}
+    local value = random_value(4, pool)
+    if #pool > 0 and math.random(4) == 1 then
+        local t = pool[math.random(#pool)]
+        t[#t + 1] = pool[math.random(#pool)]
+    end
+    local preserve_upvalues = math.random(2) == 1
+    if compare(value, preserve_upvalues, 'random ' .. i) then
+        decoded = decoded + 1
+    end
+    count = count + 1
+end
+
+-- Enough distinct values to need large references.
+local wide = {}
+for i = 1, 300 do wide[i] = {i} end
+wide[301] = wide
+compare(wide, false, 'large references')
+
+local leak = function() return secret end
+for _, serializer in ipairs({native, reference}) do
+    if pcall(serializer.serialize, leak, true) then
+        error('serializing an unsafe upvalue did not fail')
+    end
+end
+
+print(string.format('serializer conformance: %d values, %d decoded: ok',
+                    count, decoded))
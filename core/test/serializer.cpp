@@ -0,0 +1,60 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "lua_environment.hpp"
+
+#include "addon/error.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string_view>
+
+namespace
+{
+
+void run(std::u8string_view name)
+{
+    auto const interpreter = windower::test::create_serializer_interpreter();
+    try
+    {
+        windower::test::run_script(interpreter, name);
+    }
+    catch (windower::lua::error const& e)
+    {
+        FAIL() << e.what();
+    }
+}
+
+}
+
+// The checks a developer used to run in game with "/exec serializer".
+TEST(serializer, round_trips)
+{
+    run(u8"serializer.lua");
+}
+
+TEST(serializer, matches_reference_implementation)
+{
+    run(u8"serializer_conformance.lua");
+}
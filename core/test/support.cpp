@@ -0,0 +1,105 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+// Definitions that core.dll gets from utility.cpp, which depends on Windows.
+
+#include "utility.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <string_view>
+
+[[noreturn]] void windower::fail_fast() noexcept
+{
+    WINDOWER_DEBUG_BREAK;
+    std::_Exit(-1);
+}
+
+namespace
+{
+
+template<typename T>
+std::u8string integer_to_u8string(T value, int base)
+{
+    auto buffer       = std::array<char, std::numeric_limits<T>::digits + 2>{};
+    auto const end    = buffer.data() + buffer.size();
+    auto const result = std::to_chars(buffer.data(), end, value, base);
+    return {buffer.data(), result.ptr};
+}
+
+}
+
+std::string_view windower::to_string_view(std::u8string_view value) noexcept
+{
+    return {reinterpret_cast<char const*>(value.data()), value.size()};
+}
+
+windower::zstring_view windower::to_zstring_view(u8zstring_view value) noexcept
+{
+    return {reinterpret_cast<char const*>(value.data()), value.size()};
+}
+
+std::u8string windower::to_u8string(std::string_view value)
+{
+    return {value.begin(), value.end()};
+}
+
+std::u8string windower::to_u8string(signed int value, int base)
+{
+    return integer_to_u8string(value, base);
+}
+
+std::u8string windower::to_u8string(signed long int value, int base)
+{
+    return integer_to_u8string(value, base);
+}
+
+std::u8string windower::to_u8string(signed long long int value, int base)
+{
+    return integer_to_u8string(value, base);
+}
+
+std::u8string windower::to_u8string(unsigned int value, int base)
+{
+    return integer_to_u8string(value, base);
+}
+
+std::u8string windower::to_u8string(unsigned long int value, int base)
+{
+    return integer_to_u8string(value, base);
+}
+
+std::u8string windower::to_u8string(unsigned long long int value, int base)
+{
+    return integer_to_u8string(value, base);
+}
+
+std::string windower::to_string(std::u8string_view value)
+{
+    return {value.begin(), value.end()};
+}
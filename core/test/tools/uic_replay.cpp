@@ -0,0 +1,185 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Replays a frame captured with /uicapture and prints what each window
+// cost and the draws it made.
+//
+//     uic_replay <file>
+
+#include "ui/frame_capture.hpp"
+#include "ui/frame_replay.hpp"
+#include "ui/headless_render_device.hpp"
+#include "ui/layer.hpp"
+#include "ui/render_device.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+namespace
+{
+
+using namespace windower::ui;
+
+std::string_view name(layer layer) noexcept
+{
+    switch (layer)
+    {
+    case layer::layout: return "layout";
+    case layer::screen: return "screen";
+    case layer::world: return "world";
+    }
+    return "?";
+}
+
+std::string_view name(primitive_type type) noexcept
+{
+    switch (type)
+    {
+    case primitive_type::line_strip: return "lines";
+    case primitive_type::triangle_list: return "triangles";
+    }
+    return "?";
+}
+
+double microseconds(std::chrono::nanoseconds duration) noexcept
+{
+    return std::chrono::duration<double, std::micro>{duration}.count();
+}
+
+void print_windows(std::span<frame_replay::window_report const> reports)
+{
+    std::cout << std::left << std::setw(20) << "window" << std::setw(8)
+              << "layer" << std::right << std::setw(8) << "calls"
+              << std::setw(8) << "draws" << std::setw(12) << "primitives"
+              << std::setw(12) << "time (us)" << '\n';
+
+    auto calls      = std::size_t{};
+    auto draw_calls = std::size_t{};
+    auto primitives = std::size_t{};
+    auto duration   = std::chrono::nanoseconds{};
+    for (auto const& report : reports)
+    {
+        std::cout << std::left << std::setw(20) << report.id << std::setw(8)
+                  << name(report.layer) << std::right << std::setw(8)
+                  << report.calls << std::setw(8) << report.draw_calls
+                  << std::setw(12) << report.primitives << std::setw(12)
+                  << microseconds(report.duration) << '\n';
+        calls += report.calls;
+        draw_calls += report.draw_calls;
+        primitives += report.primitives;
+        duration += report.duration;
+    }
+    std::cout << std::left << std::setw(28) << "total" << std::right
+              << std::setw(8) << calls << std::setw(8) << draw_calls
+              << std::setw(12) << primitives << std::setw(12)
+              << microseconds(duration) << '\n';
+}
+
+// The device logs draws in order, so each window's draws follow the
+// previous window's.
+void print_draws(
+    std::span<frame_replay::window_report const> reports,
+    std::span<headless_render_device::draw_record const> draws)
+{
+    std::cout << '\n'
+              << std::left << std::setw(20) << "window" << std::setw(10)
+              << "type" << std::right << std::setw(8) << "texture"
+              << std::setw(8) << "first" << std::setw(12) << "primitives"
+              << "  clip\n";
+
+    auto next = std::size_t{};
+    for (auto const& report : reports)
+    {
+        for (auto i = std::size_t{}; i < report.draw_calls; ++i, ++next)
+        {
+            if (next >= draws.size())
+            {
+                return;
+            }
+            auto const& draw = draws[next];
+            std::cout << std::left << std::setw(20) << report.id
+                      << std::setw(10) << name(draw.type) << std::right
+                      << std::setw(8)
+                      << static_cast<std::uintptr_t>(draw.texture)
+                      << std::setw(8) << draw.first_index << std::setw(12)
+                      << draw.primitive_count << "  " << draw.clip.x << ','
+                      << draw.clip.y << ' ' << draw.clip.width << 'x'
+                      << draw.clip.height;
+            if (draw.wrap)
+            {
+                std::cout << " wrap";
+            }
+            if (draw.masked)
+            {
+                std::cout << " masked";
+            }
+            if (!draw.rasterized)
+            {
+                std::cout << " not rasterized";
+            }
+            std::cout << '\n';
+        }
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    auto const arguments = std::span{argv, static_cast<std::size_t>(argc)};
+    if (arguments.size() != 2)
+    {
+        std::cerr << "usage: uic_replay <file>\n";
+        return 2;
+    }
+
+    auto const path    = std::filesystem::path{arguments[1]};
+    auto const capture = frame_capture::load(path);
+    if (!capture)
+    {
+        std::cerr << "uic_replay: cannot load " << path.string() << '\n';
+        return 1;
+    }
+
+    auto const& size = capture->screen_size();
+    headless_render_device device{
+        static_cast<std::uint32_t>(size.width),
+        static_cast<std::uint32_t>(size.height)};
+    frame_replay const replay{*capture};
+    replay.bind(device);
+    auto const reports = replay.run(device);
+
+    std::cout << path.filename().string() << ": " << size.width << 'x'
+              << size.height << ", " << reports.size() << " windows, "
+              << capture->calls().size() << " calls\n\n"
+              << std::fixed << std::setprecision(1);
+    print_windows(reports);
+    print_draws(reports, device.draws());
+}
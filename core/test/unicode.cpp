@@ -0,0 +1,274 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "unicode.hpp"
+
+#if defined(_WIN32)
+#    include <icu.h>
+#else
+#    include <unicode/ustring.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+using windower::utf16_char;
+using windower::utf16_string;
+using windower::utf16_string_view;
+
+// Compares through std::string, which GoogleTest can print in any build.
+std::string bytes(std::u8string_view str)
+{
+    return {str.begin(), str.end()};
+}
+
+std::u8string icu_to_u8string(utf16_string_view str)
+{
+    auto const source = reinterpret_cast<::UChar const*>(str.data());
+    auto const size   = static_cast<std::int32_t>(str.size());
+
+    auto length     = std::int32_t{};
+    auto error_code = U_ZERO_ERROR;
+    ::u_strToUTF8WithSub(
+        nullptr, 0, &length, source, size, 0xFFFD, nullptr, &error_code);
+
+    auto result = std::u8string(static_cast<std::size_t>(length), u8'\0');
+    error_code  = U_ZERO_ERROR;
+    ::u_strToUTF8WithSub(
+        reinterpret_cast<char*>(result.data()), length, &length, source, size,
+        0xFFFD, nullptr, &error_code);
+    EXPECT_FALSE(U_FAILURE(error_code));
+    return result;
+}
+
+utf16_string icu_to_utf16_string(std::u8string_view str)
+{
+    auto const source = reinterpret_cast<char const*>(str.data());
+    auto const size   = static_cast<std::int32_t>(str.size());
+
+    auto length     = std::int32_t{};
+    auto error_code = U_ZERO_ERROR;
+    ::u_strFromUTF8WithSub(
+        nullptr, 0, &length, source, size, 0xFFFD, nullptr, &error_code);
+
+    auto result = utf16_string(static_cast<std::size_t>(length), u'\0');
+    error_code  = U_ZERO_ERROR;
+    ::u_strFromUTF8WithSub(
+        reinterpret_cast<::UChar*>(result.data()), length, &length, source,
+        size, 0xFFFD, nullptr, &error_code);
+    EXPECT_FALSE(U_FAILURE(error_code));
+    return result;
+}
+
+// Builds strings from runs of ASCII, which exercise the vector paths, mixed
+// with every class of non-ASCII code unit including unpaired surrogates.
+utf16_string random_utf16(std::mt19937& engine)
+{
+    auto const pick = [&](std::uint32_t low, std::uint32_t high) {
+        return std::uniform_int_distribution<std::uint32_t>{low, high}(engine);
+    };
+
+    auto result = utf16_string{};
+    for (auto pieces = pick(0, 12); pieces > 0; --pieces)
+    {
+        switch (pick(0, 6))
+        {
+        case 0:
+        case 1:
+            for (auto count = pick(0, 40); count > 0; --count)
+            {
+                result += static_cast<utf16_char>(pick(0x00, 0x7F));
+            }
+            break;
+        case 2: result += static_cast<utf16_char>(pick(0x80, 0x7FF)); break;
+        case 3: result += static_cast<utf16_char>(pick(0x800, 0xD7FF)); break;
+        case 4: result += static_cast<utf16_char>(pick(0xE000, 0xFFFF)); break;
+        case 5:
+            result += static_cast<utf16_char>(pick(0xD800, 0xDBFF));
+            result += static_cast<utf16_char>(pick(0xDC00, 0xDFFF));
+            break;
+        case 6: result += static_cast<utf16_char>(pick(0xD800, 0xDFFF)); break;
+        }
+    }
+    return result;
+}
+
+// Builds byte strings from ASCII runs, well-formed sequences of every length
+// and arbitrary bytes, which produce truncated, overlong and stray sequences.
+std::u8string random_utf8(std::mt19937& engine)
+{
+    auto const pick = [&](std::uint32_t low, std::uint32_t high) {
+        return std::uniform_int_distribution<std::uint32_t>{low, high}(engine);
+    };
+
+    auto result = std::u8string{};
+    for (auto pieces = pick(0, 12); pieces > 0; --pieces)
+    {
+        switch (pick(0, 4))
+        {
+        case 0:
+        case 1:
+            for (auto count = pick(0, 40); count > 0; --count)
+            {
+                result += static_cast<char8_t>(pick(0x00, 0x7F));
+            }
+            break;
+        case 2:
+            windower::append(result, static_cast<char32_t>(pick(0x80, 0xFFFF)));
+            break;
+        case 3:
+            windower::append(
+                result, static_cast<char32_t>(pick(0x10000, 0x10FFFF)));
+            break;
+        case 4:
+            for (auto count = pick(1, 4); count > 0; --count)
+            {
+                result += static_cast<char8_t>(pick(0x80, 0xFF));
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+}
+
+TEST(unicode, utf16_to_utf8_matches_icu)
+{
+    std::mt19937 engine{1};
+    for (auto i = 0; i < 50000; ++i)
+    {
+        auto const str      = random_utf16(engine);
+        auto const expected = icu_to_u8string(str);
+        ASSERT_EQ(bytes(windower::to_u8string(str)), bytes(expected))
+            << "sample " << i;
+        ASSERT_EQ(windower::to_u8string(str, {}), expected.size());
+    }
+}
+
+TEST(unicode, utf8_to_utf16_matches_icu)
+{
+    std::mt19937 engine{2};
+    for (auto i = 0; i < 50000; ++i)
+    {
+        auto const str      = random_utf8(engine);
+        auto const expected = icu_to_utf16_string(str);
+        ASSERT_EQ(windower::to_wstring(str), expected) << "sample " << i;
+        ASSERT_EQ(windower::to_wstring(str, {}), expected.size());
+    }
+}
+
+TEST(unicode, small_buffers_report_the_full_length)
+{
+    std::mt19937 engine{3};
+    for (auto i = 0; i < 5000; ++i)
+    {
+        auto const str    = random_utf8(engine);
+        auto const wide   = icu_to_utf16_string(str);
+        auto buffer       = utf16_string(wide.size(), u'\0');
+        auto const length = std::uniform_int_distribution<std::size_t>{
+            0, wide.size()}(engine);
+        ASSERT_EQ(
+            windower::to_wstring(str, std::span{buffer}.first(length)),
+            wide.size());
+        ASSERT_EQ(windower::to_wstring(str, buffer), wide.size());
+        ASSERT_EQ(buffer, wide);
+
+        auto narrow = std::u8string(str.size() * 3, u8'\0');
+        auto const narrow_length = windower::to_u8string(wide, {});
+        ASSERT_EQ(windower::to_u8string(wide, narrow), narrow_length);
+        narrow.resize(narrow_length);
+        ASSERT_EQ(bytes(narrow), bytes(icu_to_u8string(wide)));
+    }
+}
+
+// Every UTF-16 code unit either encodes to a sequence that decodes back to it
+// or to 85 41, the client's replacement character. U+FFF8..U+FFFF lie past the
+// end of the flat encode table and used to read beyond it. Unpaired
+// surrogates encode as U+FFFD, which is unmapped.
+TEST(unicode, sjis_encodes_every_bmp_code_unit)
+{
+    auto const unmapped = windower::sjis_string{0x85, 0x41};
+    for (auto i = std::uint32_t{}; i <= 0xFFFF; ++i)
+    {
+        auto const code_point = static_cast<char32_t>(i);
+        auto const wide       = utf16_string(1, static_cast<utf16_char>(i));
+        auto const encoded    = windower::to_sjis_string(wide);
+        if (i >= 0xD800 && i <= 0xDFFF || i >= 0xFFF8)
+        {
+            ASSERT_EQ(encoded, unmapped) << "U+" << std::hex << i;
+            continue;
+        }
+
+        auto appended = windower::sjis_string{};
+        windower::append(appended, code_point);
+        ASSERT_EQ(appended, encoded) << "U+" << std::hex << i;
+        ASSERT_EQ(
+            windower::to_sjis_string(windower::to_u8string(wide)), encoded)
+            << "U+" << std::hex << i;
+        if (encoded != unmapped)
+        {
+            ASSERT_EQ(windower::to_wstring(encoded), wide)
+                << "U+" << std::hex << i;
+        }
+    }
+}
+
+// Every code point the decoder produces must encode back to a sequence that
+// decodes to it. The exceptions are the client's text control codes, which
+// decode to U+F600..U+F7FF and are never encoded, and trail bytes above 0xFC,
+// which are not valid Shift-JIS.
+TEST(unicode, sjis_decodes_every_two_byte_sequence)
+{
+    auto const is_control_code = [](utf16_char unit) {
+        return unit >= 0xF600 && unit <= 0xF7FF;
+    };
+
+    for (auto i = 0; i <= 0xFFFF; ++i)
+    {
+        auto const sequence = windower::sjis_string{
+            static_cast<windower::sjis_char>(i >> 8),
+            static_cast<windower::sjis_char>(i & 0xFF)};
+        auto const decoded = windower::to_wstring(sequence);
+        if ((i & 0xFF) > 0xFC ||
+            std::ranges::any_of(decoded, is_control_code))
+        {
+            continue;
+        }
+        ASSERT_EQ(
+            windower::to_wstring(windower::to_sjis_string(decoded)), decoded)
+            << std::hex << i;
+    }
+}
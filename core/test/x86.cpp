@@ -0,0 +1,309 @@
+/*
+ * Copyright © Windower Dev Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"),to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "hooklib/x86.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using windower::hooklib::x86;
+
+struct expected_instruction
+{
+    std::vector<std::uint8_t> bytes;
+    std::uint8_t size;
+    std::uint8_t relative_offset;
+    std::uint8_t relative_size;
+};
+
+// Decodes with enough padding after the instruction that a decoder reading
+// too far still stays inside the buffer.
+x86::instruction decode(std::vector<std::uint8_t> bytes)
+{
+    bytes.resize(bytes.size() + x86::max_instruction_size);
+    return x86::decode(bytes.data());
+}
+
+// Returns the absolute target of the relative branch at code.
+std::intptr_t branch_target(std::uint8_t const* code)
+{
+    auto const instruction = x86::decode(code);
+    auto const operand     = code + instruction.relative_offset;
+    auto value             = std::int32_t{};
+    switch (instruction.relative_size)
+    {
+    case 1: value = static_cast<std::int8_t>(*operand); break;
+    case 4:
+        value = static_cast<std::int32_t>(
+            operand[0] | operand[1] << 8 | operand[2] << 16 |
+            static_cast<std::uint32_t>(operand[3]) << 24);
+        break;
+    default: ADD_FAILURE() << "not a branch";
+    }
+    return reinterpret_cast<std::intptr_t>(code) + instruction.size + value;
+}
+
+#if defined(WINDOWER_OBJDUMP)
+
+// Runs objdump over random bytes and returns the address, length and text of
+// every instruction it decodes.
+struct disassembled
+{
+    std::size_t address;
+    std::size_t size;
+    std::string text;
+};
+
+std::vector<disassembled> objdump(std::vector<std::uint8_t> const& code)
+{
+    auto const path =
+        std::filesystem::temp_directory_path() / "windower_x86_test.bin";
+    std::ofstream{path, std::ios::binary}.write(
+        reinterpret_cast<char const*>(code.data()),
+        static_cast<std::streamsize>(code.size()));
+
+    auto const command = std::string{WINDOWER_OBJDUMP} +
+                         " -D -b binary -m i386 --insn-width=16 -z \"" +
+                         path.string() + "\"";
+#    if defined(_WIN32)
+    auto const pipe = ::_popen(command.c_str(), "r");
+#    else
+    auto const pipe = ::popen(command.c_str(), "r");
+#    endif
+    std::string output;
+    std::array<char, 4096> buffer{};
+    while (auto const count =
+               std::fread(buffer.data(), 1, buffer.size(), pipe))
+    {
+        output.append(buffer.data(), count);
+    }
+#    if defined(_WIN32)
+    ::_pclose(pipe);
+#    else
+    ::pclose(pipe);
+#    endif
+    std::filesystem::remove(path);
+
+    // Instruction lines look like "  1f:\t8b 45 fc    \tmov ...".
+    std::vector<disassembled> result;
+    std::istringstream lines{output};
+    for (std::string line; std::getline(lines, line);)
+    {
+        auto const colon = line.find(":\t");
+        auto const tab   = line.find('\t', colon + 2);
+        if (colon == std::string::npos || tab == std::string::npos)
+        {
+            continue;
+        }
+        disassembled entry{};
+        std::istringstream address{line.substr(0, colon)};
+        if (!(address >> std::hex >> entry.address))
+        {
+            continue;
+        }
+        std::istringstream bytes{line.substr(colon + 2, tab - colon - 2)};
+        for (std::string byte; bytes >> byte;)
+        {
+            ++entry.size;
+        }
+        entry.text = line.substr(tab + 1);
+        result.push_back(entry);
+    }
+    return result;
+}
+
+#endif
+
+}
+
+TEST(x86, decodes_known_instructions)
+{
+    std::vector<expected_instruction> const cases = {
+        {{0x55}, 1, 0, 0},                               // push ebp
+        {{0x8B, 0x45, 0xFC}, 3, 0, 0},                   // mov eax, [ebp-4]
+        {{0x8B, 0x04, 0x25, 0, 0, 0, 0}, 7, 0, 0},       // mov eax, [disp32]
+        {{0x8B, 0x44, 0x24, 0x04}, 4, 0, 0},             // mov eax, [esp+4]
+        {{0x67, 0x8B, 0x06, 0x34, 0x12}, 5, 0, 0},       // mov eax, [0x1234]
+        {{0x66, 0xB8, 0x34, 0x12}, 4, 0, 0},             // mov ax, 0x1234
+        {{0xA1, 0, 0, 0, 0}, 5, 0, 0},                   // mov eax, [moffs]
+        {{0x67, 0xA1, 0, 0}, 4, 0, 0},                   // mov eax, [moffs16]
+        {{0xF6, 0xC0, 0x01}, 3, 0, 0},                   // test al, 1
+        {{0xF6, 0xD0}, 2, 0, 0},                         // not al
+        {{0xF7, 0xC0, 1, 0, 0, 0}, 6, 0, 0},             // test eax, 1
+        {{0xC2, 0x08, 0x00}, 3, 0, 0},                   // ret 8
+        {{0xC8, 0x10, 0x00, 0x00}, 4, 0, 0},             // enter 16, 0
+        {{0x0F, 0x38, 0x00, 0xC1}, 4, 0, 0},             // pshufb mm0, mm1
+        {{0x0F, 0x3A, 0x0F, 0xC1, 0x08}, 5, 0, 0},       // palignr mm0, mm1, 8
+        {{0x0F, 0xB6, 0x45, 0x08}, 4, 0, 0},             // movzx eax, [ebp+8]
+        {{0x8F, 0xC0}, 2, 0, 0},                         // pop eax
+        {{0xE8, 0, 0, 0, 0}, 5, 1, 4},                   // call rel32
+        {{0xE9, 0, 0, 0, 0}, 5, 1, 4},                   // jmp rel32
+        {{0xEB, 0x10}, 2, 1, 1},                         // jmp rel8
+        {{0x74, 0x10}, 2, 1, 1},                         // je rel8
+        {{0x0F, 0x84, 0, 0, 0, 0}, 6, 2, 4},             // je rel32
+        {{0x3E, 0x74, 0x10}, 3, 2, 1},                   // je rel8, hinted
+        {{0x66, 0xE9, 0x00, 0x00}, 4, 2, 2},             // jmp rel16
+    };
+
+    for (auto const& expected : cases)
+    {
+        auto const instruction = decode(expected.bytes);
+        EXPECT_EQ(instruction.size, expected.size)
+            << "opcode " << std::hex << +expected.bytes[0];
+        EXPECT_EQ(instruction.relative_offset, expected.relative_offset)
+            << "opcode " << std::hex << +expected.bytes[0];
+        EXPECT_EQ(instruction.relative_size, expected.relative_size)
+            << "opcode " << std::hex << +expected.bytes[0];
+    }
+}
+
+TEST(x86, rejects_encodings_it_cannot_measure)
+{
+    EXPECT_THROW(decode({0xC5, 0xF8, 0x77}), std::runtime_error); // VEX
+    EXPECT_THROW(decode({0x62, 0xF1, 0x7C, 0x48}), std::runtime_error);
+    EXPECT_THROW(decode({0x8F, 0xE9, 0x78, 0x95}), std::runtime_error); // XOP
+
+    // Sixteen prefixes exceed the architectural limit of fifteen bytes.
+    EXPECT_THROW(
+        decode(std::vector<std::uint8_t>(16, 0x66)), std::runtime_error);
+}
+
+TEST(x86, relocation_keeps_branch_targets)
+{
+    // push ebp; mov ebp, esp; call +0x100; je +0x20; jmp +0x40
+    std::vector<std::uint8_t> const prologue = {
+        0x55, 0x8B, 0xEC, 0xE8, 0x00, 0x01, 0x00, 0x00,
+        0x74, 0x20, 0xEB, 0x40};
+    std::vector<std::uint8_t> buffer(0x400, x86::nop_instruction);
+    std::copy(prologue.begin(), prologue.end(), buffer.begin());
+    auto const source      = buffer.data();
+    auto const destination = std::span{buffer}.subspan(0x200, 0x40);
+
+    auto const relocation =
+        x86::relocate(source, prologue.size(), destination);
+    EXPECT_EQ(relocation.source_size, prologue.size());
+    EXPECT_EQ(relocation.size, 3 + 5 + 6 + 5);
+
+    auto const copy = destination.data();
+    EXPECT_TRUE(std::equal(source, source + 3, copy));
+    EXPECT_EQ(branch_target(copy + 3), branch_target(source + 3));
+    EXPECT_EQ(copy[8], 0x0F);
+    EXPECT_EQ(copy[9], 0x84);
+    EXPECT_EQ(branch_target(copy + 8), branch_target(source + 8));
+    EXPECT_EQ(copy[14], 0xE9);
+    EXPECT_EQ(branch_target(copy + 14), branch_target(source + 10));
+}
+
+TEST(x86, relocation_rejects_code_it_cannot_move)
+{
+    std::vector<std::uint8_t> buffer(0x400, x86::nop_instruction);
+    auto const destination = std::span{buffer}.subspan(0x200, 0x40);
+
+    // jmp back to the second nop, inside the copied range
+    buffer[2] = 0xEB;
+    buffer[3] = 0xFD;
+    EXPECT_THROW(
+        x86::relocate(buffer.data(), 4, destination), std::runtime_error);
+
+    // loop
+    buffer[0] = 0xE2;
+    buffer[1] = 0x10;
+    EXPECT_THROW(
+        x86::relocate(buffer.data(), 2, destination), std::runtime_error);
+
+    // destination too small
+    buffer[0] = 0xE8;
+    EXPECT_THROW(
+        x86::relocate(buffer.data(), 5, destination.first(4)),
+        std::runtime_error);
+}
+
+#if defined(WINDOWER_OBJDUMP)
+
+// Decodes random bytes at every address where objdump starts an instruction
+// and compares the lengths. Encodings objdump marks as invalid, VEX, EVEX
+// and XOP instructions, test register moves and fwait (which objdump merges
+// with the following x87 instruction) are left out, as is the tail of the
+// buffer where objdump runs out of bytes.
+TEST(x86, lengths_match_objdump)
+{
+    std::mt19937 engine{1};
+    std::vector<std::uint8_t> code(1 << 18);
+    for (auto& byte : code)
+    {
+        byte = static_cast<std::uint8_t>(engine());
+    }
+    auto const instructions = objdump(code);
+    ASSERT_GT(instructions.size(), code.size() / 8);
+
+    code.resize(code.size() + x86::max_instruction_size);
+    auto compared = std::size_t{};
+    for (auto const& instruction : instructions)
+    {
+        auto const& text = instruction.text;
+        if (instruction.address + x86::max_instruction_size >
+                code.size() - x86::max_instruction_size ||
+            text.find("(bad)") != std::string::npos ||
+            text.find(".byte") != std::string::npos ||
+            text.find("%tr") != std::string::npos ||
+            code[instruction.address] == 0x9B)
+        {
+            continue;
+        }
+        try
+        {
+            auto const decoded =
+                x86::decode(code.data() + instruction.address);
+            ASSERT_EQ(decoded.size, instruction.size)
+                << std::hex << instruction.address << ": " << text;
+            ++compared;
+        }
+        catch (std::runtime_error const&)
+        {
+            auto const mnemonic = text.substr(0, text.find(' '));
+            ASSERT_TRUE(mnemonic[0] == 'v' || mnemonic[0] == 'k')
+                << std::hex << instruction.address << ": " << text;
+        }
+    }
+    EXPECT_GT(compared, instructions.size() * 9 / 10);
+}
+
+#endif